@@ -20,6 +20,9 @@
 // #define PEKWM_HAVE_XINERAMA
 #define PEKWM_HAVE_XFT
 #define PEKWM_HAVE_XRANDR
+// #define PEKWM_HAVE_XCB
+#define PEKWM_HAVE_XSHM
+// #define PEKWM_HAVE_XRENDER
 
 #define PEKWM_HAVE_IMAGE_PNG
 #define PEKWM_HAVE_IMAGE_JPEG
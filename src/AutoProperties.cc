@@ -250,6 +250,11 @@ AutoProperties::load(void)
 	// Validate date
 	setDefaultTypeProperties();
 
+	buildIndex(_prop_list, _prop_index);
+	buildIndex(_title_prop_list, _title_prop_index);
+	buildIndex(_decor_prop_list, _decor_prop_index);
+	buildIndex(_dock_app_prop_list, _dock_app_prop_index);
+
 	return true;
 }
 
@@ -310,6 +315,11 @@ AutoProperties::unload(void)
 	}
 	_dock_app_prop_list.clear();
 
+	_prop_index.clear();
+	_title_prop_index.clear();
+	_decor_prop_index.clear();
+	_dock_app_prop_index.clear();
+
 	// remove type properties
 	std::map<AtomName, AutoProperty*>::iterator wit;
 	for (wit = _window_type_prop_map.begin();
@@ -324,27 +334,46 @@ AutoProperties::unload(void)
 Property*
 AutoProperties::findProperty(const ClassHint* class_hint,
                              std::vector<Property*>* prop_list,
-                             int ws, ApplyOn type)
+                             RegexIndex &index, int ws, ApplyOn type)
 {
 	// Allready remove apply on start
 	if (! _apply_on_start && (type == APPLY_ON_START))
 		return nullptr;
 
-	// start searching for a suitable property
-	std::vector<Property*>::iterator it = prop_list->begin();
-	for (; it != prop_list->end(); ++it) {
+	// start searching for a suitable property among the ones with
+	// matching name and class
+	const std::vector<uint> &rules =
+		index.find(class_hint->h_name, class_hint->h_class);
+	std::vector<uint>::const_iterator it = rules.begin();
+	for (; it != rules.end(); ++it) {
+		Property *prop = (*prop_list)[*it];
 		// see if the type matches, if we have one
-		if ((type != APPLY_ON_ALWAYS) && ! (*it)->isApplyOn(type))
+		if ((type != APPLY_ON_ALWAYS) && ! prop->isApplyOn(type))
 			continue;
 
-		if (matchAutoClass(*class_hint, *it)) {
-			return (*it)->applyOnWs(ws) ? *it : nullptr;
+		if (matchAutoClassExtra(*class_hint, prop)) {
+			return prop->applyOnWs(ws) ? prop : nullptr;
 		}
 	}
 
 	return nullptr;
 }
 
+/**
+ * Index the WM_CLASS name and class patterns of prop_list, must be
+ * called whenever prop_list is modified.
+ */
+void
+AutoProperties::buildIndex(std::vector<Property*> &prop_list,
+			   RegexIndex &index)
+{
+	index.clear();
+	std::vector<Property*>::iterator it = prop_list.begin();
+	for (; it != prop_list.end(); ++it) {
+		index.add(&(*it)->getHintName(), &(*it)->getHintClass());
+	}
+}
+
 /**
  * Parse regex_str and set on regex, outputting warning with name if
  * it fails.
@@ -984,26 +1013,26 @@ AutoProperties::parseAutoPropertyValue(CfgParser::Entry *section,
 AutoProperty*
 AutoProperties::findAutoProperty(const ClassHint* class_hint, int ws, ApplyOn type)
 {
-	return static_cast<AutoProperty*>(findProperty(class_hint, &_prop_list, ws, type));
+	return static_cast<AutoProperty*>(findProperty(class_hint, &_prop_list, _prop_index, ws, type));
 }
 
 //! @brief Searches the _title_prop_list for a property
 TitleProperty*
 AutoProperties::findTitleProperty(const ClassHint* class_hint)
 {
-	return static_cast<TitleProperty*>(findProperty(class_hint, &_title_prop_list, -1, APPLY_ON_ALWAYS));
+	return static_cast<TitleProperty*>(findProperty(class_hint, &_title_prop_list, _title_prop_index, -1, APPLY_ON_ALWAYS));
 }
 
 DecorProperty*
 AutoProperties::findDecorProperty(const ClassHint* class_hint)
 {
-	return static_cast<DecorProperty*>(findProperty(class_hint, &_decor_prop_list, -1, APPLY_ON_ALWAYS));
+	return static_cast<DecorProperty*>(findProperty(class_hint, &_decor_prop_list, _decor_prop_index, -1, APPLY_ON_ALWAYS));
 }
 
 DockAppProperty*
 AutoProperties::findDockAppProperty(const ClassHint *class_hint)
 {
-	return static_cast<DockAppProperty*>(findProperty(class_hint, &_dock_app_prop_list, -1, APPLY_ON_ALWAYS));
+	return static_cast<DockAppProperty*>(findProperty(class_hint, &_dock_app_prop_list, _dock_app_prop_index, -1, APPLY_ON_ALWAYS));
 }
 
 //! @brief Get AutoProperty for window of type type
@@ -1039,25 +1068,29 @@ AutoProperties::removeApplyOnStart(void)
 	}
 
 	_apply_on_start = false;
+	buildIndex(_prop_list, _prop_index);
 }
 
 //! @brief Tries to match a class hint against an autoproperty data entry
 bool
 AutoProperties::matchAutoClass(const ClassHint &hint, Property *prop)
 {
-	bool ok = false;
-
-	if ((prop->getHintName() == hint.h_name)
-	    && (prop->getHintClass() == hint.h_class))
-		{
-			ok = true;
-			if (prop->getTitle ().is_match_ok ())  {
-				ok = (prop->getTitle () == hint.title);
-			}
-			if (ok && prop->getRole ().is_match_ok ()) {
-				ok = (prop->getRole () == hint.h_role);
-			}
-		}
+	return (prop->getHintName() == hint.h_name)
+		&& (prop->getHintClass() == hint.h_class)
+		&& matchAutoClassExtra(hint, prop);
+}
 
+//! @brief Match title and role of a class hint, name and class is
+//! expected to be matched already.
+bool
+AutoProperties::matchAutoClassExtra(const ClassHint &hint, Property *prop)
+{
+	bool ok = true;
+	if (prop->getTitle ().is_match_ok ())  {
+		ok = (prop->getTitle () == hint.title);
+	}
+	if (ok && prop->getRole ().is_match_ok ()) {
+		ok = (prop->getRole () == hint.h_role);
+	}
 	return ok;
 }
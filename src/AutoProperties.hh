@@ -15,6 +15,7 @@
 #include "CfgParser.hh"
 #include "ImageHandler.hh"
 #include "PImageIcon.hh"
+#include "RegexIndex.hh"
 #include "RegexString.hh"
 #include "X11.hh"
 
@@ -233,9 +234,12 @@ public:
 	static bool matchAutoClass(const ClassHint &hint, Property *prop);
 
 private:
+	static bool matchAutoClassExtra(const ClassHint &hint, Property *prop);
 	Property* findProperty(const ClassHint* class_hint,
 			       std::vector<Property*>* prop_list,
-			       int ws, ApplyOn type);
+			       RegexIndex &index, int ws, ApplyOn type);
+	static void buildIndex(std::vector<Property*> &prop_list,
+			       RegexIndex &index);
 
 	void loadRequire(CfgParser &a_cfg, std::string &file);
 
@@ -268,6 +272,11 @@ private:
 	std::vector<Property*> _title_prop_list;
 	std::vector<Property*> _decor_prop_list;
 	std::vector<Property*> _dock_app_prop_list;
+	/** Index of the WM_CLASS patterns of the property lists above. */
+	RegexIndex _prop_index;
+	RegexIndex _title_prop_index;
+	RegexIndex _decor_prop_index;
+	RegexIndex _dock_app_prop_index;
 	bool _harbour_sort;
 	bool _apply_on_start;
 };
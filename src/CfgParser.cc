@@ -6,6 +6,7 @@
 //
 
 #include "CfgParser.hh"
+#include "CfgParserCache.hh"
 #include "Debug.hh"
 #include "Compat.hh"
 #include "Util.hh"
@@ -24,6 +25,8 @@ enum {
 
 const std::string CfgParser::_root_source_name = std::string("");
 const char *CP_PARSE_BLANKS = " \t\n";
+/** Characters with a meaning in parse, anything else is part of a name. */
+const char *CP_PARSE_SPECIAL = "\n;{}=#/";
 
 bool
 TimeFiles::requireReload(const std::string &file)
@@ -305,7 +308,7 @@ operator<<(std::ostream &stream, const CfgParser::Entry &entry)
 //! @brief CfgParser constructor.
 CfgParser::CfgParser(void)
 	: _source(0), _root_entry(0), _is_dynamic_content(false),
-	  _section(_root_entry), _overwrite(false)
+	  _section(_root_entry), _overwrite(false), _cache(nullptr)
 {
 	_root_entry = new CfgParser::Entry(_root_source_name, 0, "ROOT", "");
 	_section = _root_entry;
@@ -354,6 +357,18 @@ CfgParser::clear(bool realloc)
 	_section_map.clear();
 }
 
+/**
+ * Return true if nothing has been parsed.
+ */
+bool
+CfgParser::isEmpty(void) const
+{
+	return _root_entry->begin() == _root_entry->end()
+		&& ! _root_entry->getSection()
+		&& _section_map.empty()
+		&& ! _is_dynamic_content;
+}
+
 /**
  * Parses source and fills root section with data.
  *
@@ -368,16 +383,28 @@ CfgParser::parse(const std::string &src, CfgParserSource::Type type,
 	// Set overwrite
 	_overwrite = overwrite;
 
-	// Init parse buffer and reserve memory.
-	std::string buf, value;
-	buf.reserve(PARSE_BUF_SIZE);
+	// Files parsed into an empty parser are cached, the result of
+	// parsing into existing content depends on that content.
+	bool use_cache = type == CfgParserSource::SOURCE_FILE
+		&& CfgParserCache::isEnabled() && isEmpty();
+	if (use_cache && CfgParserCache::load(*this, src, overwrite)) {
+		return true;
+	}
+
+	CfgParserCache cache(_var_map);
+	if (use_cache) {
+		_cache = &cache;
+	}
 
 	// Open initial source.
 	parseSourceNew(src, type);
-	if (_sources.size() == 0) {
-		return false;
+	bool ok = ! _sources.empty() && parse();
+	_cache = nullptr;
+
+	if (ok && use_cache && ! _is_dynamic_content) {
+		cache.save(*this, src, overwrite);
 	}
-	return parse();
+	return ok;
 }
 
 /**
@@ -391,6 +418,9 @@ bool
 CfgParser::parse(CfgParserSource* source, bool overwrite)
 {
 	_overwrite = overwrite;
+	if (source->isDynamic()) {
+		_is_dynamic_content = true;
+	}
 	_source = source;
 	_sources.push_back(source);
 	_source_names.push_back(source->getName());
@@ -410,9 +440,6 @@ CfgParser::parse()
 	int c, next;
 	while (_sources.size()) {
 		_source = _sources.back();
-		if (_source->isDynamic()) {
-			_is_dynamic_content = true;
-		}
 
 		while ((c = _source->get_char()) != EOF) {
 			switch (c) {
@@ -470,28 +497,35 @@ CfgParser::parse()
 					_source->unget_char(next);
 				}
 				break;
-			default:
+			default: {
+				// consume the rest of the name in one go
+				size_t len;
+				const char *span =
+					_source->get_span(CP_PARSE_SPECIAL, len);
 				buf += c;
+				buf.append(span, len);
 				break;
 			}
+			}
 		}
 
+		CfgParserSource *source = _source;
 		try {
-			_source->close();
+			source->close();
 		} catch (std::string &ex) {
 			P_LOG("Exception: " << ex);
 		}
-		delete _source;
 		_sources.pop_back();
 		_source_names.pop_back();
 
 		// done inside of the loop to ensure COMMAND and INCLUDE
 		// statements without a new line at the end of the file will
-		// be used.
+		// be used. source is deleted after as the entry refers to
+		// its name and line.
 		if (buf.size()) {
 			parseEntryFinish(buf, value, have_value);
 		}
-
+		delete source;
 	}
 
 	return true;
@@ -512,6 +546,9 @@ CfgParser::parseSourceNew(const std::string &name_orig,
 		// Open and set as active, delete if fails.
 		try {
 			source->open();
+			if (_cache && type == CfgParserSource::SOURCE_FILE) {
+				_cache->addFile(name, source->getData());
+			}
 			time_t time;
 			// Add source to file list if file
 			if (type == CfgParserSource::SOURCE_FILE) {
@@ -522,11 +559,20 @@ CfgParser::parseSourceNew(const std::string &name_orig,
 				}
 			}
 
+			// set here as sources opened while parsing are read
+			// from directly, without passing the top of parse.
+			if (source->isDynamic()) {
+				_is_dynamic_content = true;
+			}
+
 			_source = source;
 			_sources.push_back(_source);
 			done = 1;
 
 		} catch (std::string &ex) {
+			if (_cache && type == CfgParserSource::SOURCE_FILE) {
+				_cache->addMissing(name);
+			}
 			delete source;
 			// Previously added in source_new
 			_source_names.pop_back();
@@ -585,9 +631,10 @@ CfgParser::parseValue(std::string &value)
 {
 	// Expect to get a " after the =, ignore anything else.
 	int c;
-	while ((c = _source->get_char()) != EOF && c != '"') {
-		;
-	}
+	size_t len;
+	do {
+		_source->get_span("\"", len);
+	} while ((c = _source->get_char()) != EOF && c != '"');
 
 	// Check if EOF before getting a quotation mark.
 	if (c == EOF) {
@@ -596,11 +643,19 @@ CfgParser::parseValue(std::string &value)
 	}
 
 	// Parse until next ", and escape characters after \.
-	while ((c = _source->get_char()) != EOF && c != '"') {
-		// Escape character after \, if newline drop it.
-		if (c == '\\') {
+	for (;;) {
+		const char *span = _source->get_span("\"\\", len);
+		value.append(span, len);
+
+		c = _source->get_char();
+		if (c == EOF || c == '"') {
+			break;
+		} else if (c == '\\') {
+			// Escape character after \, if newline drop it.
 			c = _source->get_char();
-			if (c == '\n' || c == EOF) {
+			if (c == EOF) {
+				break;
+			} else if (c == '\n') {
 				continue;
 			}
 		}
@@ -713,8 +768,10 @@ void
 CfgParser::parseCommentLine(CfgParserSource *source)
 {
 	int c;
-	while (((c = source->get_char()) != EOF) && (c != '\n'))
-		;
+	size_t len;
+	do {
+		source->get_span("\n", len);
+	} while (((c = source->get_char()) != EOF) && (c != '\n'));
 
 	// Give back the newline, needed for flushing value before comment
 	if (c == '\n') {
@@ -727,15 +784,17 @@ void
 CfgParser::parseCommentC(CfgParserSource *source)
 {
 	int c;
-	while ((c = source->get_char()) != EOF) {
-		if (c == '*') {
+	size_t len;
+	do {
+		source->get_span("*", len);
+		if ((c = source->get_char()) == '*') {
 			if ((c = source->get_char()) == '/') {
 				break;
 			} else if (c != EOF) {
 				source->unget_char(c);
 			}
 		}
-	}
+	} while (c != EOF);
 
 	P_LOG_IF(c == EOF, "Reached EOF before closing */ in comment.");
 }
@@ -785,6 +844,9 @@ CfgParser::variableDefine(const std::string &name, const std::string &value)
 	// If the variable begins with $_ it should update the environment aswell.
 	if ((name.size() > 2) && (name[1] == '_')) {
 		setenv(name.c_str() + 2, value.c_str(), 1);
+		if (_cache) {
+			_cache->addEnvSet(name.substr(2), value);
+		}
 	}
 }
 
@@ -830,6 +892,9 @@ CfgParser::variableExpandName(std::string &var,
 	// variable, use getenv to see if it is available
 	if (var_name.size() > 2 && var_name[1] == '_') {
 		char *value = getenv(var_name.c_str() + 2);
+		if (_cache) {
+			_cache->addEnvGet(var_name.substr(2), value);
+		}
 		if (value) {
 			var.replace(begin, end - begin, value);
 			end = begin + strlen(value);
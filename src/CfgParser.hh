@@ -35,6 +35,8 @@
 #include <iostream>
 #include <cstdlib>
 
+class CfgParserCache;
+
 //! @brief Helper class
 class TimeFiles {
 public:
@@ -143,6 +145,9 @@ public:
 	}
 
 private:
+	friend class CfgParserCache;
+
+	bool isEmpty(void) const;
 	bool parse(void);
 	void parseSourceNew(const std::string &name, CfgParserSource::Type type);
 	bool parseName(std::string &buf);
@@ -193,6 +198,8 @@ private:
 	bool _is_dynamic_content;
 	Entry *_section; /**< Current section. */
 	bool _overwrite; /**< Overwrite elements when appending. */
+	/** Cache recording dependencies of current parse, if any. */
+	CfgParserCache *_cache;
 
 	static const std::string _root_source_name; //!< Root Entry Source Name.
 };
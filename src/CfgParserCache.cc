@@ -0,0 +1,695 @@
+//
+// CfgParserCache.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "CfgParserCache.hh"
+#include "Debug.hh"
+#include "Util.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+extern "C" {
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+/** "pCFG" in little endian, also detects byte order mismatches. */
+static const uint32_t CACHE_MAGIC = 0x47464370;
+/** Increase on any change to the file format or tree semantics. */
+static const uint32_t CACHE_VERSION = 1;
+
+// The file consists of the header followed by arrays of each record
+// type in the order below and finally the string table. Strings are
+// referred to by offset into the string table and stored as a 32-bit
+// length followed by the data, padded to 4 bytes. All sizes keep the
+// records aligned when the file is mapped.
+
+struct CacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t src;
+	uint32_t overwrite;
+	uint32_t num_files;
+	uint32_t num_env;
+	uint32_t num_vars_in;
+	uint32_t num_vars;
+	uint32_t num_nodes;
+	uint32_t strings_size;
+};
+
+struct CacheFile {
+	uint64_t hash;
+	uint32_t name;
+	uint32_t exists;
+};
+
+struct CacheEnv {
+	uint32_t name;
+	uint32_t value;
+	uint32_t type;
+};
+
+struct CacheVar {
+	uint32_t name;
+	uint32_t value;
+};
+
+/**
+ * Entry, followed by its section if any and then its entries.
+ */
+struct CacheNode {
+	uint32_t name;
+	uint32_t value;
+	uint32_t source;
+	int32_t line;
+	uint32_t num_entries;
+	uint32_t has_section;
+};
+
+template<typename T>
+static void
+appendRecords(std::string &data, const std::vector<T> &records, size_t size)
+{
+	if (! records.empty()) {
+		data.append(reinterpret_cast<const char*>(&records[0]),
+			    records.size() * size);
+	}
+}
+
+/**
+ * Serializes cache content.
+ */
+class CfgParserCache::Writer {
+public:
+	uint32_t addString(const std::string &str);
+	void addNode(const CfgParser::Entry *entry);
+
+	std::string strings;
+	std::vector<CacheNode> nodes;
+
+private:
+	/** Offset of strings already added. */
+	std::map<std::string, uint32_t> _offsets;
+};
+
+uint32_t
+CfgParserCache::Writer::addString(const std::string &str)
+{
+	std::map<std::string, uint32_t>::iterator it = _offsets.find(str);
+	if (it != _offsets.end()) {
+		return it->second;
+	}
+
+	uint32_t offset = strings.size();
+	uint32_t len = str.size();
+	strings.append(reinterpret_cast<const char*>(&len), sizeof(len));
+	strings.append(str);
+	strings.append((4 - strings.size() % 4) % 4, '\0');
+	_offsets[str] = offset;
+	return offset;
+}
+
+void
+CfgParserCache::Writer::addNode(const CfgParser::Entry *entry)
+{
+	size_t pos = nodes.size();
+	nodes.push_back(CacheNode());
+	nodes[pos].name = addString(entry->getName());
+	nodes[pos].value = addString(entry->getValue());
+	nodes[pos].source = addString(entry->getSourceName());
+	nodes[pos].line = entry->getLine();
+	nodes[pos].num_entries = entry->end() - entry->begin();
+
+	CfgParser::Entry *section =
+		const_cast<CfgParser::Entry*>(entry)->getSection();
+	nodes[pos].has_section = section != nullptr;
+	if (section) {
+		addNode(section);
+	}
+
+	CfgParser::Entry::entry_cit it = entry->begin();
+	for (; it != entry->end(); ++it) {
+		addNode(*it);
+	}
+}
+
+/**
+ * Bounds checked access to a mapped cache file.
+ */
+class CfgParserCache::Reader {
+public:
+	Reader(const char *data, size_t size);
+
+	bool isValid(void) const { return _header != nullptr; }
+	const CacheHeader &header(void) const { return *_header; }
+	const CacheFile *files(void) const { return _files; }
+	const CacheEnv *env(void) const { return _env; }
+	const CacheVar *varsIn(void) const { return _vars_in; }
+	const CacheVar *vars(void) const { return _vars; }
+	const CacheNode *nodes(void) const { return _nodes; }
+
+	bool getString(uint32_t offset, std::string &str) const;
+	bool readEntries(CfgParser::Entry *entry, const CacheNode &node,
+			 uint32_t &idx) const;
+
+private:
+	CfgParser::Entry *readNode(uint32_t &idx) const;
+
+	const CacheHeader *_header;
+	const CacheFile *_files;
+	const CacheEnv *_env;
+	const CacheVar *_vars_in;
+	const CacheVar *_vars;
+	const CacheNode *_nodes;
+	const char *_strings;
+
+	/** Re-used when reading nodes, saves an allocation per string. */
+	mutable std::string _name;
+	mutable std::string _value;
+	mutable std::string _source;
+};
+
+CfgParserCache::Reader::Reader(const char *data, size_t size)
+	: _header(nullptr),
+	  _files(nullptr),
+	  _env(nullptr),
+	  _vars_in(nullptr),
+	  _vars(nullptr),
+	  _nodes(nullptr),
+	  _strings(nullptr)
+{
+	if (size < sizeof(CacheHeader)) {
+		return;
+	}
+
+	const CacheHeader *header = reinterpret_cast<const CacheHeader*>(data);
+	if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION) {
+		return;
+	}
+
+	// counts are 32-bit, compute in 64-bit to avoid overflow
+	uint64_t expected = sizeof(CacheHeader)
+		+ uint64_t(header->num_files) * sizeof(CacheFile)
+		+ uint64_t(header->num_env) * sizeof(CacheEnv)
+		+ uint64_t(header->num_vars_in) * sizeof(CacheVar)
+		+ uint64_t(header->num_vars) * sizeof(CacheVar)
+		+ uint64_t(header->num_nodes) * sizeof(CacheNode)
+		+ header->strings_size;
+	if (expected != size || header->num_nodes == 0) {
+		return;
+	}
+
+	const char *pos = data + sizeof(CacheHeader);
+	_files = reinterpret_cast<const CacheFile*>(pos);
+	pos += header->num_files * sizeof(CacheFile);
+	_env = reinterpret_cast<const CacheEnv*>(pos);
+	pos += header->num_env * sizeof(CacheEnv);
+	_vars_in = reinterpret_cast<const CacheVar*>(pos);
+	pos += header->num_vars_in * sizeof(CacheVar);
+	_vars = reinterpret_cast<const CacheVar*>(pos);
+	pos += header->num_vars * sizeof(CacheVar);
+	_nodes = reinterpret_cast<const CacheNode*>(pos);
+	pos += header->num_nodes * sizeof(CacheNode);
+	_strings = pos;
+	_header = header;
+}
+
+bool
+CfgParserCache::Reader::getString(uint32_t offset, std::string &str) const
+{
+	uint32_t size = _header->strings_size;
+	if (offset % 4 || size < sizeof(uint32_t)
+	    || offset > size - sizeof(uint32_t)) {
+		return false;
+	}
+
+	uint32_t len = *reinterpret_cast<const uint32_t*>(_strings + offset);
+	offset += sizeof(uint32_t);
+	if (len > size - offset) {
+		return false;
+	}
+	str.assign(_strings + offset, len);
+	return true;
+}
+
+/**
+ * Read section and entries of node into entry, idx is the index of the
+ * next node to read and is updated as nodes are read.
+ */
+bool
+CfgParserCache::Reader::readEntries(CfgParser::Entry *entry,
+				    const CacheNode &node,
+				    uint32_t &idx) const
+{
+	if (node.has_section) {
+		CfgParser::Entry *section = readNode(idx);
+		if (section == nullptr) {
+			return false;
+		}
+		entry->setSection(section);
+	}
+
+	for (uint32_t i = 0; i < node.num_entries; i++) {
+		CfgParser::Entry *child = readNode(idx);
+		if (child == nullptr) {
+			return false;
+		}
+		entry->addEntry(child);
+	}
+	return true;
+}
+
+CfgParser::Entry*
+CfgParserCache::Reader::readNode(uint32_t &idx) const
+{
+	if (idx >= _header->num_nodes) {
+		return nullptr;
+	}
+
+	const CacheNode &node = _nodes[idx++];
+	if (! getString(node.name, _name) || ! getString(node.value, _value)
+	    || ! getString(node.source, _source)) {
+		return nullptr;
+	}
+
+	CfgParser::Entry *entry =
+		new CfgParser::Entry(_source, node.line, _name, _value);
+	if (! readEntries(entry, node, idx)) {
+		delete entry;
+		return nullptr;
+	}
+	return entry;
+}
+
+std::string CfgParserCache::_dir;
+
+/**
+ * Start recording of a parse.
+ *
+ * @param vars Variables defined before parsing.
+ */
+CfgParserCache::CfgParserCache(const CfgParser::var_map &vars)
+	: _vars(vars)
+{
+}
+
+CfgParserCache::~CfgParserCache(void)
+{
+}
+
+/**
+ * Set directory cache files are stored in, created if missing. An empty
+ * dir disables the cache.
+ *
+ * @return true if the cache is enabled.
+ */
+bool
+CfgParserCache::setDir(const std::string &dir)
+{
+	_dir = "";
+	if (dir.empty()) {
+		return false;
+	}
+
+	// create parent as well, ~/.cache might not exist.
+	std::string parent = Util::getDir(dir);
+	if (! parent.empty() && mkdir(parent.c_str(), 0700) && errno != EEXIST) {
+		P_DBG("failed to create " << parent << ": " << strerror(errno));
+		return false;
+	}
+	if (mkdir(dir.c_str(), 0700) && errno != EEXIST) {
+		P_DBG("failed to create " << dir << ": " << strerror(errno));
+		return false;
+	}
+
+	_dir = dir;
+	return true;
+}
+
+/**
+ * Get default cache directory, $XDG_CACHE_HOME/pekwm or
+ * ~/.cache/pekwm. Empty if neither $XDG_CACHE_HOME or $HOME is set.
+ */
+std::string
+CfgParserCache::getDefaultDir(void)
+{
+	std::string dir = Util::getEnv("XDG_CACHE_HOME");
+	if (dir.empty()) {
+		dir = Util::getEnv("HOME");
+		if (dir.empty()) {
+			return "";
+		}
+		dir += "/.cache";
+	}
+	return dir + "/pekwm";
+}
+
+/**
+ * Get path of cache file for src.
+ */
+std::string
+CfgParserCache::getPath(const std::string &src, bool overwrite)
+{
+	uint64_t src_hash = hash(src);
+	char name[32];
+	snprintf(name, sizeof(name), "/cfg-%08x%08x%s",
+		 static_cast<uint>(src_hash >> 32),
+		 static_cast<uint>(src_hash & 0xffffffff),
+		 overwrite ? "-o" : "");
+	return _dir + name;
+}
+
+/**
+ * Load cached tree for src into cfg, cfg is expected to be empty.
+ *
+ * @return true if the cache was up to date and loaded.
+ */
+bool
+CfgParserCache::load(CfgParser &cfg, const std::string &src, bool overwrite)
+{
+	std::string path = getPath(src, overwrite);
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+
+	struct stat sb;
+	void *data = MAP_FAILED;
+	if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+		data = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	Reader reader(static_cast<const char*>(data), sb.st_size);
+	bool loaded = false;
+	if (! reader.isValid()) {
+		P_DBG("invalid cache file " << path);
+	} else if (isUpToDate(reader, cfg, src, overwrite)) {
+		loaded = apply(reader, cfg);
+		if (loaded) {
+			P_TRACE("loaded " << src << " from cache " << path);
+		} else {
+			P_DBG("invalid cache file " << path);
+		}
+	} else {
+		P_TRACE("cache " << path << " for " << src << " is stale");
+	}
+
+	munmap(data, sb.st_size);
+	return loaded;
+}
+
+/**
+ * Check that the source, variables, environment and content of all files
+ * the cache was built from are unchanged.
+ */
+bool
+CfgParserCache::isUpToDate(const Reader &reader, CfgParser &cfg,
+			   const std::string &src, bool overwrite)
+{
+	const CacheHeader &header = reader.header();
+	std::string name, value;
+	if (! reader.getString(header.src, name) || name != src
+	    || header.overwrite != static_cast<uint32_t>(overwrite)
+	    || header.num_vars_in != cfg._var_map.size()) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.num_vars_in; i++) {
+		const CacheVar &var = reader.varsIn()[i];
+		if (! reader.getString(var.name, name)
+		    || ! reader.getString(var.value, value)) {
+			return false;
+		}
+		CfgParser::var_map_cit it = cfg._var_map.find(name);
+		if (it == cfg._var_map.end() || it->second != value) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < header.num_env; i++) {
+		const CacheEnv &env = reader.env()[i];
+		if (env.type == ENV_SET) {
+			continue;
+		}
+		if (! reader.getString(env.name, name)
+		    || ! reader.getString(env.value, value)) {
+			return false;
+		}
+		const char *current = getenv(name.c_str());
+		if (env.type == ENV_GET_UNSET
+		    ? current != nullptr
+		    : current == nullptr || value != current) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < header.num_files; i++) {
+		const CacheFile &file = reader.files()[i];
+		if (! reader.getString(file.name, name)) {
+			return false;
+		}
+
+		// open the same way as the parser does, a file that failed
+		// to open must still fail.
+		CfgParserSourceFile source(name);
+		try {
+			source.open();
+		} catch (std::string&) {
+			if (file.exists) {
+				return false;
+			}
+			continue;
+		}
+		uint64_t content_hash = hash(source.getData());
+		source.close();
+		if (! file.exists || content_hash != file.hash) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Read tree into cfg and apply the side effects of the parse, setting
+ * variables and environment.
+ */
+bool
+CfgParserCache::apply(const Reader &reader, CfgParser &cfg)
+{
+	const CacheHeader &header = reader.header();
+
+	// read into a new root, the parser is left as is if the nodes are
+	// invalid keeping variables and overwrite for parsing the source.
+	CfgParser::Entry *root =
+		new CfgParser::Entry(CfgParser::_root_source_name, 0, "ROOT", "");
+	uint32_t idx = 1;
+	if (! reader.readEntries(root, reader.nodes()[0], idx)
+	    || idx != header.num_nodes) {
+		delete root;
+		return false;
+	}
+	delete cfg._root_entry;
+	cfg._root_entry = root;
+	cfg._section = root;
+
+	std::string name, value;
+	for (uint32_t i = 0; i < header.num_env; i++) {
+		const CacheEnv &env = reader.env()[i];
+		if (env.type == ENV_SET && reader.getString(env.name, name)
+		    && reader.getString(env.value, value)) {
+			setenv(name.c_str(), value.c_str(), 1);
+		}
+	}
+	for (uint32_t i = 0; i < header.num_vars; i++) {
+		const CacheVar &var = reader.vars()[i];
+		if (reader.getString(var.name, name)
+		    && reader.getString(var.value, value)) {
+			cfg._var_map[name] = value;
+		}
+	}
+	for (uint32_t i = 0; i < header.num_files; i++) {
+		const CacheFile &file = reader.files()[i];
+		if (file.exists && reader.getString(file.name, name)) {
+			cfg._cfg_files.files.push_back(name);
+			time_t mtime = Util::getMtime(name);
+			if (cfg._cfg_files.mtime < mtime) {
+				cfg._cfg_files.mtime = mtime;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Save tree parsed from src by cfg, together with the recorded
+ * dependencies.
+ */
+bool
+CfgParserCache::save(CfgParser &cfg, const std::string &src, bool overwrite)
+{
+	Writer writer;
+
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.src = writer.addString(src);
+	header.overwrite = overwrite;
+	header.num_files = _files.size();
+	header.num_env = _env.size();
+	header.num_vars_in = _vars.size();
+	header.num_vars = cfg._var_map.size();
+
+	std::vector<CacheFile> files;
+	std::vector<File>::const_iterator fit = _files.begin();
+	for (; fit != _files.end(); ++fit) {
+		CacheFile file;
+		file.hash = fit->hash;
+		file.name = writer.addString(fit->name);
+		file.exists = fit->exists;
+		files.push_back(file);
+	}
+
+	std::vector<CacheEnv> env;
+	std::vector<Env>::const_iterator eit = _env.begin();
+	for (; eit != _env.end(); ++eit) {
+		CacheEnv e;
+		e.name = writer.addString(eit->name);
+		e.value = writer.addString(eit->value);
+		e.type = eit->type;
+		env.push_back(e);
+	}
+
+	std::vector<CacheVar> vars;
+	const CfgParser::var_map *var_maps[] = {&_vars, &cfg._var_map};
+	for (int i = 0; i < 2; i++) {
+		CfgParser::var_map_cit vit = var_maps[i]->begin();
+		for (; vit != var_maps[i]->end(); ++vit) {
+			CacheVar var;
+			var.name = writer.addString(vit->first);
+			var.value = writer.addString(vit->second);
+			vars.push_back(var);
+		}
+	}
+
+	writer.addNode(cfg.getEntryRoot());
+	header.num_nodes = writer.nodes.size();
+	header.strings_size = writer.strings.size();
+
+	std::string data(reinterpret_cast<const char*>(&header), sizeof(header));
+	appendRecords(data, files, sizeof(CacheFile));
+	appendRecords(data, env, sizeof(CacheEnv));
+	appendRecords(data, vars, sizeof(CacheVar));
+	appendRecords(data, writer.nodes, sizeof(CacheNode));
+	data.append(writer.strings);
+
+	// write to a temporary file and rename, readers never see a
+	// partially written cache.
+	std::string path = getPath(src, overwrite);
+	std::string tmp_path = path + "." + std::to_string(getpid());
+	int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd == -1) {
+		P_DBG("failed to create " << tmp_path << ": " << strerror(errno));
+		return false;
+	}
+
+	const char *pos = data.c_str();
+	size_t left = data.size();
+	while (left > 0) {
+		ssize_t written = write(fd, pos, left);
+		if (written == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			P_DBG("failed to write " << tmp_path << ": "
+			      << strerror(errno));
+			::close(fd);
+			unlink(tmp_path.c_str());
+			return false;
+		}
+		pos += written;
+		left -= written;
+	}
+	::close(fd);
+
+	if (rename(tmp_path.c_str(), path.c_str())) {
+		P_DBG("failed to rename " << tmp_path << ": " << strerror(errno));
+		unlink(tmp_path.c_str());
+		return false;
+	}
+	P_TRACE("saved " << src << " to cache " << path);
+	return true;
+}
+
+/**
+ * Record file opened while parsing.
+ */
+void
+CfgParserCache::addFile(const std::string &name, const std::string &data)
+{
+	_files.push_back(File(name, hash(data), true));
+}
+
+/**
+ * Record file that failed to open while parsing.
+ */
+void
+CfgParserCache::addMissing(const std::string &name)
+{
+	_files.push_back(File(name, 0, false));
+}
+
+/**
+ * Record environment variable read while parsing, only the first read
+ * not preceded by a set is recorded.
+ */
+void
+CfgParserCache::addEnvGet(const std::string &name, const char *value)
+{
+	if (_env_names.insert(name).second) {
+		_env.push_back(Env(name, value ? value : "",
+				   value ? ENV_GET : ENV_GET_UNSET));
+	}
+}
+
+/**
+ * Record environment variable set while parsing.
+ */
+void
+CfgParserCache::addEnvSet(const std::string &name, const std::string &value)
+{
+	_env_names.insert(name);
+	_env.push_back(Env(name, value, ENV_SET));
+}
+
+/**
+ * 64-bit FNV-1a hash of data.
+ */
+uint64_t
+CfgParserCache::hash(const std::string &data)
+{
+	// constants built from 32-bit halves, C++98 lacks long long
+	// literals.
+	const uint64_t prime = (uint64_t(0x100) << 32) | 0x1b3;
+	uint64_t hash = (uint64_t(0xcbf29ce4) << 32) | 0x84222325;
+	std::string::const_iterator it = data.begin();
+	for (; it != data.end(); ++it) {
+		hash ^= static_cast<uchar>(*it);
+		hash *= prime;
+	}
+	return hash;
+}
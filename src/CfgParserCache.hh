@@ -0,0 +1,109 @@
+//
+// CfgParserCache.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#ifndef _PEKWM_CFGPARSERCACHE_HH_
+#define _PEKWM_CFGPARSERCACHE_HH_
+
+#include "config.h"
+
+#include "CfgParser.hh"
+#include "Types.hh"
+
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Cache of parsed CfgParser trees, stored in a binary file per parsed
+ * source that is mapped into memory when loaded.
+ *
+ * While parsing, the content hash of every file opened, files that
+ * failed to open, environment variables read and set and the variables
+ * defined before parsing are recorded. The cache is used only if all of
+ * them are unchanged, otherwise the source is parsed again and the cache
+ * is replaced. Content from COMMAND is never cached.
+ */
+class CfgParserCache {
+public:
+	CfgParserCache(const CfgParser::var_map &vars);
+	~CfgParserCache(void);
+
+	/** Return true if caching is enabled, see setDir. */
+	static bool isEnabled(void) { return ! _dir.empty(); }
+	static bool setDir(const std::string &dir);
+	static std::string getDefaultDir(void);
+	static std::string getPath(const std::string &src, bool overwrite);
+
+	static bool load(CfgParser &cfg, const std::string &src,
+			 bool overwrite);
+	bool save(CfgParser &cfg, const std::string &src, bool overwrite);
+
+	void addFile(const std::string &name, const std::string &data);
+	void addMissing(const std::string &name);
+	void addEnvGet(const std::string &name, const char *value);
+	void addEnvSet(const std::string &name, const std::string &value);
+
+	static uint64_t hash(const std::string &data);
+
+private:
+	enum EnvType {
+		ENV_GET,
+		ENV_GET_UNSET,
+		ENV_SET
+	};
+
+	class File {
+	public:
+		File(const std::string &name_, uint64_t hash_, bool exists_)
+			: name(name_),
+			  hash(hash_),
+			  exists(exists_)
+		{
+		}
+
+		std::string name;
+		uint64_t hash;
+		bool exists;
+	};
+
+	class Env {
+	public:
+		Env(const std::string &name_, const std::string &value_,
+		    EnvType type_)
+			: name(name_),
+			  value(value_),
+			  type(type_)
+		{
+		}
+
+		std::string name;
+		std::string value;
+		EnvType type;
+	};
+
+	class Reader;
+	class Writer;
+
+	static bool isUpToDate(const Reader &reader, CfgParser &cfg,
+			       const std::string &src, bool overwrite);
+	static bool apply(const Reader &reader, CfgParser &cfg);
+
+	/** Directory cache files are stored in, empty if disabled. */
+	static std::string _dir;
+
+	/** Variables defined before parsing. */
+	CfgParser::var_map _vars;
+	/** Files opened, or failed to open, in order. */
+	std::vector<File> _files;
+	/** Environment read and set, in order. */
+	std::vector<Env> _env;
+	/** Environment variables already recorded. */
+	std::set<std::string> _env_names;
+};
+
+#endif // _PEKWM_CFGPARSERCACHE_HH_
@@ -7,24 +7,28 @@
 
 #include "Compat.hh"
 #include "CfgParserSource.hh"
+#include "ChildRegistry.hh"
 #include "Util.hh"
 
-#include <iostream>
-#include <cstdio>
-#include <cstdlib>
+#include <algorithm>
+#include <cstring>
 
 extern "C" {
-#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 }
 
-unsigned int CfgParserSourceCommand::_sigaction_counter = 0;
+/** Size of reads when reading source content. */
+static const size_t CFG_PARSER_SOURCE_READ_SIZE = 64 * 1024;
 
 CfgParserSource::CfgParserSource(const std::string &source)
 	: _name(source),
 	  _type(SOURCE_VIRTUAL),
 	  _line(0),
-	  _is_dynamic(false)
+	  _is_dynamic(false),
+	  _pos(0)
 {
 }
 
@@ -32,42 +36,106 @@ CfgParserSource::~CfgParserSource (void)
 {
 }
 
+/**
+ * Get run of characters up to, not including, the first character in
+ * stop or the end of the source. Line count is updated with any \n in
+ * the run.
+ *
+ * @param len Set to the length of the run.
+ * @return Pointer to the run, valid until the source is closed.
+ */
+const char*
+CfgParserSource::get_span(const char *stop, size_t &len)
+{
+	// _data is always NUL terminated, a NUL in the data ends the run
+	// early and is returned by get_char.
+	const char *span = _data.c_str() + _pos;
+	len = strcspn(span, stop);
+	_pos += len;
+	if (strchr(stop, '\n') == nullptr) {
+		_line += std::count(span, span + len, '\n');
+	}
+	return span;
+}
+
+/**
+ * Read all data from fd into the source buffer.
+ */
+bool
+CfgParserSource::read_fd(int fd)
+{
+	reset();
+
+	struct stat sb;
+	if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+		_data.reserve(sb.st_size);
+	}
+
+	char buf[CFG_PARSER_SOURCE_READ_SIZE];
+	for (;;) {
+		ssize_t nread = read(fd, buf, sizeof(buf));
+		if (nread > 0) {
+			_data.append(buf, nread);
+		} else if (nread == 0) {
+			return true;
+		} else if (errno != EINTR) {
+			return false;
+		}
+	}
+}
+
+/**
+ * Clear buffer and reset position.
+ */
+void
+CfgParserSource::reset(void)
+{
+	_data.clear();
+	_pos = 0;
+}
+
 /**
  * Open file based configuration source.
  */
 bool
 CfgParserSourceFile::open(void)
 {
-	if (_file) {
+	if (_open) {
 		throw std::string("TRYING TO OPEN ALREADY OPEN SOURCE");
 	}
 
-	_file = fopen(_name.c_str(), "r");
-	if (! _file) {
+	int fd = ::open(_name.c_str(), O_RDONLY);
+	if (fd == -1) {
 		throw std::string("failed to open file " + _name);
 	}
+	bool ok = read_fd(fd);
+	::close(fd);
+	if (! ok) {
+		throw std::string("failed to read file " + _name);
+	}
 
+	_open = true;
 	return true;
 }
 
 void
 CfgParserSourceFile::close(void)
 {
-	if (! _file) {
+	if (! _open) {
 		throw std::string("trying to close already closed source");
 	}
 
-	fclose(_file);
-	_file = 0;
+	reset();
+	_open = false;
 }
 
 
 CfgParserSourceString::CfgParserSourceString(const std::string &source,
                                              const std::string &data)
-	: CfgParserSource(source),
-	  _data(data)
+	: CfgParserSource(source)
 {
-	_pos = _data.begin();
+	_type = SOURCE_STRING;
+	_data = data;
 }
 
 CfgParserSourceString::~CfgParserSourceString(void)
@@ -77,81 +145,37 @@ CfgParserSourceString::~CfgParserSourceString(void)
 bool
 CfgParserSourceString::open(void)
 {
-	_pos = _data.begin();
+	_pos = 0;
 	return true;
 }
 
 void
 CfgParserSourceString::close(void)
 {
-	_pos = _data.end();
-}
-
-int
-CfgParserSourceString::get_char(void)
-{
-	if (_pos == _data.end()) {
-		return EOF;
-	}
-	return CfgParserSource::do_get_char(*_pos++);
-}
-
-void
-CfgParserSourceString::unget_char(int c)
-{
-	if (_pos != _data.begin()) {
-		CfgParserSource::unget_char(*_pos--);
-	}
+	_pos = _data.size();
 }
 
 /**
- * Run command and treat output as configuration source.
+ * Run command and treat output as configuration source, the output is
+ * read until the command closes stdout.
  */
 bool
 CfgParserSourceCommand::open(void)
 {
 	int fd[2];
-	int status;
-
-	status = pipe(fd);
-	if (status == -1) {
+	if (! ChildRegistry::openPipe(fd)) {
 		return false;
 	}
 
-	// Remove signal handler while parsing as otherwise reading from the
-	// pipe will break sometimes.
-	if (_sigaction_counter++ == 0) {
-		struct sigaction action;
-
-		action.sa_handler = SIG_DFL;
-		action.sa_mask = sigset_t();
-		action.sa_flags = 0;
-
-		sigaction(SIGCHLD, &action, &_sigaction);
-	}
-
-	_pid = fork();
-	if (_pid == -1) { // Error
-		return false;
-
-	} else if (_pid == 0) { // Child
-		dup2(fd[1], STDOUT_FILENO);
-
+	_pid = ChildRegistry::spawnShell(_name, fd[1], false, nullptr, nullptr);
+	::close(fd[1]);
+	if (_pid == -1) {
 		::close(fd[0]);
-		::close(fd[1]);
-
-		execlp("/bin/sh", "sh", "-c", _name.c_str(), (char *) 0);
-
-		::close (STDOUT_FILENO);
-
-		exit (1);
-
-	} else { // Parent
-
-		::close (fd[1]);
-
-		_file = ::fdopen(fd[0], "r");
+		return false;
 	}
+
+	read_fd(fd[0]);
+	::close(fd[0]);
 	return true;
 }
 
@@ -161,27 +185,11 @@ CfgParserSourceCommand::open(void)
 void
 CfgParserSourceCommand::close(void)
 {
-	if (_sigaction_counter < 1) {
+	if (_pid == -1) {
 		return;
 	}
-	_sigaction_counter--;
 
-	// Close source.
-	fclose(_file);
-
-	// Wait for process.
-	int status;
-	int pid_status;
-
-	status = waitpid(_pid, &pid_status, 0);
-
-	// If no other open CfgParserSourceCommand open, restore sigaction.
-	if (_sigaction_counter == 0) {
-		sigaction(SIGCHLD, &_sigaction, 0);
-	}
-
-	// Wait failed, throw error
-	if (status == -1) {
-		std::string msg = "failed to wait for pid " + std::to_string(_pid);
-	}
+	reset();
+	ChildRegistry::wait(_pid);
+	_pid = -1;
 }
@@ -13,8 +13,6 @@
 
 extern "C" {
 #include <sys/types.h>
-#include <sys/wait.h>
-#include <signal.h>
 }
 
 #include "Compat.hh"
@@ -22,6 +20,10 @@ extern "C" {
 /**
  * Base class for configuration sources defining the interface and
  * common methods.
+ *
+ * The content of a source is read into memory when opened, characters
+ * are then read from the buffer without a call per character and runs
+ * of characters can be taken with get_span.
  */
 class CfgParserSource
 {
@@ -42,13 +44,35 @@ public:
 	virtual bool open(void) = 0;
 	virtual void close(void) = 0;
 
-	virtual int get_char(void) = 0;
-	virtual void unget_char(int c) {
+	/**
+	 * Get next character, increments line count if \n.
+	 */
+	int get_char(void) {
+		if (_pos == _data.size()) {
+			return EOF;
+		}
+		unsigned char c = _data[_pos++];
 		if (c == '\n') {
-			--_line;
+			++_line;
 		}
+		return c;
 	}
 
+	/**
+	 * Give back the last character read, decrements line count if \n.
+	 */
+	void unget_char(int c) {
+		if (c != EOF && _pos > 0) {
+			if (_data[--_pos] == '\n') {
+				--_line;
+			}
+		}
+	}
+
+	const char *get_span(const char *stop, size_t &len);
+
+	/**< Return content of source, available while open. */
+	const std::string &getData(void) const { return _data; }
 	/**< Return name of source. */
 	const std::string &getName(void) const { return _name; }
 	/**< Return type of source. */
@@ -59,56 +83,31 @@ public:
 	bool isDynamic(void) const { return _is_dynamic; }
 
 protected:
-	int do_get_char(int c) {
-		if (c == '\n') {
-			++_line;
-		}
-		return c;
-	}
+	bool read_fd(int fd);
+	void reset(void);
 
 protected:
 	std::string _name; /**< Name of source. */
 	CfgParserSource::Type _type; /**< Type of source. */
 	uint _line; /**< Line number. */
 	bool _is_dynamic; /**< Set to true if source has dynamic content. */
-};
 
-class CfgParserSourceFp : public CfgParserSource
-{
-public:
-	CfgParserSourceFp(const std::string& source)
-		: CfgParserSource(source),
-		  _file(nullptr)
-	{
-	}
-
-	/**
-	 * Gets a character from _file, increments line count if \n.
-	 */
-	virtual int get_char(void) {
-		return do_get_char(fgetc(_file));
-	}
-
-	/**
-	 * Returns a character to _op_file, decrements line count if \n.
-	 */
-	virtual void unget_char(int c) {
-		return CfgParserSource::unget_char(ungetc(c, _file));
-	}
-
-protected:
-	std::FILE *_file; /**< FILE object source is reading from. */
+	/** Content of source. */
+	std::string _data;
+	/** Position of next character in _data. */
+	size_t _pos;
 };
 
 /**
  * File based configuration source, reads data from a plain file on
  * disk.
  */
-class CfgParserSourceFile : public CfgParserSourceFp
+class CfgParserSourceFile : public CfgParserSource
 {
 public:
 	CfgParserSourceFile(const std::string &source)
-		: CfgParserSourceFp(source)
+		: CfgParserSource(source),
+		  _open(false)
 	{
 		_type = SOURCE_FILE;
 	}
@@ -116,6 +115,9 @@ public:
 
 	virtual bool open(void);
 	virtual void close(void);
+
+private:
+	bool _open;
 };
 
 /**
@@ -129,24 +131,18 @@ public:
 
 	virtual bool open(void);
 	virtual void close(void);
-
-	virtual int get_char(void);
-	virtual void unget_char(int c);
-
-private:
-	std::string _data;
-	std::string::iterator _pos;
 };
 
 /**
  * Command based configuration source, executes a commands and parses
  * the output.
  */
-class CfgParserSourceCommand : public CfgParserSourceFp
+class CfgParserSourceCommand : public CfgParserSource
 {
 public:
 	CfgParserSourceCommand(const std::string &source)
-		: CfgParserSourceFp(source)
+		: CfgParserSource(source),
+		  _pid(-1)
 	{
 		_type = SOURCE_COMMAND;
 		_is_dynamic = true;
@@ -158,8 +154,6 @@ public:
 
 private:
 	pid_t _pid; /**< Process id of command generating output. */
-	struct sigaction _sigaction; /**< sigaction for restore. */
-	static unsigned int _sigaction_counter; /**< Counts open. */
 };
 
 #endif // _PEKWM_CFGPARSERSOURCE_HH_
@@ -0,0 +1,234 @@
+//
+// ChildRegistry.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "ChildRegistry.hh"
+#include "Debug.hh"
+#include "Util.hh"
+
+#include <cstring>
+
+extern "C" {
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+}
+
+std::map<pid_t, ChildRegistry::Entry> ChildRegistry::_children;
+
+/**
+ * Reap children whenever SIGCHLD is dispatched by mainloop.
+ */
+void
+ChildRegistry::attach(Mainloop &mainloop)
+{
+	mainloop.addSignal(SIGCHLD, handleSignal, nullptr);
+}
+
+/**
+ * Create pipe for reading the output of a child, both ends are closed
+ * on exec so children do not inherit the read end of their own or any
+ * other pipe. The write end is still stdout of the child it is given
+ * to.
+ *
+ * @return true on success.
+ */
+bool
+ChildRegistry::openPipe(int fd[2])
+{
+	if (pipe(fd) == -1) {
+		P_ERR("failed to create pipe: " << strerror(errno));
+		return false;
+	}
+	Util::setCloseOnExec(fd[0]);
+	Util::setCloseOnExec(fd[1]);
+	return true;
+}
+
+/**
+ * Start args[0], searched for in PATH, with args.
+ *
+ * @param stdout_fd File descriptor used as stdout in the child, closed
+ *                  in the child. -1 to inherit stdout.
+ * @param new_session Start child in a new session, detaching it.
+ * @param fun Called with the wait status once the child exits.
+ * @return pid of child, -1 on failure.
+ */
+pid_t
+ChildRegistry::spawn(const std::vector<std::string> &args,
+		     int stdout_fd, bool new_session,
+		     doneFun fun, void *opaque)
+{
+	if (args.empty()) {
+		P_ERR("no command given to spawn");
+		return -1;
+	}
+
+	std::vector<char*> argv;
+	std::vector<std::string>::const_iterator it = args.begin();
+	for (; it != args.end(); ++it) {
+		argv.push_back(const_cast<char*>(it->c_str()));
+	}
+	argv.push_back(nullptr);
+
+	pid_t pid = doSpawn(argv[0], true, &argv[0], stdout_fd, new_session);
+	if (pid != -1 && fun) {
+		add(pid, fun, opaque);
+	}
+	return pid;
+}
+
+/**
+ * Start command using /bin/sh, see spawn.
+ */
+pid_t
+ChildRegistry::spawnShell(const std::string &command,
+			  int stdout_fd, bool new_session,
+			  doneFun fun, void *opaque)
+{
+	if (command.empty()) {
+		P_ERR("command length == 0");
+		return -1;
+	}
+
+	char *argv[] = {
+		const_cast<char*>("sh"),
+		const_cast<char*>("-c"),
+		const_cast<char*>(command.c_str()),
+		nullptr
+	};
+	pid_t pid = doSpawn("/bin/sh", false, argv, stdout_fd, new_session);
+	if (pid != -1 && fun) {
+		add(pid, fun, opaque);
+	}
+	return pid;
+}
+
+/**
+ * Register callback for pid, called once the child has been reaped.
+ */
+void
+ChildRegistry::add(pid_t pid, doneFun fun, void *opaque)
+{
+	_children.erase(pid);
+	_children.insert(std::make_pair(pid, Entry(fun, opaque)));
+}
+
+/**
+ * Remove callback for pid, the child is still reaped when it exits.
+ */
+void
+ChildRegistry::remove(pid_t pid)
+{
+	_children.erase(pid);
+}
+
+bool
+ChildRegistry::contains(pid_t pid)
+{
+	return _children.find(pid) != _children.end();
+}
+
+/**
+ * Block until pid exits, the registered callback is not called.
+ *
+ * @return wait status of pid, -1 on error.
+ */
+int
+ChildRegistry::wait(pid_t pid)
+{
+	remove(pid);
+
+	int status;
+	while (waitpid(pid, &status, 0) == -1) {
+		if (errno != EINTR) {
+			P_DBG("failed to wait for pid " << pid << ": "
+			      << strerror(errno));
+			return -1;
+		}
+	}
+	return status;
+}
+
+/**
+ * Reap all exited children, calling the registered callbacks.
+ */
+void
+ChildRegistry::reap(void)
+{
+	pid_t pid;
+	int status;
+	while ((pid = waitpid(WAIT_ANY, &status, WNOHANG)) > 0) {
+		P_TRACE("child process " << pid << " finished");
+
+		std::map<pid_t, Entry>::iterator it = _children.find(pid);
+		if (it != _children.end()) {
+			Entry entry = it->second;
+			_children.erase(it);
+			entry.fun(pid, status, entry.opaque);
+		}
+	}
+}
+
+pid_t
+ChildRegistry::doSpawn(const char *path, bool search, char **argv,
+		       int stdout_fd, bool new_session)
+{
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	if (stdout_fd != -1 && stdout_fd != STDOUT_FILENO) {
+		posix_spawn_file_actions_adddup2(&actions, stdout_fd,
+						 STDOUT_FILENO);
+		posix_spawn_file_actions_addclose(&actions, stdout_fd);
+	}
+
+	// signals caught by the mainloop are reset on exec, the mask is
+	// not.
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+	short flags = POSIX_SPAWN_SETSIGMASK;
+	sigset_t mask;
+	sigemptyset(&mask);
+	posix_spawnattr_setsigmask(&attr, &mask);
+	if (new_session) {
+#ifdef POSIX_SPAWN_SETSID
+		flags |= POSIX_SPAWN_SETSID;
+#else // ! POSIX_SPAWN_SETSID
+		flags |= POSIX_SPAWN_SETPGROUP;
+		posix_spawnattr_setpgroup(&attr, 0);
+#endif // POSIX_SPAWN_SETSID
+	}
+	posix_spawnattr_setflags(&attr, flags);
+
+	pid_t pid;
+	int err;
+	if (search) {
+		err = posix_spawnp(&pid, path, &actions, &attr, argv, environ);
+	} else {
+		err = posix_spawn(&pid, path, &actions, &attr, argv, environ);
+	}
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+
+	if (err) {
+		P_ERR("failed to start " << path << ": " << strerror(err));
+		return -1;
+	}
+	P_TRACE("started child " << pid);
+	return pid;
+}
+
+void
+ChildRegistry::handleSignal(int, void*)
+{
+	reap();
+}
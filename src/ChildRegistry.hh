@@ -0,0 +1,76 @@
+//
+// ChildRegistry.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#ifndef _PEKWM_CHILDREGISTRY_HH_
+#define _PEKWM_CHILDREGISTRY_HH_
+
+#include "config.h"
+
+#include "Mainloop.hh"
+
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sys/types.h>
+}
+
+/**
+ * Registry of child processes shared by all pekwm binaries.
+ *
+ * Children are started with posix_spawn, avoiding the copy of the page
+ * tables done by fork in large processes. Exited children are reaped
+ * from the main loop on SIGCHLD and the wait status is passed to the
+ * callback registered with the child, if any.
+ */
+class ChildRegistry {
+public:
+	typedef void(*doneFun)(pid_t pid, int status, void *opaque);
+
+	static void attach(Mainloop &mainloop);
+
+	static bool openPipe(int fd[2]);
+
+	static pid_t spawn(const std::vector<std::string> &args,
+			   int stdout_fd, bool new_session,
+			   doneFun fun, void *opaque);
+	static pid_t spawnShell(const std::string &command,
+				int stdout_fd, bool new_session,
+				doneFun fun, void *opaque);
+
+	static void add(pid_t pid, doneFun fun, void *opaque);
+	static void remove(pid_t pid);
+	static bool contains(pid_t pid);
+	static size_t size(void) { return _children.size(); }
+
+	static int wait(pid_t pid);
+	static void reap(void);
+
+private:
+	static pid_t doSpawn(const char *path, bool search, char **argv,
+			     int stdout_fd, bool new_session);
+	static void handleSignal(int signal, void *opaque);
+
+	class Entry {
+	public:
+		Entry(doneFun fun_, void *opaque_)
+			: fun(fun_),
+			  opaque(opaque_)
+		{
+		}
+
+		doneFun fun;
+		void *opaque;
+	};
+
+	/** Children with a callback, keyed on pid. */
+	static std::map<pid_t, Entry> _children;
+};
+
+#endif // _PEKWM_CHILDREGISTRY_HH_
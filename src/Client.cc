@@ -13,6 +13,7 @@
 #include "config.h"
 
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <algorithm>
 
@@ -72,6 +73,7 @@ Client::Client(Window new_client, ClientInitConfig &initConfig, bool is_new)
 		X11::ungrabServer(true);
 		return;
 	}
+	prefetchProperties();
 
 	// Get unique Client id
 	_id = findClientID();
@@ -122,6 +124,7 @@ Client::Client(Window new_client, ClientInitConfig &initConfig, bool is_new)
 	// Tell the world about our state
 	updateEwmhStates();
 
+	X11::clearPrefetchedProperties();
 	X11::ungrabServer(true);
 
 	setClientInitConfig(initConfig, is_new, ap);
@@ -231,6 +234,33 @@ Client::getAndUpdateWindowAttributes(void)
 	return true;
 }
 
+/**
+ * Request the properties read during construction in one batch,
+ * avoiding a round-trip for each of them.
+ */
+void
+Client::prefetchProperties(void)
+{
+	static const AtomName names[] = {
+		WM_WINDOW_ROLE, WM_PROTOCOLS, MOTIF_WM_HINTS,
+		NET_WM_NAME, NET_WM_DESKTOP, WINDOW_TYPE, STATE,
+		NET_WM_STRUT, NET_WM_ICON, NET_WM_PID,
+		PEKWM_FRAME_ID, PEKWM_FRAME_ORDER, PEKWM_FRAME_ACTIVE,
+		PEKWM_FRAME_DECOR, PEKWM_FRAME_SKIP, PEKWM_TITLE
+	};
+	const size_t num_names = sizeof(names) / sizeof(names[0]);
+
+	Atom atoms[num_names + 4];
+	atoms[0] = XA_WM_CLASS;
+	atoms[1] = XA_WM_NAME;
+	atoms[2] = XA_WM_TRANSIENT_FOR;
+	atoms[3] = XA_WM_CLIENT_MACHINE;
+	for (size_t i = 0; i < num_names; i++) {
+		atoms[i + 4] = X11::getAtom(names[i]);
+	}
+	X11::prefetchProperties(_window, atoms, num_names + 4);
+}
+
 /**
  * Find frame for client based on tagging, hints and
  * autoproperties. Create a new one if not found and add the client.
@@ -759,9 +789,9 @@ Client::validate(void)
 	X11::sync(False);
 
 	XEvent ev;
-	if (XCheckTypedWindowEvent(X11::getDpy(), _window, DestroyNotify, &ev)
-	    || XCheckTypedWindowEvent(X11::getDpy(), _window, UnmapNotify, &ev)) {
-		XPutBackEvent(X11::getDpy(), &ev);
+	if (X11::checkTypedWindowEvent(_window, DestroyNotify, &ev)
+	    || X11::checkTypedWindowEvent(_window, UnmapNotify, &ev)) {
+		X11::putBackEvent(&ev);
 		return false;
 	}
 
@@ -843,13 +873,18 @@ Client::readHints(void)
 void
 Client::readClassRoleHints(void)
 {
-	// class hint
-	XClassHint class_hint;
-	if (XGetClassHint(X11::getDpy(), _window, &class_hint)) {
-		_class_hint->h_name = class_hint.res_name;
-		_class_hint->h_class = class_hint.res_class;
-		X11::free(class_hint.res_name);
-		X11::free(class_hint.res_class);
+	// class hint, res_name and res_class null separated
+	uchar *data;
+	ulong size;
+	if (X11::getProperty(_window, XA_WM_CLASS, XA_STRING, 0,
+			     &data, &size)) {
+		const char *res_name = reinterpret_cast<const char*>(data);
+		size_t name_len = strlen(res_name);
+		_class_hint->h_name = res_name;
+		if (name_len < size) {
+			_class_hint->h_class = res_name + name_len + 1;
+		}
+		X11::free(data);
 	}
 
 	// wm window role
@@ -1716,11 +1751,12 @@ Client::getWMNormalHints(void)
 void
 Client::getWMProtocols(void)
 {
-	int count;
-	Atom *protocols;
-
-	if (XGetWMProtocols(X11::getDpy(), _window, &protocols, &count) != 0) {
-		for (int i = 0; i < count; ++i) {
+	uchar *data;
+	ulong count;
+	if (X11::getProperty(_window, X11::getAtom(WM_PROTOCOLS), XA_ATOM, 0,
+			     &data, &count)) {
+		Atom *protocols = reinterpret_cast<Atom*>(data);
+		for (ulong i = 0; i < count; ++i) {
 			if (protocols[i] == X11::getAtom(WM_TAKE_FOCUS)) {
 				_send_focus_message = true;
 			} else if (protocols[i] == X11::getAtom(WM_DELETE_WINDOW)) {
@@ -1741,7 +1777,12 @@ Client::getTransientForHint(void)
 	_transient_for_window = None;
 
 	Client *transient_for = nullptr;
-	XGetTransientForHint(X11::getDpy(), _window, &_transient_for_window);
+	uchar *data;
+	if (X11::getProperty(_window, XA_WM_TRANSIENT_FOR, XA_WINDOW, 1,
+			     &data, nullptr)) {
+		_transient_for_window = *reinterpret_cast<Window*>(data);
+		X11::free(data);
+	}
 	if (_transient_for_window != None) {
 		if (_transient_for_window == _window) {
 			P_ERR(this << " client set transient hint for itself");
@@ -287,6 +287,7 @@ public: // Public Member Functions
 
 private:
 	bool getAndUpdateWindowAttributes(void);
+	void prefetchProperties(void);
 
 	bool findOrCreateFrame(AutoProperty *autoproperty);
 	bool findTaggedFrame(void);
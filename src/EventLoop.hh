@@ -10,6 +10,7 @@
 #define _PEKWM_EVENTLOOP_HH_
 
 #include "EventHandler.hh"
+#include "Mainloop.hh"
 
 extern "C" {
 #include <X11/Xlib.h>
@@ -20,7 +21,18 @@ extern "C" {
  */
 class EventLoop {
 public:
+	virtual ~EventLoop(void) { }
+
 	virtual void setEventHandler(EventHandler* event_handler) = 0;
+
+	virtual int addTimer(uint timeout_ms, bool repeat,
+			     Mainloop::timerFun fun, void *opaque) = 0;
+	virtual void removeTimer(int id) = 0;
 };
 
+namespace pekwm
+{
+	EventLoop* eventLoop(void);
+}
+
 #endif // _PEKWM_EVENTLOOP_HH_
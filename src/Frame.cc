@@ -570,7 +570,7 @@ Frame::updatedActiveChild(void)
 		}
 	}
 
-	renderTitle();
+	scheduleRepaint(RepaintScheduler::PART_TITLE);
 }
 
 void
@@ -1080,7 +1080,8 @@ Frame::doGroupingDrag(XMotionEvent *ev, Client *client, bool behind)
 
 	XEvent e;
 	while (true) { // this breaks when we get an button release
-		XMaskEvent(X11::getDpy(), PointerMotionMask|ButtonReleaseMask, &e);
+		pekwm::repaintScheduler()->flush();
+		X11::maskEvent(PointerMotionMask|ButtonReleaseMask, &e);
 
 		switch (e.type)  {
 		case MotionNotify:
@@ -1276,10 +1277,12 @@ Frame::doResize(bool left, bool x, bool top, bool y)
 	XEvent ev;
 	bool exit = false;
 	while (exit != true) {
+		// nested event loop, repaint before waiting for events
+		pekwm::repaintScheduler()->flush();
 		if (outline) {
 			drawOutline(_gm);
 		}
-		XMaskEvent(X11::getDpy(), resize_mask, &ev);
+		X11::maskEvent(resize_mask, &ev);
 		if (outline) {
 			drawOutline(_gm); // clear
 		}
@@ -1814,7 +1817,7 @@ Frame::setStateTitle(StateAction sa, Client *client, const std::string &title)
 	X11::setUtf8String(client->getWindow(), PEKWM_TITLE,
 			   client->getTitle()->getUser());
 
-	renderTitle();
+	scheduleRepaint(RepaintScheduler::PART_TITLE);
 }
 
 //! @brief Sets clients marked state.
@@ -1829,7 +1832,7 @@ Frame::setStateMarked(StateAction sa, Client *client)
 
 	// Set marked state and re-render title to update visual marker.
 	client->setStateMarked(sa);
-	renderTitle();
+	scheduleRepaint(RepaintScheduler::PART_TITLE);
 }
 
 void
@@ -2485,7 +2488,7 @@ Frame::handleTitleChange(Client *client, bool read_name)
 	if (client != _client || ! updateDecor()) {
 		// Render title as either the title changed was not the active
 		// title or the name change did not cause the decor to change.
-		renderTitle();
+		scheduleRepaint(RepaintScheduler::PART_TITLE);
 	}
 }
 
@@ -11,11 +11,13 @@
 #include "ActionHandler.hh"
 #include "AutoProperties.hh"
 #include "Config.hh"
+#include "EventLoop.hh"
 #include "FontHandler.hh"
 #include "Harbour.hh"
 #include "ImageHandler.hh"
 #include "ManagerWindows.hh"
 #include "KeyGrabber.hh"
+#include "RepaintScheduler.hh"
 #include "StatusWindow.hh"
 #include "TextureHandler.hh"
 #include "Theme.hh"
@@ -23,10 +25,12 @@
 static bool s_is_starting = true;
 
 static ObserverMapping* _observer_mapping = nullptr;
+static RepaintScheduler* _repaint_scheduler = nullptr;
 
 static ActionHandler* _action_handler = nullptr;
 static AutoProperties* _auto_properties = nullptr;
 static Config* _config = nullptr;
+static EventLoop* _event_loop = nullptr;
 static FontHandler* _font_handler = nullptr;
 static Harbour* _harbour = nullptr;
 static HintWO* _hint_wo = nullptr;
@@ -42,10 +46,13 @@ namespace pekwm
 	void initNoDisplay(void)
 	{
 		_observer_mapping = new ObserverMapping();
+		_repaint_scheduler = new RepaintScheduler();
 	}
 
 	void cleanupNoDisplay(void)
 	{
+		delete _repaint_scheduler;
+		_repaint_scheduler = nullptr;
 		delete _observer_mapping;
 	}
 
@@ -55,6 +62,7 @@ namespace pekwm
 	{
 		initNoDisplay();
 
+		_event_loop = event_loop;
 		_config = new Config();
 		_config->load(config_file);
 		_config->loadMouseConfig(_config->getMouseConfigFile());
@@ -113,6 +121,7 @@ namespace pekwm
 		X11::destruct();
 
 		delete _config;
+		_event_loop = nullptr;
 
 		cleanupNoDisplay();
 	}
@@ -132,6 +141,11 @@ namespace pekwm
 		return _config;
 	}
 
+	EventLoop* eventLoop(void)
+	{
+		return _event_loop;
+	}
+
 	FontHandler* fontHandler(void)
 	{
 		return _font_handler;
@@ -167,6 +181,11 @@ namespace pekwm
 		return _observer_mapping;
 	}
 
+	RepaintScheduler* repaintScheduler(void)
+	{
+		return _repaint_scheduler;
+	}
+
 	StatusWindow* statusWindow(void)
 	{
 		return _status_window;
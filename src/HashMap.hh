@@ -0,0 +1,277 @@
+//
+// HashMap.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#ifndef _PEKWM_HASHMAP_HH_
+#define _PEKWM_HASHMAP_HH_
+
+#include "config.h"
+
+#include "Compat.hh"
+#include "Types.hh"
+
+#include <string>
+#include <vector>
+
+/**
+ * Hash functions used by HashMap, specialized per key type.
+ */
+template<typename K>
+struct HashFn;
+
+template<>
+struct HashFn<ulong> {
+	size_t operator()(ulong val) const {
+		// spread XIDs that only differ in the low bits, the
+		// constant fits in 32-bit longs.
+		val ^= val >> 16;
+		val *= 0x45d9f3bUL;
+		val ^= val >> 16;
+		return static_cast<size_t>(val);
+	}
+};
+
+template<>
+struct HashFn<uint> {
+	size_t operator()(uint val) const {
+		return HashFn<ulong>()(val);
+	}
+};
+
+template<typename T>
+struct HashFn<T*> {
+	size_t operator()(T *val) const {
+		return HashFn<ulong>()(reinterpret_cast<ulong>(val));
+	}
+};
+
+template<>
+struct HashFn<std::string> {
+	size_t operator()(const std::string &val) const {
+		// FNV-1a
+		size_t hash = 2166136261U;
+		std::string::const_iterator it = val.begin();
+		for (; it != val.end(); ++it) {
+			hash ^= static_cast<uchar>(*it);
+			hash *= 16777619U;
+		}
+		return hash;
+	}
+};
+
+/**
+ * Open addressing hash map using linear probing and backward shift
+ * deletion, no tombstones are left on erase.
+ *
+ * The slot of the last successful lookup is remembered, repeated
+ * lookups of the same key skips hashing and probing. Slots may move on
+ * insert and erase so the cached slot is always verified.
+ */
+template<typename K, typename V, typename H = HashFn<K> >
+class HashMap {
+private:
+	class Slot {
+	public:
+		Slot(void) : used(false), key(), value() { }
+
+		bool used;
+		K key;
+		V value;
+	};
+
+public:
+	class iterator {
+	public:
+		iterator(HashMap *map, size_t pos)
+			: _map(map),
+			  _pos(pos)
+		{
+			skip();
+		}
+
+		const K &key(void) const { return _map->_slots[_pos].key; }
+		V &value(void) const { return _map->_slots[_pos].value; }
+
+		iterator &operator++(void) {
+			_pos++;
+			skip();
+			return *this;
+		}
+		bool operator==(const iterator &rhs) const {
+			return _pos == rhs._pos;
+		}
+		bool operator!=(const iterator &rhs) const {
+			return _pos != rhs._pos;
+		}
+
+	private:
+		void skip(void) {
+			while (_pos < _map->_slots.size()
+			       && ! _map->_slots[_pos].used) {
+				_pos++;
+			}
+		}
+
+		HashMap *_map;
+		size_t _pos;
+	};
+
+	HashMap(void)
+		: _size(0),
+		  _last(0)
+	{
+	}
+
+	size_t size(void) const { return _size; }
+	bool empty(void) const { return _size == 0; }
+
+	iterator begin(void) { return iterator(this, 0); }
+	iterator end(void) { return iterator(this, _slots.size()); }
+
+	/**
+	 * Find value for key.
+	 *
+	 * @return Pointer to value, nullptr if not found.
+	 */
+	V *find(const K &key) {
+		const HashMap *map = this;
+		return const_cast<V*>(map->find(key));
+	}
+
+	const V *find(const K &key) const {
+		if (_size == 0) {
+			return nullptr;
+		}
+		if (_last < _slots.size() && _slots[_last].used
+		    && _slots[_last].key == key) {
+			return &_slots[_last].value;
+		}
+
+		size_t mask = _slots.size() - 1;
+		for (size_t pos = _hash(key) & mask; _slots[pos].used;
+		     pos = (pos + 1) & mask) {
+			if (_slots[pos].key == key) {
+				_last = pos;
+				return &_slots[pos].value;
+			}
+		}
+		return nullptr;
+	}
+
+	bool contains(const K &key) const { return find(key) != nullptr; }
+
+	/**
+	 * Get value for key, inserting a default value if not found.
+	 */
+	V &operator[](const K &key) {
+		V *value = find(key);
+		if (value) {
+			return *value;
+		}
+		return insertNew(key, V());
+	}
+
+	/**
+	 * Set value for key, replacing any existing value.
+	 */
+	void insert(const K &key, const V &value) {
+		V *old_value = find(key);
+		if (old_value) {
+			*old_value = value;
+		} else {
+			insertNew(key, value);
+		}
+	}
+
+	/**
+	 * Remove key from the map.
+	 *
+	 * @return true if key was found and removed.
+	 */
+	bool erase(const K &key) {
+		if (_size == 0) {
+			return false;
+		}
+
+		size_t mask = _slots.size() - 1;
+		size_t pos = _hash(key) & mask;
+		for (; _slots[pos].used; pos = (pos + 1) & mask) {
+			if (_slots[pos].key == key) {
+				break;
+			}
+		}
+		if (! _slots[pos].used) {
+			return false;
+		}
+
+		// shift following entries back to fill the hole, keeping
+		// entries reachable from their ideal slot.
+		size_t hole = pos;
+		for (pos = (pos + 1) & mask; _slots[pos].used;
+		     pos = (pos + 1) & mask) {
+			size_t ideal = _hash(_slots[pos].key) & mask;
+			if (((pos - ideal) & mask) >= ((pos - hole) & mask)) {
+				_slots[hole] = _slots[pos];
+				hole = pos;
+			}
+		}
+		_slots[hole] = Slot();
+		_size--;
+		return true;
+	}
+
+	void clear(void) {
+		_slots.clear();
+		_size = 0;
+		_last = 0;
+	}
+
+private:
+	V &insertNew(const K &key, const V &value) {
+		if ((_size + 1) * 2 > _slots.size()) {
+			grow();
+		}
+
+		size_t mask = _slots.size() - 1;
+		size_t pos = _hash(key) & mask;
+		while (_slots[pos].used) {
+			pos = (pos + 1) & mask;
+		}
+		_slots[pos].used = true;
+		_slots[pos].key = key;
+		_slots[pos].value = value;
+		_size++;
+		_last = pos;
+		return _slots[pos].value;
+	}
+
+	void grow(void) {
+		std::vector<Slot> slots(_slots.empty() ? 16 : _slots.size() * 2);
+		slots.swap(_slots);
+
+		size_t mask = _slots.size() - 1;
+		typename std::vector<Slot>::iterator it = slots.begin();
+		for (; it != slots.end(); ++it) {
+			if (! it->used) {
+				continue;
+			}
+			size_t pos = _hash(it->key) & mask;
+			while (_slots[pos].used) {
+				pos = (pos + 1) & mask;
+			}
+			_slots[pos] = *it;
+		}
+	}
+
+	std::vector<Slot> _slots;
+	size_t _size;
+	/** Slot of the last successful lookup. */
+	mutable size_t _last;
+	H _hash;
+};
+
+#endif // _PEKWM_HASHMAP_HH_
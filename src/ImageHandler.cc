@@ -51,26 +51,254 @@ ImageRefEntry::decRef(void)
 	return _ref;
 }
 
+/** Default byte budget for the scaled image cache. */
+static const size_t SCALED_CACHE_MAX_BYTES = 8 * 1024 * 1024;
+
+ScaledImage::ScaledImage(ulong image_id_, size_t width_, size_t height_,
+			 uchar *data_)
+	: image_id(image_id_),
+	  width(width_),
+	  height(height_),
+	  data(data_),
+	  pixmap(None),
+	  mask(None)
+{
+}
+
+ScaledImageCache::ScaledImageCache(size_t max_bytes)
+	: _bytes(0),
+	  _max_bytes(max_bytes),
+	  _hits(0),
+	  _misses(0),
+	  _evictions(0)
+{
+}
+
+ScaledImageCache::~ScaledImageCache(void)
+{
+	clear();
+}
+
+void
+ScaledImageCache::setMaxBytes(size_t max_bytes)
+{
+	_max_bytes = max_bytes;
+	evict();
+}
+
+/**
+ * Get cached entry for image at size, the entry is moved first in the
+ * LRU list.
+ *
+ * @return Entry or nullptr if not cached.
+ */
+ScaledImage*
+ScaledImageCache::get(ulong image_id, size_t width, size_t height)
+{
+	std::map<Key, entry_it>::iterator it =
+		_index.find(Key(image_id, width, height));
+	if (it == _index.end()) {
+		_misses++;
+		return nullptr;
+	}
+
+	_hits++;
+	_entries.splice(_entries.begin(), _entries, it->second);
+	return &*it->second;
+}
+
+/**
+ * Add scaled data for image at size, the cache takes ownership of
+ * data. The returned entry stays valid until the next entry is added.
+ */
+ScaledImage*
+ScaledImageCache::add(ulong image_id, size_t width, size_t height,
+		      uchar *data)
+{
+	Key key(image_id, width, height);
+	std::map<Key, entry_it>::iterator it = _index.find(key);
+	if (it != _index.end()) {
+		erase(it);
+	}
+
+	_entries.push_front(ScaledImage(image_id, width, height, data));
+	_index[key] = _entries.begin();
+	_bytes += entryBytes(_entries.front());
+	evict();
+	return &_entries.front();
+}
+
+void
+ScaledImageCache::setPixmap(ScaledImage *entry, Pixmap pixmap)
+{
+	_bytes -= entryBytes(*entry);
+	entry->pixmap = pixmap;
+	_bytes += entryBytes(*entry);
+	evict();
+}
+
+void
+ScaledImageCache::setMask(ScaledImage *entry, Pixmap mask)
+{
+	_bytes -= entryBytes(*entry);
+	entry->mask = mask;
+	_bytes += entryBytes(*entry);
+	evict();
+}
+
+/**
+ * Remove all entries for image.
+ */
+void
+ScaledImageCache::remove(ulong image_id)
+{
+	std::map<Key, entry_it>::iterator it =
+		_index.lower_bound(Key(image_id, 0, 0));
+	while (it != _index.end() && it->first.image_id == image_id) {
+		erase(it++);
+	}
+}
+
+void
+ScaledImageCache::clear(void)
+{
+	P_DBG("scaled image cache " << _entries.size() << " entries "
+	      << _bytes << " bytes, hits " << _hits << " misses " << _misses
+	      << " evictions " << _evictions);
+
+	while (! _index.empty()) {
+		erase(_index.begin());
+	}
+	_hits = 0;
+	_misses = 0;
+	_evictions = 0;
+}
+
+/**
+ * Evict least recently used entries until the cache is within its
+ * budget, the most recently used entry is always kept as it may be in
+ * use by the caller.
+ */
+void
+ScaledImageCache::evict(void)
+{
+	while (_bytes > _max_bytes && _entries.size() > 1) {
+		const ScaledImage &entry = _entries.back();
+		erase(_index.find(Key(entry.image_id,
+				      entry.width, entry.height)));
+		_evictions++;
+	}
+}
+
+void
+ScaledImageCache::erase(std::map<Key, entry_it>::iterator it)
+{
+	ScaledImage &entry = *it->second;
+	_bytes -= entryBytes(entry);
+	delete [] entry.data;
+	if (entry.pixmap != None) {
+		X11::freePixmap(entry.pixmap);
+	}
+	if (entry.mask != None) {
+		X11::freePixmap(entry.mask);
+	}
+	_entries.erase(it->second);
+	_index.erase(it);
+}
+
+/**
+ * Approximate memory used by entry, server side pixmaps are counted as
+ * 32-bit and masks as 1-bit per pixel.
+ */
+size_t
+ScaledImageCache::entryBytes(const ScaledImage &entry)
+{
+	size_t pixels = entry.width * entry.height;
+	size_t bytes = pixels * 4;
+	if (entry.pixmap != None) {
+		bytes += pixels * 4;
+	}
+	if (entry.mask != None) {
+		bytes += pixels / 8;
+	}
+	return bytes;
+}
+
+ImageRefMap::ImageRefMap(void)
+{
+}
+
+/**
+ * Delete entries, images are owned by the ImageHandler and not deleted.
+ */
+ImageRefMap::~ImageRefMap(void)
+{
+	iterator it = _by_image.begin();
+	for (; it != _by_image.end(); ++it) {
+		delete it.value();
+	}
+}
+
+ImageRefEntry*
+ImageRefMap::findName(const std::string &u_name)
+{
+	ImageRefEntry **entry = _by_name.find(u_name);
+	return entry ? *entry : nullptr;
+}
+
+ImageRefEntry*
+ImageRefMap::findImage(PImage *image)
+{
+	ImageRefEntry **entry = _by_image.find(image);
+	return entry ? *entry : nullptr;
+}
+
+/**
+ * Add image with a single reference.
+ */
+void
+ImageRefMap::add(const std::string &u_name, PImage *image)
+{
+	ImageRefEntry *entry = new ImageRefEntry(u_name, image);
+	_by_name.insert(u_name, entry);
+	_by_image.insert(image, entry);
+}
+
+void
+ImageRefMap::erase(ImageRefEntry *entry)
+{
+	_by_name.erase(entry->getUName());
+	_by_image.erase(entry->get());
+	delete entry;
+}
+
 ImageHandler::ImageHandler(void)
+	: _scaled_cache(SCALED_CACHE_MAX_BYTES)
 {
 	clearColorMaps();
 }
 
 ImageHandler::~ImageHandler(void)
 {
+	_scaled_cache.clear();
+
 	if (! _images.empty()) {
 		P_ERR("ImageHandler not empty on destruct, " << _images.size()
 		      << " entries left");
 
-		while (_images.size()) {
-			std::vector<ImageRefEntry>::iterator it = _images.end() - 1;
-			if (it->get()) {
-				P_ERR("delete lost image " << it->getUName());
-				delete it->get();
-			}
-			_images.erase(it);
+		while (! _images.empty()) {
+			ImageRefEntry *entry = _images.begin().value();
+			P_ERR("delete lost image " << entry->getUName());
+			delete entry->get();
+			_images.erase(entry);
 		}
 	}
+
+	std::map<std::string, ImageRefMap*>::iterator it =
+		_images_mapped.begin();
+	for (; it != _images_mapped.end(); ++it) {
+		delete it->second;
+	}
 }
 
 /**
@@ -85,7 +313,7 @@ ImageHandler::getImage(const std::string &file)
 
 PImage*
 ImageHandler::getImage(const std::string &file, uint &ref,
-                       std::vector<ImageRefEntry> &images)
+                       ImageRefMap &images)
 {
 	if (! file.size()) {
 		ref = 0;
@@ -140,22 +368,20 @@ PImage*
 ImageHandler::getImageFromPath(const std::string &file,
                                const std::string &u_file,
                                uint &ref,
-                               std::vector<ImageRefEntry> &images)
+                               ImageRefMap &images)
 {
 	// Check cache for entry.
-	std::vector<ImageRefEntry>::iterator it = images.begin();
-	for (; it != images.end(); ++it) {
-		if (it->getUName() == u_file) {
-			ref = it->incRef();
-			return it->get();
-		}
+	ImageRefEntry *entry = images.findName(u_file);
+	if (entry) {
+		ref = entry->incRef();
+		return entry->get();
 	}
 
 	// Try to load the image, setup cache only if it succeeds.
 	PImage *image;
 	try {
 		image = new PImage(file);
-		images.push_back(ImageRefEntry(u_file, image));
+		images.add(u_file, image);
 		ref = 1;
 	} catch (LoadException&) {
 		image = nullptr;
@@ -182,7 +408,7 @@ ImageHandler::takeOwnership(PImage *image)
 {
 	std::string key = Util::to_string(static_cast<void*>(image));
 	Util::to_upper(key);
-	_images.push_back(ImageRefEntry(key, image));
+	_images.add(key, image);
 }
 
 PImage*
@@ -199,14 +425,13 @@ ImageHandler::getMappedImage(const std::string &file,
 		return nullptr;
 	}
 
-	std::map<std::string, std::vector<ImageRefEntry> >::iterator i_it =
-		_images_mapped.find(u_colormap);
-	if (i_it == _images_mapped.end()) {
-		_images_mapped[u_colormap] = std::vector<ImageRefEntry>();
+	ImageRefMap *&images = _images_mapped[u_colormap];
+	if (images == nullptr) {
+		images = new ImageRefMap();
 	}
 
 	uint ref;
-	PImage *image = getImage(file, ref, _images_mapped[u_colormap]);
+	PImage *image = getImage(file, ref, *images);
 	if (ref == 1) {
 		// new image, requires color mapping.
 		mapColors(image, _color_maps[u_colormap]);
@@ -240,28 +465,43 @@ ImageHandler::returnMappedImage(PImage *image, const std::string &colormap)
 {
 	std::string u_colormap(colormap);
 	Util::to_upper(u_colormap);
-	returnImage(image, _images_mapped[u_colormap]);
+
+	std::map<std::string, ImageRefMap*>::iterator it =
+		_images_mapped.find(u_colormap);
+	if (it != _images_mapped.end()) {
+		returnImage(image, *it->second);
+	} else {
+		P_ERR("returned image " << image << " not found in handler");
+		delete image;
+	}
 }
 
 void
-ImageHandler::returnImage(PImage *image,
-                          std::vector<ImageRefEntry> &images)
-{
-	std::vector<ImageRefEntry>::iterator it = images.begin();
-	for (; it != images.end(); ++it) {
-		if (it->get() == image) {
-			if (it->decRef() == 0) {
-				delete it->get();
-				images.erase(it);
-			}
-			return;
+ImageHandler::returnImage(PImage *image, ImageRefMap &images)
+{
+	ImageRefEntry *entry = images.findImage(image);
+	if (entry) {
+		if (entry->decRef() == 0) {
+			_scaled_cache.remove(image->getId());
+			images.erase(entry);
+			delete image;
 		}
+		return;
 	}
 
 	P_ERR("returned image " << image << " not found in handler");
 	delete image;
 }
 
+/**
+ * Drop all scaled images, called on theme reload.
+ */
+void
+ImageHandler::clearScaledCache(void)
+{
+	_scaled_cache.clear();
+}
+
 void
 ImageHandler::clearColorMaps(void)
 {
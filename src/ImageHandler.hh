@@ -11,14 +11,109 @@
 
 #include "config.h"
 
+#include "HashMap.hh"
 #include "PImage.hh"
 #include "Util.hh"
 
+#include <list>
+#include <map>
 #include <string>
 #include <vector>
 
 class PImage;
 
+/**
+ * Scaled representation of an image, see ScaledImageCache.
+ */
+class ScaledImage {
+public:
+	ScaledImage(ulong image_id_, size_t width_, size_t height_,
+		    uchar *data_);
+
+	ulong image_id;
+	size_t width;
+	size_t height;
+	/** Scaled ARGB data, owned by the cache. */
+	uchar *data;
+	Pixmap pixmap;
+	Pixmap mask;
+};
+
+/**
+ * LRU cache of scaled image data and the pixmaps created from it,
+ * bounded by a byte budget. Entries are keyed on the image identifier,
+ * which changes whenever the image data changes, and the size.
+ */
+class ScaledImageCache {
+public:
+	ScaledImageCache(size_t max_bytes);
+	~ScaledImageCache(void);
+
+	size_t size(void) const { return _entries.size(); }
+	size_t getBytes(void) const { return _bytes; }
+	size_t getMaxBytes(void) const { return _max_bytes; }
+	void setMaxBytes(size_t max_bytes);
+
+	/** Check if image at size, with pixmap, fits in the budget. */
+	bool fits(size_t width, size_t height) const {
+		return width * height * 8 <= _max_bytes;
+	}
+
+	uint getHits(void) const { return _hits; }
+	uint getMisses(void) const { return _misses; }
+
+	ScaledImage *get(ulong image_id, size_t width, size_t height);
+	ScaledImage *add(ulong image_id, size_t width, size_t height, uchar *data);
+	void setPixmap(ScaledImage *entry, Pixmap pixmap);
+	void setMask(ScaledImage *entry, Pixmap mask);
+
+	void remove(ulong image_id);
+	void clear(void);
+
+private:
+	class Key {
+	public:
+		Key(ulong image_id_, size_t width_, size_t height_)
+			: image_id(image_id_),
+			  width(width_),
+			  height(height_)
+		{
+		}
+
+		bool operator<(const Key &rhs) const {
+			if (image_id != rhs.image_id) {
+				return image_id < rhs.image_id;
+			}
+			if (width != rhs.width) {
+				return width < rhs.width;
+			}
+			return height < rhs.height;
+		}
+
+		ulong image_id;
+		size_t width;
+		size_t height;
+	};
+
+	typedef std::list<ScaledImage>::iterator entry_it;
+
+	void evict(void);
+	void erase(std::map<Key, entry_it>::iterator it);
+
+	static size_t entryBytes(const ScaledImage &entry);
+
+	/** Entries, most recently used first. */
+	std::list<ScaledImage> _entries;
+	std::map<Key, entry_it> _index;
+
+	size_t _bytes;
+	size_t _max_bytes;
+
+	uint _hits;
+	uint _misses;
+	uint _evictions;
+};
+
 /**
  * Reference counted entry.
  */
@@ -42,6 +137,34 @@ private:
 	uint _ref;
 };
 
+/**
+ * Reference counted images indexed on both upper case name and image.
+ */
+class ImageRefMap {
+public:
+	typedef HashMap<PImage*, ImageRefEntry*>::iterator iterator;
+
+	ImageRefMap(void);
+	~ImageRefMap(void);
+
+	size_t size(void) const { return _by_image.size(); }
+	bool empty(void) const { return _by_image.empty(); }
+	iterator begin(void) { return _by_image.begin(); }
+	iterator end(void) { return _by_image.end(); }
+
+	ImageRefEntry *findName(const std::string &u_name);
+	ImageRefEntry *findImage(PImage *image);
+	void add(const std::string &u_name, PImage *image);
+	void erase(ImageRefEntry *entry);
+
+private:
+	ImageRefMap(const ImageRefMap &);
+	ImageRefMap &operator=(const ImageRefMap &);
+
+	HashMap<std::string, ImageRefEntry*> _by_name;
+	HashMap<PImage*, ImageRefEntry*> _by_image;
+};
+
 /**
  * ImageHandler, a caching and image type transparent image handler.
  */
@@ -75,28 +198,33 @@ public:
 	void clearColorMaps(void);
 	void addColorMap(const std::string& name, std::map<int,int> color_map);
 
+	ScaledImageCache *getScaledCache(void) { return &_scaled_cache; }
+	void clearScaledCache(void);
+
 private:
 	PImage *getImage(const std::string &file, uint &ref,
-			 std::vector<ImageRefEntry> &images);
+			 ImageRefMap &images);
 	PImage *getImageFromPath(const std::string &file,
 				 const std::string &u_file,
 				 uint &ref,
-				 std::vector<ImageRefEntry> &images);
+				 ImageRefMap &images);
 
 	void mapColors(PImage *image, const std::map<int,int> &color_map);
 
-	static void returnImage(PImage *image,
-				std::vector<ImageRefEntry> &images);
+	void returnImage(PImage *image, ImageRefMap &images);
 private:
 
 	/** List of directories to search. */
 	std::vector<std::string> _search_path;
 	/** Loaded images. */
-	std::vector<ImageRefEntry> _images;
+	ImageRefMap _images;
 	/** Loaded images with color mapped data. */
-	std::map<std::string, std::vector<ImageRefEntry> > _images_mapped;
+	std::map<std::string, ImageRefMap*> _images_mapped;
 
 	std::map<std::string, std::map<int, int> > _color_maps;
+
+	/** Scaled representations of images. */
+	ScaledImageCache _scaled_cache;
 };
 
 namespace pekwm
@@ -0,0 +1,132 @@
+//
+// KeyChainEventHandler.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "Debug.hh"
+#include "EventLoop.hh"
+#include "KeyChainEventHandler.hh"
+#include "X11.hh"
+
+extern "C" {
+#include <X11/Xutil.h>
+}
+
+KeyChainEventHandler::KeyChainEventHandler(KeyGrabber *key_grabber,
+					   uint timeout_ms)
+	: _key_grabber(key_grabber),
+	  _timeout_ms(timeout_ms),
+	  _timer(-1),
+	  _grabbed(false),
+	  _done(false)
+{
+}
+
+KeyChainEventHandler::~KeyChainEventHandler(void)
+{
+	stopTimer();
+	if (_grabbed) {
+		X11::ungrabKeyboard();
+	}
+	if (! _done) {
+		_key_grabber->endChain();
+	}
+}
+
+bool
+KeyChainEventHandler::initEventHandler(void)
+{
+	if (! X11::grabKeyboard(X11::getRoot())) {
+		return false;
+	}
+	_grabbed = true;
+	startTimer();
+	return true;
+}
+
+EventHandler::Result
+KeyChainEventHandler::handleButtonPressEvent(XButtonEvent*)
+{
+	P_TRACE("key chain aborted by button press");
+	return EventHandler::EVENT_STOP_SKIP;
+}
+
+EventHandler::Result
+KeyChainEventHandler::handleButtonReleaseEvent(XButtonEvent*)
+{
+	return EventHandler::EVENT_SKIP;
+}
+
+EventHandler::Result
+KeyChainEventHandler::handleExposeEvent(XExposeEvent*)
+{
+	return EventHandler::EVENT_SKIP;
+}
+
+EventHandler::Result
+KeyChainEventHandler::handleMotionNotifyEvent(XMotionEvent*)
+{
+	return EventHandler::EVENT_SKIP;
+}
+
+EventHandler::Result
+KeyChainEventHandler::handleKeyEvent(XKeyEvent *ev)
+{
+	if (ev->type == KeyRelease) {
+		return EventHandler::EVENT_PROCESSED;
+	}
+
+	KeySym keysym = X11::getKeysymFromKeycode(ev->keycode);
+	if (IsModifierKey(keysym)) {
+		return EventHandler::EVENT_PROCESSED;
+	}
+
+	if (_key_grabber->continueChain(ev)) {
+		startTimer();
+		return EventHandler::EVENT_PROCESSED;
+	}
+
+	// end of the chain, the key is looked up in the chain when
+	// handled by the window manager.
+	X11::ungrabKeyboard();
+	_grabbed = false;
+	_done = true;
+	return EventHandler::EVENT_STOP_SKIP;
+}
+
+void
+KeyChainEventHandler::startTimer(void)
+{
+	stopTimer();
+	EventLoop *event_loop = pekwm::eventLoop();
+	if (event_loop && _timeout_ms > 0) {
+		_timer = event_loop->addTimer(_timeout_ms, false, timeout, this);
+	}
+}
+
+void
+KeyChainEventHandler::stopTimer(void)
+{
+	EventLoop *event_loop = pekwm::eventLoop();
+	if (event_loop && _timer != -1) {
+		event_loop->removeTimer(_timer);
+	}
+	_timer = -1;
+}
+
+/**
+ * No key pressed in time, abort the chain removing the handler.
+ */
+void
+KeyChainEventHandler::timeout(int, void *opaque)
+{
+	KeyChainEventHandler *handler =
+		static_cast<KeyChainEventHandler*>(opaque);
+	handler->_timer = -1;
+	P_TRACE("key chain timed out");
+	// deletes handler
+	pekwm::eventLoop()->setEventHandler(nullptr);
+}
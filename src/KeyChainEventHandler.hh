@@ -0,0 +1,58 @@
+//
+// KeyChainEventHandler.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#ifndef _PEKWM_KEYCHAINEVENTHANDLER_HH_
+#define _PEKWM_KEYCHAINEVENTHANDLER_HH_
+
+#include "config.h"
+
+#include "EventHandler.hh"
+#include "KeyGrabber.hh"
+
+/**
+ * Keyboard grab while a key chain is being entered, started once the
+ * first key of a chain has been pressed.
+ *
+ * Keys continuing the chain are consumed, the first key not doing so
+ * stops the handler and is passed on to the regular key handling
+ * finding the action in the chain. Other events are handled as usual
+ * while the chain is entered. The chain is aborted on button press or
+ * if no key is pressed before the timeout.
+ */
+class KeyChainEventHandler : public EventHandler {
+public:
+	KeyChainEventHandler(KeyGrabber *key_grabber, uint timeout_ms);
+	virtual ~KeyChainEventHandler(void);
+
+	virtual bool initEventHandler(void);
+
+	virtual EventHandler::Result
+	handleButtonPressEvent(XButtonEvent*);
+	virtual EventHandler::Result
+	handleButtonReleaseEvent(XButtonEvent*);
+	virtual EventHandler::Result
+	handleExposeEvent(XExposeEvent*);
+	virtual EventHandler::Result
+	handleMotionNotifyEvent(XMotionEvent*);
+	virtual EventHandler::Result
+	handleKeyEvent(XKeyEvent *ev);
+
+private:
+	void startTimer(void);
+	void stopTimer(void);
+	static void timeout(int id, void *opaque);
+
+	KeyGrabber *_key_grabber;
+	uint _timeout_ms;
+	int _timer;
+	bool _grabbed;
+	/** Set when the chain is left for KeyGrabber::findAction. */
+	bool _done;
+};
+
+#endif // _PEKWM_KEYCHAINEVENTHANDLER_HH_
@@ -15,11 +15,75 @@
 #include "Util.hh"
 #include "X11.hh"
 
-extern "C" {
-#include <X11/Xutil.h>
+#include <algorithm>
+#include <iostream>
+
+/** Position returned by KeyGrabber::Chain::Index::find if not found. */
+static const size_t INDEX_NOT_FOUND = static_cast<size_t>(-1);
+
+/**
+ * Add entry for mod and key at pos, entries must be added in position
+ * order.
+ */
+void
+KeyGrabber::Chain::Index::add(uint mod, uint key, size_t pos)
+{
+	if (! isExact(mod, key)) {
+		_wildcards.push_back(Entry(mod, key, pos));
+	} else if (! _exact.contains(hashKey(mod, key))) {
+		_exact.insert(hashKey(mod, key), pos);
+	}
 }
 
-#include <iostream>
+/**
+ * Find position of the first entry matching mod and key.
+ *
+ * @return Position or INDEX_NOT_FOUND.
+ */
+size_t
+KeyGrabber::Chain::Index::find(uint mod, uint key)
+{
+	size_t pos = INDEX_NOT_FOUND;
+	if (isExact(mod, key)) {
+		size_t *exact_pos = _exact.find(hashKey(mod, key));
+		if (exact_pos) {
+			pos = *exact_pos;
+		}
+	}
+
+	// wildcards configured before the exact match take precedence
+	std::vector<Entry>::iterator it = _wildcards.begin();
+	for (; it != _wildcards.end() && it->pos < pos; ++it) {
+		if ((it->mod == MOD_ANY || it->mod == mod)
+		    && (it->key == 0 || it->key == key)) {
+			return it->pos;
+		}
+	}
+	return pos;
+}
+
+void
+KeyGrabber::Chain::Index::clear(void)
+{
+	_exact.clear();
+	_wildcards.clear();
+}
+
+/**
+ * Return true if mod and key only match themselves and fit in the
+ * hash key, key codes are 8 bit.
+ */
+bool
+KeyGrabber::Chain::Index::isExact(uint mod, uint key)
+{
+	return mod != MOD_ANY && mod <= 0xffffff && key != 0 && key <= 0xff;
+}
+
+ulong
+KeyGrabber::Chain::Index::hashKey(uint mod, uint key)
+{
+	return (static_cast<ulong>(mod) << 8) | key;
+}
 
 //! @brief Constructor for Chain class
 KeyGrabber::Chain::Chain(uint mod, uint key)
@@ -44,43 +108,52 @@ KeyGrabber::Chain::unload(void)
 	}
 	_chains.clear();
 	_keys.clear();
+	_chain_index.clear();
+	_key_index.clear();
+}
+
+//! @brief Adds chain to Chain vector.
+void
+KeyGrabber::Chain::addChain(Chain *chain)
+{
+	_chain_index.add(chain->getMod(), chain->getKey(), _chains.size());
+	_chains.push_back(chain);
+}
+
+//! @brief Adds action to Key vector.
+void
+KeyGrabber::Chain::addAction(const ActionEvent &key)
+{
+	_key_index.add(key.mod, key.sym, _keys.size());
+	_keys.push_back(key);
 }
 
 //! @brief Searches the _chains list for an action
 KeyGrabber::Chain*
 KeyGrabber::Chain::findChain(XKeyEvent *ev, bool &matched)
 {
-	std::vector<Chain*>::iterator it = _chains.begin();
-	for (; it != _chains.end(); ++it) {
-		if ((((*it)->getMod() == MOD_ANY) || ((*it)->getMod() == ev->state)) &&
-		    (((*it)->getKey() == 0) || ((*it)->getKey() == ev->keycode))) {
-			return *it;
-		}
-	}
-	return nullptr;
+	size_t pos = _chain_index.find(ev->state, ev->keycode);
+	return pos == INDEX_NOT_FOUND ? nullptr : _chains[pos];
 }
 
 //! @brief Searches the _keys list for an action
 ActionEvent*
 KeyGrabber::Chain::findAction(XKeyEvent *ev, bool &matched)
 {
-	std::vector<ActionEvent>::iterator it = _keys.begin();
-	for (; it != _keys.end(); ++it) {
-		if ((it->mod == MOD_ANY || it->mod == ev->state)
-		    && (it->sym == 0 || it->sym == ev->keycode)) {
-			matched = true;
-			return &*it;
-		}
+	size_t pos = _key_index.find(ev->state, ev->keycode);
+	if (pos == INDEX_NOT_FOUND) {
+		return 0;
 	}
-
-	return 0;
+	matched = true;
+	return &_keys[pos];
 }
 
 //! @brief KeyGrabber constructor
 KeyGrabber::KeyGrabber(void)
 	: _menu_chain(0, 0),
 	  _global_chain(0, 0), _moveresize_chain(0, 0),
-	  _input_dialog_chain(0, 0)
+	  _input_dialog_chain(0, 0),
+	  _chain(nullptr)
 {
 	_num_lock = X11::getNumLock();
 	_scroll_lock = X11::getScrollLock();
@@ -121,6 +194,7 @@ KeyGrabber::load(const std::string &file, bool force)
 
 	section = key_cfg.getEntryRoot()->findSection("GLOBAL");
 	if (section) {
+		_chain = nullptr;
 		_global_chain.unload();
 		parseGlobalChain(section, &_global_chain);
 	}
@@ -150,6 +224,8 @@ KeyGrabber::load(const std::string &file, bool force)
 		parseMenuChain(section, &_menu_chain);
 	}
 
+	updateGrabs();
+
 	return true;
 }
 
@@ -246,48 +322,62 @@ KeyGrabber::parseMenuChain(CfgParser::Entry *section, KeyGrabber::Chain *chain)
 void
 KeyGrabber::grabKeys(Window win)
 {
+	Display *dpy = X11::getDpy(); // convenience
+
+	std::vector<std::pair<uint, uint> >::const_iterator it = _grabs.begin();
+	for (; it != _grabs.end(); ++it) {
+		XGrabKey(dpy, it->second, it->first, win, true,
+			 GrabModeAsync, GrabModeAsync);
+	}
+}
+
+/**
+ * Compute the modifier and key states to grab from the global chain,
+ * done once per load instead of for every window grabbed.
+ */
+void
+KeyGrabber::updateGrabs(void)
+{
+	_grabs.clear();
+
 	const std::vector<Chain*> &chains = _global_chain.getChains();
 	std::vector<Chain*>::const_iterator c_it = chains.begin();
 	for (; c_it != chains.end(); ++c_it) {
-		grabKey(win, (*c_it)->getMod(), (*c_it)->getKey());
+		addGrab((*c_it)->getMod(), (*c_it)->getKey());
 	}
 
 	const std::vector<ActionEvent> &keys = _global_chain.getKeys();
 	std::vector<ActionEvent>::const_iterator k_it = keys.begin();
 	for (; k_it  != keys.end(); ++k_it) {
-		grabKey(win, k_it->mod, k_it->sym);
+		addGrab(k_it->mod, k_it->sym);
 	}
+
+	// keys bound several times are only grabbed once
+	std::sort(_grabs.begin(), _grabs.end());
+	_grabs.erase(std::unique(_grabs.begin(), _grabs.end()), _grabs.end());
 }
 
-//! @brief Grabs a key with state on Window win with "all possible" modifiers.
-//! @param win Window to grab the key on.
+//! @brief Adds key with state to grab with "all possible" modifiers.
 //! @param mod Modifier state to grab.
 //! @param key Key state to grab.
 void
-KeyGrabber::grabKey(Window win, uint mod, uint key)
+KeyGrabber::addGrab(uint mod, uint key)
 {
-	Display *dpy = X11::getDpy(); // convenience
-
-	XGrabKey(dpy, key, mod, win, true, GrabModeAsync, GrabModeAsync);
-	XGrabKey(dpy, key, mod|LockMask, win, true, GrabModeAsync, GrabModeAsync);
+	_grabs.push_back(std::make_pair(mod, key));
+	_grabs.push_back(std::make_pair(mod|LockMask, key));
 
 	if (_num_lock) {
-		XGrabKey(dpy, key, mod|_num_lock,
-			 win, true, GrabModeAsync, GrabModeAsync);
-		XGrabKey(dpy, key, mod|_num_lock|LockMask,
-			 win, true, GrabModeAsync, GrabModeAsync);
+		_grabs.push_back(std::make_pair(mod|_num_lock, key));
+		_grabs.push_back(std::make_pair(mod|_num_lock|LockMask, key));
 	}
 	if (_scroll_lock) {
-		XGrabKey(dpy, key, mod|_scroll_lock,
-			 win, true, GrabModeAsync, GrabModeAsync);
-		XGrabKey(dpy, key, mod|_scroll_lock|LockMask,
-			 win, true, GrabModeAsync, GrabModeAsync);
+		_grabs.push_back(std::make_pair(mod|_scroll_lock, key));
+		_grabs.push_back(std::make_pair(mod|_scroll_lock|LockMask, key));
 	}
 	if (_num_lock && _scroll_lock) {
-		XGrabKey(dpy, key, mod|_num_lock|_scroll_lock,
-			 win, true, GrabModeAsync, GrabModeAsync);
-		XGrabKey(dpy, key, mod|_num_lock|_scroll_lock|LockMask,
-			 win, true, GrabModeAsync, GrabModeAsync);
+		_grabs.push_back(std::make_pair(mod|_num_lock|_scroll_lock, key));
+		_grabs.push_back(std::make_pair(mod|_num_lock|_scroll_lock|LockMask,
+						key));
 	}
 }
 
@@ -299,79 +389,82 @@ KeyGrabber::ungrabKeys(Window win)
 	XUngrabKey(X11::getDpy(), AnyKey, AnyModifier, win);
 }
 
-//! @brief Tries to match the XKeyEvent to an usefull action and return it
-//! @param ev XKeyEvent to match.
+/**
+ * Finds action matching ev, global chains take precedence over the
+ * actions of the type specific chains.
+ *
+ * If ev starts a key chain no action is returned, isInChain returns true
+ * and the keys following are expected to be passed to continueChain
+ * until it returns false. The key ending the chain is then looked up in
+ * the chain by findAction.
+ */
 ActionEvent*
-KeyGrabber::findAction(XKeyEvent *ev, KeyGrabber::Chain *chain, bool &matched)
+KeyGrabber::findAction(XKeyEvent *ev, PWinObj::Type type, bool &matched)
 {
+	matched = false;
 	if (! ev) {
-		return 0;
+		return nullptr;
 	}
 
 	X11::stripStateModifiers(&ev->state);
 
-	ActionEvent *action = 0;
-	KeyGrabber::Chain *sub_chain = _global_chain.findChain(ev, matched);
-	if (sub_chain) {
+	if (_chain) {
+		ActionEvent *ae = _chain->findAction(ev, matched);
 		matched = true;
-
-		if (X11::grabKeyboard(X11::getRoot())) {
-			XEvent c_ev;
-			KeyGrabber::Chain *last_chain;
-			bool exit = false;
-
-			while (! exit) {
-				XMaskEvent(X11::getDpy(), KeyPressMask, &c_ev);
-				X11::stripStateModifiers(&c_ev.xkey.state);
-
-				KeySym keysym = X11::getKeysymFromKeycode(c_ev.xkey.keycode);
-				if (IsModifierKey(keysym)) {
-					// do nothing
-				} else  if ((last_chain = sub_chain->findChain(&c_ev.xkey,
-									       matched))) {
-					sub_chain = last_chain;
-				} else {
-					action = sub_chain->findAction(&c_ev.xkey, matched);
-					exit = true;
-				}
-			}
-
-			X11::ungrabKeyboard();
-		}
-	} else {
-		action = chain->findAction(ev, matched);
+		_chain = nullptr;
+		return ae;
 	}
 
-	return action;
-}
-
-//! @brief Finds action matching ev, continues chain if needed
-ActionEvent*
-KeyGrabber::findAction(XKeyEvent *ev, PWinObj::Type type, bool &matched)
-{
-	ActionEvent *ae = 0;
-
-	matched = false;
+	_chain = _global_chain.findChain(ev, matched);
+	if (_chain) {
+		matched = true;
+		return nullptr;
+	}
 
+	ActionEvent *ae = nullptr;
 	if (type == PWinObj::WO_MENU) {
-		ae = findAction(ev, &_menu_chain, matched);
+		ae = _menu_chain.findAction(ev, matched);
 	}
 	if (type == PWinObj::WO_CMD_DIALOG || type == PWinObj::WO_SEARCH_DIALOG) {
-		ae = findAction(ev, &_input_dialog_chain, matched);
+		ae = _input_dialog_chain.findAction(ev, matched);
 	}
 
 	// no action the menu list, try the global list
 	if (! ae) {
-		ae = findAction(ev, &_global_chain, matched);
+		ae = _global_chain.findAction(ev, matched);
 	}
 
 	return ae;
 }
 
+/**
+ * Continue the key chain being entered with ev.
+ *
+ * @return true if ev continued the chain, false if it ends the chain.
+ */
+bool
+KeyGrabber::continueChain(XKeyEvent *ev)
+{
+	if (! _chain) {
+		return false;
+	}
+
+	X11::stripStateModifiers(&ev->state);
+
+	bool matched;
+	KeyGrabber::Chain *sub_chain = _chain->findChain(ev, matched);
+	if (sub_chain) {
+		_chain = sub_chain;
+		return true;
+	}
+	return false;
+}
+
 //! @brief Searches the _moveresize_chain for actions.
 ActionEvent*
 KeyGrabber::findMoveResizeAction(XKeyEvent *ev)
 {
 	bool matched;
-	return findAction(ev, &_moveresize_chain, matched);
+	X11::stripStateModifiers(&ev->state);
+	return _moveresize_chain.findAction(ev, matched);
 }
@@ -15,9 +15,11 @@
 
 #include "Action.hh"
 #include "CfgParser.hh"
+#include "HashMap.hh"
 #include "PWinObj.hh"
 
 #include <string>
+#include <vector>
 
 extern "C" {
 #include <X11/Xlib.h>
@@ -46,19 +48,54 @@ public:
 		//! @brief Returns vector of Keys in chain.
 		const std::vector<ActionEvent> &getKeys(void) const { return _keys; }
 
-		//! @brief Adds chain to Chain vector.
-		inline void addChain(Chain *chain) { _chains.push_back(chain); }
-		//! @brief Adds action to Key vector.
-		inline void addAction(const ActionEvent &key) { _keys.push_back(key); }
+		void addChain(Chain *chain);
+		void addAction(const ActionEvent &key);
 
 		Chain *findChain(XKeyEvent *ev, bool &matched);
 		ActionEvent *findAction(XKeyEvent *ev, bool &matched);
 
 	private:
+		/**
+		 * Position of the first entry matching a modifier and key
+		 * state, exact states are hashed and only entries with
+		 * MOD_ANY or any key are matched one by one.
+		 */
+		class Index {
+		public:
+			void add(uint mod, uint key, size_t pos);
+			size_t find(uint mod, uint key);
+			void clear(void);
+
+		private:
+			class Entry {
+			public:
+				Entry(uint mod_, uint key_, size_t pos_)
+					: mod(mod_),
+					  key(key_),
+					  pos(pos_)
+				{
+				}
+
+				uint mod;
+				uint key;
+				size_t pos;
+			};
+
+			static bool isExact(uint mod, uint key);
+			static ulong hashKey(uint mod, uint key);
+
+			/** Position of first entry for each exact state. */
+			HashMap<ulong, size_t> _exact;
+			/** Entries not in _exact, in position order. */
+			std::vector<Entry> _wildcards;
+		};
+
 		uint _mod, _key;
 
 		std::vector<Chain*> _chains;
 		std::vector<ActionEvent> _keys;
+		Index _chain_index;
+		Index _key_index;
 	};
 
 	KeyGrabber(void);
@@ -71,8 +108,15 @@ public:
 	ActionEvent *findAction(XKeyEvent *ev, PWinObj::Type type, bool &matched);
 	ActionEvent *findMoveResizeAction(XKeyEvent *ev);
 
+	/** Returns true if a key chain is being entered. */
+	bool isInChain(void) const { return _chain != nullptr; }
+	bool continueChain(XKeyEvent *ev);
+	/** Abort the key chain being entered, if any. */
+	void endChain(void) { _chain = nullptr; }
+
 private:
-	void grabKey(Window win, uint mod, uint key);
+	void updateGrabs(void);
+	void addGrab(uint mod, uint key);
 
 	void parseGlobalChain(CfgParser::Entry *section, KeyGrabber::Chain *chain);
 	void parseMoveResizeChain(CfgParser::Entry *section,
@@ -81,18 +125,23 @@ private:
 				   KeyGrabber::Chain *chain);
 	void parseMenuChain(CfgParser::Entry *section, KeyGrabber::Chain *chain);
 
-	ActionEvent *findAction(XKeyEvent *ev, KeyGrabber::Chain *chain,
-				bool &matched);
-
 	TimeFiles _cfg_files;
 
 	KeyGrabber::Chain _menu_chain;
 	KeyGrabber::Chain _global_chain;
 	KeyGrabber::Chain _moveresize_chain;
 	KeyGrabber::Chain _input_dialog_chain;
+	/** Global chain being entered, nullptr if none. */
+	KeyGrabber::Chain *_chain;
 
 	uint _num_lock;
 	uint _scroll_lock;
+
+	/**
+	 * Modifier and key states grabbed on windows, including all lock
+	 * modifier combinations.
+	 */
+	std::vector<std::pair<uint, uint> > _grabs;
 };
 
 namespace pekwm
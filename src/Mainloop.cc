@@ -0,0 +1,341 @@
+//
+// Mainloop.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "Compat.hh"
+#include "Debug.hh"
+#include "Mainloop.hh"
+#include "Util.hh"
+
+#include <algorithm>
+#include <cassert>
+
+extern "C" {
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+}
+
+/** Self-pipe used to forward signals to the main loop. */
+static int _signal_pipe[2] = { -1, -1 };
+
+extern "C" {
+	/**
+	 * Signal handler writing the signal number to the signal pipe.
+	 */
+	static void
+	sigHandler(int signal)
+	{
+		int saved_errno = errno;
+		unsigned char sig = static_cast<unsigned char>(signal);
+		if (write(_signal_pipe[1], &sig, 1) == -1) {
+			// pipe full, the signal is already pending
+		}
+		errno = saved_errno;
+	}
+}
+
+Mainloop::Mainloop(void)
+	: _next_timer_id(1)
+{
+}
+
+Mainloop::~Mainloop(void)
+{
+	if (_signals.empty()) {
+		return;
+	}
+
+	struct sigaction act;
+	act.sa_handler = SIG_DFL;
+	sigemptyset(&act.sa_mask);
+	act.sa_flags = 0;
+
+	std::map<int, std::pair<signalFun, void*> >::iterator it =
+		_signals.begin();
+	for (; it != _signals.end(); ++it) {
+		sigaction(it->first, &act, 0);
+	}
+}
+
+/**
+ * Add file descriptor, fun is called with opaque whenever there is data
+ * to read on fd. fun may be nullptr to only wake up the loop.
+ */
+void
+Mainloop::addFd(int fd, fdFun fun, void *opaque)
+{
+	std::map<int, FdEntry>::iterator it = _fds.find(fd);
+	if (it != _fds.end()) {
+		it->second = FdEntry(fun, opaque);
+		return;
+	}
+
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	_pfds.push_back(pfd);
+	_fds.insert(std::make_pair(fd, FdEntry(fun, opaque)));
+}
+
+void
+Mainloop::removeFd(int fd)
+{
+	if (_fds.erase(fd) == 0) {
+		return;
+	}
+
+	std::vector<struct pollfd>::iterator it = _pfds.begin();
+	for (; it != _pfds.end(); ++it) {
+		if (it->fd == fd) {
+			_pfds.erase(it);
+			break;
+		}
+	}
+}
+
+/**
+ * Add timer calling fun with opaque after timeout_ms milliseconds,
+ * if repeat is true the timer is re-scheduled every timeout_ms.
+ *
+ * @return Timer identifier, used to remove the timer.
+ */
+int
+Mainloop::addTimer(uint timeout_ms, bool repeat, timerFun fun, void *opaque)
+{
+	int id = _next_timer_id++;
+	_timers.insert(std::make_pair(id, Timer(timeout_ms, repeat,
+						fun, opaque)));
+
+	struct timespec expire;
+	clock_gettime(CLOCK_MONOTONIC, &expire);
+	addTimespecMs(expire, timeout_ms);
+	_timer_heap.push_back(TimerExpire(expire, id));
+	std::push_heap(_timer_heap.begin(), _timer_heap.end());
+
+	return id;
+}
+
+void
+Mainloop::removeTimer(int id)
+{
+	_timers.erase(id);
+	if (_timer_heap.size() > (_timers.size() * 2 + 16)) {
+		compactTimers();
+	}
+}
+
+/**
+ * Call fun with opaque from the main loop whenever signal is received.
+ * fun may be nullptr to ignore the signal.
+ */
+void
+Mainloop::addSignal(int signal, signalFun fun, void *opaque)
+{
+	if (_signal_pipe[0] == -1) {
+		if (pipe(_signal_pipe) == -1) {
+			P_ERR("failed to create signal pipe: " << strerror(errno));
+			return;
+		}
+		for (int i = 0; i < 2; i++) {
+			Util::setNonBlock(_signal_pipe[i]);
+			Util::setCloseOnExec(_signal_pipe[i]);
+		}
+	}
+	addFd(_signal_pipe[0], nullptr, nullptr);
+
+	_signals[signal] = std::make_pair(fun, opaque);
+
+	struct sigaction act;
+	act.sa_handler = sigHandler;
+	sigemptyset(&act.sa_mask);
+	act.sa_flags = SA_NOCLDSTOP | SA_RESTART;
+	sigaction(signal, &act, 0);
+}
+
+/**
+ * Wait for file descriptors, timers or signals and dispatch the
+ * callbacks.
+ *
+ * @param timeout_ms Maximum time to wait, -1 waits until an event occur.
+ * @return Number of dispatched callbacks.
+ */
+int
+Mainloop::wait(int timeout_ms)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	int timer_timeout = getTimerTimeout(now);
+	if (timer_timeout != -1
+	    && (timeout_ms == -1 || timer_timeout < timeout_ms)) {
+		timeout_ms = timer_timeout;
+	}
+
+	int dispatched = 0;
+	int ret = poll(_pfds.empty() ? nullptr : &_pfds[0], _pfds.size(),
+		       timeout_ms);
+	if (ret > 0) {
+		// callbacks may add or remove descriptors, collect the ready
+		// descriptors before dispatching.
+		std::vector<int> ready;
+		std::vector<struct pollfd>::iterator pit = _pfds.begin();
+		for (; pit != _pfds.end(); ++pit) {
+			if (pit->revents) {
+				ready.push_back(pit->fd);
+			}
+		}
+
+		std::vector<int>::iterator rit = ready.begin();
+		for (; rit != ready.end(); ++rit) {
+			if (*rit == _signal_pipe[0]) {
+				dispatched += dispatchSignals();
+				continue;
+			}
+
+			std::map<int, FdEntry>::iterator it = _fds.find(*rit);
+			if (it != _fds.end() && it->second.fun) {
+				it->second.fun(*rit, it->second.opaque);
+				dispatched++;
+			}
+		}
+	} else if (ret == -1 && errno != EINTR) {
+		P_ERR("poll failed: " << strerror(errno));
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return dispatched + runTimers(now);
+}
+
+/**
+ * Run all timers with an expire time before now.
+ */
+int
+Mainloop::runTimers(const struct timespec &now)
+{
+	int dispatched = 0;
+	while (! _timer_heap.empty()
+	       && diffTimespecMs(_timer_heap.front().expire, now) <= 0) {
+		TimerExpire expire = _timer_heap.front();
+		std::pop_heap(_timer_heap.begin(), _timer_heap.end());
+		_timer_heap.pop_back();
+
+		std::map<int, Timer>::iterator it = _timers.find(expire.id);
+		if (it == _timers.end()) {
+			continue;
+		}
+
+		Timer timer = it->second;
+		if (timer.repeat) {
+			addTimespecMs(expire.expire, timer.interval_ms);
+			if (diffTimespecMs(expire.expire, now) < 0) {
+				// fell behind, do not try to catch up
+				expire.expire = now;
+				addTimespecMs(expire.expire, timer.interval_ms);
+			}
+			_timer_heap.push_back(expire);
+			std::push_heap(_timer_heap.begin(), _timer_heap.end());
+		} else {
+			_timers.erase(it);
+		}
+
+		timer.fun(expire.id, timer.opaque);
+		dispatched++;
+	}
+	return dispatched;
+}
+
+/**
+ * Get number of milliseconds until the next timer expire, -1 if no
+ * timer is active.
+ */
+int
+Mainloop::getTimerTimeout(const struct timespec &now)
+{
+	while (! _timer_heap.empty()
+	       && _timers.find(_timer_heap.front().id) == _timers.end()) {
+		std::pop_heap(_timer_heap.begin(), _timer_heap.end());
+		_timer_heap.pop_back();
+	}
+
+	if (_timer_heap.empty()) {
+		return -1;
+	}
+	int timeout = diffTimespecMs(_timer_heap.front().expire, now);
+	return timeout < 0 ? 0 : timeout;
+}
+
+int
+Mainloop::dispatchSignals(void)
+{
+	int dispatched = 0;
+	unsigned char sigs[32];
+	ssize_t nread;
+	while ((nread = read(_signal_pipe[0], sigs, sizeof(sigs))) > 0) {
+		for (ssize_t i = 0; i < nread; i++) {
+			std::map<int, std::pair<signalFun, void*> >::iterator it =
+				_signals.find(sigs[i]);
+			if (it != _signals.end() && it->second.first) {
+				it->second.first(sigs[i], it->second.second);
+				dispatched++;
+			}
+		}
+	}
+	return dispatched;
+}
+
+/**
+ * Drop entries for removed timers from the timer heap.
+ */
+void
+Mainloop::compactTimers(void)
+{
+	std::vector<TimerExpire> heap;
+	std::vector<TimerExpire>::iterator it = _timer_heap.begin();
+	for (; it != _timer_heap.end(); ++it) {
+		if (_timers.find(it->id) != _timers.end()) {
+			heap.push_back(*it);
+		}
+	}
+	std::make_heap(heap.begin(), heap.end());
+	_timer_heap.swap(heap);
+}
+
+void
+Mainloop::addTimespecMs(struct timespec &ts, uint ms)
+{
+	ts.tv_sec += ms / 1000;
+	ts.tv_nsec += (ms % 1000) * 1000000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+}
+
+/**
+ * Get a - b in milliseconds, rounded up and clamped to the range of
+ * int. Computed in 64 bits as int milliseconds only cover 24.8 days.
+ */
+int
+Mainloop::diffTimespecMs(const struct timespec &a, const struct timespec &b)
+{
+	int64_t nsec = a.tv_nsec - b.tv_nsec;
+	int64_t ms = static_cast<int64_t>(a.tv_sec - b.tv_sec) * 1000
+		+ nsec / 1000000;
+	if (nsec % 1000000 > 0) {
+		ms++;
+	}
+	if (ms > INT_MAX) {
+		return INT_MAX;
+	} else if (ms < INT_MIN) {
+		return INT_MIN;
+	}
+	return static_cast<int>(ms);
+}
@@ -0,0 +1,128 @@
+//
+// Mainloop.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#ifndef _PEKWM_MAINLOOP_HH_
+#define _PEKWM_MAINLOOP_HH_
+
+#include "config.h"
+
+#include "Types.hh"
+
+#include <map>
+#include <vector>
+
+extern "C" {
+#include <poll.h>
+#include <time.h>
+}
+
+/**
+ * poll based main loop dispatching file descriptor, timer and signal
+ * callbacks.
+ *
+ * The set of file descriptors is only updated when a descriptor is
+ * added or removed, timers are kept in a heap ordered on expire time
+ * and signals are delivered through a self-pipe so no work is done in
+ * the signal handler.
+ */
+class Mainloop {
+public:
+	typedef void(*fdFun)(int fd, void *opaque);
+	typedef void(*timerFun)(int id, void *opaque);
+	typedef void(*signalFun)(int signal, void *opaque);
+
+	Mainloop(void);
+	~Mainloop(void);
+
+	void addFd(int fd, fdFun fun, void *opaque);
+	void removeFd(int fd);
+
+	int addTimer(uint timeout_ms, bool repeat, timerFun fun, void *opaque);
+	void removeTimer(int id);
+	size_t numTimers(void) const { return _timers.size(); }
+
+	void addSignal(int signal, signalFun fun, void *opaque);
+
+	int wait(int timeout_ms = -1);
+
+	static void addTimespecMs(struct timespec &ts, uint ms);
+	static int diffTimespecMs(const struct timespec &a,
+				  const struct timespec &b);
+
+protected:
+	int runTimers(const struct timespec &now);
+	int getTimerTimeout(const struct timespec &now);
+
+private:
+	int dispatchSignals(void);
+	void compactTimers(void);
+
+	class FdEntry {
+	public:
+		FdEntry(fdFun fun_, void *opaque_)
+			: fun(fun_),
+			  opaque(opaque_)
+		{
+		}
+
+		fdFun fun;
+		void *opaque;
+	};
+
+	class Timer {
+	public:
+		Timer(uint interval_ms_, bool repeat_,
+		      timerFun fun_, void *opaque_)
+			: interval_ms(interval_ms_),
+			  repeat(repeat_),
+			  fun(fun_),
+			  opaque(opaque_)
+		{
+		}
+
+		uint interval_ms;
+		bool repeat;
+		timerFun fun;
+		void *opaque;
+	};
+
+	/**
+	 * Entry in the timer heap, entries for removed timers are left in
+	 * the heap and skipped when they reach the top.
+	 */
+	class TimerExpire {
+	public:
+		TimerExpire(const struct timespec &expire_, int id_)
+			: expire(expire_),
+			  id(id_)
+		{
+		}
+
+		/** Ordered so the earliest expire is on top of the heap. */
+		bool operator<(const TimerExpire &rhs) const {
+			if (expire.tv_sec == rhs.expire.tv_sec) {
+				return expire.tv_nsec > rhs.expire.tv_nsec;
+			}
+			return expire.tv_sec > rhs.expire.tv_sec;
+		}
+
+		struct timespec expire;
+		int id;
+	};
+
+	std::vector<struct pollfd> _pfds;
+	std::map<int, FdEntry> _fds;
+
+	int _next_timer_id;
+	std::map<int, Timer> _timers;
+	std::vector<TimerExpire> _timer_heap;
+
+	std::map<int, std::pair<signalFun, void*> > _signals;
+};
+
+#endif // _PEKWM_MAINLOOP_HH_
@@ -220,7 +220,12 @@ PDecor::PDecor(const std::string &decor_name, const Window child_window,
 	  _title_wo(true),
 	  _title_active(0),
 	  _titles_left(0),
-	  _titles_right(1)
+	  _titles_right(1),
+	  _title_bg(None),
+	  _title_pix(None),
+	  _title_pix_width(0),
+	  _title_pix_height(0),
+	  _title_pix_state(FOCUSED_STATE_FOCUSED)
 {
 	if (init) {
 		this->init(child_window);
@@ -336,6 +341,9 @@ PDecor::~PDecor(void)
 {
 	_pdecors.erase(std::remove(_pdecors.begin(), _pdecors.end(), this),
 		       _pdecors.end());
+	if (pekwm::repaintScheduler()) {
+		pekwm::repaintScheduler()->remove(this);
+	}
 
 	while (! _children.empty()) {
 		removeChild(_children.back(), false); // Don't call delete this.
@@ -349,6 +357,7 @@ PDecor::~PDecor(void)
 	// free buttons
 	unloadDecor();
 
+	freeTitlePixmaps();
 	removeChildWindow(_title_wo.getWindow());
 	X11::destroyWindow(_title_wo.getWindow());
 	for (uint i = 0; i < BORDER_NO_POS; ++i) {
@@ -447,8 +456,8 @@ PDecor::resize(uint width, uint height)
 	setBorderShape();
 	applyBorderShape();
 
-	renderTitle();
-	renderBorder();
+	scheduleRepaint(RepaintScheduler::PART_TITLE
+			| RepaintScheduler::PART_BORDER);
 }
 
 void
@@ -517,8 +526,8 @@ PDecor::moveResize(int x, int y, uint width, uint height)
 	setBorderShape();
 	applyBorderShape();
 
-	renderTitle();
-	renderBorder();
+	scheduleRepaint(RepaintScheduler::PART_TITLE
+			| RepaintScheduler::PART_BORDER);
 }
 
 void
@@ -533,6 +542,30 @@ PDecor::resizeTitle(void)
 	placeButtons();
 }
 
+/**
+ * Repaint parts of the decor at the end of the current event batch,
+ * multiple updates in the same batch are painted once.
+ */
+void
+PDecor::scheduleRepaint(uint parts)
+{
+	pekwm::repaintScheduler()->damage(this, parts);
+}
+
+/**
+ * Repaint damaged parts of the decor, called by the RepaintScheduler.
+ */
+void
+PDecor::repaint(const RepaintScheduler::Damage &damage)
+{
+	if (damage.parts & RepaintScheduler::PART_TITLE) {
+		renderTitle();
+	}
+	if (damage.parts & RepaintScheduler::PART_BORDER) {
+		renderBorder();
+	}
+}
+
 //! @brief Raises the window, taking _layer into account
 void
 PDecor::raise(void)
@@ -559,10 +592,10 @@ PDecor::setFocused(bool focused)
 	if (_focused != focused) { // save repaints
 		PWinObj::setFocused(focused);
 
-		renderTitle();
+		scheduleRepaint(RepaintScheduler::PART_TITLE
+				| RepaintScheduler::PART_BORDER);
 		renderButtons();
 
-		renderBorder();
 		setBorderShape();
 		applyBorderShape();
 	}
@@ -915,6 +948,10 @@ PDecor::loadDecor(void)
 	unloadDecor();
 	setDataFromDecorName(_decor_name);
 
+	// textures and fonts may have changed, render the title from scratch.
+	_title_render.clear();
+	_title_pix_width = 0;
+
 	// Load decor.
 	std::vector<Theme::PDecorButtonData*>::const_iterator b_it =
 		_data->buttonBegin();
@@ -1351,7 +1388,10 @@ void PDecor::deiconify(void) {
 	}
 }
 
-//! @brief Renders and sets title background
+/**
+ * Render title, only tabs with changed text or state are re-rendered
+ * unless the title size, focus or tab layout changed.
+ */
 void
 PDecor::renderTitle(void)
 {
@@ -1366,57 +1406,158 @@ PDecor::renderTitle(void)
 		calcTabsWidth();
 	}
 
-	PTexture *t_sep = _data->getTextureSeparator(getFocusedState(false));
-	Pixmap title_bg = X11::createPixmap(_title_wo.getWidth(),
-					    _title_wo.getHeight());
-	// Render main background on pixmap
-	PTexture *t_main = _data->getTextureMain(getFocusedState(false));
-	t_main->render(title_bg, 0, 0,
-		       _title_wo.getWidth(), _title_wo.getHeight());
-
-	PFont *font;
-	bool sel; // Current tab selected flag
-	uint x = _titles_left; // Position
-	// Amount of horizontal padding
-	uint pad_horiz =  _data->getPad(PAD_LEFT) + _data->getPad(PAD_RIGHT);
+	uint width = _title_wo.getWidth();
+	uint height = _title_wo.getHeight();
+	uint sep_width =
+		_data->getTextureSeparator(getFocusedState(false))->getWidth();
 
-	uint size = _titles.size();
-	for (uint i = 0; i < size; ++i) {
-		sel = (_title_active == i);
+	std::vector<TitleRender> tabs;
+	uint x = _titles_left;
+	for (uint i = 0; i < _titles.size(); ++i) {
+		bool trim_end = _titles[i]->isCustom() || _titles[i]->isUserSet();
+		tabs.push_back(TitleRender(_titles[i]->getVisible(), x,
+					   _titles[i]->getWidth(),
+					   getFocusedState(_title_active == i),
+					   trim_end));
+		x += _titles[i]->getWidth() + sep_width;
+	}
+
+	std::vector<uint> dirty;
+	bool full = width != _title_pix_width || height != _title_pix_height
+		|| getFocusedState(false) != _title_pix_state
+		|| diffTitleRender(_title_render, tabs, dirty);
+	if (full) {
+		renderTitleBackground(width, height);
+		XCopyArea(X11::getDpy(), _title_bg, _title_pix, X11::getGC(),
+			  0, 0, width, height, 0, 0);
+		std::vector<TitleRender>::iterator it = tabs.begin();
+		for (; it != tabs.end(); ++it) {
+			renderTitleTab(*it);
+		}
+		_title_render_stats.full++;
+		_title_render_stats.tabs += tabs.size();
+	} else if (dirty.empty()) {
+		_title_render_stats.skipped++;
+		return;
+	} else {
+		std::vector<uint>::iterator it = dirty.begin();
+		for (; it != dirty.end(); ++it) {
+			renderTitleTab(tabs[*it]);
+		}
+		_title_render_stats.tabs += dirty.size();
+	}
+	_title_render.swap(tabs);
 
-		// render tab
-		PTexture *tab = _data->getTextureTab(getFocusedState(sel));
-		tab->render(title_bg, x, 0,
-			    _titles[i]->getWidth(), _title_wo.getHeight());
+	// the server may or may not copy the background pixmap, set it
+	// again as it has been updated.
+	X11::setWindowBackgroundPixmap(_title_wo.getWindow(), _title_pix);
+	if (full) {
+		X11::clearWindow(_title_wo.getWindow());
+	} else {
+		std::vector<uint>::iterator it = dirty.begin();
+		for (; it != dirty.end(); ++it) {
+			const TitleRender &tab = _title_render[*it];
+			X11::clearArea(_title_wo.getWindow(),
+				       tab.x, 0, tab.width, height);
+		}
+	}
+}
 
-		font = getFont(getFocusedState(sel));
-		font->setColor(_data->getFontColor(getFocusedState(sel)));
+/**
+ * Compare tabs with the rendered tabs.
+ *
+ * @param dirty Filled with index of tabs that need to be rendered.
+ * @return true if the tab layout changed and the title needs to be
+ *         rendered from scratch.
+ */
+bool
+PDecor::diffTitleRender(const std::vector<TitleRender> &rendered,
+			const std::vector<TitleRender> &tabs,
+			std::vector<uint> &dirty)
+{
+	if (rendered.size() != tabs.size()) {
+		return true;
+	}
 
-		PFont::TrimType trim = PFont::FONT_TRIM_MIDDLE;
-		if (_titles[i]->isCustom() || _titles[i]->isUserSet()) {
-			trim = PFont::FONT_TRIM_END;
+	for (uint i = 0; i < tabs.size(); ++i) {
+		if (rendered[i].x != tabs[i].x
+		    || rendered[i].width != tabs[i].width) {
+			dirty.clear();
+			return true;
 		}
+		if (rendered[i] != tabs[i]) {
+			dirty.push_back(i);
+		}
+	}
+	return false;
+}
 
-		font->draw(title_bg,
-			   x + _data->getPad(PAD_LEFT), // X position
-			   _data->getPad(PAD_UP), // Y position
-			   _titles[i]->getVisible(), 0, // Text and max chars
-			   _titles[i]->getWidth() - pad_horiz, // Available width
-			   trim); // Type of trim
+/**
+ * Render main texture and separators to the title background, creating
+ * new title pixmaps if the size changed.
+ */
+void
+PDecor::renderTitleBackground(uint width, uint height)
+{
+	if (width != _title_pix_width || height != _title_pix_height
+	    || _title_bg == None) {
+		freeTitlePixmaps();
+		_title_bg = X11::createPixmap(width, height);
+		_title_pix = X11::createPixmap(width, height);
+		_title_pix_width = width;
+		_title_pix_height = height;
+	}
+	_title_pix_state = getFocusedState(false);
 
-		// move to next tab (or separator if any)
-		x += _titles[i]->getWidth();
+	PTexture *t_main = _data->getTextureMain(_title_pix_state);
+	t_main->render(_title_bg, 0, 0, width, height);
 
-		// draw separator
+	PTexture *t_sep = _data->getTextureSeparator(_title_pix_state);
+	uint x = _titles_left;
+	uint size = _titles.size();
+	for (uint i = 0; i < size; ++i) {
+		x += _titles[i]->getWidth();
 		if (size > 1 && i < size - 1) {
-			t_sep->render(title_bg, x, 0, 0, 0);
+			t_sep->render(_title_bg, x, 0, 0, 0);
 			x += t_sep->getWidth();
 		}
 	}
+}
 
-	X11::setWindowBackgroundPixmap(_title_wo.getWindow(), title_bg);
-	X11::clearWindow(_title_wo.getWindow());
-	X11::freePixmap(title_bg);
+/**
+ * Render tab onto the title pixmap, restoring the background under the
+ * tab first.
+ */
+void
+PDecor::renderTitleTab(const TitleRender &tab)
+{
+	uint height = _title_pix_height;
+	XCopyArea(X11::getDpy(), _title_bg, _title_pix, X11::getGC(),
+		  tab.x, 0, tab.width, height, tab.x, 0);
+
+	PTexture *t_tab = _data->getTextureTab(tab.state);
+	t_tab->render(_title_pix, tab.x, 0, tab.width, height);
+
+	PFont *font = getFont(tab.state);
+	font->setColor(_data->getFontColor(tab.state));
+
+	uint pad_horiz =  _data->getPad(PAD_LEFT) + _data->getPad(PAD_RIGHT);
+	font->draw(_title_pix,
+		   tab.x + _data->getPad(PAD_LEFT), // X position
+		   _data->getPad(PAD_UP), // Y position
+		   tab.text, 0, // Text and max chars
+		   tab.width - pad_horiz, // Available width
+		   tab.trim_end
+		   ? PFont::FONT_TRIM_END : PFont::FONT_TRIM_MIDDLE);
+}
+
+void
+PDecor::freeTitlePixmaps(void)
+{
+	X11::freePixmap(_title_bg);
+	X11::freePixmap(_title_pix);
+	_title_pix_width = 0;
+	_title_pix_height = 0;
 }
 
 void
@@ -13,6 +13,7 @@
 
 #include "Config.hh"
 #include "PWinObj.hh"
+#include "RepaintScheduler.hh"
 #include "ThemeGm.hh"
 
 class ActionEvent;
@@ -118,6 +119,53 @@ public:
 		uint _width;
 	};
 
+	/** State a title tab was last rendered with. */
+	class TitleRender {
+	public:
+		TitleRender(const std::string &text_, uint x_, uint width_,
+			    FocusedState state_, bool trim_end_)
+			: text(text_),
+			  x(x_),
+			  width(width_),
+			  state(state_),
+			  trim_end(trim_end_)
+		{
+		}
+
+		bool operator==(const TitleRender &rhs) const {
+			return x == rhs.x && width == rhs.width
+				&& state == rhs.state && trim_end == rhs.trim_end
+				&& text == rhs.text;
+		}
+		bool operator!=(const TitleRender &rhs) const {
+			return ! (*this == rhs);
+		}
+
+		std::string text;
+		uint x;
+		uint width;
+		FocusedState state;
+		bool trim_end;
+	};
+
+	/** Number of title renders, for verifying incremental rendering. */
+	class TitleRenderStats {
+	public:
+		TitleRenderStats(void)
+			: full(0),
+			  tabs(0),
+			  skipped(0)
+		{
+		}
+
+		/** Renders of background, separators and all tabs. */
+		uint full;
+		/** Tabs rendered, including tabs in full renders. */
+		uint tabs;
+		/** Renders where nothing had changed. */
+		uint skipped;
+	};
+
 	PDecor(const std::string &decor_name = DEFAULT_DECOR_NAME,
 	       const Window child_window = None,
 	       bool init = true);
@@ -168,6 +216,8 @@ public:
 	virtual void setSkip(uint skip);
 
 	virtual std::string getDecorName(void);
+
+	virtual void repaint(const RepaintScheduler::Damage &damage);
 	// END - PDecor interface.
 
 	static std::vector<PDecor*>::const_iterator pdecor_begin(void) {
@@ -195,6 +245,10 @@ public:
 
 	uint getRealHeight(void) const;
 
+	const TitleRenderStats &getTitleRenderStats(void) const {
+		return _title_render_stats;
+	}
+
 	//! @brief Returns last click x root position.
 	inline int getPointerX(void) const { return _pointer_x; }
 	//! @brief Returns last click y root position.
@@ -309,12 +363,17 @@ protected:
 #endif // PEKWM_HAVE_SHAPE
 
 	void resizeTitle(void);
+	void scheduleRepaint(uint parts);
 
 	static void checkWOSnap(PWinObj *skip_wo, Geometry &gm);
 	static void checkEdgeSnap(Geometry &gm);
 
 	void alignChild(PWinObj *child);
 
+	static bool diffTitleRender(const std::vector<TitleRender> &rendered,
+				    const std::vector<TitleRender> &tabs,
+				    std::vector<uint> &dirty);
+
 	FocusedState getFocusedState(bool selected) const {
 		if (selected) {
 			return _focused
@@ -359,6 +418,10 @@ private:
 	void calcTabsWidthAsymetricGrow(uint width_avail, uint tab_width);
 	void calcTabsWidthAsymetricShrink(uint width_avail, uint tab_width);
 
+	void renderTitleBackground(uint width, uint height);
+	void renderTitleTab(const TitleRender &tab);
+	void freeTitlePixmaps(void);
+
 protected:
 	std::string _decor_name; //!< Name of the active decoration
 	/** Original decor name if it is temp. overridden */
@@ -421,6 +484,16 @@ private:
 	std::vector<PDecor::TitleItem*> _titles;
 	uint _titles_left, _titles_right; // area where to put titles
 
+	/** Title background, main texture and separators. */
+	Pixmap _title_bg;
+	/** Title background with tabs, used as title window background. */
+	Pixmap _title_pix;
+	uint _title_pix_width, _title_pix_height;
+	FocusedState _title_pix_state;
+	/** Tabs as rendered on _title_pix. */
+	std::vector<TitleRender> _title_render;
+	TitleRenderStats _title_render_stats;
+
 	static std::vector<PDecor*> _pdecors; /**< List of all PDecors */
 };
 
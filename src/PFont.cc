@@ -20,6 +20,9 @@
 std::string PFont::_trim_string = std::string();
 const char *FALLBACK_FONT = "fixed";
 
+/** Maximum number of cached width measurements per font. */
+static const size_t WIDTH_CACHE_MAX = 1024;
+
 // PFont::Color
 
 PFont::Color::Color(void)
@@ -122,22 +125,76 @@ PFont::trim(std::string &text, PFont::TrimType trim_type, uint max_width)
 	}
 }
 
+/**
+ * Get the width text would take using this font, measurements are
+ * cached as the same titles are measured over and over again.
+ *
+ * @param text Text to measure.
+ * @param max_chars Number of bytes of text to measure, 0 for all.
+ */
+uint
+PFont::getWidth(const std::string &text, uint max_chars)
+{
+	if (text.empty()) {
+		return 0;
+	}
+
+	// only the measured prefix affects the width, use it as the key so
+	// prefixes and full strings share entries.
+	bool prefix = max_chars > 0 && max_chars < text.size();
+	const std::string &key = prefix ? text.substr(0, max_chars) : text;
+
+	uint *width = _width_cache.find(key);
+	if (width) {
+		return *width;
+	}
+
+	if (_width_cache.size() >= WIDTH_CACHE_MAX) {
+		_width_cache.clear();
+	}
+	uint measured = measureWidth(text, max_chars);
+	_width_cache.insert(key, measured);
+	return measured;
+}
+
+/**
+ * Get byte positions of all characters in text except the first, these
+ * are the lengths of all non-empty prefixes shorter than text.
+ */
+void
+PFont::getCharPositions(const std::string &text,
+			std::vector<size_t> &positions)
+{
+	Charset::Utf8Iterator it(text, 0);
+	for (++it; ! it.end(); ++it) {
+		positions.push_back(it.pos());
+	}
+}
+
 /**
  * Figures how many charachters to have before exceding max_width
+ *
+ * Prefix widths grow with the prefix length, so the longest prefix
+ * that fits is found with a binary search.
  */
 void
 PFont::trimEnd(std::string &text, uint max_width)
 {
-	Charset::Utf8Iterator it(text, text.size());
-	--it;
-	--it;
-	for (; ! it.begin(); --it) {
-		if (getWidth(text, it.pos()) <= max_width) {
-			text = text.substr(0, it.pos());
-			return;
+	std::vector<size_t> positions;
+	getCharPositions(text, positions);
+
+	size_t fit = 0;
+	size_t lo = 0, hi = positions.size();
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (getWidth(text, positions[mid]) <= max_width) {
+			fit = positions[mid];
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
 	}
-	text = "";
+	text = text.substr(0, fit);
 }
 
 /**
@@ -152,9 +209,6 @@ PFont::trimMiddle(std::string &text, uint max_width)
 	uint max_side = (max_width / 2);
 	uint sep_width = getWidth(_trim_string);
 
-	uint pos = 0;
-	std::string dest;
-
 	// If the trim string is too large, do nothing and let trimEnd handle this.
 	if (sep_width > max_width) {
 		return false;
@@ -162,30 +216,48 @@ PFont::trimMiddle(std::string &text, uint max_width)
 	// Add space for the trim string
 	max_side -= sep_width / 2;
 
-	// Get numbers of chars before trim string (..)
-	Charset::Utf8Iterator it(text, text.size());
-	for (--it; ! it.begin(); --it) {
-		if (getWidth(text, it.pos()) <= max_side) {
-			pos = it.pos();
-			dest.insert(0, text.substr(0, it.pos()));
-			break;
+	std::vector<size_t> positions;
+	getCharPositions(text, positions);
+
+	// Get numbers of chars before trim string (..), longest prefix
+	// fitting in max_side.
+	size_t pos = 0, pos_idx = 0;
+	size_t lo = 0, hi = positions.size();
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (getWidth(text, positions[mid]) <= max_side) {
+			pos = positions[mid];
+			pos_idx = mid + 1;
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
 	}
+	std::string dest(text.substr(0, pos));
 
-	// get numbers of chars after ...
+	// get numbers of chars after ..., longest suffix starting after
+	// pos fitting in max_side. Suffix widths shrink as the start moves
+	// towards the end.
 	if (pos < text.size()) {
-		for (++it; ! it.end(); ++it) {
-			std::string second_part(text.substr(it.pos(), text.size() - it.pos()));
+		size_t start = text.size();
+		lo = pos_idx;
+		hi = positions.size();
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+			std::string second_part(text.substr(positions[mid]));
 			if (getWidth(second_part, 0) <= max_side) {
-				dest.insert(dest.size(), second_part);
-				break;
+				start = positions[mid];
+				hi = mid;
+			} else {
+				lo = mid + 1;
 			}
 		}
+		dest.insert(dest.size(), text.substr(start));
 
 		// Got a char after and before, if not do nothing and trimEnd
 		// will handle trimming after this call.
 		if (dest.size() > 1) {
-			if ((getWidth(dest) + getWidth(_trim_string)) <= max_width) {
+			if ((getWidth(dest) + sep_width) <= max_width) {
 				dest.insert(pos, _trim_string);
 				trimmed = true;
 			}
@@ -275,6 +347,8 @@ PFontX11::load(const std::string &font_name)
 void
 PFontX11::unload(void)
 {
+	clearWidthCache();
+
 	if (_font) {
 		XFreeFont(X11::getDpy(), _font);
 		_font = 0;
@@ -291,7 +365,7 @@ PFontX11::unload(void)
 
 //! @brief Gets the width the text would take using this font
 uint
-PFontX11::getWidth(const std::string &text, uint max_chars)
+PFontX11::measureWidth(const std::string &text, uint max_chars)
 {
 	if (! text.size()) {
 		return 0;
@@ -431,6 +505,8 @@ PFontXmb::load(const std::string &font_name)
 void
 PFontXmb::unload(void)
 {
+	clearWidthCache();
+
 	if (_fontset) {
 		XFreeFontSet(X11::getDpy(), _fontset);
 		_fontset = 0;
@@ -448,7 +524,7 @@ PFontXmb::unload(void)
 
 //! @brief Gets the width the text would take using this font
 uint
-PFontXmb::getWidth(const std::string &text, uint max_chars)
+PFontXmb::measureWidth(const std::string &text, uint max_chars)
 {
 	if (! text.size()) {
 		return 0;
@@ -559,6 +635,8 @@ PFontXft::load(const std::string &font_name)
 void
 PFontXft::unload(void)
 {
+	clearWidthCache();
+
 	if (_font) {
 		XftFontClose(X11::getDpy(), _font);
 		_font = 0;
@@ -567,7 +645,7 @@ PFontXft::unload(void)
 
 //! @brief Gets the width the text would take using this font
 uint
-PFontXft::getWidth(const std::string &text, uint max_chars)
+PFontXft::measureWidth(const std::string &text, uint max_chars)
 {
 	if (! text.size()) {
 		return 0;
@@ -12,8 +12,10 @@
 #include "config.h"
 
 #include <string>
+#include <vector>
 
 #include "pekwm.hh"
+#include "HashMap.hh"
 
 extern "C" {
 #ifdef PEKWM_HAVE_XFT
@@ -62,7 +64,11 @@ public:
 	inline uint getJustify(void) const { return _justify; }
 
 	inline void setJustify(uint j) { _justify = j; }
-	inline void setOffset(uint x, uint y) { _offset_x = x; _offset_y = y; }
+	inline void setOffset(uint x, uint y) {
+		_offset_x = x;
+		_offset_y = y;
+		_width_cache.clear();
+	}
 
 	int draw(Drawable dest, int x, int y, const std::string &text,
 		 uint max_chars = 0, uint max_width = 0,
@@ -81,20 +87,31 @@ public:
 	virtual bool load(const std::string& font_name) = 0;
 	virtual void unload(void) { }
 
-	virtual uint getWidth(const std::string& text, uint max_chars = 0) = 0;
+	uint getWidth(const std::string& text, uint max_chars = 0);
 	virtual uint getHeight(void) { return _height; }
 
 	virtual void setColor(PFont::Color* color) = 0;
 
+protected:
+	virtual uint measureWidth(const std::string& text, uint max_chars) = 0;
+	void clearWidthCache(void) { _width_cache.clear(); }
+
 private:
 	virtual void drawText(Drawable dest, int x, int y, const std::string &text,
 			      uint chars, bool fg) = 0;
 
+	static void getCharPositions(const std::string &text,
+				     std::vector<size_t> &positions);
+
 protected:
 	uint _height, _ascent, _descent;
 	uint _offset_x, _offset_y, _justify;
 
 	static std::string _trim_string;
+
+private:
+	/** Measured width of text, keyed on the measured prefix. */
+	HashMap<std::string, uint> _width_cache;
 };
 
 class PFontX11 : public PFont {
@@ -106,10 +123,11 @@ public:
 	virtual bool load(const std::string &name);
 	virtual void unload(void);
 
-	virtual uint getWidth(const std::string &text, uint max_chars = 0);
-
 	virtual void setColor(PFont::Color *color);
 
+protected:
+	virtual uint measureWidth(const std::string &text, uint max_chars);
+
 private:
 	virtual void drawText(Drawable dest, int x, int y, const std::string &text,
 			      uint chars, bool fg);
@@ -128,10 +146,11 @@ public:
 	virtual bool load(const std::string &name);
 	virtual void unload(void);
 
-	virtual uint getWidth(const std::string &text, uint max_chars = 0);
-
 	virtual void setColor(PFont::Color *color);
 
+protected:
+	virtual uint measureWidth(const std::string &text, uint max_chars);
+
 private:
 	virtual void drawText(Drawable dest, int x, int y, const std::string &text,
 			      uint chars, bool fg);
@@ -151,10 +170,11 @@ public:
 	virtual bool load(const std::string &font_name);
 	virtual void unload(void);
 
-	virtual uint getWidth(const std::string &text, uint max_chars = 0);
-
 	virtual void setColor(PFont::Color *color);
 
+protected:
+	virtual uint measureWidth(const std::string &text, uint max_chars);
+
 private:
 	virtual void drawText(Drawable dest, int x, int y, const std::string &text,
 			      uint chars, bool fg);
@@ -9,25 +9,28 @@
 #include "config.h"
 
 #include "Debug.hh"
+#include "ImageHandler.hh"
 #include "PImage.hh"
 #include "PImageLoaderJpeg.hh"
 #include "PImageLoaderPng.hh"
 #include "PImageLoaderXpm.hh"
 #include "Util.hh"
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
 
 extern "C" {
 #include <X11/Xutil.h>
-}
-
-static void
-destroyXImage(XImage *ximage)
-{
-	delete [] ximage->data;
-	ximage->data = nullptr;
-	X11::destroyImage(ximage);
+#ifdef PEKWM_HAVE_XRENDER
+#include <X11/extensions/Xrender.h>
+#endif // PEKWM_HAVE_XRENDER
 }
 
 typedef ulong (*rgbToPixel)(uchar, uchar, uchar);
@@ -116,6 +119,130 @@ getRgbToPixelFun(XImage* ximage)
 	}
 }
 
+/**
+ * Byte order of the host, pixels can be stored as words in XImages with
+ * the same byte order.
+ */
+static int
+getHostByteOrder(void)
+{
+	uint order = 1;
+	return *reinterpret_cast<uchar*>(&order) ? LSBFirst : MSBFirst;
+}
+
+typedef void (*argbToPixelRow)(const uchar*, uint*, size_t);
+
+/**
+ * Convert row of ARGB data to 24-bit pixels with red in the high byte.
+ */
+static void
+argbToPixelRow24bitLSB(const uchar *src, uint *dst, size_t width)
+{
+	size_t x = 0;
+#ifdef __SSE2__
+	// SSE2 is only available on little endian hosts, the ARGB bytes of
+	// each pixel are loaded as BGRA words.
+	const __m128i mask_g = _mm_set1_epi32(0x00ff00);
+	const __m128i mask_r = _mm_set1_epi32(0xff0000);
+	for (; x + 4 <= width; x += 4) {
+		__m128i argb = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(src + x * 4));
+		__m128i b = _mm_srli_epi32(argb, 24);
+		__m128i g = _mm_and_si128(_mm_srli_epi32(argb, 8), mask_g);
+		__m128i r = _mm_and_si128(_mm_slli_epi32(argb, 8), mask_r);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+				 _mm_or_si128(_mm_or_si128(r, g), b));
+	}
+#endif // __SSE2__
+	for (; x < width; ++x) {
+		const uchar *p = src + x * 4;
+		dst[x] = (p[1] << 16) | (p[2] << 8) | p[3];
+	}
+}
+
+/**
+ * Convert row of ARGB data to 24-bit pixels with blue in the high byte.
+ */
+static void
+argbToPixelRow24bitMSB(const uchar *src, uint *dst, size_t width)
+{
+	size_t x = 0;
+#ifdef __SSE2__
+	const __m128i mask_bgr = _mm_set1_epi32(0xffffff);
+	for (; x + 4 <= width; x += 4) {
+		__m128i argb = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(src + x * 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+				 _mm_and_si128(_mm_srli_epi32(argb, 8),
+					       mask_bgr));
+	}
+#endif // __SSE2__
+	for (; x < width; ++x) {
+		const uchar *p = src + x * 4;
+		dst[x] = (p[3] << 16) | (p[2] << 8) | p[1];
+	}
+}
+
+/**
+ * Get row conversion for XImage, nullptr if the XImage does not store
+ * 24-bit pixels as words in host byte order.
+ */
+static argbToPixelRow
+getArgbToPixelRowFun(XImage *ximage)
+{
+	if (ximage->bits_per_pixel != 32
+	    || ximage->byte_order != getHostByteOrder()) {
+		return nullptr;
+	}
+
+	if ((ximage->red_mask == 0xff0000)
+	    && (ximage->green_mask == 0xff00)
+	    && (ximage->blue_mask == 0xff)) {
+		return argbToPixelRow24bitLSB;
+	} else if ((ximage->red_mask == 0xff)
+		   && (ximage->green_mask == 0xff00)
+		   && (ximage->blue_mask == 0xff0000)) {
+		return argbToPixelRow24bitMSB;
+	}
+	return nullptr;
+}
+
+/**
+ * Get mask bits for 8 pixels of ARGB data, the first pixel in the
+ * lowest bit. Pixels with alpha above 127 are set.
+ */
+static inline uchar
+getMaskBits(const uchar *src)
+{
+#ifdef __SSE2__
+	// the high bit of the alpha byte is in bit 0, 4, 8 and 12 of the
+	// byte mask.
+	int lo = _mm_movemask_epi8(_mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(src)));
+	int hi = _mm_movemask_epi8(_mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(src + 16)));
+	int bits = lo | (hi << 16);
+	return (bits & 0x01) | ((bits >> 3) & 0x02)
+		| ((bits >> 6) & 0x04) | ((bits >> 9) & 0x08)
+		| ((bits >> 12) & 0x10) | ((bits >> 15) & 0x20)
+		| ((bits >> 18) & 0x40) | ((bits >> 21) & 0x80);
+#else // ! __SSE2__
+	uchar bits = 0;
+	for (int i = 0; i < 8; i++) {
+		bits |= (src[i * 4] >> 7) << i;
+	}
+	return bits;
+#endif // __SSE2__
+}
+
+static inline uchar
+reverseBits(uchar bits)
+{
+	bits = ((bits & 0xf0) >> 4) | ((bits & 0x0f) << 4);
+	bits = ((bits & 0xcc) >> 2) | ((bits & 0x33) << 2);
+	return ((bits & 0xaa) >> 1) | ((bits & 0x55) << 1);
+}
+
 typedef void (*pixelToRgb)(ulong, uchar&, uchar&, uchar&);
 
 static void
@@ -211,9 +338,11 @@ getPixelToRgbFun(XImage *ximage)
 }
 
 PImage::PImage(void)
-	: _type(IMAGE_TYPE_NO),
+	: _id(nextId()),
+	  _type(IMAGE_TYPE_NO),
 	  _pixmap(None),
 	  _mask(None),
+	  _picture(None),
 	  _width(0),
 	  _height(0),
 	  _data(nullptr),
@@ -227,9 +356,11 @@ PImage::PImage(void)
  * @param path Path to image file, if specified this is loaded.
  */
 PImage::PImage(const std::string &path)
-	: _type(IMAGE_TYPE_NO),
+	: _id(nextId()),
+	  _type(IMAGE_TYPE_NO),
 	  _pixmap(None),
 	  _mask(None),
+	  _picture(None),
 	  _width(0),
 	  _height(0),
 	  _data(nullptr),
@@ -241,9 +372,11 @@ PImage::PImage(const std::string &path)
 }
 
 PImage::PImage(PImage *image)
-	: _type(image->getType()),
+	: _id(nextId()),
+	  _type(image->getType()),
 	  _pixmap(None),
 	  _mask(None),
+	  _picture(None),
 	  _width(image->getWidth()),
 	  _height(image->getHeight()),
 	  _use_alpha(image->_use_alpha)
@@ -256,9 +389,11 @@ PImage::PImage(PImage *image)
  * Create PImage from XImage.
  */
 PImage::PImage(XImage *image, uchar opacity)
-	: _type(IMAGE_TYPE_FIXED),
+	: _id(nextId()),
+	  _type(IMAGE_TYPE_FIXED),
 	  _pixmap(None),
 	  _mask(None),
+	  _picture(None),
 	  _width(image->width),
 	  _height(image->height),
 	  _data(new uchar[image->width * image->height * 4]),
@@ -338,11 +473,18 @@ PImage::unload(void)
 	if (_mask) {
 		X11::freePixmap(_mask);
 	}
+#ifdef PEKWM_HAVE_XRENDER
+	if (_picture != None) {
+		XRenderFreePicture(X11::getDpy(), _picture);
+	}
+#endif // PEKWM_HAVE_XRENDER
 
 	_pixmap = None;
 	_mask = None;
+	_picture = None;
 	_width = 0;
 	_height = 0;
+	_id = nextId();
 }
 
 /**
@@ -374,19 +516,32 @@ PImage::draw(Render &rend, int x, int y, size_t width, size_t height)
 	    || ((_type == IMAGE_TYPE_SCALED)
 		&& (_width == width) && (_height == height))) {
 		if (_use_alpha) {
-			drawAlphaFixed(rend, x, y, width, height, _data);
+			// fixed images are clipped to the image size, never
+			// scaled.
+			width = std::min(width, _width);
+			height = std::min(height, _height);
+			if (! drawAlphaComposite(rend, x, y, width, height,
+						 false)) {
+				drawAlphaFixed(rend, x, y, width, height, _data);
+			}
 		} else {
 			drawFixed(rend, x, y, width, height);
 		}
 	} else if (_type == IMAGE_TYPE_SCALED) {
 		if (_use_alpha) {
-			drawAlphaScaled(rend, x, y, width, height);
+			if (! drawAlphaComposite(rend, x, y, width, height,
+						 false)) {
+				drawAlphaScaled(rend, x, y, width, height);
+			}
 		} else {
 			drawScaled(rend, x, y, width, height);
 		}
 	} else if (_type == IMAGE_TYPE_TILED) {
 		if (_use_alpha) {
-			drawAlphaTiled(rend, x, y, width, height);
+			if (! drawAlphaComposite(rend, x, y, width, height,
+						 true)) {
+				drawAlphaTiled(rend, x, y, width, height);
+			}
 		} else {
 			drawTiled(rend, x, y, width, height);
 		}
@@ -420,13 +575,23 @@ PImage::getPixmap(bool &need_free, size_t width, size_t height)
 		}
 		pix = _pixmap;
 	} else {
-		uchar *scaled_data = getScaledData(width, height);
-		if (scaled_data) {
-			need_free = true;
-			pix = createPixmap(scaled_data, width, height);
-			delete [] scaled_data;
+		ScaledImageCache *cache = getScaledCache();
+		ScaledImage *scaled = getScaledImage(cache, width, height);
+		if (scaled) {
+			if (scaled->pixmap == None) {
+				cache->setPixmap(scaled, createPixmap(scaled->data,
+								      width, height));
+			}
+			pix = scaled->pixmap;
 		} else {
-			pix = None;
+			uchar *scaled_data = getScaledData(width, height);
+			if (scaled_data) {
+				need_free = true;
+				pix = createPixmap(scaled_data, width, height);
+				delete [] scaled_data;
+			} else {
+				pix = None;
+			}
 		}
 	}
 
@@ -466,13 +631,23 @@ PImage::getMask(bool &need_free, size_t width, size_t height)
 		}
 		pix = _mask;
 	} else {
-		uchar *scaled_data = getScaledData(width, height);
-		if (scaled_data) {
-			need_free = true;
-			pix = createMask(scaled_data, width, height);
-			delete [] scaled_data;
+		ScaledImageCache *cache = getScaledCache();
+		ScaledImage *scaled = getScaledImage(cache, width, height);
+		if (scaled) {
+			if (scaled->mask == None) {
+				cache->setMask(scaled, createMask(scaled->data,
+								  width, height));
+			}
+			pix = scaled->mask;
 		} else {
-			pix = None;
+			uchar *scaled_data = getScaledData(width, height);
+			if (scaled_data) {
+				need_free = true;
+				pix = createMask(scaled_data, width, height);
+				delete [] scaled_data;
+			} else {
+				pix = None;
+			}
 		}
 	}
 
@@ -589,7 +764,7 @@ PImage::drawFixed(Render &rend, int x, int y, size_t width, size_t height)
 		XImage *ximage = createXImage(_data, _width, _height);
 		if (ximage) {
 			rend.putImage(ximage, x, y, width, height);
-			destroyXImage(ximage);
+			X11::destroyImage(ximage);
 		}
 	} else {
 		// Plain copy of the pixmap onto Drawable.
@@ -606,6 +781,27 @@ PImage::drawFixed(Render &rend, int x, int y, size_t width, size_t height)
 void
 PImage::drawScaled(Render &rend, int x, int y, size_t width, size_t height)
 {
+	ScaledImageCache *cache = getScaledCache();
+	ScaledImage *scaled = getScaledImage(cache, width, height);
+	if (scaled) {
+		if (rend.getDrawable() == None) {
+			XImage *ximage = createXImage(scaled->data, width, height);
+			if (ximage) {
+				rend.putImage(ximage, x, y, width, height);
+				X11::destroyImage(ximage);
+			}
+		} else {
+			if (scaled->pixmap == None) {
+				cache->setPixmap(scaled, createPixmap(scaled->data,
+								      width, height));
+			}
+			XCopyArea(X11::getDpy(), scaled->pixmap,
+				  rend.getDrawable(), X11::getGC(),
+				  0, 0, width, height, x, y);
+		}
+		return;
+	}
+
 	// Create scaled representation of image.
 	uchar *scaled_data = getScaledData(width, height);
 	if (scaled_data) {
@@ -613,7 +809,7 @@ PImage::drawScaled(Render &rend, int x, int y, size_t width, size_t height)
 		delete [] scaled_data;
 		if (ximage) {
 			rend.putImage(ximage, x, y, width, height);
-			destroyXImage(ximage);
+			X11::destroyImage(ximage);
 		}
 	}
 }
@@ -649,7 +845,7 @@ PImage::drawTiled(Render &rend, int x, int y, size_t width, size_t height)
 			RenderAndXImage raxi(rend, ximage);
 			renderTiled(x, y, width, height, _width, _height,
 				    renderWithXImageRender, reinterpret_cast<void*>(&raxi));
-			destroyXImage(ximage);
+			X11::destroyImage(ximage);
 		}
 	} else {
 		Drawable dest = rend.getDrawable();
@@ -677,6 +873,12 @@ PImage::drawTiled(Render &rend, int x, int y, size_t width, size_t height)
 void
 PImage::drawAlphaScaled(Render &rend, int x, int y, size_t width, size_t height)
 {
+	ScaledImage *scaled = getScaledImage(getScaledCache(), width, height);
+	if (scaled) {
+		drawAlphaFixed(rend, x, y, width, height, scaled->data);
+		return;
+	}
+
 	uchar *scaled_data = getScaledData(width, height);
 	if (scaled_data) {
 		drawAlphaFixed(rend, x, y, width, height, scaled_data);
@@ -716,6 +918,47 @@ PImage::drawAlphaTiled(Render &rend, int x, int y, size_t width, size_t height)
 		    renderWithAlphaFixed, reinterpret_cast<void*>(&irad));
 }
 
+/**
+ * Draw image using server side compositing, the image is kept as an ARGB
+ * picture on the server and scaled with a picture transform. Fixed
+ * images are clipped to width and height instead of scaled.
+ *
+ * @return false if the renderer does not support compositing.
+ */
+bool
+PImage::drawAlphaComposite(Render &rend, int x, int y,
+                           size_t width, size_t height, bool tile)
+{
+	if (rend.getDrawable() == None || ! X11::hasExtensionXRender()) {
+		return false;
+	}
+
+	XID picture = getPicture();
+	if (picture == None) {
+		return false;
+	}
+	if (_type == IMAGE_TYPE_FIXED) {
+		return rend.composite(picture, width, height,
+				      x, y, width, height, false);
+	}
+	return rend.composite(picture, _width, _height,
+			      x, y, width, height, tile);
+}
+
+/**
+ * Returns ARGB picture of image, None if XRender is unavailable.
+ */
+XID
+PImage::getPicture(void)
+{
+#ifdef PEKWM_HAVE_XRENDER
+	if (_picture == None && _data != nullptr) {
+		_picture = createPicture(_data, _width, _height);
+	}
+#endif // PEKWM_HAVE_XRENDER
+	return _picture;
+}
+
 /**
  * Creates Pixmap from data.
  *
@@ -734,12 +977,74 @@ PImage::createPixmap(uchar* data, size_t width, size_t height)
 		pix = X11::createPixmap(width, height);
 		X11::putImage(pix, X11::getGC(), ximage,
 			      0, 0, 0, 0, width, height);
-		destroyXImage(ximage);
+		X11::destroyImage(ximage);
 	}
 
 	return pix;
 }
 
+#ifdef PEKWM_HAVE_XRENDER
+
+/**
+ * Creates ARGB picture, with premultiplied alpha, from data.
+ *
+ * @param data Pointer to data to create picture from.
+ * @param width Width of image data is representing.
+ * @param height Height of image data is representing.
+ * @return Returns Picture on success, else None.
+ */
+XID
+PImage::createPicture(uchar* data, size_t width, size_t height)
+{
+	Display *dpy = X11::getDpy();
+	XRenderPictFormat *format =
+		XRenderFindStandardFormat(dpy, PictStandardARGB32);
+	if (format == nullptr) {
+		return None;
+	}
+
+	XImage *ximage = XCreateImage(dpy, X11::getVisual(), 32, ZPixmap,
+				      0, nullptr, width, height, 32, 0);
+	if (! ximage) {
+		P_ERR("failed to create XImage " << width << "x" << height);
+		return None;
+	}
+	// pixels are written in host byte order, Xlib swaps them if the
+	// server uses a different order.
+	ximage->byte_order = getHostByteOrder();
+	// freed by XDestroyImage
+	ximage->data =
+		static_cast<char*>(malloc(ximage->bytes_per_line * height));
+
+	uchar *src = data;
+	for (size_t y = 0; y < height; ++y) {
+		uint *dst = reinterpret_cast<uint*>(ximage->data
+						    + y * ximage->bytes_per_line);
+		for (size_t x = 0; x < width; ++x) {
+			uint a = src[0];
+			uint r = (src[1] * a + 127) / 255;
+			uint g = (src[2] * a + 127) / 255;
+			uint b = (src[3] * a + 127) / 255;
+			dst[x] = (a << 24) | (r << 16) | (g << 8) | b;
+			src += 4;
+		}
+	}
+
+	Pixmap pix = XCreatePixmap(dpy, X11::getRoot(), width, height, 32);
+	GC gc = XCreateGC(dpy, pix, 0, 0);
+	X11::putImage(pix, gc, ximage, 0, 0, 0, 0, width, height);
+	XFreeGC(dpy, gc);
+	X11::destroyImage(ximage);
+
+	Picture picture = XRenderCreatePicture(dpy, pix, format, 0, nullptr);
+	XRenderSetPictureFilter(dpy, picture, FilterGood, nullptr, 0);
+	X11::freePixmap(pix);
+
+	return picture;
+}
+
+#endif // PEKWM_HAVE_XRENDER
+
 /**
  * Creates shape mask Pixmap from data.
  *
@@ -765,17 +1070,7 @@ PImage::createMask(uchar* data, size_t width, size_t height)
 
 	// Alocate ximage data storage.
 	ximage->data = new char[ximage->bytes_per_line * height];
-
-	uchar *src = data;
-
-	ulong pixel_trans = X11::getBlackPixel();
-	ulong pixel_solid = X11::getWhitePixel();
-	for (size_t y = 0; y < height; ++y) {
-		for (size_t x = 0; x < width; ++x) {
-			XPutPixel(ximage, x, y, (*src > 127) ? pixel_solid : pixel_trans);
-			src += 4; // Skip A, R, G, and B
-		}
-	}
+	fillMask(ximage, data, X11::getWhitePixel(), X11::getBlackPixel());
 
 	Pixmap pix = X11::createPixmapMask(width, height);
 	GC gc = XCreateGC(X11::getDpy(), pix, 0, 0);
@@ -799,21 +1094,41 @@ PImage::createMask(uchar* data, size_t width, size_t height)
 XImage*
 PImage::createXImage(uchar* data, size_t width, size_t height)
 {
-	// Create XImage
-	XImage *ximage = X11::createImage(nullptr, width, height);
+	// Create XImage, data is allocated by X11
+	XImage *ximage = X11::createImage(width, height);
 	if (! ximage) {
 		P_ERR("failed to create XImage " << width << "x" << height);
 		return nullptr;
 	}
 
-	// Allocate ximage data storage.
-	ximage->data = new char[ximage->bytes_per_line * height];
+	fillXImage(ximage, data);
+	return ximage;
+}
 
-	uchar *src = data;
+/**
+ * Convert ARGB data, of the same size as ximage, to pixels in ximage.
+ *
+ * 24-bit visuals stored as words in host byte order are converted a
+ * row at a time, other visuals use XPutPixel.
+ */
+void
+PImage::fillXImage(XImage *ximage, const uchar *data)
+{
+	size_t width = ximage->width;
+	size_t height = ximage->height;
+
+	argbToPixelRow argbToPixelRow = getArgbToPixelRowFun(ximage);
+	if (argbToPixelRow) {
+		for (size_t y = 0; y < height; ++y) {
+			uint *dst = reinterpret_cast<uint*>(
+				ximage->data + y * ximage->bytes_per_line);
+			argbToPixelRow(data + y * width * 4, dst, width);
+		}
+		return;
+	}
 
+	const uchar *src = data;
 	rgbToPixel rgbToPixel = getRgbToPixelFun(ximage);
-
-	// Put data into XImage.
 	for (size_t y = 0; y < height; ++y) {
 		for (size_t x = 0; x < width; ++x) {
 			// skip alpha
@@ -824,24 +1139,303 @@ PImage::createXImage(uchar* data, size_t width, size_t height)
 			XPutPixel(ximage, x, y, rgbToPixel(r, g, b));
 		}
 	}
+}
 
-	return ximage;
+/**
+ * Set pixels in 1-bit ximage to pixel_solid where the alpha of data is
+ * above 127, else pixel_trans.
+ *
+ * Bitmaps where the bit order matches the byte order are filled 8
+ * pixels at a time, other layouts use XPutPixel.
+ */
+void
+PImage::fillMask(XImage *ximage, const uchar *data,
+		 ulong pixel_solid, ulong pixel_trans)
+{
+	size_t width = ximage->width;
+	size_t height = ximage->height;
+	const uchar *src = data;
+
+	if (ximage->bits_per_pixel != 1
+	    || (ximage->bitmap_unit != 8
+		&& ximage->byte_order != ximage->bitmap_bit_order)) {
+		for (size_t y = 0; y < height; ++y) {
+			for (size_t x = 0; x < width; ++x) {
+				XPutPixel(ximage, x, y,
+					  (*src > 127) ? pixel_solid : pixel_trans);
+				src += 4; // Skip A, R, G, and B
+			}
+		}
+		return;
+	}
+
+	// all bits are flipped if the transparent pixel is set, solid bits
+	// are only kept if solid and transparent pixels differ.
+	uchar flip = (pixel_trans & 1) ? 0xff : 0;
+	uchar keep = ((pixel_solid ^ pixel_trans) & 1) ? 0xff : 0;
+	bool msb = ximage->bitmap_bit_order == MSBFirst;
+	for (size_t y = 0; y < height; ++y) {
+		uchar *dst = reinterpret_cast<uchar*>(
+			ximage->data + y * ximage->bytes_per_line);
+		size_t x = 0;
+		for (; x + 8 <= width; x += 8, src += 32) {
+			uchar bits = getMaskBits(src);
+			bits = (msb ? reverseBits(bits) : bits) & keep;
+			*dst++ = bits ^ flip;
+		}
+		if (x < width) {
+			uchar bits = 0;
+			for (size_t i = 0; x < width; ++x, ++i, src += 4) {
+				bits |= (*src >> 7) << i;
+			}
+			bits = (msb ? reverseBits(bits) : bits) & keep;
+			*dst = bits ^ flip;
+		}
+	}
 }
 
-static inline uchar
-scalePixel(uchar* data, int pos, int width, float x_diff, float y_diff)
+/**
+ * Read ARGB pixel as a 32-bit word, all channels are processed the same
+ * way so the byte order does not matter.
+ */
+static inline uint
+readPixel(const uchar *data, size_t pos)
+{
+	uint pixel;
+	memcpy(&pixel, data + pos * 4, 4);
+	return pixel;
+}
+
+/**
+ * Interpolate between pixels a and b, weight is the weight of b in
+ * 1/256th. Two channels are processed at a time in each 32-bit word,
+ * the sum of the weights is 256 so no channel overflows into the next.
+ */
+static inline uint
+lerpPixel(uint a, uint b, uint weight)
+{
+	uint iweight = 256 - weight;
+	uint rb = ((a & 0x00ff00ff) * iweight
+		   + (b & 0x00ff00ff) * weight) >> 8;
+	uint ag = ((a >> 8) & 0x00ff00ff) * iweight
+		+ ((b >> 8) & 0x00ff00ff) * weight;
+	return (rb & 0x00ff00ff) | (ag & 0xff00ff00);
+}
+
+#ifdef __SSE2__
+/**
+ * Bilinear interpolation of one pixel with all four source pixels
+ * widened to 16-bit lanes in two registers.
+ */
+static inline uint
+bilinearPixelSSE2(const uchar *src, size_t row0, size_t row1,
+		  size_t x0, size_t x1, uint wx, uint wy)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i top = _mm_unpacklo_epi32(
+		_mm_cvtsi32_si128(readPixel(src, row0 + x0)),
+		_mm_cvtsi32_si128(readPixel(src, row0 + x1)));
+	__m128i bottom = _mm_unpacklo_epi32(
+		_mm_cvtsi32_si128(readPixel(src, row1 + x0)),
+		_mm_cvtsi32_si128(readPixel(src, row1 + x1)));
+	top = _mm_unpacklo_epi8(top, zero);
+	bottom = _mm_unpacklo_epi8(bottom, zero);
+
+	short iwx = 256 - wx;
+	__m128i wxv = _mm_set_epi16(wx, wx, wx, wx, iwx, iwx, iwx, iwx);
+	top = _mm_mullo_epi16(top, wxv);
+	bottom = _mm_mullo_epi16(bottom, wxv);
+	top = _mm_srli_epi16(_mm_add_epi16(top, _mm_srli_si128(top, 8)), 8);
+	bottom = _mm_srli_epi16(_mm_add_epi16(bottom,
+					      _mm_srli_si128(bottom, 8)), 8);
+
+	__m128i res = _mm_add_epi16(
+		_mm_mullo_epi16(top, _mm_set1_epi16(256 - wy)),
+		_mm_mullo_epi16(bottom, _mm_set1_epi16(wy)));
+	res = _mm_srli_epi16(res, 8);
+	return _mm_cvtsi128_si32(_mm_packus_epi16(res, res));
+}
+#endif // __SSE2__
+
+/**
+ * Map destination coordinates to source coordinates, sampling at pixel
+ * centers, in 16.16 fixed-point. off is the first source pixel and
+ * weight the weight of the next source pixel in 1/256th.
+ */
+static void
+scaleCoords(size_t ssize, size_t dsize,
+	    std::vector<size_t> &off, std::vector<uint> &weight)
 {
-	float p0 = data[pos];
-	float p1 = data[pos + 4];
-	float p2 = data[pos + width * 4];
-	float p3 = data[pos + 4 + width * 4];
-	float res = p0 * (1 - x_diff) * (1 - y_diff)
-		+ p1 * (x_diff) * (1 - y_diff)
-		+ p2 * (y_diff) * (1 - x_diff)
-		+ p3 * (x_diff * y_diff);
-	return static_cast<uchar>(res);
+	off.resize(dsize);
+	weight.resize(dsize);
+
+	size_t step = (ssize << 16) / dsize;
+	size_t max = (ssize - 1) << 16;
+	for (size_t i = 0; i < dsize; i++) {
+		size_t pos = step * i + step / 2;
+		pos = pos < 0x8000 ? 0 : pos - 0x8000;
+		if (pos > max) {
+			pos = max;
+		}
+		off[i] = pos >> 16;
+		weight[i] = (pos >> 8) & 0xff;
+	}
 }
 
+/**
+ * Bilinear scale of ARGB data using fixed-point arithmetic.
+ */
+void
+PImage::scaleBilinear(const uchar *src, size_t swidth, size_t sheight,
+		      uchar *dst, size_t dwidth, size_t dheight)
+{
+	std::vector<size_t> x_off, y_off;
+	std::vector<uint> x_weight, y_weight;
+	scaleCoords(swidth, dwidth, x_off, x_weight);
+	scaleCoords(sheight, dheight, y_off, y_weight);
+
+	for (size_t dy = 0; dy < dheight; dy++) {
+		size_t row0 = y_off[dy] * swidth;
+		size_t row1 = y_off[dy] + 1 < sheight ? row0 + swidth : row0;
+		uint wy = y_weight[dy];
+
+		for (size_t dx = 0; dx < dwidth; dx++) {
+			size_t x0 = x_off[dx];
+			size_t x1 = x0 + 1 < swidth ? x0 + 1 : x0;
+			uint wx = x_weight[dx];
+
+#ifdef __SSE2__
+			uint pixel = bilinearPixelSSE2(src, row0, row1, x0, x1,
+						       wx, wy);
+#else // ! __SSE2__
+			uint top = lerpPixel(readPixel(src, row0 + x0),
+					     readPixel(src, row0 + x1), wx);
+			uint bottom = lerpPixel(readPixel(src, row1 + x0),
+						readPixel(src, row1 + x1), wx);
+			uint pixel = lerpPixel(top, bottom, wy);
+#endif // __SSE2__
+			memcpy(dst, &pixel, 4);
+			dst += 4;
+		}
+	}
+}
+
+/**
+ * Box filter scale of ARGB data, every destination pixel is the average
+ * of the source pixels it covers. Used for large downscales where
+ * bilinear sampling skips source pixels.
+ */
+void
+PImage::scaleBox(const uchar *src, size_t swidth, size_t sheight,
+		 uchar *dst, size_t dwidth, size_t dheight)
+{
+	std::vector<size_t> x_start(dwidth + 1);
+	for (size_t dx = 0; dx <= dwidth; dx++) {
+		x_start[dx] = dx * swidth / dwidth;
+	}
+
+	// sums are 64 bit, 32 bit overflows once a box covers more than
+	// 2^32 / 255 source pixels.
+	std::vector<uint64_t> sums(dwidth * 4);
+	size_t sy = 0;
+	for (size_t dy = 0; dy < dheight; dy++) {
+		std::fill(sums.begin(), sums.end(), 0);
+
+		size_t sy_end = (dy + 1) * sheight / dheight;
+		uint64_t rows = sy_end - sy;
+		for (; sy < sy_end; sy++) {
+			const uchar *p = src + sy * swidth * 4;
+			for (size_t dx = 0; dx < dwidth; dx++) {
+				uint64_t *sum = &sums[dx * 4];
+				const uchar *end = p + (x_start[dx + 1]
+							- x_start[dx]) * 4;
+#ifdef __SSE2__
+				const __m128i zero = _mm_setzero_si128();
+				__m128i acc_lo = _mm_loadu_si128(
+					reinterpret_cast<__m128i*>(sum));
+				__m128i acc_hi = _mm_loadu_si128(
+					reinterpret_cast<__m128i*>(sum + 2));
+				for (; p < end; p += 4) {
+					__m128i px = _mm_cvtsi32_si128(
+						readPixel(p, 0));
+					px = _mm_unpacklo_epi8(px, zero);
+					px = _mm_unpacklo_epi16(px, zero);
+					acc_lo = _mm_add_epi64(
+						acc_lo,
+						_mm_unpacklo_epi32(px, zero));
+					acc_hi = _mm_add_epi64(
+						acc_hi,
+						_mm_unpackhi_epi32(px, zero));
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(sum),
+						 acc_lo);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(sum + 2),
+						 acc_hi);
+#else // ! __SSE2__
+				for (; p < end; p += 4) {
+					sum[0] += p[0];
+					sum[1] += p[1];
+					sum[2] += p[2];
+					sum[3] += p[3];
+				}
+#endif // __SSE2__
+			}
+		}
+
+		for (size_t dx = 0; dx < dwidth; dx++) {
+			uint64_t count = (x_start[dx + 1] - x_start[dx]) * rows;
+			uint64_t *sum = &sums[dx * 4];
+			for (int i = 0; i < 4; i++) {
+				*dst++ = static_cast<uchar>((sum[i] + count / 2)
+							    / count);
+			}
+		}
+	}
+}
+
+/**
+ * Get scaled representation of image from cache, scaling the image if
+ * not found.
+ *
+ * @return ScaledImage owned by the cache, nullptr if no cache is
+ *         available or the image is too large to be cached.
+ */
+ScaledImage*
+PImage::getScaledImage(ScaledImageCache *cache, size_t width, size_t height)
+{
+	// images too large to be cached, such as wallpapers, are scaled
+	// on every use instead of holding on to the whole budget.
+	if (cache == nullptr || ! cache->fits(width, height)) {
+		return nullptr;
+	}
+
+	ScaledImage *scaled = cache->get(_id, width, height);
+	if (scaled == nullptr) {
+		uchar *scaled_data = getScaledData(width, height);
+		if (scaled_data) {
+			scaled = cache->add(_id, width, height, scaled_data);
+		}
+	}
+	return scaled;
+}
+
+/**
+ * Get scaled image cache, not available in applications without an
+ * ImageHandler.
+ */
+ScaledImageCache*
+PImage::getScaledCache(void)
+{
+	ImageHandler *image_handler = pekwm::imageHandler();
+	return image_handler ? image_handler->getScaledCache() : nullptr;
+}
+
+ulong
+PImage::nextId(void)
+{
+	static ulong next_id = 0;
+	return ++next_id;
+}
 
 /**
  * Scales image data and returns pointer to new data.
@@ -853,34 +1447,16 @@ scalePixel(uchar* data, int pos, int width, float x_diff, float y_diff)
 uchar*
 PImage::getScaledData(size_t dwidth, size_t dheight)
 {
-	if (dwidth < 1 || dheight < 1) {
+	if (dwidth < 1 || dheight < 1 || _width < 1 || _height < 1) {
 		return nullptr;
 	}
 
-	uchar *scaled_data = new uchar[dwidth * dheight * 4] ;
-	float x_ratio = static_cast<float>(_width - 1) / dwidth ;
-	float y_ratio = static_cast<float>(_height - 1) / dheight;
-
-	size_t dst = 0 ;
-	for (size_t dy = 0; dy < dheight; dy++) {
-		for (size_t dx = 0; dx < dwidth; dx++) {
-			size_t sx = static_cast<size_t>(x_ratio * dx);
-			size_t sy = static_cast<size_t>(y_ratio * dy);
-
-			int spos = (sy * _width + sx) * 4;
-			float x_diff = (x_ratio * dx) - sx;
-			float y_diff = (y_ratio * dy) - sy;
-
-			scaled_data[dst++] =
-				scalePixel(_data, spos, _width, x_diff, y_diff); // A
-			scaled_data[dst++] =
-				scalePixel(_data + 1, spos, _width, x_diff, y_diff); // R
-			scaled_data[dst++] =
-				scalePixel(_data + 2, spos, _width, x_diff, y_diff); // G
-			scaled_data[dst++] =
-				scalePixel(_data + 3, spos, _width, x_diff, y_diff); // B
-		}
+	uchar *scaled_data = new uchar[dwidth * dheight * 4];
+	if (dwidth * 2 <= _width && dheight * 2 <= _height) {
+		scaleBox(_data, _width, _height, scaled_data, dwidth, dheight);
+	} else {
+		scaleBilinear(_data, _width, _height,
+			      scaled_data, dwidth, dheight);
 	}
-
 	return scaled_data;
 }
@@ -14,6 +14,9 @@
 
 #include <string>
 
+class ScaledImage;
+class ScaledImageCache;
+
 //! @brief Image baseclass defining interface for image handling.
 class PImage {
 public:
@@ -27,6 +30,9 @@ public:
 	//! @brief Sets type of image.
 	inline void setType(ImageType type) { _type = type; }
 
+	/** Identifier, changes whenever the image data is replaced. */
+	inline ulong getId(void) const { return _id; }
+
 	inline uchar* getData(void) { return _data; }
 	//! @brief Returns width of image.
 	inline size_t getWidth(void) const { return _width; }
@@ -49,6 +55,16 @@ public:
 				   int x, int y, size_t width, size_t height,
 				   uchar* data);
 
+	static void fillXImage(XImage *ximage, const uchar *data);
+	static void fillMask(XImage *ximage, const uchar *data,
+			     ulong pixel_solid, ulong pixel_trans);
+
+	static void scaleBilinear(const uchar *src, size_t swidth,
+				  size_t sheight, uchar *dst,
+				  size_t dwidth, size_t dheight);
+	static void scaleBox(const uchar *src, size_t swidth, size_t sheight,
+			     uchar *dst, size_t dwidth, size_t dheight);
+
 protected:
 	PImage(void);
 
@@ -59,19 +75,34 @@ protected:
 			     int x, int y, size_t widht, size_t height);
 	void drawAlphaTiled(Render &rend,
 			    int x, int y, size_t widht, size_t height);
+	bool drawAlphaComposite(Render &rend, int x, int y,
+				size_t width, size_t height, bool tile);
 
 	Pixmap createPixmap(uchar* data, size_t width, size_t height);
 	Pixmap createMask(uchar* data, size_t width, size_t height);
+	XID getPicture(void);
 
 private:
 	XImage* createXImage(uchar* data, size_t width, size_t height);
+#ifdef PEKWM_HAVE_XRENDER
+	static XID createPicture(uchar* data, size_t width, size_t height);
+#endif // PEKWM_HAVE_XRENDER
 	uchar* getScaledData(size_t width, size_t height);
+	ScaledImage *getScaledImage(ScaledImageCache *cache,
+				    size_t width, size_t height);
+	static ScaledImageCache *getScaledCache(void);
+
+	static ulong nextId(void);
 
 protected:
+	/** Image identifier, used as key in the scaled image cache. */
+	ulong _id;
 	ImageType _type; //!< Type of image.
 
 	Pixmap _pixmap; //!< Pixmap representation of image.
 	Pixmap _mask; //!< Pixmap representation of image shape mask.
+	/** ARGB XRender picture of image, created on first composite. */
+	XID _picture;
 
 	size_t _width; //!< Width of image.
 	size_t _height; //!< Height of image.
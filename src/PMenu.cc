@@ -232,12 +232,18 @@ PMenu::handleButtonRelease(XButtonEvent *ev)
 }
 
 /**
- * Handle Expose event, just redraw the currently selected menu item.
+ * Handle Expose event, the exposed area is collected and the selected
+ * menu item is redrawn once at the end of the event batch.
  */
 ActionEvent*
-PMenu::handleExposeEvent(XExposeEvent*)
+PMenu::handleExposeEvent(XExposeEvent *ev)
 {
-	renderSelectedItem();
+	if (*_menu_wo == ev->window) {
+		Geometry area(ev->x, ev->y, ev->width, ev->height);
+		pekwm::repaintScheduler()->damage(this,
+						  RepaintScheduler::PART_CONTENT,
+						  area);
+	}
 	return nullptr;
 }
 
@@ -762,6 +768,31 @@ PMenu::deselectItem(bool unmap_submenu)
 
 #undef COPY_ITEM_AREA
 
+/**
+ * Repaint the selected item where it intersects the damaged area, the
+ * rest of the menu is painted by the server from the background.
+ */
+void
+PMenu::repaint(const RepaintScheduler::Damage &damage)
+{
+	PDecor::repaint(damage);
+	if (! _mapped || _item_curr >= _items.size()) {
+		return;
+	}
+
+	PMenu::Item *item = _items[_item_curr];
+	if (item->getType() == PMenu::Item::MENU_ITEM_HIDDEN) {
+		return;
+	}
+
+	Geometry gm(item->getX(), item->getY(), _item_width_max, _item_height);
+	if (damage.clip(gm)) {
+		XCopyArea(X11::getDpy(), _menu_bg_se, _menu_wo->getWindow(),
+			  X11::getGC(), gm.x, gm.y, gm.width, gm.height,
+			  gm.x, gm.y);
+	}
+}
+
 //! @brief Selects next item ( wraps ). First item if none is selected.
 void
 PMenu::selectNextItem(void)
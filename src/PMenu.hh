@@ -88,6 +88,7 @@ public:
 
 	// START - PDecor interface.
 	virtual void loadTheme(void);
+	virtual void repaint(const RepaintScheduler::Damage &damage);
 	// END - PDecor interface.
 
 	static inline PMenu *findMenu(Window win) {
@@ -31,7 +31,7 @@ PTexture::render(Drawable draw,
                  int x, int y, size_t width, size_t height,
                  int root_x, int root_y)
 {
-	X11Render rend(draw);
+	XRenderRender rend(draw);
 	render(rend, x, y, width, height, root_x, root_y);
 }
 
@@ -54,8 +54,7 @@ PTexture::render(Render &rend,
 		if (_opacity == 255) {
 			doRender(rend, x, y, width, height);
 		} else {
-			char *data = static_cast<char*>(malloc(width * height * 4));
-			XImage *ximage = X11::createImage(data, width, height);
+			XImage *ximage = X11::createImage(width, height);
 			if (ximage) {
 				XImageRender x_rend(ximage);
 				doRender(x_rend, 0, 0, width, height);
@@ -21,7 +21,8 @@ PWinObj* PWinObj::_skip_enter_after = nullptr;
 PWinObj* PWinObj::_focused_wo = nullptr;
 PWinObj* PWinObj::_root_wo = nullptr;
 std::vector<PWinObj*> PWinObj::_wo_list = std::vector<PWinObj*>();
-std::map<Window, PWinObj*> PWinObj::_wo_map = std::map<Window, PWinObj*>();
+HashMap<Window, PWinObj*> PWinObj::_wo_map;
+HashMap<PWinObj*, size_t> PWinObj::_wo_list_pos;
 
 //! @brief PWinObj constructor.
 PWinObj::PWinObj(bool keyboard_input)
@@ -272,16 +273,27 @@ PWinObj::getSizeRequest(Geometry &request)
 void
 PWinObj::woListAdd(PWinObj *wo)
 {
+	_wo_list_pos.insert(wo, _wo_list.size());
 	_wo_list.push_back(wo);
 }
 
 //! @brief Remove PWinObj from _wo_list.
+//!
+//! The last PWinObj is moved into the removed slot, _wo_list is thus
+//! in creation order only until the first remove.
 void
 PWinObj::woListRemove(PWinObj *wo)
 {
-	std::vector<PWinObj*>::iterator it
-		= find(_wo_list.begin(), _wo_list.end(), wo);
-	if (it != _wo_list.end()) {
-		_wo_list.erase(it);
+	size_t *pos = _wo_list_pos.find(wo);
+	if (pos == nullptr) {
+		return;
+	}
+
+	size_t idx = *pos;
+	_wo_list_pos.erase(wo);
+	if (idx != _wo_list.size() - 1) {
+		_wo_list[idx] = _wo_list.back();
+		_wo_list_pos.insert(_wo_list[idx], idx);
 	}
+	_wo_list.pop_back();
 }
@@ -11,12 +11,10 @@
 
 #include "config.h"
 
-#include <algorithm>
-#include <map>
-
 #include "pekwm.hh"
 #include "X11.hh"
 #include "Action.hh"
+#include "HashMap.hh"
 #include "Observable.hh"
 
 //! @brief X11 Window wrapper class.
@@ -29,6 +27,26 @@ public:
 	class PWinObjDeleted : public Observation {
 	};
 
+	/**
+	 * Position in the StackingList, maintained by the list.
+	 */
+	class StackingPos {
+	public:
+		StackingPos(void)
+			: prev(nullptr),
+			  next(nullptr),
+			  layer(LAYER_NONE),
+			  stacked(false)
+		{
+		}
+
+		PWinObj *prev; //!< PWinObj below.
+		PWinObj *next; //!< PWinObj above.
+		/** Layer the PWinObj is stacked in, kept on layer changes. */
+		Layer layer;
+		bool stacked; //!< Set when in a StackingList.
+	};
+
 	//! @brief PWinObj inherited types.
 	enum Type {
 		WO_FRAME = (1<<1), //!< Frame type.
@@ -65,20 +83,15 @@ public:
 	//! @param win Window to match PWinObjs against.
 	//! @return PWinObj pointer on match, else 0.
 	static inline PWinObj *findPWinObj(Window win) {
-		std::map<Window, PWinObj*>::iterator it(_wo_map.find(win));
-		return (it != _wo_map.end()) ? it->second : 0;
+		PWinObj **wo = _wo_map.find(win);
+		return wo ? *wo : 0;
 	}
 
 	//! @brief Searches in PWinObj list if PWinObj wo exists.
 	//! @param wo PWinObj to search for.
 	//! @return true if found, else false.
 	static inline bool windowObjectExists(PWinObj *wo) {
-		std::vector<PWinObj*>::iterator it =
-			std::find(_wo_list.begin(), _wo_list.end(), wo);
-		if (it != _wo_list.end()) {
-			return true;
-		}
-		return false;
+		return _wo_list_pos.contains(wo);
 	}
 
 	static bool isSkipEnterAfter(Window win) {
@@ -133,6 +146,7 @@ public:
 	inline uint getWorkspace(void) const { return _workspace; }
 	/** @brief Returns layer PWinObj is in. */
 	inline Layer getLayer(void) const { return _layer; }
+	StackingPos &getStackingPos(void) { return _stacking_pos; }
 
 	//! @brief Returns mapped state of PWinObj.
 	inline bool isMapped(void) const { return _mapped; }
@@ -259,6 +273,8 @@ protected:
 	bool _shape_bounding:1; //!< _window has a custom bounding region (shape)
 	bool _keyboard_input:1; //!< PWinObj is consuming keyboard input.
 
+	StackingPos _stacking_pos; //!< Position in the stacking list.
+
 	/**
 	 * Window to skip (instead of PWinObj), set on PWinObj destructor
 	 * to preserve skip functionality when PWinObj goes away.
@@ -269,7 +285,9 @@ protected:
 	static PWinObj *_root_wo; //!< Static root PWinObj pointer.
 	static PWinObj *_focused_wo; //!< Static focused PWinObj pointer.
 	static std::vector<PWinObj*> _wo_list; //!< List of PWinObjs.
-	static std::map<Window, PWinObj*> _wo_map; //!< Mapping of Window to PWinObj
+	static HashMap<Window, PWinObj*> _wo_map; //!< Mapping of Window to PWinObj
+	/** Position of PWinObj in _wo_list, for O(1) remove. */
+	static HashMap<PWinObj*, size_t> _wo_list_pos;
 };
 
 #endif // _PEKWM_PWINOBJ_HH_
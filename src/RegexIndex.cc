@@ -0,0 +1,127 @@
+//
+// RegexIndex.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "RegexIndex.hh"
+
+#include <algorithm>
+
+/** Maximum number of memoized string pairs. */
+static const size_t MATCHES_MAX = 1024;
+
+void
+RegexIndex::Bucket::add(const std::string &prefix, uint rule)
+{
+	_rules[prefix].push_back(rule);
+	if (std::find(_lengths.begin(), _lengths.end(), prefix.size())
+	    == _lengths.end()) {
+		_lengths.push_back(prefix.size());
+	}
+}
+
+/**
+ * Add rules in buckets str starts with to rules.
+ */
+void
+RegexIndex::Bucket::find(const std::string &str, std::vector<uint> &rules)
+{
+	std::vector<size_t>::iterator it = _lengths.begin();
+	for (; it != _lengths.end(); ++it) {
+		if (*it > str.size()) {
+			continue;
+		}
+		std::vector<uint> *bucket = _rules.find(str.substr(0, *it));
+		if (bucket) {
+			rules.insert(rules.end(), bucket->begin(), bucket->end());
+		}
+	}
+}
+
+void
+RegexIndex::Bucket::clear(void)
+{
+	_rules.clear();
+	_lengths.clear();
+}
+
+RegexIndex::RegexIndex(void)
+{
+}
+
+RegexIndex::~RegexIndex(void)
+{
+}
+
+/**
+ * Add rule, the rule number is the number of rules added before it.
+ * The patterns must not change while in the index.
+ */
+void
+RegexIndex::add(const RegexString *first, const RegexString *second)
+{
+	uint rule = _rules.size();
+	_rules.push_back(std::make_pair(first, second));
+	_matches.clear();
+
+	if (! first->is_match_ok() || ! second->is_match_ok()) {
+		// can never match
+	} else if (! first->getLiteralPrefix().empty()) {
+		_first.add(first->getLiteralPrefix(), rule);
+	} else if (! second->getLiteralPrefix().empty()) {
+		_second.add(second->getLiteralPrefix(), rule);
+	} else {
+		_unindexed.push_back(rule);
+	}
+}
+
+void
+RegexIndex::clear(void)
+{
+	_rules.clear();
+	_first.clear();
+	_second.clear();
+	_unindexed.clear();
+	_matches.clear();
+}
+
+/**
+ * Find rules matching first and second.
+ *
+ * @return Matching rule numbers in the order they were added, valid
+ *         until the index is modified or find is called again.
+ */
+const std::vector<uint>&
+RegexIndex::find(const std::string &first, const std::string &second)
+{
+	std::string key(first);
+	key += '\0';
+	key += second;
+
+	std::vector<uint> *matches = _matches.find(key);
+	if (matches) {
+		return *matches;
+	}
+
+	std::vector<uint> candidates(_unindexed);
+	_first.find(first, candidates);
+	_second.find(second, candidates);
+	std::sort(candidates.begin(), candidates.end());
+
+	std::vector<uint> rules;
+	std::vector<uint>::iterator it = candidates.begin();
+	for (; it != candidates.end(); ++it) {
+		if (*_rules[*it].first == first && *_rules[*it].second == second) {
+			rules.push_back(*it);
+		}
+	}
+
+	if (_matches.size() >= MATCHES_MAX) {
+		_matches.clear();
+	}
+	_matches.insert(key, rules);
+	return *_matches.find(key);
+}
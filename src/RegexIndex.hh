@@ -0,0 +1,66 @@
+//
+// RegexIndex.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#ifndef _PEKWM_REGEXINDEX_HH_
+#define _PEKWM_REGEXINDEX_HH_
+
+#include "config.h"
+
+#include "HashMap.hh"
+#include "RegexString.hh"
+
+#include <string>
+#include <vector>
+
+/**
+ * Index of rules matching a pair of strings, such as the name and class
+ * of WM_CLASS, with a RegexString each.
+ *
+ * Rules are bucketed on the literal prefix of the first pattern, or the
+ * second if the first has none, so only rules in buckets the strings
+ * start with and rules without a literal prefix are tried. The matching
+ * rules for a pair of strings are memoized.
+ */
+class RegexIndex {
+public:
+	RegexIndex(void);
+	~RegexIndex(void);
+
+	size_t size(void) const { return _rules.size(); }
+
+	void add(const RegexString *first, const RegexString *second);
+	void clear(void);
+
+	const std::vector<uint> &find(const std::string &first,
+				      const std::string &second);
+
+private:
+	class Bucket {
+	public:
+		void add(const std::string &prefix, uint rule);
+		void find(const std::string &str, std::vector<uint> &rules);
+		void clear(void);
+
+	private:
+		/** Rules by literal prefix. */
+		HashMap<std::string, std::vector<uint> > _rules;
+		/** Lengths of the prefixes in _rules. */
+		std::vector<size_t> _lengths;
+	};
+
+	/** Pattern pair for each rule, rule number is the position. */
+	std::vector<std::pair<const RegexString*, const RegexString*> > _rules;
+	Bucket _first;
+	Bucket _second;
+	/** Rules without a literal prefix, always tried. */
+	std::vector<uint> _unindexed;
+	/** Matching rules keyed on the string pair. */
+	HashMap<std::string, std::vector<uint> > _matches;
+};
+
+#endif // _PEKWM_REGEXINDEX_HH_
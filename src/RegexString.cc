@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 
 #include "Charset.hh"
 #include "Debug.hh"
@@ -21,6 +22,7 @@ const char RegexString::SEPARATOR = '/';
 RegexString::RegexString(void)
 	: _reg_ok(false),
 	  _reg_inverted(false),
+	  _match_type(MATCH_REGEX),
 	  _ref_max(1)
 {
 }
@@ -31,6 +33,7 @@ RegexString::RegexString(void)
 RegexString::RegexString(const std::string &str, bool full)
 	: _reg_ok(false),
 	  _reg_inverted(false),
+	  _match_type(MATCH_REGEX),
 	  _ref_max(1)
 {
 	parse_match(str, full);
@@ -136,15 +139,80 @@ RegexString::parse_match(const std::string &match, bool full)
 			USER_WARN("invalid format of regular expression, "
 				  << "missing separator " << SEPARATOR);
 		}
+		expression_str = match;
 		expression = Charset::toSystem(match);
 	}
 
 	_reg_ok = ! regcomp(&_regex, expression.c_str(), flags);
 	_pattern = match;
+	if (_reg_ok) {
+		parse_literal(expression_str, flags);
+	}
 
 	return _reg_ok;
 }
 
+static bool
+isRegexMeta(char c)
+{
+	return strchr(".[]()*+?{}|^$\\", c) != nullptr;
+}
+
+/**
+ * Look for expressions that are plain (anchored) literals, these are
+ * matched with string compare instead of regexec. The literal prefix
+ * is also extracted for indexing, only ASCII literals are considered
+ * to not depend on the system charset.
+ */
+void
+RegexString::parse_literal(const std::string &expression, int flags)
+{
+	_match_type = MATCH_REGEX;
+	_literal.clear();
+	_prefix.clear();
+	if (_reg_inverted || (flags & REG_ICASE)
+	    || expression.find('|') != std::string::npos) {
+		return;
+	}
+
+	bool anchored = ! expression.empty() && expression[0] == '^';
+	std::string::size_type pos = anchored ? 1 : 0;
+	std::string literal;
+	while (pos < expression.size()) {
+		char c = expression[pos];
+		if (c == '\\' && (pos + 1) < expression.size()
+		    && isRegexMeta(expression[pos + 1])) {
+			literal += expression[pos + 1];
+			pos += 2;
+		} else if (isRegexMeta(c) || (c & 0x80)) {
+			break;
+		} else {
+			literal += c;
+			pos++;
+		}
+	}
+
+	std::string rest = expression.substr(pos);
+	if (rest.empty()) {
+		_match_type = anchored ? MATCH_PREFIX : MATCH_CONTAINS;
+		_literal = literal;
+	} else if (rest == "$" && anchored) {
+		_match_type = MATCH_EXACT;
+		_literal = literal;
+	} else if (literal.empty() && (rest == ".*" || rest == ".*$")) {
+		_match_type = MATCH_ANY;
+	}
+
+	if (anchored) {
+		// the last char is optional if followed by a quantifier
+		if (! rest.empty() && ! literal.empty()
+		    && (rest[0] == '*' || rest[0] == '?' || rest[0] == '{')) {
+			literal.erase(literal.size() - 1);
+		}
+		_prefix = literal;
+	}
+}
+
 //! @brief Parses replace part of ed_s command.
 //! Expects input in the style of /replace/me/. / can be any character
 //! except \. References to sub expressions are made with \num. \0 Represents
@@ -243,8 +311,26 @@ RegexString::operator==(const std::string &rhs) const
 		return false;
 	}
 
-	std::string mb_rhs = Charset::toSystem(rhs);
-	bool match = regexec(&_regex, mb_rhs.c_str(), 0, 0, 0) == 0;
+	bool match;
+	switch (_match_type) {
+	case MATCH_ANY:
+		match = true;
+		break;
+	case MATCH_EXACT:
+		match = rhs == _literal;
+		break;
+	case MATCH_PREFIX:
+		match = rhs.compare(0, _literal.size(), _literal) == 0;
+		break;
+	case MATCH_CONTAINS:
+		match = rhs.find(_literal) != std::string::npos;
+		break;
+	default: {
+		std::string mb_rhs = Charset::toSystem(rhs);
+		match = regexec(&_regex, mb_rhs.c_str(), 0, 0, 0) == 0;
+		break;
+	}
+	}
 
 	return _reg_inverted ? ! match : match;
 }
@@ -259,4 +345,7 @@ RegexString::free_regex(void)
 		_pattern = "";
 	}
 	_reg_inverted = false;
+	_match_type = MATCH_REGEX;
+	_literal.clear();
+	_prefix.clear();
 }
@@ -49,13 +49,25 @@ public:
 		int _ref; //!< Reference string should be replaced with.
 	};
 
+	/** How a parsed match expression is evaluated. */
+	enum MatchType {
+		MATCH_REGEX, //!< regexec
+		MATCH_ANY, //!< .* matches everything
+		MATCH_EXACT, //!< ^literal$
+		MATCH_PREFIX, //!< ^literal
+		MATCH_CONTAINS //!< literal
+	};
+
 	RegexString(void);
 	RegexString(const std::string &string, bool full = false);
 	~RegexString(void);
 
 	//! @brief Returns parse_match data status.
-	bool is_match_ok(void) { return _reg_ok; }
+	bool is_match_ok(void) const { return _reg_ok; }
 	const std::string& getPattern(void) const { return _pattern; }
+	MatchType getMatchType(void) const { return _match_type; }
+	/** Literal all matching strings start with, empty if unknown. */
+	const std::string& getLiteralPrefix(void) const { return _prefix; }
 
 	bool ed_s(std::string &str);
 
@@ -69,6 +81,7 @@ private:
 	RegexString(const RegexString &);
 	RegexString &operator=(const RegexString &);
 	void free_regex(void);
+	void parse_literal(const std::string &expression, int flags);
 
 private:
 	regex_t _regex; //!< Compiled regular expression holder.
@@ -76,6 +89,12 @@ private:
 	std::string _pattern; /**< String regex was compiled from. */
 	/** If true, a non-matching regexp is considered a match. */
 	bool _reg_inverted;
+	/** Set if the expression can be matched without regexec. */
+	MatchType _match_type;
+	/** Literal used for non MATCH_REGEX matching. */
+	std::string _literal;
+	/** Literal prefix of all matching strings. */
+	std::string _prefix;
 
 	int _ref_max; //!< Highest reference used.
 	/** Vector of RegexString::Part holding data generated by parse_replace. */
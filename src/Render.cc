@@ -10,6 +10,9 @@
 
 extern "C" {
 #include <assert.h>
+#ifdef PEKWM_HAVE_XRENDER
+#include <X11/extensions/Xrender.h>
+#endif // PEKWM_HAVE_XRENDER
 }
 
 // Render
@@ -61,6 +64,19 @@ Render::~Render(void)
 {
 }
 
+/**
+ * Composite ARGB picture over the content of the render, scaling it from
+ * src_width x src_height to width x height or tiling it if tile is set.
+ *
+ * @return false if compositing is unsupported, the caller is expected to
+ *         blend the image itself.
+ */
+bool
+Render::composite(XID, uint, uint, int, int, uint, uint, bool)
+{
+	return false;
+}
+
 // X11Render
 
 X11Render::X11Render(Drawable draw)
@@ -138,6 +154,84 @@ X11Render::destroyImage(XImage *image)
 }
 
 
+// XRenderRender
+
+XRenderRender::XRenderRender(Drawable draw)
+	: X11Render(draw),
+	  _picture(None)
+{
+}
+
+XRenderRender::~XRenderRender(void)
+{
+#ifdef PEKWM_HAVE_XRENDER
+	if (_picture != None) {
+		XRenderFreePicture(X11::getDpy(), _picture);
+	}
+#endif // PEKWM_HAVE_XRENDER
+}
+
+bool
+XRenderRender::composite(XID picture, uint src_width, uint src_height,
+                         int dest_x, int dest_y, uint width, uint height,
+                         bool tile)
+{
+#ifdef PEKWM_HAVE_XRENDER
+	if (picture == None || getDrawable() == None
+	    || ! X11::hasExtensionXRender()) {
+		return false;
+	}
+
+	Display *dpy = X11::getDpy();
+	if (_picture == None) {
+		XRenderPictFormat *format =
+			XRenderFindVisualFormat(dpy, X11::getVisual());
+		if (format == nullptr) {
+			return false;
+		}
+		_picture = XRenderCreatePicture(dpy, getDrawable(), format,
+						0, nullptr);
+	}
+
+	// the source picture is shared between renders, transform and
+	// repeat are restored after compositing.
+	XRenderPictureAttributes pa;
+	bool scale = ! tile && (src_width != width || src_height != height);
+	if (scale) {
+		XTransform transform = {{
+			{ XDoubleToFixed(static_cast<double>(src_width) / width),
+			  0, 0 },
+			{ 0, XDoubleToFixed(static_cast<double>(src_height) / height),
+			  0 },
+			{ 0, 0, XDoubleToFixed(1.0) }
+		}};
+		XRenderSetPictureTransform(dpy, picture, &transform);
+	} else if (tile) {
+		pa.repeat = RepeatNormal;
+		XRenderChangePicture(dpy, picture, CPRepeat, &pa);
+	}
+
+	XRenderComposite(dpy, PictOpOver, picture, None, _picture,
+			 0, 0, 0, 0, dest_x, dest_y, width, height);
+
+	if (scale) {
+		XTransform identity = {{
+			{ XDoubleToFixed(1.0), 0, 0 },
+			{ 0, XDoubleToFixed(1.0), 0 },
+			{ 0, 0, XDoubleToFixed(1.0) }
+		}};
+		XRenderSetPictureTransform(dpy, picture, &identity);
+	} else if (tile) {
+		pa.repeat = RepeatNone;
+		XRenderChangePicture(dpy, picture, CPRepeat, &pa);
+	}
+	return true;
+#else // ! PEKWM_HAVE_XRENDER
+	return X11Render::composite(picture, src_width, src_height,
+				    dest_x, dest_y, width, height, tile);
+#endif // PEKWM_HAVE_XRENDER
+}
+
 // XImageRender
 
 XImageRender::XImageRender(XImage *image)
@@ -160,11 +254,10 @@ XImageRender::getDrawable(void) const
 XImage*
 XImageRender::getImage(int src_x, int src_y, uint width, uint height)
 {
-	XImage *image = X11::createImage(nullptr, width, height);
+	XImage *image = X11::createImage(width, height);
 	if (image == nullptr) {
 		return image;
 	}
-	image->data = new char[image->bytes_per_line * height];
 
 	if (static_cast<int>(src_y + height) > _image->height) {
 		height = std::min(height, static_cast<uint>(_image->height - src_y));
@@ -185,8 +278,6 @@ XImageRender::getImage(int src_x, int src_y, uint width, uint height)
 void
 XImageRender::destroyImage(XImage *image)
 {
-	delete [] image->data;
-	image->data = nullptr;
 	X11::destroyImage(image);
 }
 
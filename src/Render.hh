@@ -42,6 +42,9 @@ public:
 	virtual void fill(int x, int y, uint width, uint height) = 0;
 	virtual void putImage(XImage *image, int dest_x, int dest_y,
 			      uint width, uint height) = 0;
+	virtual bool composite(XID picture, uint src_width, uint src_height,
+			       int dest_x, int dest_y, uint width, uint height,
+			       bool tile);
 };
 
 /**
@@ -71,6 +74,24 @@ private:
 	GC _gc;
 };
 
+/**
+ * Renderer compositing ARGB pictures onto a Drawable using XRender,
+ * other primitives are rendered with X11 primitives.
+ */
+class XRenderRender : public X11Render {
+public:
+	XRenderRender(Drawable draw);
+	virtual ~XRenderRender(void);
+
+	virtual bool composite(XID picture, uint src_width, uint src_height,
+			       int dest_x, int dest_y, uint width, uint height,
+			       bool tile);
+
+private:
+	/** Picture of the Drawable, created on first use. */
+	XID _picture;
+};
+
 /**
  * Renderer using XImage APIs for rendering onto a XImage.
  */
@@ -0,0 +1,196 @@
+//
+// RepaintScheduler.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "Debug.hh"
+#include "PDecor.hh"
+#include "RepaintScheduler.hh"
+
+#include <algorithm>
+
+RepaintScheduler::Damage::Damage(void)
+	: parts(0),
+	  full(false),
+	  area(0, 0, 0, 0)
+{
+}
+
+/**
+ * Add damage to the whole of parts.
+ */
+void
+RepaintScheduler::Damage::add(uint parts_)
+{
+	parts |= parts_;
+	if (parts_ & PART_CONTENT) {
+		full = true;
+	}
+}
+
+/**
+ * Add damage to area of the content, area is merged into the bounding
+ * box of the already damaged area.
+ */
+void
+RepaintScheduler::Damage::add(uint parts_, const Geometry &gm)
+{
+	parts |= parts_;
+	if (full || ! gm.width || ! gm.height) {
+		return;
+	}
+
+	if (! area.width || ! area.height) {
+		area = gm;
+		return;
+	}
+
+	int x2 = std::max(area.x + static_cast<int>(area.width),
+			  gm.x + static_cast<int>(gm.width));
+	int y2 = std::max(area.y + static_cast<int>(area.height),
+			  gm.y + static_cast<int>(gm.height));
+	area.x = std::min(area.x, gm.x);
+	area.y = std::min(area.y, gm.y);
+	area.width = x2 - area.x;
+	area.height = y2 - area.y;
+}
+
+bool
+RepaintScheduler::Damage::intersects(const Geometry &gm) const
+{
+	Geometry clipped(gm);
+	return clip(clipped);
+}
+
+/**
+ * Clip gm to the damaged content area.
+ *
+ * @return false if gm is outside of the damaged area.
+ */
+bool
+RepaintScheduler::Damage::clip(Geometry &gm) const
+{
+	if (! (parts & PART_CONTENT)) {
+		return false;
+	}
+	if (full) {
+		return true;
+	}
+
+	int x1 = std::max(area.x, gm.x);
+	int y1 = std::max(area.y, gm.y);
+	int x2 = std::min(area.x + static_cast<int>(area.width),
+			  gm.x + static_cast<int>(gm.width));
+	int y2 = std::min(area.y + static_cast<int>(area.height),
+			  gm.y + static_cast<int>(gm.height));
+	if (x2 <= x1 || y2 <= y1) {
+		return false;
+	}
+
+	gm = Geometry(x1, y1, x2 - x1, y2 - y1);
+	return true;
+}
+
+RepaintScheduler::RepaintScheduler(void)
+{
+}
+
+RepaintScheduler::~RepaintScheduler(void)
+{
+}
+
+/**
+ * Damage parts of decor, content is damaged as a whole.
+ */
+void
+RepaintScheduler::damage(PDecor *decor, uint parts)
+{
+	getOrAdd(decor).add(parts);
+}
+
+/**
+ * Damage area of decor content.
+ */
+void
+RepaintScheduler::damage(PDecor *decor, uint parts, const Geometry &area)
+{
+	getOrAdd(decor).add(parts, area);
+}
+
+/**
+ * Remove decor from the scheduler, must be called before the decor is
+ * deleted.
+ */
+void
+RepaintScheduler::remove(PDecor *decor)
+{
+	size_t *pos = _damage_pos.find(decor);
+	if (pos) {
+		_damage[*pos].first = nullptr;
+		_damage_pos.erase(decor);
+	}
+
+	std::vector<std::pair<PDecor*, Damage> >::iterator it =
+		_flushing.begin();
+	for (; it != _flushing.end(); ++it) {
+		if (it->first == decor) {
+			it->first = nullptr;
+		}
+	}
+}
+
+/**
+ * Get pending damage for decor, nullptr if decor is not damaged.
+ */
+const RepaintScheduler::Damage*
+RepaintScheduler::getDamage(PDecor *decor)
+{
+	size_t *pos = _damage_pos.find(decor);
+	return pos ? &_damage[*pos].second : nullptr;
+}
+
+/**
+ * Repaint all damaged decors, called at the end of an event batch.
+ * Damage added while repainting is kept for the next flush.
+ *
+ * @return Number of repainted decors.
+ */
+uint
+RepaintScheduler::flush(void)
+{
+	if (_damage_pos.empty()) {
+		return 0;
+	}
+
+	_flushing.swap(_damage);
+	_damage.clear();
+	_damage_pos.clear();
+
+	uint repainted = 0;
+	for (size_t i = 0; i < _flushing.size(); i++) {
+		if (_flushing[i].first) {
+			_flushing[i].first->repaint(_flushing[i].second);
+			repainted++;
+		}
+	}
+	_flushing.clear();
+
+	P_TRACE("repainted " << repainted << " decors");
+	return repainted;
+}
+
+RepaintScheduler::Damage&
+RepaintScheduler::getOrAdd(PDecor *decor)
+{
+	size_t *pos = _damage_pos.find(decor);
+	if (pos) {
+		return _damage[*pos].second;
+	}
+
+	_damage_pos.insert(decor, _damage.size());
+	_damage.push_back(std::make_pair(decor, Damage()));
+	return _damage.back().second;
+}
@@ -0,0 +1,81 @@
+//
+// RepaintScheduler.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#ifndef _PEKWM_REPAINTSCHEDULER_HH_
+#define _PEKWM_REPAINTSCHEDULER_HH_
+
+#include "config.h"
+
+#include "HashMap.hh"
+#include "X11.hh"
+
+#include <vector>
+
+class PDecor;
+
+/**
+ * Collects damage for decors during an event batch, each damaged decor
+ * is repainted once when the batch is flushed with the union of the
+ * damaged parts and areas.
+ */
+class RepaintScheduler {
+public:
+	/** Parts of a decor to repaint. */
+	enum Part {
+		PART_TITLE = 1 << 0,
+		PART_BORDER = 1 << 1,
+		/** Decor specific content, menu items or status text. */
+		PART_CONTENT = 1 << 2
+	};
+
+	/** Damaged parts of a decor. */
+	class Damage {
+	public:
+		Damage(void);
+
+		void add(uint parts);
+		void add(uint parts, const Geometry &area);
+		bool intersects(const Geometry &gm) const;
+		bool clip(Geometry &gm) const;
+
+		uint parts;
+		/** Content is damaged as a whole, area is not used. */
+		bool full;
+		/** Bounding box of the damaged content area. */
+		Geometry area;
+	};
+
+	RepaintScheduler(void);
+	~RepaintScheduler(void);
+
+	void damage(PDecor *decor, uint parts);
+	void damage(PDecor *decor, uint parts, const Geometry &area);
+	void remove(PDecor *decor);
+
+	const Damage *getDamage(PDecor *decor);
+	size_t size(void) const { return _damage_pos.size(); }
+
+	uint flush(void);
+
+private:
+	Damage &getOrAdd(PDecor *decor);
+
+	/** Damaged decors in the order they were first damaged. */
+	std::vector<std::pair<PDecor*, Damage> > _damage;
+	/** Position of decor in _damage. */
+	HashMap<PDecor*, size_t> _damage_pos;
+	/** Damage being repainted by flush. */
+	std::vector<std::pair<PDecor*, Damage> > _flushing;
+};
+
+namespace pekwm
+{
+	RepaintScheduler* repaintScheduler(void);
+}
+
+#endif // _PEKWM_REPAINTSCHEDULER_HH_
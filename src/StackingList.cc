@@ -0,0 +1,176 @@
+//
+// StackingList.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "StackingList.hh"
+
+StackingList::StackingList(void)
+	: _size(0)
+{
+	for (int i = 0; i <= LAYER_NONE; i++) {
+		_bottom[i] = nullptr;
+		_top[i] = nullptr;
+	}
+}
+
+StackingList::~StackingList(void)
+{
+}
+
+/**
+ * Check if wo is stacked below other, both must be in the list.
+ * Searches from wo within the layer when in the same layer.
+ */
+bool
+StackingList::isBelow(PWinObj *wo, PWinObj *other)
+{
+	Layer layer = wo->getStackingPos().layer;
+	if (layer != other->getStackingPos().layer) {
+		return layer < other->getStackingPos().layer;
+	}
+
+	// search in both directions to stop early on objects close to
+	// the top or bottom of the layer
+	PWinObj *up = wo->getStackingPos().next;
+	PWinObj *down = wo->getStackingPos().prev;
+	while (up || down) {
+		if (up) {
+			if (up == other) {
+				return true;
+			}
+			up = up->getStackingPos().layer == layer
+				? up->getStackingPos().next : nullptr;
+		}
+		if (down) {
+			if (down == other) {
+				return false;
+			}
+			down = down->getStackingPos().layer == layer
+				? down->getStackingPos().prev : nullptr;
+		}
+	}
+	return false;
+}
+
+PWinObj*
+StackingList::getBottom(void) const
+{
+	for (int i = 0; i <= LAYER_NONE; i++) {
+		if (_bottom[i]) {
+			return _bottom[i];
+		}
+	}
+	return nullptr;
+}
+
+PWinObj*
+StackingList::getTop(void) const
+{
+	return getTopBelow(static_cast<Layer>(LAYER_NONE + 1));
+}
+
+/**
+ * Insert wo at the top of layer, wo is moved if already in the list.
+ */
+void
+StackingList::insertTop(PWinObj *wo, Layer layer)
+{
+	remove(wo);
+	link(wo, layer, _top[layer] ? _top[layer] : getTopBelow(layer));
+}
+
+/**
+ * Insert wo at the bottom of layer.
+ */
+void
+StackingList::insertBottom(PWinObj *wo, Layer layer)
+{
+	remove(wo);
+	link(wo, layer, getTopBelow(layer));
+}
+
+/**
+ * Insert wo directly above below, in the same layer as below.
+ */
+void
+StackingList::insertAbove(PWinObj *wo, PWinObj *below)
+{
+	remove(wo);
+	link(wo, below->getStackingPos().layer, below);
+}
+
+void
+StackingList::remove(PWinObj *wo)
+{
+	PWinObj::StackingPos &pos = wo->getStackingPos();
+	if (! pos.stacked) {
+		return;
+	}
+
+	if (pos.prev) {
+		pos.prev->getStackingPos().next = pos.next;
+	}
+	if (pos.next) {
+		pos.next->getStackingPos().prev = pos.prev;
+	}
+	if (_bottom[pos.layer] == wo) {
+		_bottom[pos.layer] =
+			pos.next && pos.next->getStackingPos().layer == pos.layer
+			? pos.next : nullptr;
+	}
+	if (_top[pos.layer] == wo) {
+		_top[pos.layer] =
+			pos.prev && pos.prev->getStackingPos().layer == pos.layer
+			? pos.prev : nullptr;
+	}
+
+	pos = PWinObj::StackingPos();
+	_size--;
+}
+
+/**
+ * Get the top PWinObj in the layers below layer.
+ */
+PWinObj*
+StackingList::getTopBelow(Layer layer) const
+{
+	for (int i = layer - 1; i >= 0; i--) {
+		if (_top[i]) {
+			return _top[i];
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * Link wo above prev, prev must be in layer or be the top of the layers
+ * below layer. nullptr prev links wo at the bottom of the list, wo
+ * must not be in the list.
+ */
+void
+StackingList::link(PWinObj *wo, Layer layer, PWinObj *prev)
+{
+	PWinObj::StackingPos &pos = wo->getStackingPos();
+	pos.prev = prev;
+	pos.next = prev ? prev->getStackingPos().next : getBottom();
+	pos.layer = layer;
+	pos.stacked = true;
+	if (pos.prev) {
+		pos.prev->getStackingPos().next = wo;
+	}
+	if (pos.next) {
+		pos.next->getStackingPos().prev = wo;
+	}
+
+	if (! prev || prev->getStackingPos().layer != layer) {
+		_bottom[layer] = wo;
+	}
+	if (! _top[layer] || _top[layer] == prev) {
+		_top[layer] = wo;
+	}
+	_size++;
+}
@@ -0,0 +1,129 @@
+//
+// StackingList.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#ifndef _PEKWM_STACKINGLIST_HH_
+#define _PEKWM_STACKINGLIST_HH_
+
+#include "config.h"
+
+#include "PWinObj.hh"
+
+#include <cstddef>
+#include <iterator>
+
+/**
+ * Stacking order of PWinObjs, bottom to top.
+ *
+ * The list is linked through the StackingPos of each PWinObj and is
+ * split in one segment per layer, the bottom and top of each segment is
+ * tracked making insert and remove O(1).
+ */
+class StackingList {
+public:
+	class iterator {
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef PWinObj* value_type;
+		typedef ptrdiff_t difference_type;
+		typedef PWinObj** pointer;
+		typedef PWinObj* reference;
+
+		iterator(void)
+			: _list(nullptr),
+			  _wo(nullptr)
+		{
+		}
+		iterator(const StackingList *list, PWinObj *wo)
+			: _list(list),
+			  _wo(wo)
+		{
+		}
+
+		PWinObj *operator*(void) const { return _wo; }
+
+		iterator &operator++(void) {
+			_wo = _wo->getStackingPos().next;
+			return *this;
+		}
+		iterator operator++(int) {
+			iterator it(*this);
+			++(*this);
+			return it;
+		}
+		iterator &operator--(void) {
+			_wo = _wo ? _wo->getStackingPos().prev : _list->getTop();
+			return *this;
+		}
+		iterator operator--(int) {
+			iterator it(*this);
+			--(*this);
+			return it;
+		}
+
+		bool operator==(const iterator &rhs) const {
+			return _wo == rhs._wo;
+		}
+		bool operator!=(const iterator &rhs) const {
+			return _wo != rhs._wo;
+		}
+
+	private:
+		const StackingList *_list;
+		PWinObj *_wo;
+	};
+	typedef iterator const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef reverse_iterator const_reverse_iterator;
+
+	StackingList(void);
+	~StackingList(void);
+
+	iterator begin(void) const { return iterator(this, getBottom()); }
+	iterator end(void) const { return iterator(this, nullptr); }
+	reverse_iterator rbegin(void) const { return reverse_iterator(end()); }
+	reverse_iterator rend(void) const { return reverse_iterator(begin()); }
+
+	size_t size(void) const { return _size; }
+	bool empty(void) const { return _size == 0; }
+
+	static bool contains(PWinObj *wo) {
+		return wo->getStackingPos().stacked;
+	}
+	/** PWinObj directly above wo, nullptr if wo is at the top. */
+	static PWinObj *getAbove(PWinObj *wo) {
+		return wo->getStackingPos().next;
+	}
+	/** PWinObj directly below wo, nullptr if wo is at the bottom. */
+	static PWinObj *getBelow(PWinObj *wo) {
+		return wo->getStackingPos().prev;
+	}
+	static bool isBelow(PWinObj *wo, PWinObj *other);
+
+	PWinObj *getBottom(void) const;
+	PWinObj *getTop(void) const;
+
+	void insertTop(PWinObj *wo, Layer layer);
+	void insertBottom(PWinObj *wo, Layer layer);
+	void insertAbove(PWinObj *wo, PWinObj *below);
+	void remove(PWinObj *wo);
+
+private:
+	StackingList(const StackingList&);
+	StackingList &operator=(const StackingList&);
+
+	PWinObj *getTopBelow(Layer layer) const;
+	void link(PWinObj *wo, Layer layer, PWinObj *prev);
+
+	/** Bottom PWinObj in each layer, nullptr if empty. */
+	PWinObj *_bottom[LAYER_NONE + 1];
+	/** Top PWinObj in each layer, nullptr if empty. */
+	PWinObj *_top[LAYER_NONE + 1];
+	size_t _size;
+};
+
+#endif // _PEKWM_STACKINGLIST_HH_
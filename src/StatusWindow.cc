@@ -98,12 +98,28 @@ StatusWindow::draw(const std::string &text, bool do_center, Geometry *gm)
 		     gm->y + (gm->height - _gm.height) / 2);
 	}
 
+	// text is drawn once at the end of the event batch, it is updated
+	// on every motion event when moving and resizing.
+	_text = text;
+	scheduleRepaint(RepaintScheduler::PART_CONTENT);
+}
+
+void
+StatusWindow::repaint(const RepaintScheduler::Damage &damage)
+{
+	PDecor::repaint(damage);
+	if (! _mapped || ! (damage.parts & RepaintScheduler::PART_CONTENT)) {
+		return;
+	}
+
+	Theme::TextDialogData *sd = _theme->getStatusData();
+	PFont *font = sd->getFont();
 	font->setColor(sd->getColor());
 	X11::clearWindow(_status_wo->getWindow());
 	font->draw(_status_wo->getWindow(),
-		   (width - font->getWidth(text.c_str())) / 2,
+		   (getChildWidth() - font->getWidth(_text)) / 2,
 		   sd->getPad(PAD_UP),
-		   text.c_str());
+		   _text);
 }
 
 //! @brief Renders and sets background
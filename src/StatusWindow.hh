@@ -25,6 +25,8 @@ public:
 	void draw(const std::string &text, bool do_center = false,
 		  Geometry *gm = 0);
 
+	virtual void repaint(const RepaintScheduler::Damage &damage);
+
 private:
 	// BEGIN - PDecor interface
 	virtual void loadTheme(void);
@@ -36,6 +38,8 @@ private:
 private:
 	Theme* _theme;
 	PWinObj *_status_wo;
+	/** Text drawn on next repaint. */
+	std::string _text;
 };
 
 namespace pekwm
@@ -17,6 +17,10 @@
 
 #include <iostream>
 
+extern "C" {
+#include <ctype.h>
+}
+
 static Util::StringTo<PTexture::Type> parse_map[] =
 	{{"SOLID", PTexture::TYPE_SOLID},
 	 {"SOLIDRAISED", PTexture::TYPE_SOLID_RAISED},
@@ -59,22 +63,23 @@ TextureHandler::~TextureHandler(void)
 PTexture*
 TextureHandler::getTexture(const std::string &texture)
 {
+	std::string key = normalizeKey(texture);
+
 	// check for already existing entry
-	std::vector<TextureHandler::Entry*>::iterator it = _textures.begin();
-	for (; it != _textures.end(); ++it) {
-		if (*(*it) == texture) {
-			(*it)->incRef();
-			return (*it)->getTexture();
-		}
+	TextureHandler::Entry **it = _textures.find(key);
+	if (it) {
+		(*it)->incRef();
+		return (*it)->getTexture();
 	}
 
 	// parse texture
 	PTexture *ptexture = parse(texture);
 	if (ptexture) {
 		// create new entry
-		TextureHandler::Entry *entry = new TextureHandler::Entry(texture, ptexture);
+		TextureHandler::Entry *entry = new TextureHandler::Entry(key, ptexture);
 		entry->incRef();
-		_textures.push_back(entry);
+		_textures.insert(key, entry);
+		_textures_by_ptr.insert(ptexture, entry);
 	}
 
 	return ptexture;
@@ -89,18 +94,16 @@ PTexture*
 TextureHandler::referenceTexture(PTexture *texture)
 {
 	// Check for already existing entry
-	std::vector<TextureHandler::Entry*>::iterator it(_textures.begin());
-	for (; it != _textures.end(); ++it) {
-		if ((*it)->getTexture() == texture) {
-			(*it)->incRef();
-			return texture;
-		}
+	TextureHandler::Entry **it = _textures_by_ptr.find(texture);
+	if (it) {
+		(*it)->incRef();
+		return texture;
 	}
 
 	// Create new entry
 	TextureHandler::Entry *entry = new TextureHandler::Entry("", texture);
 	entry->incRef();
-	_textures.push_back(entry);
+	_textures_by_ptr.insert(texture, entry);
 
 	return texture;
 }
@@ -111,25 +114,50 @@ TextureHandler::referenceTexture(PTexture *texture)
 void
 TextureHandler::returnTexture(PTexture *texture)
 {
-	bool found = false;
-
-	std::vector<TextureHandler::Entry*>::iterator it(_textures.begin());
-	for (; it != _textures.end(); ++it) {
-		if ((*it)->getTexture() == texture) {
-			found = true;
+	TextureHandler::Entry **it = _textures_by_ptr.find(texture);
+	if (it == nullptr) {
+		delete texture;
+		return;
+	}
 
-			(*it)->decRef();
-			if ((*it)->getRef() == 0) {
-				delete *it;
-				_textures.erase(it);
-			}
-			break;
+	TextureHandler::Entry *entry = *it;
+	entry->decRef();
+	if (entry->getRef() == 0) {
+		_textures_by_ptr.erase(texture);
+		if (! entry->getKey().empty()) {
+			_textures.erase(entry->getKey());
 		}
+		delete entry;
 	}
+}
 
-	if (! found) {
-		delete texture;
+/**
+ * Normalize texture specification for use as lookup key. Texture
+ * names are case insensitive and whitespace between tokens is not
+ * significant, so the key is upper case with whitespace runs collapsed
+ * into a single space.
+ */
+std::string
+TextureHandler::normalizeKey(const std::string &texture)
+{
+	std::string key;
+	key.reserve(texture.size());
+
+	bool space = false;
+	std::string::const_iterator it = texture.begin();
+	for (; it != texture.end(); ++it) {
+		uchar chr = static_cast<uchar>(*it);
+		if (isspace(chr)) {
+			space = ! key.empty();
+		} else {
+			if (space) {
+				key += ' ';
+				space = false;
+			}
+			key += static_cast<char>(toupper(chr));
+		}
 	}
+	return key;
 }
 
 /**
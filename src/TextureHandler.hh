@@ -12,6 +12,7 @@
 #include "config.h"
 
 #include "Compat.hh"
+#include "HashMap.hh"
 #include "PTexture.hh"
 
 #include <map>
@@ -28,8 +29,8 @@ class TextureHandler {
 public:
 	class Entry {
 	public:
-		Entry(const std::string &name, PTexture *texture)
-			: _name(name),
+		Entry(const std::string &key, PTexture *texture)
+			: _key(key),
 			  _texture(texture),
 			  _ref(0)
 		{
@@ -39,18 +40,16 @@ public:
 			delete _texture;
 		}
 
+		/** Normalized texture key, empty for referenced textures. */
+		const std::string &getKey(void) const { return _key; }
 		PTexture *getTexture(void) { return _texture; }
 
 		inline uint getRef(void) const { return _ref; }
 		inline void incRef(void) { ++_ref; }
 		inline void decRef(void) { if (_ref > 0) { --_ref; } }
 
-		inline bool operator==(const std::string &name) {
-			return (::strcasecmp(_name.c_str(), name.c_str()) == 0);
-		}
-
 	private:
-		std::string _name;
+		std::string _key;
 		PTexture *_texture;
 
 		uint _ref;
@@ -64,6 +63,10 @@ public:
 	PTexture *referenceTexture(PTexture *texture);
 	void returnTexture(PTexture *texture);
 
+	size_t size(void) const { return _textures_by_ptr.size(); }
+
+	static std::string normalizeKey(const std::string &texture);
+
 private:
 	PTexture *parse(const std::string &texture);
 	PTexture *parseSolid(std::vector<std::string> &tok);
@@ -78,7 +81,10 @@ private:
 	/** Minimum texture name length. */
 	const int _length_min;
 
-	std::vector<TextureHandler::Entry*> _textures;
+	/** Textures by normalized key. */
+	HashMap<std::string, TextureHandler::Entry*> _textures;
+	/** All textures, including referenced textures without a key. */
+	HashMap<PTexture*, TextureHandler::Entry*> _textures_by_ptr;
 	std::map<std::string, std::map<int,int>*> _color_maps;
 };
 
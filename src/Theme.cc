@@ -1240,6 +1240,7 @@ Theme::load(const std::string &dir, const std::string &variant)
 	}
 
 	unload();
+	_ih->clearScaledCache();
 
 	_theme_dir = norm_dir;
 	_theme_file = theme_file;
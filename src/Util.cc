@@ -32,6 +32,7 @@ extern "C" {
 
 #include "CfgParser.hh"
 #include "Charset.hh"
+#include "ChildRegistry.hh"
 #include "Debug.hh"
 #include "Util.hh"
 
@@ -146,58 +147,22 @@ namespace Util {
 	}
 
 	/**
-	 * Fork and execute command with /bin/sh and execlp
+	 * Execute command with /bin/sh in a new session.
 	 */
 	void
 	forkExec(std::string command)
 	{
-		if (command.length() == 0) {
-			P_ERR("command length == 0");
-			return;
-		}
-
-		pid_t pid = fork();
-		switch (pid) {
-		case 0:
-			setsid();
-			execlp("/bin/sh", "sh", "-c", command.c_str(), (char *) 0);
-			P_ERR("execlp failed: " << strerror(errno));
-			exit(1);
-		case -1:
-			P_ERR("fork failed: " << strerror(errno));
-			break;
-		default:
-			P_TRACE("started child " << pid);
-			break;
-		}
+		ChildRegistry::spawnShell(command, -1, true, nullptr, nullptr);
 	}
 
+	/**
+	 * Execute args in a new session, args[0] is searched for in PATH.
+	 */
 	pid_t
 	forkExec(const std::vector<std::string>& args)
 	{
 		assert(! args.empty());
-
-		pid_t pid = fork();
-		switch (pid) {
-		case 0: {
-			int i = 0;
-			char **argv = new char*[args.size() + 1];
-			std::vector<std::string>::const_iterator it = args.begin();
-			for (; it != args.end(); ++it) {
-				argv[i++] = const_cast<char*>(it->c_str());
-			}
-			argv[i] = nullptr;
-
-			setsid();
-			execvp(argv[0], argv);
-			exit(1);
-		}
-		case -1:
-			P_ERR("fork failed: " << strerror(errno));
-		default:
-			P_TRACE("started child " << pid);
-			return pid;
-		}
+		return ChildRegistry::spawn(args, -1, true, nullptr, nullptr);
 	}
 
 	/**
@@ -241,6 +206,27 @@ namespace Util {
 		return true;
 	}
 
+	/**
+	 * Set file descriptor to be closed when executing a new program.
+	 */
+	bool
+	setCloseOnExec(int fd)
+	{
+		int flags = fcntl(fd, F_GETFD, 0);
+		if (flags == -1) {
+			P_ERR("failed to get fd flags from fd " << fd
+			      << ": " << strerror(errno));
+			return false;
+		}
+		int ret = fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+		if (ret == -1) {
+			P_ERR("failed to set FD_CLOEXEC on fd " << fd
+			      << ": " << strerror(errno));
+			return false;
+		}
+		return true;
+	}
+
 	//! @brief Determines if the file exists
 	bool
 	isFile(const std::string &file)
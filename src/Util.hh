@@ -74,6 +74,7 @@ namespace Util {
 	pid_t forkExec(const std::vector<std::string>& args);
 	std::string getHostname(void);
 	bool setNonBlock(int fd);
+	bool setCloseOnExec(int fd);
 
 	bool isFile(const std::string &file);
 	bool isExecutable(const std::string &file);
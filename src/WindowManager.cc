@@ -21,6 +21,7 @@
 
 #include "ActionHandler.hh"
 #include "AutoProperties.hh"
+#include "ChildRegistry.hh"
 #include "Config.hh"
 #include "Theme.hh"
 #include "PFont.hh"
@@ -31,9 +32,11 @@
 #include "Util.hh"
 #include "X11Util.hh"
 #include "X11.hh"
+#include "RepaintScheduler.hh"
 
 #include "RegexString.hh"
 
+#include "KeyChainEventHandler.hh"
 #include "KeyGrabber.hh"
 #include "MenuHandler.hh"
 #include "Harbour.hh"
@@ -53,7 +56,6 @@ extern "C" {
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/wait.h>
 #include <errno.h>
 #include <unistd.h>
 
@@ -64,42 +66,17 @@ extern "C" {
 // include after all includes to get ifndefs right
 #include "Compat.hh"
 
-extern "C" {
-
-	static bool is_signal = false;
-	static bool is_signal_hup = false;
-	static bool is_signal_int_term = false;
-	static bool is_signal_alrm = false;
-	static bool is_signal_chld = false;
-
-	/**
-	 * Signal handler setting signal flags.
-	 */
-	static void
-	sigHandler(int signal)
-	{
-		is_signal = true;
-
-		switch (signal) {
-		case SIGHUP:
-			is_signal_hup = true;
-			break;
-		case SIGINT:
-		case SIGTERM:
-			is_signal_int_term = true;
-			break;
-		case SIGCHLD:
-			is_signal_chld = true;
-			break;
-		case SIGALRM:
-			// Do nothing, just used to break out of waiting
-			is_signal_alrm = true;
-			break;
-		}
-	}
-
-} // extern "C"
+/**
+ * Maximum number of events handled before damaged decors are repainted
+ * and the client lists are written.
+ */
+static const uint REPAINT_MAX_EVENTS = 64;
 
+/**
+ * Milliseconds to wait for the next key of a key chain before it is
+ * aborted.
+ */
+static const uint KEY_CHAIN_TIMEOUT_MS = 5000;
 
 // WindowManager
 
@@ -132,6 +109,7 @@ WindowManager::start(const std::string &config_file,
 		pekwm::rootWo()->setEwmhDesktopNames();
 		pekwm::rootWo()->setEwmhDesktopLayout();
 		Workspaces::updateClientList();
+		Workspaces::flushClientLists();
 
 		// add all frames to the MRU list
 		Frame::frame_cit it = Frame::frame_begin();
@@ -160,18 +138,11 @@ WindowManager::WindowManager(void)
 	_screen_edges[2] = 0;
 	_screen_edges[3] = 0;
 
-	struct sigaction act;
-
 	// Set up the signal handlers.
-	act.sa_handler = sigHandler;
-	act.sa_mask = sigset_t();
-	act.sa_flags = SA_NOCLDSTOP | SA_NODEFER;
-
-	sigaction(SIGTERM, &act, 0);
-	sigaction(SIGINT, &act, 0);
-	sigaction(SIGHUP, &act, 0);
-	sigaction(SIGCHLD, &act, 0);
-	sigaction(SIGALRM, &act, 0);
+	_mainloop.addSignal(SIGTERM, handleSignal, this);
+	_mainloop.addSignal(SIGINT, handleSignal, this);
+	_mainloop.addSignal(SIGHUP, handleSignal, this);
+	ChildRegistry::attach(_mainloop);
 }
 
 //! @brief WindowManager destructor
@@ -540,7 +511,7 @@ void
 WindowManager::stopBackground(void)
 {
 	if (_bg_pid != -1) {
-		// SIGCHILD will take care of waiting for the child
+		// reaped by the ChildRegistry on SIGCHLD
 		kill(_bg_pid, SIGKILL);
 	}
 	_bg_pid = -1;
@@ -637,41 +608,24 @@ WindowManager::restart(std::string command)
 
 // Event handling routins beneath this =====================================
 
+/**
+ * Signal callback, invoked from the main loop and not the signal
+ * handler.
+ */
 void
-WindowManager::handleSignals(void)
+WindowManager::handleSignal(int signal, void *opaque)
 {
-	// SIGALRM used to timeout workspace indicator
-	if (is_signal_alrm) {
-		P_TRACE("handle SIGALRM");
-		is_signal_alrm = false;
-		Workspaces::hideWorkspaceIndicator();
-	}
-
-	// SIGHUP
-	if (is_signal_hup || _reload) {
-		P_TRACE("handle SIGHUP or reload");
-		is_signal_hup = false;
-		doReload();
-	}
-
-	// Wait for children if a SIGCHLD was received
-	if (is_signal_chld) {
+	WindowManager *wm = reinterpret_cast<WindowManager*>(opaque);
+	switch (signal) {
+	case SIGHUP:
 		P_TRACE("handle SIGHUP");
-		pid_t pid;
-		do {
-			pid = waitpid(WAIT_ANY, nullptr, WNOHANG);
-			if (pid == -1) {
-				if (errno == EINTR) {
-					P_TRACE("waitpid interrupted, retrying");
-				}
-			} else if (pid == 0) {
-				P_TRACE("no more finished child processes");
-			} else {
-				P_TRACE("child process " << pid << " finished");
-			}
-		} while (pid > 0 || (pid == -1 && errno == EINTR));
-
-		is_signal_chld = false;
+		wm->_reload = true;
+		break;
+	case SIGINT:
+	case SIGTERM:
+		P_TRACE("handle SIGINT/SIGTERM");
+		wm->_shutdown = true;
+		break;
 	}
 }
 
@@ -680,20 +634,48 @@ WindowManager::doEventLoop(void)
 {
 	XEvent ev;
 
-	while (! _shutdown && ! is_signal_int_term) {
-		if (is_signal) {
-			handleSignals();
-			is_signal = false;
-		}
+	// Drain all pending events at once, coalescing redundant motion,
+	// configure requests and property changes.
+	X11::setEventBatch(true);
+
+	// Only used to wake up the main loop, events are read using
+	// X11::getNextEvent
+	_mainloop.addFd(ConnectionNumber(X11::getDpy()), nullptr, nullptr);
+
+	uint events = 0;
+	while (! _shutdown) {
 		if (_reload) {
 			doReload();
 		}
 
-		// Get next event, drop event handling if none was given
-		if (X11::getNextEvent(ev)) {
-			if (! _event_handler || ! handleEventHandlerEvent(ev)) {
-				handleEvent(ev);
+		if (X11::pending() > 0) {
+			// Get next event, drop event handling if none was given
+			if (X11::getNextEvent(ev)) {
+				if (! _event_handler
+				    || ! handleEventHandlerEvent(ev)) {
+					handleEvent(ev);
+				}
+			}
+
+			// do not let a steady stream of events starve repaints,
+			// timers and signals
+			if (++events >= REPAINT_MAX_EVENTS) {
+				pekwm::repaintScheduler()->flush();
+				Workspaces::flushClientLists();
+				events = 0;
+
+				X11::flush();
+				_mainloop.wait(0);
 			}
+		} else {
+			// end of event batch, repaint everything damaged by it
+			// and publish the client lists once
+			pekwm::repaintScheduler()->flush();
+			Workspaces::flushClientLists();
+			events = 0;
+
+			X11::flush();
+			_mainloop.wait();
 		}
 	}
 }
@@ -851,6 +833,9 @@ WindowManager::handleKeyEvent(XKeyEvent *ev)
 		wo->setLastActivity(ev->time);
 	}
 
+	// key ending a chain, looked up in the chain by findAction
+	bool in_chain = pekwm::keyGrabber()->isInChain();
+
 	switch (type) {
 	case PWinObj::WO_CLIENT:
 	case PWinObj::WO_FRAME:
@@ -880,6 +865,15 @@ WindowManager::handleKeyEvent(XKeyEvent *ev)
 		break;
 	}
 
+	if (in_chain) {
+		// focus changed to a window not using the KeyGrabber while
+		// the chain was entered
+		pekwm::keyGrabber()->endChain();
+	} else if (pekwm::keyGrabber()->isInChain()) {
+		startKeyChain();
+		return;
+	}
+
 	handleKeyEventAction(ev, ae, wo, wo_orig);
 
 	// Flush Enter events caused by keygrabbing
@@ -893,6 +887,30 @@ WindowManager::handleKeyEvent(XKeyEvent *ev)
 	}
 }
 
+/**
+ * Grab the keyboard waiting for the rest of the key chain started,
+ * other events keep being handled while the chain is entered.
+ */
+void
+WindowManager::startKeyChain(void)
+{
+	if (_event_handler) {
+		P_DBG("not starting key chain, event handler " << _event_handler
+		      << " active");
+		pekwm::keyGrabber()->endChain();
+		return;
+	}
+
+	EventHandler *event_handler =
+		new KeyChainEventHandler(pekwm::keyGrabber(),
+					 KEY_CHAIN_TIMEOUT_MS);
+	if (event_handler->initEventHandler()) {
+		setEventHandler(event_handler);
+	} else {
+		delete event_handler;
+	}
+}
+
 void
 WindowManager::handleKeyEventAction(XKeyEvent *ev, ActionEvent *ae,
 				    PWinObj *wo, PWinObj *wo_orig)
@@ -56,6 +56,12 @@ public:
 		_event_handler = event_handler;
 	}
 
+	virtual int addTimer(uint timeout_ms, bool repeat,
+			     Mainloop::timerFun fun, void *opaque) {
+		return _mainloop.addTimer(timeout_ms, repeat, fun, opaque);
+	}
+	virtual void removeTimer(int id) { _mainloop.removeTimer(id); }
+
 	// public event handlers used when doing grabbed actions
 	void handleKeyEvent(XKeyEvent *ev);
 	void handleButtonPressEvent(XButtonEvent *ev);
@@ -72,7 +78,7 @@ private:
 	void scanWindows(void);
 	void execStartFile(void);
 
-	void handleSignals(void);
+	static void handleSignal(int signal, void *opaque);
 
 	void doReload(void);
 	void doReloadConfig(void);
@@ -115,6 +121,7 @@ private:
 	void handleLeaveNotify(XCrossingEvent *ev);
 	void handleFocusInEvent(XFocusChangeEvent *ev);
 
+	void startKeyChain(void);
 	void handleKeyEventAction(XKeyEvent *ev, ActionEvent *ae, PWinObj *wo,
 				  PWinObj *wo_orig);
 
@@ -136,6 +143,7 @@ private:
 	std::string _restart_command;
 	pid_t _bg_pid;
 
+	Mainloop _mainloop;
 	EventHandler *_event_handler;
 
 	EdgeWO *_screen_edges[4];
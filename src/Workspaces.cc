@@ -12,6 +12,7 @@
 #include "Debug.hh"
 #include "Workspaces.hh"
 #include "Config.hh"
+#include "EventLoop.hh"
 #include "PWinObj.hh"
 #include "PDecor.hh"
 #include "Frame.hh"
@@ -28,8 +29,6 @@
 #endif // PEKWM_HAVE_LIMITS
 
 extern "C" {
-#include <signal.h>
-#include <sys/time.h>
 
 #include <X11/Xatom.h> // for XA_WINDOW
 }
@@ -66,10 +65,16 @@ Workspace::setDefaultLayouter(const std::string &layo)
 uint Workspaces::_active;
 uint Workspaces::_previous;
 uint Workspaces::_per_row;
-std::vector<PWinObj*> Workspaces::_wobjs;
+StackingList Workspaces::_wobjs;
 std::vector<Workspace> Workspaces::_workspaces;
 std::vector<Frame*> Workspaces::_mru;
+bool Workspaces::_client_list_dirty = true;
+bool Workspaces::_client_stacking_list_dirty = true;
+bool Workspaces::_client_lists_set = false;
+std::vector<Window> Workspaces::_client_list;
+std::vector<Window> Workspaces::_client_stacking_list;
 WorkspaceIndicator* Workspaces::_workspace_indicator = nullptr;
+int Workspaces::_workspace_indicator_timer = -1;
 
 WinLayouter *Workspace::_default_layouter = WinLayouterFactory("SMART");
 
@@ -82,6 +87,10 @@ Workspaces::init(void)
 void
 Workspaces::cleanup()
 {
+	if (_workspace_indicator_timer != -1 && pekwm::eventLoop()) {
+		pekwm::eventLoop()->removeTimer(_workspace_indicator_timer);
+	}
+	_workspace_indicator_timer = -1;
 	delete _workspace_indicator;
 }
 
@@ -185,12 +194,16 @@ Workspaces::showWorkspaceIndicator(void)
 		_workspace_indicator->mapWindowRaised();
 		PWinObj::setSkipEnterAfter(_workspace_indicator);
 
-		struct itimerval value;
-		timerclear(&value.it_value);
-		timerclear(&value.it_interval);
-		value.it_value.tv_sec += timeout / 1000;
-		value.it_value.tv_usec += (timeout % 1000) * 1000;
-		setitimer(ITIMER_REAL, &value, 0);
+		EventLoop *event_loop = pekwm::eventLoop();
+		if (event_loop) {
+			if (_workspace_indicator_timer != -1) {
+				event_loop->removeTimer(_workspace_indicator_timer);
+			}
+			_workspace_indicator_timer =
+				event_loop->addTimer(timeout, false,
+						     hideWorkspaceIndicatorTimeout,
+						     nullptr);
+		}
 	}
 }
 
@@ -200,6 +213,13 @@ Workspaces::hideWorkspaceIndicator(void)
 	_workspace_indicator->unmapWindow();
 }
 
+void
+Workspaces::hideWorkspaceIndicatorTimeout(int, void*)
+{
+	_workspace_indicator_timer = -1;
+	hideWorkspaceIndicator();
+}
+
 bool
 Workspaces::gotoWorkspace(uint direction, bool warp)
 {
@@ -351,16 +371,8 @@ Workspaces::warpToWorkspace(uint num, int dir)
 void
 Workspaces::fixStacking(PWinObj *pwo)
 {
-	const_iterator it = find(_wobjs.begin(), _wobjs.end(), pwo);
-	if (it == _wobjs.end()) {
-		return;
-	}
-
-	if (++it == _wobjs.end()) {
-		X11::raiseWindow(pwo->getWindow());
-	} else {
-		Window winlist[] = { (*it)->getWindow(), pwo->getWindow() };
-		X11::stackWindows(winlist, 2);
+	if (_wobjs.contains(pwo)) {
+		restack(pwo, pwo);
 	}
 }
 
@@ -374,88 +386,83 @@ Workspaces::fixStacking(PWinObj *pwo)
 void
 Workspaces::insert(PWinObj *wo, bool raise)
 {
-	PWinObj *top_obj = 0;
-	Frame *frame, *wo_frame = dynamic_cast<Frame*>(wo);
-	iterator it;
+	restack(wo, stackInList(wo, raise));
+}
 
+/**
+ * Link wo into the stacking list at the top or bottom of its layer,
+ * frames transient for wo stacked below it are moved above it.
+ *
+ * @return Top-most of wo and the moved transients.
+ */
+PWinObj*
+Workspaces::stackInList(PWinObj *wo, bool raise)
+{
+	Frame *wo_frame = dynamic_cast<Frame*>(wo);
 	if (! raise
 	    && wo_frame && wo_frame->getTransFor()
-	    && wo_frame->getTransFor()->getLayer() == wo_frame->getLayer()) {
+	    && wo_frame->getTransFor()->getLayer() == wo_frame->getLayer()
+	    && wo_frame->getTransFor()->getParent() != wo
+	    && _wobjs.contains(wo_frame->getTransFor()->getParent())) {
 		// Lower only to the top of the transient_for window.
-		it = find(_wobjs.begin(), _wobjs.end(), wo_frame->getTransFor()->getParent());
-		++it;
-		top_obj = it!=_wobjs.end()?*it:0; // I think it==_wobjs.end() can't happen
+		_wobjs.insertAbove(wo, wo_frame->getTransFor()->getParent());
+	} else if (raise) {
+		_wobjs.insertTop(wo, wo->getLayer());
 	} else {
-		it = _wobjs.begin();
-		for (; it != _wobjs.end(); ++it) {
-			if (raise) {
-				// If raising, make sure the inserted wo gets below the first
-				// window in the next layer.
-				if ((*it)->getLayer() > wo->getLayer()) {
-					top_obj = *it;
-					break;
-				}
-			} else if (wo->getLayer() <= (*it)->getLayer()) {
-				// If lowering, put the window below the first window with the same level.
-				top_obj = *it;
-				break;
-			}
-		}
+		_wobjs.insertBottom(wo, wo->getLayer());
 	}
 
-	_wobjs.insert(it, wo);
-
-	std::vector<PWinObj*> winstack;
-	winstack.reserve(3);
-	winstack.push_back(wo);
-
+	PWinObj *top = wo;
 	if (wo_frame && wo_frame->hasTrans()) {
-		std::vector<Client*>::const_iterator t_it;
-		for (it = _wobjs.begin(); *it != wo;) {
-			if ((frame = dynamic_cast<Frame*>(*it))) {
-				t_it = find(wo_frame->getTransBegin(), wo_frame->getTransEnd(),
-					    frame->getActiveClient());
-				if (t_it != wo_frame->getTransEnd()) {
-					winstack.push_back(frame);
-					it = _wobjs.erase(it);
-					continue;
-				}
+		std::vector<PWinObj*> trans;
+		std::vector<Client*>::const_iterator it = wo_frame->getTransBegin();
+		for (; it != wo_frame->getTransEnd(); ++it) {
+			Frame *frame = dynamic_cast<Frame*>((*it)->getParent());
+			if (frame && frame != wo
+			    && frame->getActiveClient() == *it
+			    && _wobjs.contains(frame)
+			    && StackingList::isBelow(frame, wo)) {
+				trans.push_back(frame);
 			}
-			++it;
 		}
 
-		it = find(_wobjs.begin(), _wobjs.end(), wo);
-		++it;
-		_wobjs.insert(it, winstack.begin()+1, winstack.end());
+		// keep the stacking order between the transients
+		std::sort(trans.begin(), trans.end(), StackingList::isBelow);
+		std::vector<PWinObj*>::iterator t_it = trans.begin();
+		for (; t_it != trans.end(); ++t_it) {
+			_wobjs.insertAbove(*t_it, top);
+			top = *t_it;
+		}
 	}
+	return top;
+}
 
-	if (top_obj) {
-		winstack.push_back(top_obj);
+/**
+ * Restack the windows from top down to wo below the window above top,
+ * sending one sibling relative request per window.
+ */
+void
+Workspaces::restack(PWinObj *wo, PWinObj *top)
+{
+	PWinObj *above = StackingList::getAbove(top);
+	if (above) {
+		X11::stackWindowBelow(top->getWindow(), above->getWindow());
 	} else {
-		X11::raiseWindow(winstack.back()->getWindow());
+		X11::raiseWindow(top->getWindow());
 	}
 
-	const unsigned size = winstack.size();
-	Window *wins = new Window[size];
-	std::vector<PWinObj*>::iterator wit(winstack.end());
-	for (unsigned i=0; i<size; ++i) {
-		wins[i] = (*--wit)->getWindow();
+	for (; top != wo; top = StackingList::getBelow(top)) {
+		X11::stackWindowBelow(StackingList::getBelow(top)->getWindow(),
+				      top->getWindow());
 	}
-	X11::stackWindows(wins, size);
-	delete [] wins;
 }
 
 //! @brief Removes a PWinObj from the stacking list.
 void
 Workspaces::remove(PWinObj* wo)
 {
-	iterator it_wo(_wobjs.begin());
-	for (;it_wo != _wobjs.end();) {
-		if (wo == *it_wo) {
-			it_wo = _wobjs.erase(it_wo);
-		} else {
-			++it_wo;
-		}
+	if (wo) {
+		_wobjs.remove(wo);
 	}
 
 	// remove from last focused
@@ -539,17 +546,16 @@ Workspaces::unhideAll(uint workspace, bool focus)
 void
 Workspaces::raise(PWinObj* wo)
 {
-	iterator it(find(_wobjs.begin(), _wobjs.end(), wo));
-
-	if (it == _wobjs.end()) { // no Frame to raise.
+	if (! _wobjs.contains(wo)) { // no Frame to raise.
 		return;
 	}
-	if (handleFullscreenBeforeRaise(wo)) {
-		it = find(_wobjs.begin(), _wobjs.end(), wo);
-	}
-	_wobjs.erase(it);
+	handleFullscreenBeforeRaise(wo);
 
-	insert(wo, true); // reposition and restack
+	PWinObj *above = StackingList::getAbove(wo);
+	PWinObj *top = stackInList(wo, true);
+	if (top != wo || StackingList::getAbove(wo) != above) {
+		restack(wo, top);
+	}
 }
 
 /**
@@ -607,27 +613,22 @@ Workspaces::lowerFullscreenWindows(Layer new_layer)
 	// with new_layer == LAYER_ONTOP could put fullscreen windows
 	// there, so we need to check all layers above new_layer, not just
 	// LAYER_ABOVE_DOCK.
-	iterator wo = _wobjs.begin();
-	for (; wo != _wobjs.end(); ++wo) {
-		if ((*wo)->getLayer() > new_layer
-		    && (*wo)->isMapped() && (*wo)->isFullscreen()) {
-			fs_wobjs.push_back(*wo);
-			(*wo)->setLayer(new_layer);
-		}
-	}
-
-	for (wo = fs_wobjs.begin(); wo != fs_wobjs.end(); ++wo) {
-		// We could have erased these windows in the first for loop,
-		// which could reduce a couple of find() calls.
-		//
-		// But we want the higher fullscreen windows to _stay_ in
-		// _wobjs, so that they can be the (top_obj) anchor point for
-		// restacking. And since that anchor is most likely fullscreen
-		// and hides everything else, no flickering.
-		iterator it(std::find(_wobjs.begin(), _wobjs.end(), *wo));
-
-		if (it != _wobjs.end()) {
-			_wobjs.erase(it);
+	iterator it = _wobjs.begin();
+	for (; it != _wobjs.end(); ++it) {
+		if ((*it)->getLayer() > new_layer
+		    && (*it)->isMapped() && (*it)->isFullscreen()) {
+			fs_wobjs.push_back(*it);
+			(*it)->setLayer(new_layer);
+		}
+	}
+
+	// The higher fullscreen windows _stay_ in _wobjs while the lower
+	// ones are moved, so that they can be the anchor point for
+	// restacking. And since that anchor is most likely fullscreen
+	// and hides everything else, no flickering.
+	std::vector<PWinObj*>::iterator wo = fs_wobjs.begin();
+	for (; wo != fs_wobjs.end(); ++wo) {
+		if (_wobjs.contains(*wo)) {
 			insert(*wo, true);
 		}
 	}
@@ -638,13 +639,15 @@ Workspaces::lowerFullscreenWindows(Layer new_layer)
 void
 Workspaces::lower(PWinObj* wo)
 {
-	iterator it(find(_wobjs.begin(), _wobjs.end(), wo));
-
-	if (it == _wobjs.end()) // no Frame to raise.
+	if (! _wobjs.contains(wo)) { // no Frame to lower.
 		return;
-	_wobjs.erase(it);
+	}
 
-	insert(wo, false); // reposition and restack
+	PWinObj *above = StackingList::getAbove(wo);
+	PWinObj *top = stackInList(wo, false);
+	if (top != wo || StackingList::getAbove(wo) != above) {
+		restack(wo, top);
+	}
 }
 
 PWinObj*
@@ -696,83 +699,130 @@ Workspaces::getTopWO(uint type_mask)
 }
 
 /**
- * Builds a list of all clients in stacking order, clients in the same
- * frame come after each other.
+ * Check if client should be reported in the Ewmh client lists.
  */
-Window*
-Workspaces::buildClientList(unsigned int &num_windows)
+bool
+Workspaces::isClientListed(Client *client)
 {
-	Frame *frame;
-	Client *client, *client_active;
+	Frame *frame = static_cast<Frame*>(client->getParent());
+	if (! frame || ! StackingList::contains(frame)
+	    || client->isSkip(SKIP_TASKBAR)) {
+		return false;
+	}
+	return client == frame->getActiveClient()
+		|| pekwm::config()->isReportAllClients();
+}
 
-	std::vector<Window> windows;
-	iterator it_f;
-	const_iterator it_c;
-	for (it_f = _wobjs.begin(); it_f != _wobjs.end(); ++it_f) {
+/**
+ * Builds a list of all clients in mapping order, oldest first.
+ */
+void
+Workspaces::buildClientList(std::vector<Window> &windows)
+{
+	windows.clear();
+	Client::client_cit it = Client::client_begin();
+	for (; it != Client::client_end(); ++it) {
+		if (isClientListed(*it)) {
+			windows.push_back((*it)->getWindow());
+		}
+	}
+}
+
+/**
+ * Builds a list of all clients in stacking order, bottom to top, clients
+ * in the same frame come after each other with the active client last.
+ */
+void
+Workspaces::buildClientStackingList(std::vector<Window> &windows)
+{
+	windows.clear();
+	const_iterator it_f = _wobjs.begin();
+	for (; it_f != _wobjs.end(); ++it_f) {
 		if ((*it_f)->getType() != PWinObj::WO_FRAME) {
 			continue;
 		}
 
-		frame = static_cast<Frame*>(*it_f);
-		client_active = frame->getActiveClient();
-
-		if (pekwm::config()->isReportAllClients()) {
-			for (it_c = frame->begin(); it_c != frame->end(); ++it_c) {
-				client = dynamic_cast<Client*>(*it_c);
-				if (client
-				    && client != client_active
-				    && ! client->isSkip(SKIP_TASKBAR)) {
-					windows.push_back(client->getWindow());
-				}
+		Frame *frame = static_cast<Frame*>(*it_f);
+		Client *client_active = frame->getActiveClient();
+		std::vector<PWinObj*>::const_iterator it_c = frame->begin();
+		for (; it_c != frame->end(); ++it_c) {
+			Client *client = dynamic_cast<Client*>(*it_c);
+			if (client && client != client_active
+			    && isClientListed(client)) {
+				windows.push_back(client->getWindow());
 			}
 		}
-
-		if (client_active && ! client_active->isSkip(SKIP_TASKBAR)) {
+		if (client_active && isClientListed(client_active)) {
 			windows.push_back(client_active->getWindow());
 		}
 	}
+}
 
-	num_windows = windows.size();
-	Window *wins = new Window[num_windows ? num_windows : 1];
-	if (num_windows > 0) {
-		copy(windows.begin(), windows.end(), wins);
+/**
+ * Set the Ewmh client list atom on the root window if windows differ
+ * from the last set list.
+ *
+ * @return true if the property was written.
+ */
+bool
+Workspaces::setClientList(AtomName atom, const std::vector<Window> &windows,
+			  std::vector<Window> &current)
+{
+	if (windows == current && _client_lists_set) {
+		return false;
 	}
 
-	return wins;
+	if (windows.empty()) {
+		X11::unsetProperty(X11::getRoot(), atom);
+	} else {
+		X11::setWindows(X11::getRoot(), atom,
+				const_cast<Window*>(&windows[0]), windows.size());
+	}
+	current = windows;
+	return true;
 }
 
 /**
- * Updates the Ewmh Client list hint.
+ * Mark the Ewmh client lists for update, written on the next
+ * flushClientLists.
  */
 void
 Workspaces::updateClientList(void)
 {
-	uint num;
-	Window *windows = buildClientList(num);
-	if (num == 0) {
-		X11::unsetProperty(X11::getRoot(), NET_CLIENT_LIST);
-		X11::unsetProperty(X11::getRoot(), NET_CLIENT_LIST_STACKING);
-	} else {
-		X11::setWindows(X11::getRoot(), NET_CLIENT_LIST, windows, num);
-		X11::setWindows(X11::getRoot(), NET_CLIENT_LIST_STACKING, windows, num);
-	}
-	delete [] windows;
+	_client_list_dirty = true;
+	_client_stacking_list_dirty = true;
 }
 
 /**
- * Updates the Ewmh Stacking list hint.
+ * Mark the Ewmh stacking list for update, written on the next
+ * flushClientLists.
  */
 void
 Workspaces::updateClientStackingList(void)
 {
-	uint num;
-	Window *windows = buildClientList(num);
-	if (num == 0) {
-		X11::unsetProperty(X11::getRoot(), NET_CLIENT_LIST_STACKING);
-	} else {
-		X11::setWindows(X11::getRoot(), NET_CLIENT_LIST_STACKING, windows, num);
+	_client_stacking_list_dirty = true;
+}
+
+/**
+ * Write the Ewmh client lists updated since the last call, called once
+ * per event batch. Lists that did not change are not written.
+ */
+void
+Workspaces::flushClientLists(void)
+{
+	std::vector<Window> windows;
+	if (_client_list_dirty) {
+		buildClientList(windows);
+		setClientList(NET_CLIENT_LIST, windows, _client_list);
+		_client_list_dirty = false;
+	}
+	if (_client_stacking_list_dirty) {
+		buildClientStackingList(windows);
+		setClientList(NET_CLIENT_LIST_STACKING, windows,
+			      _client_stacking_list);
+		_client_stacking_list_dirty = false;
 	}
-	delete [] windows;
+	_client_lists_set = true;
 }
 
 /**
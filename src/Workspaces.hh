@@ -14,10 +14,12 @@
 #include <string>
 
 #include "pekwm.hh"
+#include "StackingList.hh"
 #include "WinLayouter.hh"
 #include "WorkspaceIndicator.hh"
 
 class PWinObj;
+class Client;
 class Frame;
 
 class Workspace {
@@ -52,11 +54,10 @@ private:
 
 class Workspaces {
 public:
-	typedef std::vector<PWinObj*>::iterator iterator;
-	typedef std::vector<PWinObj*>::const_iterator const_iterator;
-	typedef std::vector<PWinObj*>::reverse_iterator reverse_iterator;
-	typedef std::vector<PWinObj*>::const_reverse_iterator
-	const_reverse_iterator;
+	typedef StackingList::iterator iterator;
+	typedef StackingList::const_iterator const_iterator;
+	typedef StackingList::reverse_iterator reverse_iterator;
+	typedef StackingList::const_reverse_iterator const_reverse_iterator;
 
 	static void init(void);
 	static void cleanup(void);
@@ -115,6 +116,7 @@ public:
 	static PWinObj* getTopWO(uint type_mask);
 	static void updateClientList(void);
 	static void updateClientStackingList(void);
+	static void flushClientLists(void);
 	static void placeWoInsideScreen(PWinObj *wo);
 
 	static void findWOAndFocus(PWinObj *search);
@@ -127,6 +129,7 @@ public:
 
 	static void showWorkspaceIndicator(void);
 	static void hideWorkspaceIndicator(void);
+	static void hideWorkspaceIndicatorTimeout(int id, void *opaque);
 
 	// list iterators
 	static std::vector<Frame*>::iterator mru_begin(void) {
@@ -157,9 +160,17 @@ public:
 	}
 
 private:
-	static Window *buildClientList(unsigned int &num_windows);
+	static bool isClientListed(Client *client);
+	static void buildClientList(std::vector<Window> &windows);
+	static void buildClientStackingList(std::vector<Window> &windows);
+	static bool setClientList(AtomName atom,
+				  const std::vector<Window> &windows,
+				  std::vector<Window> &current);
 	static bool warpToWorkspace(uint num, int dir);
 
+	static PWinObj *stackInList(PWinObj *wo, bool raise);
+	static void restack(PWinObj *wo, PWinObj *top);
+
 	static bool lowerFullscreenWindows(Layer new_layer);
 	static std::string getWorkspaceName(uint num);
 
@@ -169,11 +180,24 @@ private:
 
 	/** Window popping up when switching workspace */
 	static WorkspaceIndicator *_workspace_indicator;
+	/** Timer hiding the workspace indicator, -1 if not active. */
+	static int _workspace_indicator_timer;
 
-	static std::vector<PWinObj*> _wobjs;
+	static StackingList _wobjs;
 	/** The most recently used frame is kept at the front. */
 	static std::vector<Frame*> _mru;
 	static std::vector<Workspace> _workspaces;
+
+	/** Set when _NET_CLIENT_LIST needs to be updated. */
+	static bool _client_list_dirty;
+	/** Set when _NET_CLIENT_LIST_STACKING needs to be updated. */
+	static bool _client_stacking_list_dirty;
+	/** Set after the client lists have been written once. */
+	static bool _client_lists_set;
+	/** Last written _NET_CLIENT_LIST. */
+	static std::vector<Window> _client_list;
+	/** Last written _NET_CLIENT_LIST_STACKING. */
+	static std::vector<Window> _client_stacking_list;
 };
 
 #endif // _PEKWM_WORKSPACES_HH_
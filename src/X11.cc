@@ -8,9 +8,12 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <cassert>
+#include <map>
+#include <set>
 #ifdef PEKWM_HAVE_LIMITS
 #include <limits>
 #endif // PEKWM_HAVE_LIMITS
@@ -18,7 +21,9 @@
 extern "C" {
 #include <sys/types.h>
 #include <sys/time.h>
-#include <sys/select.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -31,6 +36,14 @@ extern "C" {
 #ifdef PEKWM_HAVE_XRANDR
 #include <X11/extensions/Xrandr.h>
 #endif // PEKWM_HAVE_XRANDR
+#ifdef PEKWM_HAVE_XRENDER
+#include <X11/extensions/Xrender.h>
+#endif // PEKWM_HAVE_XRENDER
+#ifdef PEKWM_HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif // PEKWM_HAVE_XSHM
 #include <X11/keysym.h> // For XK_ entries
 #ifdef PEKWM_HAVE_X11_XKBLIB_H
 #include <X11/XKBlib.h>
@@ -52,6 +65,20 @@ const uint X11::MODIFIER_TO_MASK_NUM =
 	sizeof(X11::MODIFIER_TO_MASK[0]);
 Atom X11::_atoms[MAX_NR_ATOMS];
 
+/** Event type used to mark coalesced events in the event queue. */
+static const int EVENT_COALESCED = 0;
+
+#ifdef PEKWM_HAVE_XSHM
+/** Images smaller than this are sent over the connection. */
+static const size_t SHM_IMAGE_MIN = 16 * 1024;
+/** Shared memory segment sizes are rounded up to a multiple of this. */
+static const size_t SHM_SEGMENT_ALIGN = 64 * 1024;
+/** Maximum number of pooled shared memory segments. */
+static const size_t SHM_SEGMENTS_MAX = 4;
+/** Segments larger than this are freed instead of pooled on release. */
+static const size_t SHM_SEGMENT_KEEP_MAX = 4 * 1024 * 1024;
+#endif // PEKWM_HAVE_XSHM
+
 extern "C" {
 	/**
 	 * Invoked after all Xlib calls if run in synchronous mode.
@@ -340,6 +367,32 @@ private:
 	uint _ref;
 };
 
+#ifdef PEKWM_HAVE_XSHM
+/**
+ * Shared memory segment attached to the server, reused for XImages.
+ */
+class X11::ShmSegment {
+public:
+	ShmSegment(size_t size_)
+		: size(size_),
+		  image(nullptr),
+		  serial(0)
+	{
+		info.shmseg = None;
+		info.shmid = -1;
+		info.shmaddr = nullptr;
+		info.readOnly = False;
+	}
+
+	XShmSegmentInfo info;
+	size_t size;
+	/** XImage using the segment, nullptr if the segment is free. */
+	XImage *image;
+	/** Serial of the last XShmPutImage request reading the segment. */
+	ulong serial;
+};
+#endif // PEKWM_HAVE_XSHM
+
 /**
  * Init X11 connection, must be called before any X11:: call is made.
  */
@@ -352,6 +405,9 @@ X11::init(Display *dpy, bool synchronous, bool honour_randr)
 
 	_dpy = dpy;
 	_honour_randr = honour_randr;
+#ifdef PEKWM_HAVE_XCB
+	_xcb = XGetXCBConnection(_dpy);
+#endif // PEKWM_HAVE_XCB
 
 	if (synchronous) {
 		XSynchronize(_dpy, True);
@@ -421,6 +477,18 @@ X11::init(Display *dpy, bool synchronous, bool honour_randr)
 	}
 #endif // PEKWM_HAVE_X11_XKBLIB_H
 
+#ifdef PEKWM_HAVE_XSHM
+	_has_extension_shm = XShmQueryExtension(_dpy);
+#endif // PEKWM_HAVE_XSHM
+
+#ifdef PEKWM_HAVE_XRENDER
+	{
+		int dummy_event, dummy_error;
+		_has_extension_xrender =
+			XRenderQueryExtension(_dpy, &dummy_event, &dummy_error);
+	}
+#endif // PEKWM_HAVE_XRENDER
+
 	// Now screen geometry has been read and extensions have been
 	// looked for, read head information.
 	initHeads();
@@ -448,6 +516,8 @@ X11::init(Display *dpy, bool synchronous, bool honour_randr)
 //! @brief X11 destructor
 void
 X11::destruct(void) {
+	clearPrefetchedProperties();
+
 	if (_colors.size() > 0) {
 		ulong *pixels = new ulong[_colors.size()];
 		for (uint i=0; i < _colors.size(); ++i) {
@@ -467,6 +537,14 @@ X11::destruct(void) {
 		XFreeCursor(_dpy, _cursor_map[i]);
 	}
 
+#ifdef PEKWM_HAVE_XSHM
+	std::vector<ShmSegment*>::iterator it = _shm_segments.begin();
+	for (; it != _shm_segments.end(); ++it) {
+		shmDestroySegment(*it);
+	}
+	_shm_segments.clear();
+#endif // PEKWM_HAVE_XSHM
+
 	// Under certain circumstances trying to restart pekwm can cause it to
 	// use 100% of the CPU without making any progress with the restart.
 	// This X11:sync() seems to be work around the issue (c.f. #300).
@@ -623,9 +701,21 @@ X11::flush(void)
 	}
 }
 
+/**
+ * Get number of events available without blocking, including events
+ * read into the event queue.
+ */
 int
 X11::pending(void)
 {
+	while (_event_queue_pos < _event_queue.size()
+	       && _event_queue[_event_queue_pos].type == EVENT_COALESCED) {
+		_event_queue_pos++;
+	}
+	if (_event_queue_pos < _event_queue.size()) {
+		return _event_queue.size() - _event_queue_pos;
+	}
+
 	if (_dpy) {
 		return XPending(_dpy);
 	}
@@ -633,7 +723,11 @@ X11::pending(void)
 }
 
 /**
- * Get next event using select to avoid signal blocking
+ * Get next event using poll to avoid signal blocking
+ *
+ * When event batching is enabled, all pending events are read from the
+ * server at once and redundant events are coalesced before they are
+ * returned one by one.
  *
  * @param ev Event to fill in.
  * @return true if event was fetched, else false.
@@ -641,27 +735,223 @@ X11::pending(void)
 bool
 X11::getNextEvent(XEvent &ev, struct timeval *timeout)
 {
+	if (popEventQueue(ev)) {
+		return true;
+	}
+
 	if (pending()) {
+		if (_event_batch) {
+			fillEventQueue();
+			return popEventQueue(ev);
+		}
 		XNextEvent(_dpy, &ev);
 		return true;
 	}
 
-	int ret;
-	fd_set rfds;
-
 	flush();
 
-	FD_ZERO(&rfds);
-	FD_SET(_fd, &rfds);
-
-	ret = select(_fd + 1, &rfds, nullptr, nullptr, timeout);
+	struct pollfd pfd = { _fd, POLLIN, 0 };
+	int timeout_ms = -1;
+	if (timeout) {
+		timeout_ms = timeout->tv_sec * 1000 + timeout->tv_usec / 1000;
+	}
+	int ret = poll(&pfd, 1, timeout_ms);
 	if (ret > 0) {
+		if (_event_batch) {
+			fillEventQueue();
+			return popEventQueue(ev);
+		}
 		XNextEvent(_dpy, &ev);
 	}
 
 	return ret > 0;
 }
 
+/**
+ * Read all events available from the server into the event queue and
+ * coalesce redundant events.
+ */
+void
+X11::fillEventQueue(void)
+{
+	if (_event_queue_pos >= _event_queue.size()) {
+		_event_queue.clear();
+		_event_queue_pos = 0;
+	}
+
+	size_t start = _event_queue.size();
+	XEvent ev;
+	for (int num = XPending(_dpy); num > 0;
+	     num = XEventsQueued(_dpy, QueuedAlready)) {
+		for (; num > 0; num--) {
+			XNextEvent(_dpy, &ev);
+			_event_queue.push_back(ev);
+		}
+	}
+
+	ulong coalesced = _event_queue_stats.coalesced();
+	_event_queue_stats.batches++;
+	_event_queue_stats.events += _event_queue.size() - start;
+	coalesceEvents(_event_queue, start, _event_queue_stats);
+
+	if (_event_queue_stats.coalesced() != coalesced) {
+		P_TRACE("coalesced " << _event_queue_stats.coalesced() - coalesced
+			<< " of " << _event_queue.size() - start << " events");
+		P_DBG("event queue batches " << _event_queue_stats.batches
+		      << " events " << _event_queue_stats.events
+		      << " motion " << _event_queue_stats.motion
+		      << " configure " << _event_queue_stats.configure
+		      << " property " << _event_queue_stats.property);
+	}
+}
+
+/**
+ * Get the next event from the event queue skipping coalesced events.
+ *
+ * @return true if an event was fetched, false if the queue is empty.
+ */
+bool
+X11::popEventQueue(XEvent &ev)
+{
+	while (_event_queue_pos < _event_queue.size()) {
+		XEvent &q_ev = _event_queue[_event_queue_pos++];
+		if (q_ev.type != EVENT_COALESCED) {
+			ev = q_ev;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Merge values from the earlier ConfigureRequest src into the later
+ * request dst for the fields not set in dst.
+ */
+static void
+mergeConfigureRequest(XConfigureRequestEvent &dst,
+		      const XConfigureRequestEvent &src)
+{
+	ulong mask = src.value_mask & ~dst.value_mask;
+	if (mask & CWX) {
+		dst.x = src.x;
+	}
+	if (mask & CWY) {
+		dst.y = src.y;
+	}
+	if (mask & CWWidth) {
+		dst.width = src.width;
+	}
+	if (mask & CWHeight) {
+		dst.height = src.height;
+	}
+	if (mask & CWBorderWidth) {
+		dst.border_width = src.border_width;
+	}
+	// sibling is only relevant together with the stack mode
+	if (mask & CWStackMode) {
+		dst.detail = src.detail;
+		dst.above = src.above;
+	} else {
+		mask &= ~CWSibling;
+	}
+	dst.value_mask |= mask;
+}
+
+/**
+ * Coalesce redundant events in events starting at pos.
+ *
+ * MotionNotify events are dropped if a later MotionNotify for the same
+ * window follows without any button, key or crossing event in between,
+ * ConfigureRequest events for the same window are merged into the last
+ * one and only the last PropertyNotify for each window and atom is
+ * kept. Events that change the life cycle of a window act as barriers
+ * for the window.
+ *
+ * Coalesced events get the type EVENT_COALESCED and are skipped when
+ * read from the queue.
+ */
+void
+X11::coalesceEvents(std::vector<XEvent> &events, size_t pos,
+		    EventQueueStats &stats)
+{
+	std::map<Window, size_t> motion;
+	std::map<Window, size_t> configure;
+	std::set<std::pair<Window, Atom> > property;
+
+	for (size_t i = events.size(); i > pos; ) {
+		XEvent &ev = events[--i];
+
+		Window barrier = None;
+		switch (ev.type) {
+		case MotionNotify: {
+			std::map<Window, size_t>::iterator it =
+				motion.find(ev.xmotion.window);
+			if (it != motion.end()
+			    && events[it->second].xmotion.state == ev.xmotion.state) {
+				ev.type = EVENT_COALESCED;
+				stats.motion++;
+			} else {
+				motion[ev.xmotion.window] = i;
+			}
+			break;
+		}
+		case ButtonPress:
+		case ButtonRelease:
+		case KeyPress:
+		case KeyRelease:
+		case EnterNotify:
+		case LeaveNotify:
+			motion.clear();
+			break;
+		case ConfigureRequest: {
+			std::map<Window, size_t>::iterator it =
+				configure.find(ev.xconfigurerequest.window);
+			if (it == configure.end()) {
+				configure[ev.xconfigurerequest.window] = i;
+			} else {
+				mergeConfigureRequest(events[it->second].xconfigurerequest,
+						      ev.xconfigurerequest);
+				ev.type = EVENT_COALESCED;
+				stats.configure++;
+			}
+			break;
+		}
+		case PropertyNotify:
+			if (! property.insert(std::make_pair(ev.xproperty.window,
+							     ev.xproperty.atom)).second) {
+				ev.type = EVENT_COALESCED;
+				stats.property++;
+			}
+			break;
+		case MapRequest:
+			barrier = ev.xmaprequest.window;
+			break;
+		case MapNotify:
+			barrier = ev.xmap.window;
+			break;
+		case UnmapNotify:
+			barrier = ev.xunmap.window;
+			break;
+		case DestroyNotify:
+			barrier = ev.xdestroywindow.window;
+			break;
+		case ReparentNotify:
+			barrier = ev.xreparent.window;
+			break;
+		case ClientMessage:
+			barrier = ev.xclient.window;
+			break;
+		}
+
+		if (barrier != None) {
+			configure.erase(barrier);
+			property.erase(property.lower_bound(std::make_pair(barrier, 0)),
+				       property.upper_bound(std::make_pair(barrier,
+									   ~0UL)));
+		}
+	}
+}
+
 void
 X11::allowEvents(int event_mode, Time time)
 {
@@ -1096,33 +1386,43 @@ bool
 X11::getProperty(Window win, Atom atom, Atom type,
                  ulong expected, uchar **data_ret, ulong *actual)
 {
-	if (expected == 0) {
-		expected = 1024;
-	}
-
 	uchar *data = nullptr;
-	ulong read = 0, left = 0;
-	do {
-		if (data != nullptr) {
+	ulong read = 0;
+	Atom r_type;
+	int r_format;
+	if (getPrefetchedProperty(win, atom, type, &r_type, &r_format,
+				  &data, &read)) {
+		if (data != nullptr && read == 0) {
 			X11::free(data);
 			data = nullptr;
 		}
-		expected += left;
-
-		Atom r_type;
-		int r_format, status;
-		status =
-			XGetWindowProperty(_dpy, win, atom,
-					   0L, expected, False, type,
-					   &r_type, &r_format, &read, &left, &data);
-		if (status != Success || type != r_type || read == 0) {
+	} else {
+		if (expected == 0) {
+			expected = 1024;
+		}
+
+		ulong left = 0;
+		do {
 			if (data != nullptr) {
 				X11::free(data);
 				data = nullptr;
 			}
-			left = 0;
-		}
-	} while (left);
+			expected += left;
+
+			int status =
+				XGetWindowProperty(_dpy, win, atom,
+						   0L, expected, False, type,
+						   &r_type, &r_format,
+						   &read, &left, &data);
+			if (status != Success || type != r_type || read == 0) {
+				if (data != nullptr) {
+					X11::free(data);
+					data = nullptr;
+				}
+				left = 0;
+			}
+		} while (left);
+	}
 
 	if (actual) {
 		*actual = read;
@@ -1137,8 +1437,17 @@ X11::getTextProperty(Window win, Atom atom, std::string &value)
 {
 	// Read text property, return if it fails.
 	XTextProperty text_property;
-	if (! XGetTextProperty(_dpy, win, &text_property, atom)
-	    || ! text_property.value || ! text_property.nitems) {
+	if (getPrefetchedProperty(win, atom, AnyPropertyType,
+				  &text_property.encoding,
+				  &text_property.format,
+				  &text_property.value,
+				  &text_property.nitems)) {
+		if (! text_property.value || ! text_property.nitems) {
+			X11::free(text_property.value);
+			return false;
+		}
+	} else if (! XGetTextProperty(_dpy, win, &text_property, atom)
+		   || ! text_property.value || ! text_property.nitems) {
 		return false;
 	}
 
@@ -1168,9 +1477,13 @@ X11::getEwmhPropData(Window win, AtomName prop, Atom type, int &num)
 	ulong items_ret, after_ret;
 	uchar *prop_data = 0;
 
-	XGetWindowProperty(_dpy, win, _atoms[prop], 0, 0x7fffffff,
-			   False, type, &type_ret, &format_ret, &items_ret,
-			   &after_ret, &prop_data);
+	if (! getPrefetchedProperty(win, _atoms[prop], type,
+				    &type_ret, &format_ret,
+				    &prop_data, &items_ret)) {
+		XGetWindowProperty(_dpy, win, _atoms[prop], 0, 0x7fffffff,
+				   False, type, &type_ret, &format_ret,
+				   &items_ret, &after_ret, &prop_data);
+	}
 	num = items_ret;
 	return prop_data;
 }
@@ -1178,11 +1491,195 @@ X11::getEwmhPropData(Window win, AtomName prop, Atom type, int &num)
 void
 X11::unsetProperty(Window win, AtomName aname)
 {
+	dropPrefetchedProperty(win, _atoms[aname]);
 	if (_dpy) {
 		XDeleteProperty(_dpy, win, _atoms[aname]);
 	}
 }
 
+/**
+ * Request atoms on win in one batch without waiting for the replies,
+ * getProperty, getTextProperty and getEwmhPropData then use the
+ * replies until clearPrefetchedProperties is called. Can be called for
+ * several windows before reading any of them, sending all requests
+ * before waiting for the first reply.
+ *
+ * Only done with XCB, without it properties are read one round-trip
+ * at a time as they are requested.
+ */
+void
+X11::prefetchProperties(Window win, const Atom *atoms, size_t num)
+{
+#ifdef PEKWM_HAVE_XCB
+	if (_xcb == nullptr) {
+		return;
+	}
+
+	for (size_t i = 0; i < num; i++) {
+		std::pair<Window, Atom> key(win, atoms[i]);
+		prefetch_map::iterator it = _prefetch.find(key);
+		if (it != _prefetch.end()) {
+			xcb_discard_reply(_xcb, it->second.sequence);
+		}
+		_prefetch[key] = xcb_get_property(_xcb, 0, win, atoms[i],
+						  XCB_GET_PROPERTY_TYPE_ANY,
+						  0, 0x7fffffff);
+	}
+	xcb_flush(_xcb);
+#else // ! PEKWM_HAVE_XCB
+	(void) win;
+	(void) atoms;
+	(void) num;
+#endif // PEKWM_HAVE_XCB
+}
+
+/**
+ * Discard all prefetched properties not yet read.
+ */
+void
+X11::clearPrefetchedProperties(void)
+{
+#ifdef PEKWM_HAVE_XCB
+	prefetch_map::iterator it = _prefetch.begin();
+	for (; it != _prefetch.end(); ++it) {
+		xcb_discard_reply(_xcb, it->second.sequence);
+	}
+	_prefetch.clear();
+#endif // PEKWM_HAVE_XCB
+}
+
+/**
+ * Get prefetched atom on win, the reply is only used once. Data is
+ * returned in the same form as XGetWindowProperty with AnyPropertyType
+ * matching all types.
+ *
+ * @return false if atom was not prefetched.
+ */
+bool
+X11::getPrefetchedProperty(Window win, Atom atom, Atom type,
+			   Atom *type_ret, int *format_ret,
+			   uchar **data_ret, ulong *items_ret)
+{
+#ifdef PEKWM_HAVE_XCB
+	if (_prefetch.empty()) {
+		return false;
+	}
+	prefetch_map::iterator it =
+		_prefetch.find(std::make_pair(win, atom));
+	if (it == _prefetch.end()) {
+		return false;
+	}
+	xcb_get_property_cookie_t cookie = it->second;
+	_prefetch.erase(it);
+
+	*type_ret = None;
+	*format_ret = 0;
+	*data_ret = nullptr;
+	*items_ret = 0;
+
+	xcb_generic_error_t *error = nullptr;
+	xcb_get_property_reply_t *reply =
+		xcb_get_property_reply(_xcb, cookie, &error);
+	if (reply == nullptr) {
+		::free(error);
+		return true;
+	}
+
+	*type_ret = reply->type;
+	*format_ret = reply->format;
+	if (reply->type != None
+	    && (type == AnyPropertyType || type == reply->type)) {
+		*data_ret = copyPropertyValue(reply->format,
+					      xcb_get_property_value(reply),
+					      reply->value_len);
+		if (*data_ret) {
+			*items_ret = reply->value_len;
+		}
+	}
+	::free(reply);
+	return true;
+#else // ! PEKWM_HAVE_XCB
+	(void) win;
+	(void) atom;
+	(void) type;
+	(void) type_ret;
+	(void) format_ret;
+	(void) data_ret;
+	(void) items_ret;
+	return false;
+#endif // PEKWM_HAVE_XCB
+}
+
+/**
+ * Drop prefetched atom on win, used when the property is changed
+ * making the reply stale.
+ */
+void
+X11::dropPrefetchedProperty(Window win, Atom atom)
+{
+#ifdef PEKWM_HAVE_XCB
+	prefetch_map::iterator it =
+		_prefetch.find(std::make_pair(win, atom));
+	if (it != _prefetch.end()) {
+		xcb_discard_reply(_xcb, it->second.sequence);
+		_prefetch.erase(it);
+	}
+#else // ! PEKWM_HAVE_XCB
+	(void) win;
+	(void) atom;
+#endif // PEKWM_HAVE_XCB
+}
+
+/**
+ * Copy property value from the wire format to the format returned by
+ * XGetWindowProperty, 16 and 32 bit items are stored as short and long
+ * and the data is always null terminated.
+ *
+ * @return Data to be freed with X11::free, nullptr on invalid format.
+ */
+uchar*
+X11::copyPropertyValue(int format, const void *value, ulong items)
+{
+	size_t size;
+	switch (format) {
+	case 8:
+		size = items;
+		break;
+	case 16:
+		size = items * sizeof(short);
+		break;
+	case 32:
+		size = items * sizeof(long);
+		break;
+	default:
+		return nullptr;
+	}
+
+	uchar *data = static_cast<uchar*>(malloc(size + 1));
+	if (data == nullptr) {
+		return nullptr;
+	}
+
+	if (format == 8) {
+		memcpy(data, value, items);
+	} else if (format == 16) {
+		const int16_t *src = static_cast<const int16_t*>(value);
+		short *dst = reinterpret_cast<short*>(data);
+		for (ulong i = 0; i < items; i++) {
+			dst[i] = src[i];
+		}
+	} else {
+		// sign extended as done by Xlib
+		const int32_t *src = static_cast<const int32_t*>(value);
+		long *dst = reinterpret_cast<long*>(data);
+		for (ulong i = 0; i < items; i++) {
+			dst[i] = src[i];
+		}
+	}
+	data[size] = '\0';
+	return data;
+}
+
 void
 X11::getMousePosition(int &x, int &y)
 {
@@ -1253,6 +1750,7 @@ int
 X11::changeProperty(Window win, Atom prop, Atom type, int format,
                     int mode, const unsigned char *data, int num_e)
 {
+	dropPrefetchedProperty(win, prop);
 	if (_dpy) {
 		return XChangeProperty(_dpy, win, prop, type, format, mode,
 				       data, num_e);
@@ -1336,36 +1834,275 @@ X11::createImage(char *data, uint width, uint height)
 	return nullptr;
 }
 
+/**
+ * Create 24-bit ZPixmap XImage with allocated data, the data is
+ * placed in a pooled shared memory segment when MIT-SHM is
+ * available. Free with destroyImage.
+ */
+XImage*
+X11::createImage(uint width, uint height)
+{
+	if (! _dpy) {
+		return nullptr;
+	}
+
+#ifdef PEKWM_HAVE_XSHM
+	XImage *shm_ximage = createShmImage(24, width, height);
+	if (shm_ximage) {
+		return shm_ximage;
+	}
+#endif // PEKWM_HAVE_XSHM
+
+	XImage *ximage = createImage(nullptr, width, height);
+	if (ximage) {
+		// freed by XDestroyImage
+		ximage->data =
+			static_cast<char*>(malloc(ximage->bytes_per_line * height));
+	}
+	return ximage;
+}
+
 XImage*
 X11::getImage(Drawable src, int x, int y, uint width, uint height,
               unsigned long plane_mask, int format)
 {
-	if (_dpy) {
-		return XGetImage(_dpy, src, x, y, width, height,
-				 plane_mask, format);
+	if (! _dpy) {
+		return nullptr;
 	}
-	return nullptr;
+
+#ifdef PEKWM_HAVE_XSHM
+	if (format == ZPixmap && plane_mask == AllPlanes) {
+		XImage *ximage = createShmImage(_depth, width, height);
+		if (ximage) {
+			if (XShmGetImage(_dpy, src, ximage, x, y, AllPlanes)) {
+				return ximage;
+			}
+			destroyImage(ximage);
+		}
+	}
+#endif // PEKWM_HAVE_XSHM
+
+	return XGetImage(_dpy, src, x, y, width, height, plane_mask, format);
 }
 
+/**
+ * Put ximage on dest, images with data in a shared memory segment must
+ * not be modified after this call as the server reads the data
+ * asynchronously.
+ */
 void
 X11::putImage(Drawable dest, GC gc, XImage *ximage,
               int src_x, int src_y, int dest_x, int dest_y,
               uint width, uint height)
 {
-	if (_dpy) {
-		XPutImage(_dpy, dest, gc, ximage,
-			  src_x, src_y, dest_x, dest_y, width, height);
+	if (! _dpy) {
+		return;
 	}
+
+#ifdef PEKWM_HAVE_XSHM
+	ShmSegment *seg = shmFind(ximage);
+	if (seg) {
+		XShmPutImage(_dpy, dest, gc, ximage,
+			     src_x, src_y, dest_x, dest_y, width, height, False);
+		seg->serial = NextRequest(_dpy) - 1;
+		return;
+	}
+#endif // PEKWM_HAVE_XSHM
+
+	XPutImage(_dpy, dest, gc, ximage,
+		  src_x, src_y, dest_x, dest_y, width, height);
 }
 
 void
 X11::destroyImage(XImage *ximage)
 {
 	if (ximage) {
+#ifdef PEKWM_HAVE_XSHM
+		ShmSegment *seg = shmFind(ximage);
+		if (seg) {
+			ximage->data = nullptr;
+			shmRelease(seg);
+		}
+#endif // PEKWM_HAVE_XSHM
+		XDestroyImage(ximage);
+	}
+}
+
+#ifdef PEKWM_HAVE_XSHM
+
+/**
+ * Create ZPixmap XImage with data in a pooled shared memory segment.
+ *
+ * @return XImage, nullptr if MIT-SHM is unavailable, the image is too
+ *         small to benefit from it or no segment is available.
+ */
+XImage*
+X11::createShmImage(int depth, uint width, uint height)
+{
+	if (! _has_extension_shm) {
+		return nullptr;
+	}
+
+	XImage *ximage = XShmCreateImage(_dpy, _visual, depth, ZPixmap,
+					 nullptr, nullptr, width, height);
+	if (ximage == nullptr) {
+		return nullptr;
+	}
+
+	size_t size = ximage->bytes_per_line * height;
+	ShmSegment *seg = size < SHM_IMAGE_MIN ? nullptr : shmAcquire(size);
+	if (seg == nullptr) {
 		XDestroyImage(ximage);
+		return nullptr;
+	}
+
+	seg->image = ximage;
+	ximage->data = seg->info.shmaddr;
+	ximage->obdata = reinterpret_cast<char*>(&seg->info);
+	return ximage;
+}
+
+/**
+ * Get free segment of at least size bytes, the smallest free segment
+ * large enough is preferred. A free segment that is too small is
+ * replaced when the pool is full.
+ */
+X11::ShmSegment*
+X11::shmAcquire(size_t size)
+{
+	ShmSegment *seg = nullptr;
+	std::vector<ShmSegment*>::iterator small = _shm_segments.end();
+	std::vector<ShmSegment*>::iterator it = _shm_segments.begin();
+	for (; it != _shm_segments.end(); ++it) {
+		if ((*it)->image) {
+			continue;
+		}
+		if ((*it)->size < size) {
+			small = it;
+		} else if (seg == nullptr || (*it)->size < seg->size) {
+			seg = *it;
+		}
+	}
+
+	if (seg) {
+		if (LastKnownRequestProcessed(_dpy) < seg->serial) {
+			// server might still be reading the previous image
+			XSync(_dpy, False);
+		}
+		return seg;
+	}
+
+	if (_shm_segments.size() >= SHM_SEGMENTS_MAX) {
+		if (small == _shm_segments.end()) {
+			return nullptr;
+		}
+		shmDestroySegment(*small);
+		_shm_segments.erase(small);
+	}
+
+	seg = shmCreateSegment(size);
+	if (seg) {
+		_shm_segments.push_back(seg);
+	}
+	return seg;
+}
+
+/**
+ * Get segment used by ximage, nullptr if ximage is not in a segment.
+ */
+X11::ShmSegment*
+X11::shmFind(XImage *ximage)
+{
+	std::vector<ShmSegment*>::iterator it = _shm_segments.begin();
+	for (; it != _shm_segments.end(); ++it) {
+		if ((*it)->image == ximage) {
+			return *it;
+		}
 	}
+	return nullptr;
 }
 
+/**
+ * Return segment to the pool, large segments are freed.
+ */
+void
+X11::shmRelease(ShmSegment *seg)
+{
+	seg->image = nullptr;
+	if (seg->size > SHM_SEGMENT_KEEP_MAX) {
+		std::vector<ShmSegment*>::iterator it =
+			std::find(_shm_segments.begin(), _shm_segments.end(), seg);
+		if (it != _shm_segments.end()) {
+			_shm_segments.erase(it);
+		}
+		shmDestroySegment(seg);
+	}
+}
+
+/**
+ * Create shared memory segment and attach it to the server. MIT-SHM
+ * is disabled if the server fails to attach the segment, as is the
+ * case with remote displays.
+ */
+X11::ShmSegment*
+X11::shmCreateSegment(size_t size)
+{
+	size = ((size + SHM_SEGMENT_ALIGN - 1) / SHM_SEGMENT_ALIGN)
+		* SHM_SEGMENT_ALIGN;
+
+	ShmSegment *seg = new ShmSegment(size);
+	seg->info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+	if (seg->info.shmid == -1) {
+		P_DBG("failed to get shared memory segment of " << size
+		      << " bytes: " << strerror(errno));
+		delete seg;
+		return nullptr;
+	}
+
+	void *addr = shmat(seg->info.shmid, nullptr, 0);
+	if (addr == reinterpret_cast<void*>(-1)) {
+		P_DBG("failed to attach shared memory segment: "
+		      << strerror(errno));
+		shmctl(seg->info.shmid, IPC_RMID, nullptr);
+		delete seg;
+		return nullptr;
+	}
+	seg->info.shmaddr = static_cast<char*>(addr);
+
+	bool ignore = xerrors_ignore;
+	uint count = xerrors_count;
+	xerrors_ignore = false;
+	XShmAttach(_dpy, &seg->info);
+	XSync(_dpy, False);
+	bool attached = count == xerrors_count;
+	xerrors_ignore = ignore;
+
+	// segment is removed once both pekwm and the server has detached
+	shmctl(seg->info.shmid, IPC_RMID, nullptr);
+
+	if (! attached) {
+		P_DBG("server failed to attach shared memory segment, "
+		      "disabling MIT-SHM");
+		_has_extension_shm = false;
+		shmdt(seg->info.shmaddr);
+		delete seg;
+		return nullptr;
+	}
+
+	P_TRACE("created shared memory segment of " << size << " bytes");
+	return seg;
+}
+
+void
+X11::shmDestroySegment(ShmSegment *seg)
+{
+	XShmDetach(_dpy, &seg->info);
+	shmdt(seg->info.shmaddr);
+	delete seg;
+}
+
+#endif // PEKWM_HAVE_XSHM
+
 void
 X11::setWindowBackground(Window window, ulong pixel)
 {
@@ -1655,6 +2392,12 @@ X11::getKeysymFromKeycode(KeyCode keycode)
 void
 X11::removeMotionEvents(void)
 {
+	for (size_t i = _event_queue_pos; i < _event_queue.size(); i++) {
+		if (_event_queue[i].type == MotionNotify) {
+			_event_queue[i].type = EVENT_COALESCED;
+		}
+	}
+
 	XEvent xev;
 	while (XCheckMaskEvent(_dpy, PointerMotionMask, &xev))
 		;
@@ -1883,12 +2626,157 @@ X11::stackWindows(Window *wins, unsigned len)
 	}
 }
 
+/**
+ * Stack w directly below its sibling sibling.
+ */
+void
+X11::stackWindowBelow(Window w, Window sibling)
+{
+	if (_dpy) {
+		XWindowChanges changes;
+		changes.sibling = sibling;
+		changes.stack_mode = Below;
+		XConfigureWindow(_dpy, w, CWSibling|CWStackMode, &changes);
+	}
+}
+
 bool
 X11::checkTypedEvent(int type, XEvent *ev)
 {
+	for (size_t i = _event_queue_pos; i < _event_queue.size(); i++) {
+		if (_event_queue[i].type == type) {
+			*ev = _event_queue[i];
+			_event_queue[i].type = EVENT_COALESCED;
+			return true;
+		}
+	}
 	return XCheckTypedEvent(_dpy, type, ev);
 }
 
+bool
+X11::checkTypedWindowEvent(Window win, int type, XEvent *ev)
+{
+	for (size_t i = _event_queue_pos; i < _event_queue.size(); i++) {
+		if (_event_queue[i].type == type
+		    && _event_queue[i].xany.window == win) {
+			*ev = _event_queue[i];
+			_event_queue[i].type = EVENT_COALESCED;
+			return true;
+		}
+	}
+	return XCheckTypedWindowEvent(_dpy, win, type, ev);
+}
+
+/**
+ * Wait for event matching mask, checking the event queue before
+ * waiting for the server.
+ */
+void
+X11::maskEvent(long mask, XEvent *ev)
+{
+	for (size_t i = _event_queue_pos; i < _event_queue.size(); i++) {
+		if (isEventInMask(_event_queue[i], mask)) {
+			*ev = _event_queue[i];
+			_event_queue[i].type = EVENT_COALESCED;
+			return;
+		}
+	}
+	XMaskEvent(_dpy, mask, ev);
+}
+
+/**
+ * Push event back to the front of the event queue.
+ */
+void
+X11::putBackEvent(XEvent *ev)
+{
+	if (_event_queue_pos > 0) {
+		_event_queue[--_event_queue_pos] = *ev;
+	} else if (_event_queue.empty()) {
+		XPutBackEvent(_dpy, ev);
+	} else {
+		_event_queue.insert(_event_queue.begin(), *ev);
+	}
+}
+
+/**
+ * Check if event would be selected by the event mask.
+ */
+bool
+X11::isEventInMask(const XEvent &ev, long mask)
+{
+	long ev_mask;
+	switch (ev.type) {
+	case KeyPress:
+		ev_mask = KeyPressMask;
+		break;
+	case KeyRelease:
+		ev_mask = KeyReleaseMask;
+		break;
+	case ButtonPress:
+		ev_mask = ButtonPressMask;
+		break;
+	case ButtonRelease:
+		ev_mask = ButtonReleaseMask;
+		break;
+	case MotionNotify:
+		ev_mask = PointerMotionMask | PointerMotionHintMask
+			| ButtonMotionMask | Button1MotionMask
+			| Button2MotionMask | Button3MotionMask
+			| Button4MotionMask | Button5MotionMask;
+		break;
+	case EnterNotify:
+		ev_mask = EnterWindowMask;
+		break;
+	case LeaveNotify:
+		ev_mask = LeaveWindowMask;
+		break;
+	case FocusIn:
+	case FocusOut:
+		ev_mask = FocusChangeMask;
+		break;
+	case KeymapNotify:
+		ev_mask = KeymapStateMask;
+		break;
+	case Expose:
+		ev_mask = ExposureMask;
+		break;
+	case VisibilityNotify:
+		ev_mask = VisibilityChangeMask;
+		break;
+	case CreateNotify:
+		ev_mask = SubstructureNotifyMask;
+		break;
+	case DestroyNotify:
+	case UnmapNotify:
+	case MapNotify:
+	case ReparentNotify:
+	case ConfigureNotify:
+	case GravityNotify:
+	case CirculateNotify:
+		ev_mask = StructureNotifyMask | SubstructureNotifyMask;
+		break;
+	case MapRequest:
+	case ConfigureRequest:
+	case CirculateRequest:
+		ev_mask = SubstructureRedirectMask;
+		break;
+	case ResizeRequest:
+		ev_mask = ResizeRedirectMask;
+		break;
+	case PropertyNotify:
+		ev_mask = PropertyChangeMask;
+		break;
+	case ColormapNotify:
+		ev_mask = ColormapChangeMask;
+		break;
+	default:
+		ev_mask = NoEventMask;
+		break;
+	}
+	return (ev_mask & mask) != 0;
+}
+
 void
 X11::sync(Bool discard)
 {
@@ -1929,11 +2817,24 @@ bool X11::_has_extension_xkb = false;
 bool X11::_has_extension_xinerama = false;
 bool X11::_has_extension_xrandr = false;
 int X11::_event_xrandr = -1;
+bool X11::_has_extension_shm = false;
+bool X11::_has_extension_xrender = false;
+#ifdef PEKWM_HAVE_XSHM
+std::vector<X11::ShmSegment*> X11::_shm_segments;
+#endif // PEKWM_HAVE_XSHM
 uint X11::_num_lock;
 uint X11::_scroll_lock;
 std::vector<Head> X11::_heads;
 uint X11::_server_grabs;
 Time X11::_last_event_time;
+bool X11::_event_batch = false;
+std::vector<XEvent> X11::_event_queue;
+size_t X11::_event_queue_pos = 0;
+EventQueueStats X11::_event_queue_stats;
+#ifdef PEKWM_HAVE_XCB
+xcb_connection_t *X11::_xcb = nullptr;
+X11::prefetch_map X11::_prefetch;
+#endif // PEKWM_HAVE_XCB
 Window X11::_last_click_id = None;
 Time X11::_last_click_time[BUTTON_NO - 1];
 std::vector<X11::ColorEntry*> X11::_colors;
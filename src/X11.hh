@@ -15,6 +15,7 @@
 #include "Types.hh"
 
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -38,6 +39,9 @@ extern "C" {
 
 #define ShapeNotifyMask 1
 #endif // PEKWM_HAVE_SHAPE
+#ifdef PEKWM_HAVE_XCB
+#include <X11/Xlib-xcb.h>
+#endif // PEKWM_HAVE_XCB
 
 	extern bool xerrors_ignore; /**< If true, ignore X errors. */
 	extern unsigned int xerrors_count; /**< Number of X errors occured. */
@@ -265,6 +269,34 @@ struct ScreenChangeNotification
 	uint height;
 };
 
+/**
+ * Counters for the batched event queue, see X11::setEventBatch.
+ */
+struct EventQueueStats
+{
+	EventQueueStats(void)
+		: batches(0),
+		  events(0),
+		  motion(0),
+		  configure(0),
+		  property(0)
+	{
+	}
+
+	ulong coalesced(void) const { return motion + configure + property; }
+
+	/** Number of times the queue was filled. */
+	ulong batches;
+	/** Number of events read from the X server. */
+	ulong events;
+	/** Number of MotionNotify events dropped. */
+	ulong motion;
+	/** Number of ConfigureRequest events merged. */
+	ulong configure;
+	/** Number of PropertyNotify events dropped. */
+	ulong property;
+};
+
 //! @brief Display information class.
 class X11
 {
@@ -292,6 +324,8 @@ public:
 	static uint getNumLock(void) { return _num_lock; }
 	static uint getScrollLock(void) { return _scroll_lock; }
 	static bool hasExtensionShape(void) { return _has_extension_shape; }
+	static bool hasExtensionShm(void) { return _has_extension_shm; }
+	static bool hasExtensionXRender(void) { return _has_extension_xrender; }
 	static int getEventShape(void) { return _event_shape; }
 	static bool updateGeometry(uint width, uint height);
 	static Cursor getCursor(CursorType type) { return _cursor_map[type]; }
@@ -348,6 +382,11 @@ public:
 	static int pending(void);
 
 	static bool getNextEvent(XEvent &ev, struct timeval *timeout = nullptr);
+	static void setEventBatch(bool batch) { _event_batch = batch; }
+	static bool isEventBatch(void) { return _event_batch; }
+	static const EventQueueStats &getEventQueueStats(void) {
+		return _event_queue_stats;
+	}
 	static void allowEvents(int event_mode, Time time);
 	static bool grabServer(void);
 	static bool ungrabServer(bool sync);
@@ -396,6 +435,9 @@ public:
 				     Atom type, int &num);
 	static void unsetProperty(Window win, AtomName aname);
 
+	static void prefetchProperties(Window win, const Atom *atoms, size_t num);
+	static void clearPrefetchedProperties(void);
+
 	static void getMousePosition(int &x, int &y);
 	static uint getButtonFromState(uint state);
 
@@ -443,7 +485,11 @@ public:
 	static void ungrabButton(uint button, uint modifiers, Window win);
 
 	static void stackWindows(Window *wins, unsigned len);
+	static void stackWindowBelow(Window w, Window sibling);
 	static bool checkTypedEvent(int type, XEvent *ev);
+	static bool checkTypedWindowEvent(Window win, int type, XEvent *ev);
+	static void maskEvent(long mask, XEvent *ev);
+	static void putBackEvent(XEvent *ev);
 
 	static void sync(Bool discard);
 
@@ -469,6 +515,7 @@ public:
 	static Pixmap createPixmap(unsigned w, unsigned h);
 	static void freePixmap(Pixmap& pixmap);
 	static XImage *createImage(char *data, uint width, uint height);
+	static XImage *createImage(uint width, uint height);
 	static XImage *getImage(Drawable src, int x, int y, uint width, uint height,
 				unsigned long plane_mask, int format);
 	static void putImage(Drawable dest, GC gc, XImage *ximage,
@@ -494,6 +541,11 @@ public:
 protected:
 	static int parseGeometryVal(const char *c_str, const char *e_end,
 				    int &val_ret);
+	static void coalesceEvents(std::vector<XEvent> &events, size_t pos,
+				   EventQueueStats &stats);
+	static bool isEventInMask(const XEvent &ev, long mask);
+	static uchar *copyPropertyValue(int format, const void *value,
+					ulong items);
 
 private:
 	static uint calcDistance(int x1, int y1, int x2, int y2);
@@ -503,6 +555,25 @@ private:
 	static void initHeadsRandr(void);
 	static void initHeadsXinerama(void);
 
+	static void fillEventQueue(void);
+	static bool popEventQueue(XEvent &ev);
+
+	static bool getPrefetchedProperty(Window win, Atom atom, Atom type,
+					  Atom *type_ret, int *format_ret,
+					  uchar **data_ret, ulong *items_ret);
+	static void dropPrefetchedProperty(Window win, Atom atom);
+
+#ifdef PEKWM_HAVE_XSHM
+	class ShmSegment;
+
+	static XImage *createShmImage(int depth, uint width, uint height);
+	static ShmSegment *shmAcquire(size_t size);
+	static ShmSegment *shmFind(XImage *ximage);
+	static void shmRelease(ShmSegment *seg);
+	static ShmSegment *shmCreateSegment(size_t size);
+	static void shmDestroySegment(ShmSegment *seg);
+#endif // PEKWM_HAVE_XSHM
+
 protected:
 	X11(void) {}
 	~X11(void) {}
@@ -535,12 +606,36 @@ private:
 	static bool _has_extension_xrandr;
 	static int _event_xrandr;
 
+	static bool _has_extension_shm;
+	static bool _has_extension_xrender;
+#ifdef PEKWM_HAVE_XSHM
+	/** Shared memory segments for XImages, in use or free. */
+	static std::vector<ShmSegment*> _shm_segments;
+#endif // PEKWM_HAVE_XSHM
+
 	static std::vector<Head> _heads; //! Array of head information
 	static uint _last_head; //! Last accessed head
 
 	static uint _server_grabs;
 
 	static Time _last_event_time;
+
+	/** If true, drain all pending events into _event_queue at once. */
+	static bool _event_batch;
+	/** Events read from the server but not yet dispatched. */
+	static std::vector<XEvent> _event_queue;
+	/** Position of the next event to dispatch in _event_queue. */
+	static size_t _event_queue_pos;
+	static EventQueueStats _event_queue_stats;
+
+#ifdef PEKWM_HAVE_XCB
+	typedef std::map<std::pair<Window, Atom>,
+			 xcb_get_property_cookie_t> prefetch_map;
+
+	static xcb_connection_t *_xcb;
+	/** Outstanding GetProperty requests by window and atom. */
+	static prefetch_map _prefetch;
+#endif // PEKWM_HAVE_XCB
 	// information for dobule clicks
 	static Window _last_click_id;
 	static Time _last_click_time[BUTTON_NO - 1];
@@ -6,43 +6,20 @@
 // See the LICENSE file for more information.
 //
 
+#include "ChildRegistry.hh"
 #include "Debug.hh"
 #include "X11App.hh"
 #include "X11Util.hh"
 
+#include <algorithm>
+
 extern "C" {
-#include <sys/wait.h>
 #include <errno.h>
+#include <limits.h>
+#include <signal.h>
 #include <unistd.h>
 }
 
-static bool is_signal = false;
-static bool is_signal_alrm = false;
-static bool is_signal_hup = false;
-static bool is_signal_int_term = false;
-static bool is_signal_chld = false;
-
-static void sigHandler(int signal)
-{
-	is_signal = true;
-	switch (signal) {
-	case SIGHUP:
-		is_signal_hup = true;
-		break;
-	case SIGINT:
-	case SIGTERM:
-		is_signal_int_term = true;
-		break;
-	case SIGCHLD:
-		is_signal_chld = true;
-		break;
-	case SIGALRM:
-		// Do nothing, just used to break out of waiting
-		is_signal_alrm = true;
-		break;
-	}
-}
-
 /**
  * Base for X11 applications
  */
@@ -52,13 +29,16 @@ X11App::X11App(Geometry gm, const std::string &title,
 	: PWinObj(true),
 	  _wm_name(wm_name),
 	  _wm_class(wm_class),
-	  _stop(-1),
-	  _max_fd(-1)
+	  _stop(-1)
 {
-	_dpy_fd = ConnectionNumber(X11::getDpy());
-	addFd(_dpy_fd);
+	// Only used to wake up the main loop, events are read using
+	// X11::getNextEvent
+	_mainloop.addFd(ConnectionNumber(X11::getDpy()), nullptr, nullptr);
 
-	initSignalHandler();
+	_mainloop.addSignal(SIGTERM, handleSignal, this);
+	_mainloop.addSignal(SIGINT, handleSignal, this);
+	_mainloop.addSignal(SIGHUP, nullptr, nullptr);
+	ChildRegistry::attach(_mainloop);
 
 	_gm = gm;
 	_window =
@@ -106,50 +86,44 @@ X11App::stop(uint code) { _stop = code; }
 void
 X11App::addFd(int fd)
 {
-	if (fd > _max_fd) {
-		_max_fd = fd;
-	}
-	_fds.push_back(fd);
+	_mainloop.addFd(fd, fdReady, this);
 }
 
 void
 X11App::removeFd(int fd)
 {
-	_max_fd = 0;
-	std::vector<int>::iterator it = _fds.begin();
-	for (; it != _fds.end(); ) {
-		if (*it == fd) {
-			it = _fds.erase(it);
-		} else {
-			if (*it > _max_fd) {
-				_max_fd = *it;
-			}
-			++it;
-		}
-	}
+	_mainloop.removeFd(fd);
 }
 
+/**
+ * Run main loop until stopped, refresh is called every timeout_s
+ * seconds. UINT_MAX disables the refresh timer.
+ */
 int
 X11App::main(uint timeout_s)
 {
-	bool timed_out = false;
+	int timer = -1;
+	if (timeout_s != UINT_MAX) {
+		timeout_s = std::min(timeout_s, UINT_MAX / 1000);
+		timer = _mainloop.addTimer(timeout_s * 1000, true,
+					   refreshTimeout, this);
+	}
 
 	P_TRACE(_wm_name << ", " << _wm_class << ": entering main loop");
 	while (_stop == -1) {
-		if (is_signal) {
-			handleSignal();
+		if (X11::pending()) {
+			processEvent();
 		} else {
-			refresh(timed_out);
-
-			if (X11::pending()) {
-				processEvent();
-				timed_out = false;
-			} else {
-				timed_out = waitForData(timeout_s);
-			}
+			// flush before waiting ensuring any outstanding
+			// output is sent before waiting on a reply.
+			X11::flush();
+			_mainloop.wait();
 		}
 	}
 
+	if (timer != -1) {
+		_mainloop.removeTimer(timer);
+	}
 	return _stop;
 }
 
@@ -170,21 +144,14 @@ X11App::handleFd(int)
 }
 
 /**
- * Refresh function, called at every timeout interval.
+ * Refresh function, called at every timeout interval with timed_out
+ * set to true.
  */
 void
 X11App::refresh(bool)
 {
 }
 
-/**
- * Called whenever a child process finish
- */
-void
-X11App::handleChildDone(pid_t, int)
-{
-}
-
 /**
  * Called whenever the screen size has changed (XRandr)
  */
@@ -194,82 +161,27 @@ X11App::screenChanged(const ScreenChangeNotification &scn)
 }
 
 void
-X11App::initSignalHandler(void)
+X11App::fdReady(int fd, void *opaque)
 {
-	struct sigaction act;
-
-	// Set up the signal handlers.
-	act.sa_handler = sigHandler;
-	act.sa_mask = sigset_t();
-	act.sa_flags = SA_NOCLDSTOP | SA_NODEFER;
-
-	sigaction(SIGTERM, &act, 0);
-	sigaction(SIGINT, &act, 0);
-	sigaction(SIGHUP, &act, 0);
-	sigaction(SIGCHLD, &act, 0);
-	sigaction(SIGALRM, &act, 0);
+	reinterpret_cast<X11App*>(opaque)->handleFd(fd);
 }
 
 void
-X11App::handleSignal(void)
+X11App::refreshTimeout(int, void *opaque)
 {
-	if (is_signal_chld) {
-		pid_t pid;
-		do {
-			int status;
-			pid = waitpid(WAIT_ANY, &status, WNOHANG);
-			if (pid == -1) {
-				if (errno == EINTR) {
-					P_TRACE("waitpid interrupted, retrying");
-				}
-			} else if (pid == 0) {
-				P_TRACE("no more finished child processes");
-			} else {
-				P_TRACE("child process " << pid << " finished");
-				handleChildDone(pid, WEXITSTATUS(status));
-			}
-		} while (pid > 0 || (pid == -1 && errno == EINTR));
-
-		is_signal_chld = false;
-	}
-	if (is_signal_int_term) {
-		stop(1);
-		is_signal_int_term = false;
-	}
-	is_signal = false;
+	reinterpret_cast<X11App*>(opaque)->refresh(true);
 }
 
-bool
-X11App::waitForData(int timeout_s)
+void
+X11App::handleSignal(int signal, void *opaque)
 {
-	// flush before selecting input ensuring any outstanding
-	// output is sent before waiting on a reply.
-	X11::flush();
-
-	fd_set rfds;
-	FD_ZERO(&rfds);
-	std::vector<int>::iterator it;
-	for (it = _fds.begin(); it != _fds.end(); ++it) {
-		FD_SET(*it, &rfds);
-	}
-
-	struct timeval timeout = { timeout_s, 0 };
-	int ret = select(_max_fd + 1, &rfds, nullptr, nullptr, &timeout);
-	if (ret > 0) {
-		for (it = _fds.begin(); it != _fds.end(); ++it) {
-			if (! FD_ISSET(*it, &rfds)) {
-				continue;
-			}
-
-			if (*it == _dpy_fd) {
-				processEvent();
-			} else {
-				handleFd(*it);
-			}
-		}
+	X11App *app = reinterpret_cast<X11App*>(opaque);
+	switch (signal) {
+	case SIGINT:
+	case SIGTERM:
+		app->stop(1);
+		break;
 	}
-
-	return ret < 1;
 }
 
 void
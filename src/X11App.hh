@@ -9,6 +9,7 @@
 #ifndef _PEKWM_X11APP_HH_
 #define _PEKWM_X11APP_HH_
 
+#include "Mainloop.hh"
 #include "PWinObj.hh"
 #include "X11.hh"
 
@@ -28,17 +29,18 @@ public:
 	virtual int main(uint timeout_s);
 
 protected:
+	Mainloop &getMainloop(void) { return _mainloop; }
+
 	virtual void handleEvent(XEvent*);
 	virtual void handleFd(int);
 	virtual void refresh(bool);
-	virtual void handleChildDone(pid_t, int);
 
 	virtual void screenChanged(const ScreenChangeNotification &scn);
 
 private:
-	void initSignalHandler(void);
-	void handleSignal(void);
-	bool waitForData(int timeout_s);
+	static void fdReady(int fd, void *opaque);
+	static void refreshTimeout(int id, void *opaque);
+	static void handleSignal(int signal, void *opaque);
 
 	void processEvent(void);
 
@@ -47,9 +49,7 @@ private:
 	std::string _wm_class;
 
 	int _stop;
-	std::vector<int> _fds;
-	int _dpy_fd;
-	int _max_fd;
+	Mainloop _mainloop;
 };
 
 #endif // _PEKWM_X11APP_HH_
@@ -545,7 +545,7 @@ public:
 			_background = X11::createPixmap(_gm.width, _gm.height);
 			X11::setWindowBackgroundPixmap(_window, _background);
 		}
-		X11Render rend(_background);
+		XRenderRender rend(_background);
 		_data->getBackground()->render(rend,
 					       0, 0, _gm.width, _gm.height);
 		std::vector<Widget*>::iterator it = _widgets.begin();
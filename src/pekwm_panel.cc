@@ -8,9 +8,11 @@
 
 #include "pekwm.hh"
 #include "Charset.hh"
+#include "ChildRegistry.hh"
 #include "Compat.hh"
 #include "Debug.hh"
 #include "FontHandler.hh"
+#include "HashMap.hh"
 #include "ImageHandler.hh"
 #include "Observable.hh"
 #include "PImageIcon.hh"
@@ -26,6 +28,7 @@ extern "C" {
 #include <getopt.h>
 #include <limits.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 }
@@ -45,7 +48,17 @@ extern "C" {
 #define DEFAULT_BAR_BORDER "black"
 #define DEFAULT_BAR_FILL "grey50"
 
+/** Longest line read from external commands, longer lines are dropped. */
+#define EXTERNAL_COMMAND_LINE_MAX 4096
+/** First restart delay of persistent commands, doubled on each restart. */
+#define PERSISTENT_RESTART_MIN_S 1
+/** Restart delay limit of persistent commands without an Interval. */
+#define PERSISTENT_RESTART_MAX_S 300
+/** Run time after which a persistent command is considered stable. */
+#define PERSISTENT_STABLE_S 60
+
 typedef void(*fdFun)(int fd, void *opaque);
+typedef void(*commandDoneFun)(void *opaque);
 
 /**
  * Client state, used for selecting correct theme data for the client
@@ -90,6 +103,7 @@ static Util::StringTo<PanelPlacement> panel_placement_map[] =
 	 {"BOTTOM", PANEL_BOTTOM},
 	 {nullptr, PANEL_TOP}};
 
+#ifndef UNITTEST
 /** static pekwm resources, accessed via the pekwm namespace. */
 static ObserverMapping* _observer_mapping = nullptr;
 static FontHandler* _font_handler = nullptr;
@@ -118,6 +132,7 @@ namespace pekwm
 		return _texture_handler;
 	}
 }
+#endif // ! UNITTEST
 
 /**
  * Size request for widget.
@@ -225,28 +240,39 @@ WidgetConfig::~WidgetConfig(void)
 
 /**
  * Configuration for commands to be run at given intervals to
- * collect data.
+ * collect data, or kept running if persistent.
  */
 class CommandConfig {
 public:
 	CommandConfig(const std::string& command,
-		      uint interval_s);
+		      uint interval_s, bool persistent);
 	~CommandConfig(void);
 
 	const std::string& getCommand(void) const { return _command; }
 	uint getIntervalS(void) const { return _interval_s; }
+	bool isPersistent(void) const { return _persistent; }
+
+	void merge(uint interval_s, bool persistent)
+	{
+		_interval_s = std::min(_interval_s, interval_s);
+		_persistent = _persistent || persistent;
+	}
 
 private:
 	/** Command to run (using the shell) */
 	std::string _command;
-	/** Interval between runs, not including run time. */
+	/** Interval between runs, not including run time. For persistent
+	    commands the longest delay before restarting. */
 	uint _interval_s;
+	/** Command streams data and is restarted with backoff on exit. */
+	bool _persistent;
 };
 
 CommandConfig::CommandConfig(const std::string& command,
-                             uint interval_s)
+                             uint interval_s, bool persistent)
 	: _command(command),
-	  _interval_s(interval_s)
+	  _interval_s(interval_s),
+	  _persistent(persistent)
 {
 }
 
@@ -308,7 +334,8 @@ private:
 
 PanelConfig::PanelConfig(void)
 	: _placement(DEFAULT_PLACEMENT),
-	  _head(-1)
+	  _head(-1),
+	  _refresh_interval_s(UINT_MAX)
 {
 }
 
@@ -360,17 +387,33 @@ PanelConfig::loadCommands(CfgParser::Entry *section)
 	CfgParser::Entry::entry_cit it = section->begin();
 	for (; it != section->end(); ++it) {
 		uint interval = UINT_MAX;
+		bool persistent = false;
 
 		if ((*it)->getSection()) {
 			std::vector<CfgParserKey*> keys;
 			keys.push_back(new CfgParserKeyNumeric<uint>("INTERVAL",
 								     interval,
 								     UINT_MAX));
+			keys.push_back(new CfgParserKeyBool("PERSISTENT",
+							    persistent, false));
 			(*it)->getSection()->parseKeyValues(keys.begin(), keys.end());
 			std::for_each(keys.begin(), keys.end(),
 				      Util::Free<CfgParserKey*>());
 		}
-		_commands.push_back(CommandConfig((*it)->getValue(), interval));
+
+		// the same command is only run once, providing data for
+		// all widgets referencing its fields.
+		command_config_vector::iterator c_it = _commands.begin();
+		for (; c_it != _commands.end(); ++c_it) {
+			if (c_it->getCommand() == (*it)->getValue()) {
+				c_it->merge(interval, persistent);
+				break;
+			}
+		}
+		if (c_it == _commands.end()) {
+			_commands.push_back(CommandConfig((*it)->getValue(),
+							  interval, persistent));
+		}
 	}
 }
 
@@ -442,22 +485,23 @@ PanelConfig::parseSize(const std::string& size)
 	return SizeReq(WIDGET_UNIT_REQUIRED, 0);
 }
 
+/**
+ * Refresh is only required by widgets with an interval, output from
+ * commands is rendered as it is read.
+ *
+ * @return Minimum widget interval, UINT_MAX if no widget has one which
+ *         X11App::main treats as no refresh timer.
+ */
 uint
 PanelConfig::calculateRefreshIntervalS(void) const
 {
 	uint min = UINT_MAX;
-	command_config_vector::const_iterator it = _commands.begin();
-	for (; it != _commands.end(); ++it) {
+	std::vector<WidgetConfig>::const_iterator it = _widgets.begin();
+	for (; it != _widgets.end(); ++it) {
 		if (it->getIntervalS() < min) {
 			min = it->getIntervalS();
 		}
 	}
-	std::vector<WidgetConfig>::const_iterator w_it = _widgets.begin();
-	for (; w_it != _widgets.end(); ++w_it) {
-		if (w_it->getIntervalS() < min) {
-			min = w_it->getIntervalS();
-		}
-	}
 	return min;
 }
 
@@ -482,6 +526,161 @@ FieldObservation::~FieldObservation(void)
 {
 }
 
+/**
+ * Fixed size ring buffer splitting data read from a file descriptor
+ * into lines. Lines longer than the buffer are dropped.
+ */
+class LineBuffer {
+public:
+	LineBuffer(size_t size);
+	~LineBuffer(void);
+
+	size_t size(void) const { return _used; }
+
+	ssize_t read(int fd);
+	bool getLine(std::string &line);
+	bool getRest(std::string &line);
+	void clear(void);
+
+private:
+	void copy(std::string &line, size_t len);
+	void consume(size_t len);
+
+private:
+	std::vector<char> _buf;
+	/** Position of the first byte of data. */
+	size_t _head;
+	/** Number of bytes in the buffer. */
+	size_t _used;
+	/** Number of bytes from _head known not to contain a newline. */
+	size_t _scanned;
+	/** Set when dropping the rest of a line longer than the buffer. */
+	bool _discard;
+};
+
+LineBuffer::LineBuffer(size_t size)
+	: _buf(size),
+	  _head(0),
+	  _used(0),
+	  _scanned(0),
+	  _discard(false)
+{
+}
+
+LineBuffer::~LineBuffer(void)
+{
+}
+
+/**
+ * Read available data from fd into the free space of the buffer.
+ *
+ * @return Result of readv, 0 on end of file.
+ */
+ssize_t
+LineBuffer::read(int fd)
+{
+	if (_used == _buf.size()) {
+		P_DBG("line longer than " << _buf.size() << " bytes, dropping");
+		clear();
+		_discard = true;
+	}
+
+	size_t tail = (_head + _used) % _buf.size();
+	struct iovec iov[2];
+	int iovcnt = 1;
+	iov[0].iov_base = &_buf[tail];
+	if (tail < _head) {
+		iov[0].iov_len = _head - tail;
+	} else {
+		iov[0].iov_len = _buf.size() - tail;
+		if (_head > 0) {
+			iov[1].iov_base = &_buf[0];
+			iov[1].iov_len = _head;
+			iovcnt = 2;
+		}
+	}
+
+	ssize_t nread = readv(fd, iov, iovcnt);
+	if (nread > 0) {
+		_used += nread;
+	}
+	return nread;
+}
+
+/**
+ * Get the next complete line, without the newline.
+ *
+ * @return true if a line was available.
+ */
+bool
+LineBuffer::getLine(std::string &line)
+{
+	while (_scanned < _used) {
+		if (_buf[(_head + _scanned) % _buf.size()] != '\n') {
+			_scanned++;
+			continue;
+		}
+
+		bool discard = _discard;
+		_discard = false;
+		if (! discard) {
+			copy(line, _scanned);
+		}
+		consume(_scanned + 1);
+		if (! discard) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Get data after the last newline, used when the end of the output has
+ * been reached.
+ *
+ * @return true if there was data not part of a dropped line.
+ */
+bool
+LineBuffer::getRest(std::string &line)
+{
+	bool has_rest = _used > 0 && ! _discard;
+	if (has_rest) {
+		copy(line, _used);
+	}
+	clear();
+	return has_rest;
+}
+
+void
+LineBuffer::clear(void)
+{
+	_head = 0;
+	_used = 0;
+	_scanned = 0;
+	_discard = false;
+}
+
+void
+LineBuffer::copy(std::string &line, size_t len)
+{
+	size_t first = std::min(len, _buf.size() - _head);
+	line.assign(&_buf[_head], first);
+	if (first < len) {
+		line.append(&_buf[0], len - first);
+	}
+}
+
+void
+LineBuffer::consume(size_t len)
+{
+	_head = (_head + len) % _buf.size();
+	_used -= len;
+	_scanned = 0;
+	if (_used == 0) {
+		_head = 0;
+	}
+}
+
 /**
  * Collection of data from external commands.
  *
@@ -497,52 +696,61 @@ public:
 	class CommandProcess
 	{
 	public:
-		CommandProcess(const std::string& command, uint interval_s);
+		CommandProcess(const std::string& command, uint interval_s,
+			       bool persistent);
 		~CommandProcess(void);
 
+		const std::string& getCommand(void) const { return _command; }
 		int getFd(void) const { return _fd; }
 		pid_t getPid(void) const { return _pid; }
-		std::string& getBuf(void) { return _buf; }
+		LineBuffer& getBuf(void) { return _buf; }
+		uint getIntervalS(void) const { return _interval_s; }
+		int getTimer(void) const { return _timer; }
+		void setTimer(int timer) { _timer = timer; }
+
+		/**
+		 * Seconds to wait before the next run. Persistent commands
+		 * are restarted with an exponential backoff, reset once the
+		 * command has been running for PERSISTENT_STABLE_S.
+		 */
+		uint getNextRunS(void)
+		{
+			if (! _persistent) {
+				return _interval_s;
+			}
+
+			if (time(nullptr) - _started >= PERSISTENT_STABLE_S) {
+				_restart_s = PERSISTENT_RESTART_MIN_S;
+			}
+			uint max_s = _interval_s == UINT_MAX
+				? PERSISTENT_RESTART_MAX_S : _interval_s;
+			max_s = std::max(max_s,
+					 static_cast<uint>(PERSISTENT_RESTART_MIN_S));
+
+			uint delay_s = std::min(_restart_s, max_s);
+			_restart_s = std::min(_restart_s * 2, max_s);
+			return delay_s;
+		}
 
-		bool start(void)
+		bool start(ChildRegistry::doneFun fun, void *opaque)
 		{
+			_started = time(nullptr);
+
 			int fd[2];
-			int ret = pipe(fd);
-			if (ret == -1) {
-				P_ERR("pipe failed due to: " << strerror(errno));
+			if (! ChildRegistry::openPipe(fd)) {
 				return false;
 			}
 
-			_pid = fork();
+			// write end is stdout of the command, only reading
+			_pid = ChildRegistry::spawnShell(_command, fd[1], false,
+							 fun, opaque);
+			close(fd[1]);
 			if (_pid == -1) {
 				close(fd[0]);
-				close(fd[1]);
-				P_ERR("fork failed due to: " << strerror(errno));
 				return false;
-			} else if (_pid == 0) {
-				// child, dup write end of file descriptor to stdout
-				dup2(fd[1], STDOUT_FILENO);
-
-				close(fd[0]);
-				close(fd[1]);
-
-				char *argv[5];
-				argv[0] = strdup("/bin/sh");
-				argv[1] = strdup("sh");
-				argv[2] = strdup("-c");
-				argv[3] = strdup(_command.c_str());
-				argv[4] = NULL;
-				execvp(argv[0], argv);
-
-				P_ERR("failed to execute: " << _command);
-
-				close(STDOUT_FILENO);
-				exit(1);
 			}
 
-			// parent, close write end just going to read
 			_fd = fd[0];
-			close(fd[1]);
 			Util::setNonBlock(_fd);
 			if (Debug::isLevel(Debug::LEVEL_TRACE)) {
 				std::ostringstream msg;
@@ -553,11 +761,6 @@ public:
 			return true;
 		}
 
-		bool checkInterval(struct timespec *now)
-		{
-			return now->tv_sec >= _next_interval.tv_sec;
-		}
-
 		void reset(void)
 		{
 			_pid = -1;
@@ -565,21 +768,23 @@ public:
 				close(_fd);
 			}
 			_fd = -1;
-			_buf = "";
-
-			int ret = clock_gettime(CLOCK_MONOTONIC, &_next_interval);
-			assert(ret == 0);
-			_next_interval.tv_sec += _interval_s;
+			_buf.clear();
 		}
 
 	private:
 		std::string _command;
 		uint _interval_s;
-		struct timespec _next_interval;
+		bool _persistent;
+		/** Timer starting the command, -1 if not scheduled. */
+		int _timer;
+		/** Delay before the next restart of a persistent command. */
+		uint _restart_s;
+		/** Time the command was last started. */
+		time_t _started;
 
 		pid_t _pid;
 		int _fd;
-		std::string _buf;
+		LineBuffer _buf;
 	};
 
 	ExternalCommandData(const PanelConfig& cfg);
@@ -587,31 +792,52 @@ public:
 
 	const std::string& get(const std::string& field) const
 	{
-		std::map<std::string, std::string>::const_iterator it =
-			_fields.find(field);
-		return it == _fields.end() ? _empty_wstring : it->second;
-	}
-
-	void refresh(fdFun addFd, void *opaque)
+		const std::string *value = _fields.find(field);
+		return value ? *value : _empty_wstring;
+	}
+
+	/**
+	 * Schedule all commands for immediate execution, commands are
+	 * re-scheduled interval seconds after they finish.
+	 *
+	 * @param addFd Called with the output fd of started commands.
+	 * @param removeFd Called with the output fd of finished commands.
+	 * @param commandDone Called once the remaining output of a
+	 *                    finished command has been parsed.
+	 */
+	void start(Mainloop *mainloop, fdFun addFd, fdFun removeFd,
+		   commandDoneFun commandDone, void *opaque)
 	{
-		struct timespec now;
-		int ret = clock_gettime(CLOCK_MONOTONIC, &now);
-		assert(ret == 0);
+		_mainloop = mainloop;
+		_add_fd = addFd;
+		_remove_fd = removeFd;
+		_command_done = commandDone;
+		_fd_opaque = opaque;
 
 		std::vector<CommandProcess>::iterator it = _command_processes.begin();
 		for (; it != _command_processes.end(); ++it) {
-			if (it->getPid() == -1
-			    && it->checkInterval(&now)
-			    && it->start()) {
-				addFd(it->getFd(), opaque);
-			}
+			it->setTimer(_mainloop->addTimer(0, false,
+							 startCommand, this));
 		}
 	}
 
+	/**
+	 * Read output from the command with fd, complete lines are parsed
+	 * as they arrive. Lines longer than EXTERNAL_COMMAND_LINE_MAX are
+	 * dropped by the line buffer, the total output is not limited as
+	 * long-running commands stream output for their whole life.
+	 *
+	 * @return false on end of output or error.
+	 */
 	bool input(int fd)
 	{
-		char buf[1024];
-		ssize_t nread = read(fd, buf, sizeof(buf));
+		CommandProcess *process = findProcess(fd);
+		if (process == nullptr) {
+			return false;
+		}
+
+		LineBuffer &buf = process->getBuf();
+		ssize_t nread = buf.read(fd);
 		if (nread < 1) {
 			if (nread == -1) {
 				P_TRACE("failed to read from " << fd << ": " << strerror(errno));
@@ -619,18 +845,22 @@ public:
 			return false;
 		}
 
-		std::vector<CommandProcess>::iterator it = _command_processes.begin();
-		for (; it != _command_processes.end(); ++it) {
-			if (it->getFd() == fd) {
-				append(it->getBuf(), buf, nread);
-				break;
-			}
+		std::string line;
+		while (buf.getLine(line)) {
+			parseLine(line);
 		}
-
 		return true;
 	}
 
-	void done(pid_t pid, fdFun removeFd, void *opaque)
+private:
+	static void commandDone(pid_t pid, int, void *opaque)
+	{
+		ExternalCommandData *data =
+			reinterpret_cast<ExternalCommandData*>(opaque);
+		data->done(pid);
+	}
+
+	void done(pid_t pid)
 	{
 		std::vector<CommandProcess>::iterator it = _command_processes.begin();
 		for (; it != _command_processes.end(); ++it) {
@@ -638,68 +868,133 @@ public:
 				while (input(it->getFd())) {
 					// read data left in pipe if any
 				}
-				parseOutput(it->getBuf());
-				removeFd(it->getFd(), opaque);
+				std::string line;
+				if (it->getBuf().getRest(line)) {
+					parseLine(line);
+				}
+				_remove_fd(it->getFd(), _fd_opaque);
 
-				// clean up state, resetting timer and pid/fd
+				// clean up state, resetting pid/fd and schedule
+				// next run
 				it->reset();
+				schedule(*it);
+
+				_command_done(_fd_opaque);
 				break;
 			}
 		}
 	}
 
-private:
-	void append(std::string &buf, char *data, size_t size)
+	/**
+	 * Schedule next run of process, commands without an interval
+	 * are only run once.
+	 */
+	void schedule(CommandProcess &process)
 	{
-		buf.append(data, data + size);
-		size_t pos = buf.find('\n');
-		while (pos != std::string::npos) {
-			std::string line = buf.substr(0, pos);
-			parseLine(line);
-			buf.erase(0, pos + 1);
-			pos = buf.find('\n');
+		if (_mainloop == nullptr) {
+			return;
+		}
+
+		uint next_run_s = process.getNextRunS();
+		if (next_run_s == UINT_MAX) {
+			P_TRACE("no interval for " << process.getCommand()
+				<< ", not running again");
+			return;
 		}
+		P_TRACE("next run of " << process.getCommand() << " in "
+			<< next_run_s << "s");
+		next_run_s = std::min(next_run_s, UINT_MAX / 1000);
+		process.setTimer(_mainloop->addTimer(next_run_s * 1000,
+						     false, startCommand,
+						     this));
 	}
 
-	void parseOutput(const std::string& buf)
+	static void startCommand(int id, void *opaque)
 	{
-		std::vector<std::string> lines;
-		Util::splitString(buf, lines, "\n");
-		std::vector<std::string>::iterator it = lines.begin();
-		for (; it != lines.end(); ++it) {
-			parseLine(*it);
+		ExternalCommandData *data =
+			reinterpret_cast<ExternalCommandData*>(opaque);
+		std::vector<CommandProcess>::iterator it =
+			data->_command_processes.begin();
+		for (; it != data->_command_processes.end(); ++it) {
+			if (it->getTimer() == id) {
+				it->setTimer(-1);
+				if (it->start(commandDone, data)) {
+					data->_add_fd(it->getFd(), data->_fd_opaque);
+				} else {
+					data->schedule(*it);
+				}
+				break;
+			}
 		}
 	}
 
+	CommandProcess *findProcess(int fd)
+	{
+		std::vector<CommandProcess>::iterator it = _command_processes.begin();
+		for (; it != _command_processes.end(); ++it) {
+			if (it->getFd() == fd) {
+				return &*it;
+			}
+		}
+		return nullptr;
+	}
+
+	/**
+	 * Parse field and value separated by a space or tab, observers
+	 * are only notified if the value of the field changed.
+	 */
 	void parseLine(const std::string& line)
 	{
-		std::vector<std::string> field_value;
-		if (Util::splitString(line, field_value, " \t", 2) == 2) {
-			_fields[field_value[0]] = field_value[1];
-			FieldObservation field_obs(field_value[0]);
-			pekwm::observerMapping()->notifyObservers(this, &field_obs);
+		size_t start = line.find_first_not_of(" \t\n");
+		if (start == std::string::npos) {
+			return;
+		}
+		size_t end = line.find_first_of(" \t", start);
+		if (end == std::string::npos || end + 1 == line.size()) {
+			return;
 		}
+
+		std::string field = line.substr(start, end - start);
+		std::string *value = _fields.find(field);
+		if (value == nullptr) {
+			value = &_fields[field];
+		} else if (value->compare(0, std::string::npos,
+					  line, end + 1, std::string::npos) == 0) {
+			return;
+		}
+		value->assign(line, end + 1, std::string::npos);
+
+		FieldObservation field_obs(field);
+		pekwm::observerMapping()->notifyObservers(this, &field_obs);
 	}
 
 private:
 	const PanelConfig& _cfg;
 
-	std::map<std::string, std::string> _fields;
+	Mainloop *_mainloop;
+	fdFun _add_fd;
+	fdFun _remove_fd;
+	commandDoneFun _command_done;
+	void *_fd_opaque;
+
+	/** Last value of each field. */
+	HashMap<std::string, std::string> _fields;
 	std::vector<CommandProcess> _command_processes;
 };
 
 ExternalCommandData::CommandProcess::CommandProcess(const std::string& command,
-                                                    uint interval_s)
+                                                    uint interval_s,
+                                                    bool persistent)
 	: _command(command),
 	  _interval_s(interval_s),
+	  _persistent(persistent),
+	  _timer(-1),
+	  _restart_s(PERSISTENT_RESTART_MIN_S),
+	  _started(time(nullptr)),
 	  _pid(-1),
-	  _fd(-1)
+	  _fd(-1),
+	  _buf(EXTERNAL_COMMAND_LINE_MAX)
 {
-	// set next interval to last second to ensure immediate
-	// execution
-	int ret = clock_gettime(CLOCK_MONOTONIC, &_next_interval);
-	assert(ret == 0);
-	_next_interval.tv_sec--;
 }
 
 ExternalCommandData::CommandProcess::~CommandProcess(void)
@@ -708,6 +1003,8 @@ ExternalCommandData::CommandProcess::~CommandProcess(void)
 }
 
 class ClientInfo : public NetWMStates {
+	friend class ClientList;
+
 public:
 	ClientInfo(Window window);
 	virtual ~ClientInfo(void);
@@ -722,6 +1019,8 @@ public:
 		return sticky || this->_workspace == workspace;
 	}
 
+	void prefetch(void);
+	void read(void);
 	bool handlePropertyNotify(XPropertyEvent *ev);
 
 private:
@@ -749,32 +1048,49 @@ private:
 	Geometry _gm;
 	uint _workspace;
 	PImageIcon *_icon;
+	/** ClientList update generation. */
+	uint _list_gen;
 };
 
 ExternalCommandData::ExternalCommandData(const PanelConfig& cfg)
-	: _cfg(cfg)
+	: _cfg(cfg),
+	  _mainloop(nullptr),
+	  _add_fd(nullptr),
+	  _remove_fd(nullptr),
+	  _command_done(nullptr),
+	  _fd_opaque(nullptr)
 {
 	PanelConfig::command_config_it it = _cfg.commandsBegin();
 	for (; it != _cfg.commandsEnd(); ++it) {
 		_command_processes.push_back(CommandProcess(it->getCommand(),
-							    it->getIntervalS()));
+							    it->getIntervalS(),
+							    it->isPersistent()));
 	}
 }
 
 ExternalCommandData::~ExternalCommandData(void)
 {
+	if (_mainloop == nullptr) {
+		return;
+	}
+
+	std::vector<CommandProcess>::iterator it = _command_processes.begin();
+	for (; it != _command_processes.end(); ++it) {
+		if (it->getTimer() != -1) {
+			_mainloop->removeTimer(it->getTimer());
+		}
+		if (it->getPid() != -1) {
+			ChildRegistry::remove(it->getPid());
+		}
+	}
 }
 
 ClientInfo::ClientInfo(Window window)
-	: _window(window)
+	: _window(window),
+	  _workspace(0),
+	  _icon(nullptr),
+	  _list_gen(0)
 {
-	X11::selectInput(_window, PropertyChangeMask);
-
-	_name = readName();
-	_gm = readGeometry();
-	_workspace = readWorkspace();
-	X11Util::readEwmhStates(_window, *this);
-	_icon = PImageIcon::newFromWindow(_window);
 }
 
 ClientInfo::~ClientInfo(void)
@@ -784,6 +1100,39 @@ ClientInfo::~ClientInfo(void)
 	}
 }
 
+/**
+ * Request the properties read by read without waiting for the replies,
+ * done for all new clients before reading any of them.
+ */
+void
+ClientInfo::prefetch(void)
+{
+	Atom atoms[] = {
+		X11::getAtom(NET_WM_VISIBLE_NAME),
+		X11::getAtom(NET_WM_NAME),
+		XA_WM_NAME,
+		X11::getAtom(NET_WM_DESKTOP),
+		X11::getAtom(STATE),
+		X11::getAtom(NET_WM_ICON)
+	};
+	X11::prefetchProperties(_window, atoms,
+				sizeof(atoms) / sizeof(atoms[0]));
+}
+
+/**
+ * Read client properties, input must be selected on the window before
+ * reading to not miss updates.
+ */
+void
+ClientInfo::read(void)
+{
+	_name = readName();
+	_gm = readGeometry();
+	_workspace = readWorkspace();
+	X11Util::readEwmhStates(_window, *this);
+	_icon = PImageIcon::newFromWindow(_window);
+}
+
 bool
 ClientInfo::handlePropertyNotify(XPropertyEvent *ev)
 {
@@ -816,6 +1165,117 @@ ClientInfo::readName(void)
 	return _empty_wstring;
 }
 
+/**
+ * Clients in _NET_CLIENT_LIST order.
+ *
+ * Updates are diffed against the previous list, existing clients out
+ * of order are looked up in a hash index instead of searching the list.
+ */
+class ClientList {
+public:
+	typedef std::vector<ClientInfo*>::const_iterator const_iterator;
+
+	ClientList(void);
+	~ClientList(void);
+
+	size_t size(void) const { return _clients.size(); }
+	const_iterator begin(void) const { return _clients.begin(); }
+	const_iterator end(void) const { return _clients.end(); }
+
+	ClientInfo *find(Window win) const {
+		ClientInfo **client_info = _index.find(win);
+		return client_info ? *client_info : nullptr;
+	}
+
+	bool update(const Window *windows, ulong num,
+		    std::vector<ClientInfo*> &added);
+
+private:
+	ClientList(const ClientList&);
+	ClientList &operator=(const ClientList&);
+
+	/** Clients in list order. */
+	std::vector<ClientInfo*> _clients;
+	/** Clients by window. */
+	mutable HashMap<Window, ClientInfo*> _index;
+	/** Update generation, clients in the list have it set. */
+	uint _gen;
+};
+
+ClientList::ClientList(void)
+	: _gen(0)
+{
+}
+
+ClientList::~ClientList(void)
+{
+	std::vector<ClientInfo*>::iterator it = _clients.begin();
+	for (; it != _clients.end(); ++it) {
+		delete *it;
+	}
+}
+
+/**
+ * Update list to windows, clients no longer in the list are deleted
+ * and new clients are created without reading their properties.
+ *
+ * @param added Set to the created clients.
+ * @return true if the list changed.
+ */
+bool
+ClientList::update(const Window *windows, ulong num,
+		   std::vector<ClientInfo*> &added)
+{
+	added.clear();
+
+	bool same_order = num == _clients.size();
+	for (ulong i = 0; same_order && i < num; i++) {
+		same_order = _clients[i]->getWindow() == windows[i];
+	}
+	if (same_order) {
+		return false;
+	}
+
+	// walk the new and previous list in order, the list is in mapping
+	// order so most windows match without using the index.
+	_gen++;
+	std::vector<ClientInfo*> clients;
+	clients.reserve(num);
+	size_t prev = 0;
+	for (ulong i = 0; i < num; i++) {
+		ClientInfo *client_info;
+		if (prev < _clients.size()
+		    && _clients[prev]->getWindow() == windows[i]) {
+			client_info = _clients[prev++];
+		} else {
+			ClientInfo **found = _index.find(windows[i]);
+			if (found) {
+				client_info = *found;
+			} else {
+				client_info = new ClientInfo(windows[i]);
+				_index.insert(windows[i], client_info);
+				added.push_back(client_info);
+			}
+		}
+
+		if (client_info->_list_gen != _gen) {
+			client_info->_list_gen = _gen;
+			clients.push_back(client_info);
+		}
+	}
+
+	std::vector<ClientInfo*>::iterator it = _clients.begin();
+	for (; it != _clients.end(); ++it) {
+		if ((*it)->_list_gen != _gen) {
+			_index.erase((*it)->getWindow());
+			delete *it;
+		}
+	}
+	_clients.swap(clients);
+
+	return true;
+}
+
 /**
  * Current window manager state.
  */
@@ -828,8 +1288,7 @@ public:
 	class PEKWM_THEME_Changed : public Observation {
 	};
 
-	typedef std::vector<ClientInfo*> client_info_vector;
-	typedef client_info_vector::const_iterator client_info_it;
+	typedef ClientList::const_iterator client_info_it;
 
 	WmState(void);
 	virtual ~WmState(void);
@@ -850,7 +1309,9 @@ public:
 		return _empty_wstring;
 	}
 	Window getActiveWindow(void) const { return _active_window; }
-	ClientInfo *findClientInfo(Window win) const;
+	ClientInfo *findClientInfo(Window win) const {
+		return _clients.find(win);
+	}
 
 	uint numClients(void) const { return _clients.size(); }
 	client_info_it clientsBegin(void) const { return _clients.begin(); }
@@ -859,10 +1320,6 @@ public:
 	bool handlePropertyNotify(XPropertyEvent *ev);
 
 private:
-	ClientInfo* findClientInfo(Window win,
-				   const std::vector<ClientInfo*> &clients) const;
-	ClientInfo* popClientInfo(Window win, std::vector<ClientInfo*> &clients);
-
 	bool readActiveWorkspace(void);
 	bool readActiveWindow(void);
 	bool readClientListStacking(void);
@@ -871,7 +1328,7 @@ private:
 private:
 	Window _active_window;
 	uint _workspace;
-	client_info_vector _clients;
+	ClientList _clients;
 	std::vector<std::string> _desktop_names;
 
 	XROOTPMAP_ID_Changed _xrootpmap_id_changed;
@@ -887,16 +1344,6 @@ WmState::WmState(void)
 
 WmState::~WmState(void)
 {
-	std::vector<ClientInfo*>::iterator it = _clients.begin();
-	for (; it != _clients.end(); ++it) {
-		delete *it;
-	}
-}
-
-ClientInfo*
-WmState::findClientInfo(Window win) const
-{
-	return findClientInfo(win, _clients);
 }
 
 bool
@@ -918,7 +1365,7 @@ WmState::handlePropertyNotify(XPropertyEvent *ev)
 			observation = &_pekwm_theme_changed;
 		}
 	} else {
-		ClientInfo *client_info = findClientInfo(ev->window, _clients);
+		ClientInfo *client_info = _clients.find(ev->window);
 		if (client_info != nullptr) {
 			updated = client_info->handlePropertyNotify(ev);
 		}
@@ -931,33 +1378,6 @@ WmState::handlePropertyNotify(XPropertyEvent *ev)
 	return updated;
 }
 
-ClientInfo*
-WmState::findClientInfo(Window win,
-                        const std::vector<ClientInfo*> &clients) const
-{
-	std::vector<ClientInfo*>::const_iterator it = clients.begin();
-	for (; it != clients.end(); ++it) {
-		if ((*it)->getWindow() == win) {
-			return *it;
-		}
-	}
-	return nullptr;
-}
-
-ClientInfo*
-WmState::popClientInfo(Window win, std::vector<ClientInfo*> &clients)
-{
-	std::vector<ClientInfo*>::iterator it = clients.begin();
-	for (; it != clients.end(); ++it) {
-		if ((*it)->getWindow() == win) {
-			ClientInfo *client_info = *it;
-			clients.erase(it);
-			return client_info;
-		}
-	}
-	return nullptr;
-}
-
 bool
 WmState::readActiveWorkspace(void)
 {
@@ -997,26 +1417,28 @@ WmState::readClientListStacking(void)
 		return false;
 	}
 
-	client_info_vector old_clients = _clients;
-	_clients.clear();
-	for (uint i = 0; i < actual; i++) {
-		ClientInfo *client_info = popClientInfo(windows[i], old_clients);
-		if (client_info == nullptr) {
-			_clients.push_back(new ClientInfo(windows[i]));
-		} else {
-			_clients.push_back(client_info);
-		}
-	}
+	std::vector<ClientInfo*> added;
+	bool updated = _clients.update(windows, actual, added);
+	X11::free(windows);
 
-	client_info_it it = old_clients.begin();
-	for (; it != old_clients.end(); ++it) {
-		delete *it;
+	// select input on all new clients and request all of their
+	// properties before waiting for any reply, the replies are then
+	// read in one pass.
+	std::vector<ClientInfo*>::iterator it = added.begin();
+	for (; it != added.end(); ++it) {
+		X11::selectInput((*it)->getWindow(), PropertyChangeMask);
 	}
+	for (it = added.begin(); it != added.end(); ++it) {
+		(*it)->prefetch();
+	}
+	for (it = added.begin(); it != added.end(); ++it) {
+		(*it)->read();
+	}
+	X11::clearPrefetchedProperties();
 
-	X11::free(windows);
-
-	P_TRACE("read _NET_CLIENT_LIST, " << actual << " windows");
-	return true;
+	P_TRACE("read _NET_CLIENT_LIST, " << actual << " windows, "
+		<< added.size() << " new");
+	return updated;
 }
 
 bool
@@ -1285,10 +1707,42 @@ loadTheme(PanelTheme& theme, const std::string& pekwm_config_file)
 	theme.setIconPath(icon_path, theme_dir + "/icons/");
 }
 
+/**
+ * Render onto the pixmap of a widget, clear copies the panel background
+ * at the position of the widget making it possible to render widgets
+ * in widget local coordinates.
+ */
+class WidgetRender : public XRenderRender {
+public:
+	WidgetRender(Pixmap pixmap, Pixmap background, int x)
+		: XRenderRender(pixmap),
+		  _background(background),
+		  _x(x)
+	{
+	}
+	virtual ~WidgetRender(void) { }
+
+	virtual void clear(int x, int y, uint width, uint height)
+	{
+		XCopyArea(X11::getDpy(), _background, getDrawable(),
+			  X11::getGC(), _x + x, y, width, height, x, y);
+	}
+
+private:
+	Pixmap _background;
+	int _x;
+};
+
 /**
  * Base class for all widgets displayed on the panel.
+ *
+ * Widgets are rendered onto a pixmap of their own that is copied to
+ * the panel window, the pixmap is only re-rendered when the hash of
+ * the content returned by updateContent changes.
  */
 class PanelWidget {
+	friend class TestPanelWidget;
+
 public:
 	PanelWidget(const PanelTheme &theme, const SizeReq& size_req);
 	virtual ~PanelWidget(void);
@@ -1312,10 +1766,24 @@ public:
 
 	virtual void click(int, int) { }
 
+	/**
+	 * Update the content to render, returns a hash of the content.
+	 * Widgets without a content hash are rendered when dirty.
+	 */
+	virtual size_t updateContent(void)
+	{
+		return _dirty ? _hash + 1 : _hash;
+	}
+
+	bool renderCached(Pixmap background, bool force);
+	void copyTo(Drawable dest, int x, uint width) const;
+
+	/**
+	 * Render widget, coordinates are relative to the widget.
+	 */
 	virtual void render(Render& render)
 	{
-		render.clear(_x, 0, _width, _theme.getHeight());
-		_dirty = false;
+		render.clear(0, 0, _width, _theme.getHeight());
 	}
 
 protected:
@@ -1331,6 +1799,13 @@ private:
 	int _rx;
 	uint _width;
 	SizeReq _size_req;
+
+	/** Rendered widget, matching _hash. */
+	Pixmap _pixmap;
+	uint _pixmap_width;
+	uint _pixmap_height;
+	/** Hash of the content rendered onto _pixmap. */
+	size_t _hash;
 };
 
 PanelWidget::PanelWidget(const PanelTheme &theme,
@@ -1340,12 +1815,74 @@ PanelWidget::PanelWidget(const PanelTheme &theme,
 	  _x(0),
 	  _rx(0),
 	  _width(0),
-	  _size_req(size_req)
+	  _size_req(size_req),
+	  _pixmap(None),
+	  _pixmap_width(0),
+	  _pixmap_height(0),
+	  _hash(0)
 {
 }
 
 PanelWidget::~PanelWidget(void)
 {
+	X11::freePixmap(_pixmap);
+}
+
+/**
+ * Render widget onto its pixmap if the content changed, the size
+ * changed or force is set. The dirty flag is consumed by updateContent
+ * and only kept if the widget could not be rendered.
+ *
+ * @param background Panel background, used when clearing.
+ * @return true if the pixmap was rendered and needs to be copied.
+ */
+bool
+PanelWidget::renderCached(Pixmap background, bool force)
+{
+	size_t hash = updateContent();
+	bool dirty = _dirty;
+	_dirty = false;
+	if (_width == 0) {
+		_dirty = dirty;
+		return false;
+	}
+
+	uint height = _theme.getHeight();
+	if (_pixmap == None
+	    || _pixmap_width != _width || _pixmap_height != height) {
+		X11::freePixmap(_pixmap);
+		_pixmap = X11::createPixmap(_width, height);
+		if (_pixmap == None) {
+			_dirty = dirty;
+			return false;
+		}
+		_pixmap_width = _width;
+		_pixmap_height = height;
+		force = true;
+	}
+
+	if (! force && hash == _hash) {
+		return false;
+	}
+	_hash = hash;
+
+	WidgetRender rend(_pixmap, background, _x);
+	render(rend);
+	return true;
+}
+
+/**
+ * Copy the part of the rendered widget between x and x + width, in
+ * panel coordinates, to dest.
+ */
+void
+PanelWidget::copyTo(Drawable dest, int x, uint width) const
+{
+	if (_pixmap == None) {
+		return;
+	}
+	XCopyArea(X11::getDpy(), _pixmap, dest, X11::getGC(),
+		  x - _x, 0, width, _pixmap_height, x, 0);
 }
 
 int
@@ -1380,18 +1917,22 @@ public:
 		return font->getWidth(" " + wtime + " ");
 	}
 
+	/**
+	 * Format the current time, only rendered when the formatted
+	 * time changes.
+	 */
+	virtual size_t updateContent(void)
+	{
+		formatNow(_wtime);
+		return HashFn<std::string>()(_wtime);
+	}
+
 	virtual void render(Render &rend)
 	{
 		PanelWidget::render(rend);
 
-		std::string wtime;
-		formatNow(wtime);
 		PFont *font = _theme.getFont(CLIENT_STATE_UNFOCUSED);
-		renderText(rend, font, getX(), wtime, getWidth());
-
-		// always treat date time as dirty, requires redraw up to
-		// every second.
-		_dirty = true;
+		renderText(rend, font, 0, _wtime, getWidth());
 	}
 
 private:
@@ -1408,6 +1949,8 @@ private:
 
 private:
 	std::string _format;
+	/** Last formatted time. */
+	std::string _wtime;
 };
 
 /**
@@ -1529,7 +2072,7 @@ ClientListWidget::render(Render &rend)
 	for (; it != _entries.end(); ++it) {
 		PImage *icon = it->getIcon();
 		int icon_width = icon ? height + 1 : 0;
-		int x = getX() + it->getX() + icon_width;
+		int x = it->getX() + icon_width;
 		int entry_width = _entry_width - icon_width;
 
 		PFont *font = _theme.getFont(it->getState());
@@ -1612,6 +2155,7 @@ public:
 		}
 	}
 
+	virtual size_t updateContent(void);
 	virtual void render(Render &rend);
 
 private:
@@ -1624,6 +2168,8 @@ private:
 	ExternalCommandData& _ext_data;
 	std::string _field;
 	std::vector<std::pair<float, XColor*> > _colors;
+	/** Fill percentage, updated when the field changes. */
+	float _fill_p;
 };
 
 BarWidget::BarWidget(const PanelTheme& theme,
@@ -1633,7 +2179,8 @@ BarWidget::BarWidget(const PanelTheme& theme,
                      const CfgParser::Entry *section)
 	: PanelWidget(theme, size_req),
 	  _ext_data(ext_data),
-	  _field(field)
+	  _field(field),
+	  _fill_p(0.0)
 {
 	parseColors(section);
 	pekwm::observerMapping()->addObserver(&_ext_data, this);
@@ -1644,6 +2191,22 @@ BarWidget::~BarWidget(void)
 	pekwm::observerMapping()->removeObserver(&_ext_data, this);
 }
 
+/**
+ * Bar content is the number of filled pixels and the fill color,
+ * changes in the value that do not change these are not rendered.
+ */
+size_t
+BarWidget::updateContent(void)
+{
+	if (_dirty) {
+		_fill_p = getPercent(_ext_data.get(_field));
+	}
+
+	int fill = static_cast<int>(_fill_p * (_theme.getHeight() - 6));
+	ulong pixel = getBarFill(_fill_p);
+	return HashFn<ulong>()((pixel << 16) ^ fill);
+}
+
 void
 BarWidget::render(Render &rend)
 {
@@ -1652,12 +2215,11 @@ BarWidget::render(Render &rend)
 	int width = getWidth() - 3;
 	int height = _theme.getHeight() - 4;
 	rend.setColor(_theme.getBarBorder()->pixel);
-	rend.rectangle(getX() + 1, 1, width, height);
+	rend.rectangle(1, 1, width, height);
 
-	float fill_p = getPercent(_ext_data.get(_field));
-	int fill = static_cast<int>(fill_p * (height - 2));
-	rend.setColor(getBarFill(fill_p));
-	rend.fill(getX() + 2, 1 + height - fill, width - 1, fill);
+	int fill = static_cast<int>(_fill_p * (height - 2));
+	rend.setColor(getBarFill(_fill_p));
+	rend.fill(2, 1 + height - fill, width - 1, fill);
 }
 
 int
@@ -1902,12 +2464,16 @@ public:
 
 	virtual void notify(Observable *, Observation *observation);
 	virtual uint getRequiredSize(void) const;
+	virtual size_t updateContent(void);
 	virtual void render(Render &rend);
 
 private:
 	ExternalCommandData& _ext_data;
 	WmState& _wm_state;
 	std::string _pp_format;
+	/** Formatted text, updated when referenced fields change. */
+	std::string _text;
+	size_t _text_hash;
 
 	bool _check_wm_state;
 	std::vector<std::string> _fields;
@@ -1919,6 +2485,7 @@ TextWidget::TextWidget(const PanelTheme& theme, const SizeReq& size_req,
 	: PanelWidget(theme, size_req),
 	  _ext_data(ext_data),
 	  _wm_state(wm_state),
+	  _text_hash(0),
 	  _check_wm_state(false)
 {
 	TextFormatter tf(_ext_data, _wm_state);
@@ -1980,15 +2547,28 @@ TextWidget::getRequiredSize(void) const
 	return 0;
 }
 
+/**
+ * Re-format the text when a referenced field has changed, the text is
+ * only rendered if the formatted output differs.
+ */
+size_t
+TextWidget::updateContent(void)
+{
+	if (_dirty) {
+		TextFormatter tf(_ext_data, _wm_state);
+		_text = tf.format(_pp_format);
+		_text_hash = HashFn<std::string>()(_text);
+	}
+	return _text_hash;
+}
+
 void
 TextWidget::render(Render &rend)
 {
 	PanelWidget::render(rend);
 
-	TextFormatter tf(_ext_data, _wm_state);
 	PFont *font = _theme.getFont(CLIENT_STATE_UNFOCUSED);
-	std::string text = tf.format(_pp_format);
-	renderText(rend, font, getX(), text, getWidth());
+	renderText(rend, font, 0, _text, getWidth());
 }
 
 /**
@@ -2068,7 +2648,7 @@ IconWidget::render(Render& rend)
 	}
 
 	uint height = _theme.getHeight() - 2;
-	_icon->draw(rend, getX(), 1, height, height);
+	_icon->draw(rend, 0, 1, height, height);
 }
 
 void
@@ -2182,24 +2762,6 @@ WidgetFactory::construct(const WidgetConfig& cfg)
 	return nullptr;
 }
 
-typedef bool(*renderPredFun)(PanelWidget *w, void *opaque);
-
-static bool renderPredExposeEv(PanelWidget *w, void *opaque)
-{
-	XExposeEvent *ev = reinterpret_cast<XExposeEvent*>(opaque);
-	return (w->getX() >= ev->x) && (w->getRX() <= (ev->x + ev->width));
-}
-
-static bool renderPredDirty(PanelWidget *w, void*)
-{
-	return w->isDirty();
-}
-
-static bool renderPredAlways(PanelWidget*, void*)
-{
-	return true;
-}
-
 /**
  * Widgets in the panel are given a size when configured, can be given
  * in:
@@ -2249,9 +2811,24 @@ private:
 		return nullptr;
 	}
 
+	/**
+	 * Collect the exposed area until the last Expose event in the
+	 * series and copy the rendered widgets once.
+	 */
 	void handleExpose(XExposeEvent *ev)
 	{
-		renderPred(renderPredExposeEv, reinterpret_cast<void*>(ev));
+		if (_expose_rx > _expose_x) {
+			_expose_x = std::min(_expose_x, ev->x);
+			_expose_rx = std::max(_expose_rx, ev->x + ev->width);
+		} else {
+			_expose_x = ev->x;
+			_expose_rx = ev->x + ev->width;
+		}
+
+		if (ev->count == 0) {
+			renderExposed(_expose_x, _expose_rx);
+			_expose_x = _expose_rx = 0;
+		}
 	}
 
 	void handlePropertyNotify(XPropertyEvent *ev)
@@ -2261,15 +2838,14 @@ private:
 		}
 	}
 
+	/**
+	 * Render widgets with changed content as soon as command output
+	 * has been read, no polling of command data is done.
+	 */
 	virtual void handleFd(int fd)
 	{
 		_ext_data.input(fd);
-	}
-
-	virtual void handleChildDone(pid_t pid, int)
-	{
-		_ext_data.done(pid,
-			       PekwmPanel::ppRemoveFd, reinterpret_cast<void*>(this));
+		render();
 	}
 
 	virtual void screenChanged(const ScreenChangeNotification&)
@@ -2277,6 +2853,9 @@ private:
 		P_TRACE("screen geometry updated, resizing");
 		place();
 		resizeWidgets();
+		renderBackground();
+		X11::clearWindow(_window);
+		renderWidgets(true);
 	}
 
 	PanelWidget* findWidget(int x)
@@ -2306,7 +2885,8 @@ private:
 	}
 
 	void resizeWidgets(void);
-	void renderPred(renderPredFun pred, void *opaque);
+	void renderWidgets(bool force);
+	void renderExposed(int x, int rx);
 	void renderBackground(void);
 
 	static void ppAddFd(int fd, void *opaque)
@@ -2321,13 +2901,27 @@ private:
 		panel->removeFd(fd);
 	}
 
+	/**
+	 * Called when a command has finished, renders the output read
+	 * when draining the command.
+	 */
+	static void ppCommandDone(void *opaque)
+	{
+		PekwmPanel *panel = reinterpret_cast<PekwmPanel*>(opaque);
+		panel->render();
+	}
+
 private:
 	const PanelConfig& _cfg;
 	PanelTheme& _theme;
 	WmState _wm_state;
 	std::vector<PanelWidget*> _widgets;
 	ExternalCommandData _ext_data;
+	/** Panel background including handles and separators. */
 	Pixmap _pixmap;
+	/** Exposed area collected until the last Expose event. */
+	int _expose_x;
+	int _expose_rx;
 };
 
 PekwmPanel::PekwmPanel(const PanelConfig &cfg, PanelTheme &theme,
@@ -2340,7 +2934,9 @@ PekwmPanel::PekwmPanel(const PanelConfig &cfg, PanelTheme &theme,
 	  _cfg(cfg),
 	  _theme(theme),
 	  _ext_data(cfg),
-	  _pixmap(X11::createPixmap(sh->width, sh->height))
+	  _pixmap(X11::createPixmap(sh->width, sh->height)),
+	  _expose_x(0),
+	  _expose_rx(0)
 {
 	X11::selectInput(_window,
 			 ButtonPressMask|ButtonReleaseMask|
@@ -2364,6 +2960,9 @@ PekwmPanel::PekwmPanel(const PanelConfig &cfg, PanelTheme &theme,
 	X11::selectInput(X11::getRoot(), PropertyChangeMask);
 
 	pekwm::observerMapping()->addObserver(&_wm_state, this);
+
+	_ext_data.start(&getMainloop(), ppAddFd, ppRemoveFd, ppCommandDone,
+			reinterpret_cast<void*>(this));
 }
 
 PekwmPanel::~PekwmPanel(void)
@@ -2381,6 +2980,7 @@ PekwmPanel::configure(void)
 {
 	addWidgets();
 	resizeWidgets();
+	renderBackground();
 }
 
 void
@@ -2412,7 +3012,7 @@ PekwmPanel::place(void)
 void
 PekwmPanel::render(void)
 {
-	renderPred(renderPredDirty, nullptr);
+	renderWidgets(false);
 }
 
 void
@@ -2428,16 +3028,20 @@ PekwmPanel::notify(Observable*, Observation *observation)
 	if (dynamic_cast<WmState::XROOTPMAP_ID_Changed*>(observation)
 	    || dynamic_cast<WmState::PEKWM_THEME_Changed*>(observation)) {
 		renderBackground();
-		renderPred(renderPredAlways, nullptr);
+		X11::clearWindow(_window);
+		renderWidgets(true);
 	}
 }
 
+/**
+ * Called every refresh interval, widgets are only rendered and copied
+ * to the window if their content has changed.
+ */
 void
 PekwmPanel::refresh(bool timed_out)
 {
-	_ext_data.refresh(ppAddFd, reinterpret_cast<void*>(this));
 	if (timed_out) {
-		renderPred(renderPredAlways, nullptr);
+		renderWidgets(false);
 	}
 }
 
@@ -2547,30 +3151,43 @@ PekwmPanel::resizeWidgets(void)
 	}
 }
 
+/**
+ * Render widgets with changed content, or all widgets if force is set,
+ * and copy only the rendered widgets to the window.
+ */
 void
-PekwmPanel::renderPred(renderPredFun pred, void *opaque)
+PekwmPanel::renderWidgets(bool force)
 {
-	if (_widgets.empty()) {
-		return;
+	std::vector<PanelWidget*>::iterator it = _widgets.begin();
+	for (; it != _widgets.end(); ++it) {
+		if ((*it)->renderCached(_pixmap, force)) {
+			(*it)->copyTo(_window, (*it)->getX(), (*it)->getWidth());
+		}
 	}
+}
 
-	PTexture *sep = _theme.getSep();
-	PTexture *handle = _theme.getHandle();
-
-	int x = handle ? handle->getWidth() : 0;
-	PanelWidget *last_widget = _widgets.back();
-	X11Render rend(_window);
+/**
+ * Copy widgets between x and rx to the window, the area outside of the
+ * widgets is restored from the window background. Widgets rendered
+ * with new content are copied in full.
+ */
+void
+PekwmPanel::renderExposed(int x, int rx)
+{
 	std::vector<PanelWidget*>::iterator it = _widgets.begin();
 	for (; it != _widgets.end(); ++it) {
-		bool do_render = pred(*it, opaque);
-		if (do_render) {
-			(*it)->render(rend);
+		if ((*it)->getRX() <= x || (*it)->getX() >= rx) {
+			continue;
 		}
-		x += (*it)->getWidth();
 
-		if (do_render && *it != last_widget) {
-			sep->render(rend, x, 0, sep->getWidth(), sep->getHeight());
-			x += sep->getWidth();
+		if ((*it)->renderCached(_pixmap, false)) {
+			// content changed, the visible part outside of the
+			// exposed area is stale too
+			(*it)->copyTo(_window, (*it)->getX(), (*it)->getWidth());
+		} else {
+			int cx = std::max(x, (*it)->getX());
+			int crx = std::min(rx, (*it)->getRX());
+			(*it)->copyTo(_window, cx, crx - cx);
 		}
 	}
 }
@@ -2591,8 +3208,21 @@ PekwmPanel::renderBackground(void)
 			       handle->getWidth(), handle->getHeight(),
 			       0, 0); // root coordinates
 	}
+
+	// separators are part of the background, widgets are copied on
+	// top of it.
+	if (_widgets.size() > 1) {
+		PTexture *sep = _theme.getSep();
+		std::vector<PanelWidget*>::iterator it = _widgets.begin();
+		for (; it != _widgets.end() - 1; ++it) {
+			sep->render(_pixmap, (*it)->getRX(), 0,
+				    sep->getWidth(), sep->getHeight());
+		}
+	}
 }
 
+#ifndef UNITTEST
+
 static bool loadConfig(PanelConfig& cfg, const std::string& file)
 {
 	if (file.size() && cfg.load(file)) {
@@ -2739,3 +3369,5 @@ int main(int argc, char *argv[])
 
 	return 0;
 }
+
+#endif // ! UNITTEST
@@ -8,6 +8,7 @@
 
 #include "config.h"
 
+#include "CfgParserCache.hh"
 #include "Charset.hh"
 #include "Compat.hh"
 #include "Debug.hh"
@@ -47,6 +48,8 @@ printUsage(void)
 		  << std::endl;
 	std::cout << " --log-file  set log file." << std::endl;
 	std::cout << " --log-level set log level." << std::endl;
+	std::cout << " --no-cache  always parse configuration files"
+		  << std::endl;
 	std::cout << " --replace   replace running window manager" << std::endl;
 	std::cout << " --sync      run Xlib in synchronous mode" << std::endl;
 	std::cout << " --version   show version info" << std::endl;
@@ -92,6 +95,7 @@ main(int argc, char **argv)
 	std::string config_file;
 	bool synchronous = false;
 	bool replace = false;
+	bool cache = true;
 	for (int i = 1; i < argc; ++i) {
 		if (strcmp("--info", argv[i]) == 0) {
 			printInfo();
@@ -102,6 +106,8 @@ main(int argc, char **argv)
 			if (! Debug::setLogFile(argv[++i])) {
 				std::cerr << "Failed to open log file " << argv[i] << std::endl;
 			}
+		} else if (strcmp("--no-cache", argv[i]) == 0) {
+			cache = false;
 		} else if (strcmp("--replace", argv[i]) == 0) {
 			replace = true;
 		} else if (strcmp("--sync", argv[i]) == 0) {
@@ -136,6 +142,11 @@ main(int argc, char **argv)
 		setenv("PEKWM_CONFIG_PATH", config_file.substr(0, sep).c_str(), 1);
 	}
 
+	// parsed configuration is cached between starts and restarts.
+	if (cache) {
+		CfgParserCache::setDir(CfgParserCache::getDefaultDir());
+	}
+
 	USER_INFO("Starting pekwm. Use this information in bug reports: "
 		  << FEATURES << std::endl
 		  << "using configuration at " << config_file);
@@ -0,0 +1,96 @@
+//
+// bench.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#ifndef _BENCH_HH_
+#define _BENCH_HH_
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <time.h>
+}
+
+/**
+ * Run statement F iterations times and report the time per iteration.
+ */
+#define BENCH(name, iterations, F)					\
+	do {								\
+		struct timespec __bench_start, __bench_end;		\
+		clock_gettime(CLOCK_MONOTONIC, &__bench_start);		\
+		for (size_t __bench_i = 0; __bench_i < (iterations);	\
+		     __bench_i++) {					\
+			F;						\
+		}							\
+		clock_gettime(CLOCK_MONOTONIC, &__bench_end);		\
+		BenchSuite::report((name), (iterations),		\
+				   __bench_start, __bench_end);		\
+	} while (0)
+
+/**
+ * Base class for benchmarks, all constructed suites are run by
+ * BenchSuite::main. A benchmark name may be given on the command line
+ * to only run suites with that name.
+ */
+class BenchSuite {
+public:
+	BenchSuite(const std::string &name)
+		: _name(name)
+	{
+		_suites.push_back(this);
+	}
+	virtual ~BenchSuite(void) { }
+
+	const std::string &name(void) const { return _name; }
+
+	static int main(int argc, char *argv[])
+	{
+		std::vector<BenchSuite*>::iterator it(_suites.begin());
+		for (; it != _suites.end(); ++it) {
+			if (argc > 1 && (*it)->name() != argv[1]) {
+				continue;
+			}
+			std::cout << (*it)->name() << std::endl;
+			(*it)->run();
+		}
+		return 0;
+	}
+
+	static void report(const std::string &name, size_t iterations,
+			   const struct timespec &start,
+			   const struct timespec &end)
+	{
+		double ns = (end.tv_sec - start.tv_sec) * 1e9
+			+ (end.tv_nsec - start.tv_nsec);
+		std::cout << "  * " << std::left << std::setw(40) << name
+			  << std::right << std::setw(12) << std::fixed
+			  << std::setprecision(1) << (ns / iterations)
+			  << " ns/op" << std::endl;
+	}
+
+protected:
+	virtual void run(void) = 0;
+
+private:
+	std::string _name;
+	static std::vector<BenchSuite*> _suites;
+};
+
+std::vector<BenchSuite*> BenchSuite::_suites;
+
+/**
+ * Sink preventing the compiler from optimizing away benchmarked
+ * results.
+ */
+static volatile size_t bench_sink;
+
+#endif // _BENCH_HH_
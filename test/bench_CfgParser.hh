@@ -0,0 +1,186 @@
+//
+// bench_CfgParser.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "bench.hh"
+#include "CfgParser.hh"
+#include "CfgParserCache.hh"
+#include "Util.hh"
+
+#include <vector>
+
+extern "C" {
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+/**
+ * Parse throughput of the configuration files in data/ and test/data,
+ * run from the test directory, and of generated menu and autoproperties
+ * files of the size created by menu generators.
+ *
+ * data/menu is not included as it runs COMMAND.
+ */
+class BenchCfgParser : public BenchSuite {
+public:
+	BenchCfgParser(void)
+		: BenchSuite("CfgParser")
+	{
+	}
+
+protected:
+	virtual void run(void);
+
+private:
+	static void benchFiles(const std::string &name,
+			       const std::vector<std::string> &files);
+	static bool parseFiles(const std::vector<std::string> &files);
+	static std::string generateMenu(size_t entries);
+	static std::string generateAutoproperties(size_t entries);
+	static std::string writeTmp(const std::string &data);
+};
+
+void
+BenchCfgParser::run(void)
+{
+	// variables set by pekwm at startup and used by data/
+	setenv("PEKWM_CONFIG_PATH", "../data", 1);
+	setenv("PEKWM_ETC_PATH", "../data", 1);
+	setenv("PEKWM_SCRIPT_PATH", "../data/scripts", 1);
+	setenv("PEKWM_THEME_PATH", "../data/themes", 1);
+
+	const char *data_files[] = {
+		"../data/autoproperties", "../data/config", "../data/keys",
+		"../data/mouse", "../data/panel", "../data/vars",
+		"data/cfg_parser_include.cfg"
+	};
+	std::vector<std::string> files;
+	std::vector<std::string>::iterator it;
+	for (size_t i = 0; i < sizeof(data_files) / sizeof(data_files[0]); i++) {
+		if (Util::isFile(data_files[i])) {
+			files.push_back(data_files[i]);
+		} else {
+			std::cerr << "  missing " << data_files[i] << std::endl;
+		}
+	}
+	benchFiles("data", files);
+
+	std::vector<std::string> generated;
+	generated.push_back(writeTmp(generateMenu(10000)));
+	benchFiles("menu 10000", generated);
+	unlink(generated[0].c_str());
+
+	generated[0] = writeTmp(generateAutoproperties(5000));
+	benchFiles("autoproperties 5000", generated);
+
+	// same files loaded from the parse cache, the first parse fills it
+	char dir[] = "/tmp/bench_cfgparser_cache.XXXXXX";
+	if (mkdtemp(dir) && CfgParserCache::setDir(dir)) {
+		files.push_back(generated[0]);
+		parseFiles(files);
+		benchFiles("cached data + autoproperties 5000", files);
+
+		for (it = files.begin(); it != files.end(); ++it) {
+			unlink(CfgParserCache::getPath(*it, false).c_str());
+		}
+		CfgParserCache::setDir("");
+		rmdir(dir);
+	}
+	unlink(generated[0].c_str());
+}
+
+void
+BenchCfgParser::benchFiles(const std::string &name,
+			   const std::vector<std::string> &files)
+{
+	size_t bytes = 0;
+	std::vector<std::string>::const_iterator it = files.begin();
+	for (; it != files.end(); ++it) {
+		struct stat sb;
+		if (stat(it->c_str(), &sb) == 0) {
+			bytes += sb.st_size;
+		}
+	}
+	if (bytes == 0) {
+		return;
+	}
+
+	size_t iterations = 50000000 / bytes;
+	if (iterations < 5) {
+		iterations = 5;
+	}
+
+	std::ostringstream bname;
+	bname << "parse " << name << " (" << (bytes / 1024) << " KiB)";
+	BENCH(bname.str(), iterations, bench_sink += parseFiles(files));
+}
+
+bool
+BenchCfgParser::parseFiles(const std::vector<std::string> &files)
+{
+	bool ok = true;
+	std::vector<std::string>::const_iterator it = files.begin();
+	for (; it != files.end(); ++it) {
+		CfgParser cfg;
+		ok = cfg.parse(*it) && ok;
+	}
+	return ok;
+}
+
+std::string
+BenchCfgParser::generateMenu(size_t entries)
+{
+	std::ostringstream menu;
+	menu << "# generated menu\n"
+	     << "$TERM = \"xterm -fn fixed\"\n"
+	     << "RootMenu = \"Pekwm\" {\n";
+	for (size_t i = 0; i < entries; i++) {
+		if (i % 20 == 0) {
+			if (i) {
+				menu << "\t}\n";
+			}
+			menu << "\tSubmenu = \"Category " << i / 20 << "\" {\n";
+		}
+		menu << "\t\tEntry = \"Application " << i << "\" {"
+		     << " Icon = \"app-" << i << ".png\";"
+		     << " Actions = \"Exec $TERM -e /usr/bin/app-" << i
+		     << " --name \\\"App " << i << "\\\" &\" }\n";
+	}
+	menu << "\t}\n}\n";
+	return menu.str();
+}
+
+std::string
+BenchCfgParser::generateAutoproperties(size_t entries)
+{
+	std::ostringstream ap;
+	for (size_t i = 0; i < entries; i++) {
+		ap << "/* rule " << i << " */\n"
+		   << "Property = \"^app" << i << ",^App" << i << "\" {\n"
+		   << "\tApplyOn = \"New Start Reload\"\n"
+		   << "\tWorkspace = \"" << i % 9 << "\"\n"
+		   << "\tGeometry = \"800x600+" << i % 100 << "+" << i % 50
+		   << "\"\n"
+		   << "\tSticky = \"False\"\n"
+		   << "}\n";
+	}
+	return ap.str();
+}
+
+std::string
+BenchCfgParser::writeTmp(const std::string &data)
+{
+	char path[] = "/tmp/bench_cfgparser.XXXXXX";
+	int fd = mkstemp(path);
+	if (fd == -1) {
+		return "";
+	}
+	::write(fd, data.c_str(), data.size());
+	::close(fd);
+	return path;
+}
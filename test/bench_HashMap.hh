@@ -0,0 +1,81 @@
+//
+// bench_HashMap.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "bench.hh"
+#include "HashMap.hh"
+
+#include <map>
+
+/**
+ * Compare HashMap with std::map for the Window to PWinObj lookup done
+ * on every X event.
+ */
+class BenchHashMap : public BenchSuite {
+public:
+	BenchHashMap(void)
+		: BenchSuite("HashMap")
+	{
+	}
+
+protected:
+	virtual void run(void);
+
+private:
+	static void benchSize(size_t num);
+};
+
+void
+BenchHashMap::run(void)
+{
+	benchSize(64);
+	benchSize(1024);
+	benchSize(16384);
+}
+
+void
+BenchHashMap::benchSize(size_t num)
+{
+	// XIDs allocated by a client are sequential from its resource
+	// base, simulate a couple of clients.
+	std::vector<ulong> keys;
+	for (size_t i = 0; i < num; i++) {
+		keys.push_back(((i % 8) << 21) + 0x400000 + i * 3);
+	}
+	const size_t iterations = 1000000;
+	size_t mask = num - 1;
+
+	std::ostringstream suffix;
+	suffix << " (" << num << ")";
+
+	std::map<ulong, void*> map;
+	HashMap<ulong, void*> hmap;
+	BENCH("std::map insert" + suffix.str(), num,
+	      map[keys[__bench_i]] = &map);
+	BENCH("HashMap insert" + suffix.str(), num,
+	      hmap[keys[__bench_i]] = &map);
+
+	BENCH("std::map find" + suffix.str(), iterations,
+	      bench_sink += map.find(keys[(__bench_i * 7) & mask])
+	      != map.end());
+	BENCH("HashMap find" + suffix.str(), iterations,
+	      bench_sink += hmap.find(keys[(__bench_i * 7) & mask])
+	      != nullptr);
+
+	// bursts of events for the same window
+	BENCH("std::map find same" + suffix.str(), iterations,
+	      bench_sink += map.find(keys[(__bench_i >> 4) & mask])
+	      != map.end());
+	BENCH("HashMap find same" + suffix.str(), iterations,
+	      bench_sink += hmap.find(keys[(__bench_i >> 4) & mask])
+	      != nullptr);
+
+	BENCH("std::map erase" + suffix.str(), num,
+	      map.erase(keys[__bench_i]));
+	BENCH("HashMap erase" + suffix.str(), num,
+	      hmap.erase(keys[__bench_i]));
+}
@@ -0,0 +1,232 @@
+//
+// bench_PImage.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "bench.hh"
+#include "PImage.hh"
+
+#include <vector>
+
+/**
+ * Compare the fixed-point scalers with the previous floating point
+ * scaler, and the row conversion of ARGB data to XImages with
+ * XPutPixel, at icon and wallpaper sizes.
+ */
+class BenchPImage : public BenchSuite {
+public:
+	BenchPImage(void)
+		: BenchSuite("PImage")
+	{
+	}
+
+protected:
+	virtual void run(void);
+
+private:
+	static void benchScale(size_t swidth, size_t sheight,
+			       size_t dwidth, size_t dheight);
+	static void benchFill(size_t width, size_t height);
+	static void fillXImagePutPixel(XImage *ximage, const uchar *data);
+	static void fillMaskPutPixel(XImage *ximage, const uchar *data);
+	static void initImage(XImage &ximage, std::vector<char> &data,
+			      int depth, size_t width, size_t height);
+	static void scaleFloat(const uchar *src, size_t swidth, size_t sheight,
+			       uchar *dst, size_t dwidth, size_t dheight);
+};
+
+void
+BenchPImage::run(void)
+{
+	benchScale(48, 48, 16, 16);
+	benchScale(16, 16, 64, 64);
+	benchScale(1920, 1080, 2560, 1440);
+	benchScale(3840, 2160, 1920, 1080);
+
+	benchFill(16, 16);
+	benchFill(48, 48);
+	benchFill(1920, 1080);
+	benchFill(3840, 2160);
+}
+
+void
+BenchPImage::benchScale(size_t swidth, size_t sheight,
+			size_t dwidth, size_t dheight)
+{
+	std::vector<uchar> src(swidth * sheight * 4);
+	for (size_t i = 0; i < src.size(); i++) {
+		src[i] = static_cast<uchar>(i * 7);
+	}
+	std::vector<uchar> dst(dwidth * dheight * 4);
+
+	size_t iterations = 50000000 / (swidth * sheight + dwidth * dheight);
+	if (iterations < 5) {
+		iterations = 5;
+	}
+
+	std::ostringstream suffix;
+	suffix << " " << swidth << "x" << sheight
+	       << "->" << dwidth << "x" << dheight;
+
+	BENCH("float" + suffix.str(), iterations,
+	      scaleFloat(&src[0], swidth, sheight, &dst[0], dwidth, dheight));
+	BENCH("bilinear" + suffix.str(), iterations,
+	      PImage::scaleBilinear(&src[0], swidth, sheight,
+				    &dst[0], dwidth, dheight));
+	if (dwidth * 2 <= swidth && dheight * 2 <= sheight) {
+		BENCH("box" + suffix.str(), iterations,
+		      PImage::scaleBox(&src[0], swidth, sheight,
+				       &dst[0], dwidth, dheight));
+	}
+	bench_sink += dst[0];
+}
+
+static inline uchar
+scalePixelFloat(const uchar* data, int pos, int width,
+		float x_diff, float y_diff)
+{
+	float p0 = data[pos];
+	float p1 = data[pos + 4];
+	float p2 = data[pos + width * 4];
+	float p3 = data[pos + 4 + width * 4];
+	float res = p0 * (1 - x_diff) * (1 - y_diff)
+		+ p1 * (x_diff) * (1 - y_diff)
+		+ p2 * (y_diff) * (1 - x_diff)
+		+ p3 * (x_diff * y_diff);
+	return static_cast<uchar>(res);
+}
+
+/**
+ * Scaler used by PImage::getScaledData before the fixed-point scaler.
+ */
+void
+BenchPImage::scaleFloat(const uchar *src, size_t swidth, size_t sheight,
+			uchar *dst, size_t dwidth, size_t dheight)
+{
+	float x_ratio = static_cast<float>(swidth - 1) / dwidth;
+	float y_ratio = static_cast<float>(sheight - 1) / dheight;
+
+	for (size_t dy = 0; dy < dheight; dy++) {
+		for (size_t dx = 0; dx < dwidth; dx++) {
+			size_t sx = static_cast<size_t>(x_ratio * dx);
+			size_t sy = static_cast<size_t>(y_ratio * dy);
+
+			int spos = (sy * swidth + sx) * 4;
+			float x_diff = (x_ratio * dx) - sx;
+			float y_diff = (y_ratio * dy) - sy;
+
+			for (int i = 0; i < 4; i++) {
+				*dst++ = scalePixelFloat(src + i, spos, swidth,
+							 x_diff, y_diff);
+			}
+		}
+	}
+}
+
+void
+BenchPImage::benchFill(size_t width, size_t height)
+{
+	std::vector<uchar> src(width * height * 4);
+	for (size_t i = 0; i < src.size(); i++) {
+		src[i] = static_cast<uchar>(i * 7);
+	}
+
+	size_t iterations = 50000000 / (width * height);
+	if (iterations < 5) {
+		iterations = 5;
+	}
+
+	std::ostringstream suffix;
+	suffix << " " << width << "x" << height;
+
+	XImage ximage;
+	std::vector<char> data;
+	initImage(ximage, data, 24, width, height);
+	BENCH("putpixel" + suffix.str(), iterations,
+	      fillXImagePutPixel(&ximage, &src[0]));
+	BENCH("fillXImage" + suffix.str(), iterations,
+	      PImage::fillXImage(&ximage, &src[0]));
+	bench_sink += data[0];
+
+	initImage(ximage, data, 1, width, height);
+	BENCH("putpixel mask" + suffix.str(), iterations,
+	      fillMaskPutPixel(&ximage, &src[0]));
+	BENCH("fillMask" + suffix.str(), iterations,
+	      PImage::fillMask(&ximage, &src[0], 1, 0));
+	bench_sink += data[0];
+}
+
+static ulong
+rgbToPixel24bitLSB(uchar r, uchar g, uchar b)
+{
+	return ((r << 16) & 0xff0000)
+		| ((g << 8) & 0x00ff00) | (b & 0x0000ff);
+}
+
+/**
+ * Conversion used by PImage::createXImage before the row conversion.
+ */
+void
+BenchPImage::fillXImagePutPixel(XImage *ximage, const uchar *data)
+{
+	ulong (*rgbToPixel)(uchar, uchar, uchar) = rgbToPixel24bitLSB;
+	const uchar *src = data;
+	for (int y = 0; y < ximage->height; ++y) {
+		for (int x = 0; x < ximage->width; ++x) {
+			src++;
+			uchar r = *src++;
+			uchar g = *src++;
+			uchar b = *src++;
+			XPutPixel(ximage, x, y, rgbToPixel(r, g, b));
+		}
+	}
+}
+
+/**
+ * Conversion used by PImage::createMask before the row conversion.
+ */
+void
+BenchPImage::fillMaskPutPixel(XImage *ximage, const uchar *data)
+{
+	const uchar *src = data;
+	for (int y = 0; y < ximage->height; ++y) {
+		for (int x = 0; x < ximage->width; ++x) {
+			XPutPixel(ximage, x, y, (*src > 127) ? 1 : 0);
+			src += 4;
+		}
+	}
+}
+
+/**
+ * Setup XImage in host byte order without a display.
+ */
+void
+BenchPImage::initImage(XImage &ximage, std::vector<char> &data,
+		       int depth, size_t width, size_t height)
+{
+	uint order = 1;
+	int byte_order = *reinterpret_cast<uchar*>(&order) ? LSBFirst : MSBFirst;
+
+	memset(&ximage, 0, sizeof(ximage));
+	ximage.width = width;
+	ximage.height = height;
+	ximage.format = ZPixmap;
+	ximage.byte_order = byte_order;
+	ximage.bitmap_unit = 32;
+	ximage.bitmap_bit_order = byte_order;
+	ximage.bitmap_pad = 32;
+	ximage.depth = depth;
+	ximage.bits_per_pixel = depth == 1 ? 1 : 32;
+	ximage.bytes_per_line = ((width * ximage.bits_per_pixel + 31) / 32) * 4;
+	if (depth != 1) {
+		ximage.red_mask = 0xff0000;
+		ximage.green_mask = 0xff00;
+		ximage.blue_mask = 0xff;
+	}
+	data.assign(ximage.bytes_per_line * height, 0);
+	ximage.data = &data[0];
+	XInitImage(&ximage);
+}
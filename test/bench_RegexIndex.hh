@@ -0,0 +1,182 @@
+//
+// bench_RegexIndex.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "bench.hh"
+#include "Charset.hh"
+#include "RegexIndex.hh"
+
+/**
+ * Match synthetic WM_CLASS hints against a large autoproperties rule
+ * set, first matching rule wins as in AutoProperties::findProperty.
+ */
+class BenchRegexIndex : public BenchSuite {
+public:
+	BenchRegexIndex(void)
+		: BenchSuite("RegexIndex")
+	{
+	}
+	virtual ~BenchRegexIndex(void);
+
+protected:
+	virtual void run(void);
+
+private:
+	static size_t findRegexec(size_t i);
+	static size_t findLinear(size_t i);
+	static size_t findIndex(size_t i);
+	static size_t findIndexSame(size_t i);
+
+	static std::vector<std::pair<std::string, std::string> > _patterns;
+	static std::vector<std::pair<regex_t, regex_t> > _regexes;
+	static std::vector<std::pair<RegexString*, RegexString*> > _rules;
+	static std::vector<std::pair<std::string, std::string> > _hints;
+	static RegexIndex _index;
+};
+
+std::vector<std::pair<std::string, std::string> > BenchRegexIndex::_patterns;
+std::vector<std::pair<regex_t, regex_t> > BenchRegexIndex::_regexes;
+std::vector<std::pair<RegexString*, RegexString*> > BenchRegexIndex::_rules;
+std::vector<std::pair<std::string, std::string> > BenchRegexIndex::_hints;
+RegexIndex BenchRegexIndex::_index;
+
+BenchRegexIndex::~BenchRegexIndex(void)
+{
+	std::vector<std::pair<RegexString*, RegexString*> >::iterator it =
+		_rules.begin();
+	for (; it != _rules.end(); ++it) {
+		delete it->first;
+		delete it->second;
+	}
+	std::vector<std::pair<regex_t, regex_t> >::iterator rit =
+		_regexes.begin();
+	for (; rit != _regexes.end(); ++rit) {
+		regfree(&rit->first);
+		regfree(&rit->second);
+	}
+}
+
+void
+BenchRegexIndex::run(void)
+{
+	const size_t num_rules = 500;
+	for (size_t i = 0; i < num_rules; i++) {
+		std::ostringstream name, clazz;
+		switch (i % 5) {
+		case 0:
+			name << "^app" << i << "$";
+			clazz << "^App" << i << "$";
+			break;
+		case 1:
+			name << "^app" << i;
+			clazz << ".*";
+			break;
+		case 2:
+			name << "^app" << i << "-[a-z]+$";
+			clazz << "^App";
+			break;
+		case 3:
+			name << ".*";
+			clazz << "^Tool" << i << "$";
+			break;
+		default:
+			name << "^(tool|app)" << i << "$";
+			clazz << "Dock" << i;
+			break;
+		}
+		_patterns.push_back(std::make_pair(name.str(), clazz.str()));
+	}
+	// catch-all rule last, as commonly found in autoproperties
+	_patterns.push_back(std::make_pair("^.*", "^.*"));
+
+	std::vector<std::pair<std::string, std::string> >::iterator it =
+		_patterns.begin();
+	for (; it != _patterns.end(); ++it) {
+		std::pair<regex_t, regex_t> regex;
+		regcomp(&regex.first, it->first.c_str(), REG_EXTENDED);
+		regcomp(&regex.second, it->second.c_str(), REG_EXTENDED);
+		_regexes.push_back(regex);
+
+		_rules.push_back(std::make_pair(new RegexString(it->first),
+						new RegexString(it->second)));
+		_index.add(_rules.back().first, _rules.back().second);
+	}
+
+	const size_t num_hints = 10000;
+	for (size_t i = 0; i < num_hints; i++) {
+		std::ostringstream name, clazz;
+		size_t n = (i * 7) % (num_rules * 2);
+		name << (i % 3 ? "app" : "tool") << n;
+		if (i % 4 == 0) {
+			name << "-dialog";
+		}
+		clazz << (i % 3 ? "App" : "Tool") << n;
+		_hints.push_back(std::make_pair(name.str(), clazz.str()));
+	}
+
+	BENCH("regexec linear (10k hints)", num_hints,
+	      bench_sink += findRegexec(__bench_i));
+	BENCH("RegexString linear (10k hints)", num_hints,
+	      bench_sink += findLinear(__bench_i));
+	BENCH("RegexIndex (10k hints)", num_hints,
+	      bench_sink += findIndex(__bench_i));
+	BENCH("RegexIndex same hint", num_hints,
+	      bench_sink += findIndexSame(__bench_i));
+}
+
+/**
+ * Match every rule with regexec, as RegexString did before literal
+ * matching and the index.
+ */
+size_t
+BenchRegexIndex::findRegexec(size_t i)
+{
+	const std::pair<std::string, std::string> &hint = _hints[i];
+	for (size_t j = 0; j < _regexes.size(); j++) {
+		std::string name = Charset::toSystem(hint.first);
+		if (regexec(&_regexes[j].first, name.c_str(), 0, 0, 0) != 0) {
+			continue;
+		}
+		std::string clazz = Charset::toSystem(hint.second);
+		if (regexec(&_regexes[j].second, clazz.c_str(), 0, 0, 0) == 0) {
+			return j;
+		}
+	}
+	return 0;
+}
+
+size_t
+BenchRegexIndex::findLinear(size_t i)
+{
+	const std::pair<std::string, std::string> &hint = _hints[i];
+	for (size_t j = 0; j < _rules.size(); j++) {
+		if (*_rules[j].first == hint.first
+		    && *_rules[j].second == hint.second) {
+			return j;
+		}
+	}
+	return 0;
+}
+
+size_t
+BenchRegexIndex::findIndex(size_t i)
+{
+	const std::vector<uint> &rules =
+		_index.find(_hints[i].first, _hints[i].second);
+	return rules.empty() ? 0 : rules[0];
+}
+
+/**
+ * Repeated lookups for the same hint, as done on title changes.
+ */
+size_t
+BenchRegexIndex::findIndexSame(size_t i)
+{
+	const std::vector<uint> &rules =
+		_index.find(_hints[i / 1000].first, _hints[i / 1000].second);
+	return rules.empty() ? 0 : rules[0];
+}
@@ -0,0 +1,216 @@
+//
+// bench_Theme.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "bench.hh"
+#include "CfgParser.hh"
+#include "FontHandler.hh"
+#include "HashMap.hh"
+#include "ImageHandler.hh"
+#include "TextureHandler.hh"
+#include "Theme.hh"
+#include "X11.hh"
+
+#include <vector>
+
+extern "C" {
+#include <dirent.h>
+#include <string.h>
+}
+
+/**
+ * Theme load timing using the themes in data/themes, run from the test
+ * directory.
+ *
+ * Loading a theme requires a display, without one only the texture
+ * lookup done during theme load is measured using the texture
+ * specifications from the themes.
+ */
+class BenchTheme : public BenchSuite {
+public:
+	BenchTheme(void)
+		: BenchSuite("Theme")
+	{
+	}
+
+protected:
+	virtual void run(void);
+
+private:
+	static void getThemeDirs(std::vector<std::string> &dirs);
+	static void getTextures(CfgParser::Entry *section,
+				std::vector<std::string> &textures);
+	static bool isTexture(const std::string &value);
+
+	static void benchLookup(const std::vector<std::string> &textures);
+	static void lookupScan(const std::vector<std::string> &textures);
+	static void lookupHash(const std::vector<std::string> &textures);
+
+	static void benchLoad(const std::vector<std::string> &dirs);
+	static void loadTheme(FontHandler &fh, TextureHandler &th,
+			      const std::string &dir);
+};
+
+void
+BenchTheme::run(void)
+{
+	std::vector<std::string> dirs;
+	getThemeDirs(dirs);
+
+	std::vector<std::string> textures;
+	std::vector<std::string>::iterator it = dirs.begin();
+	for (; it != dirs.end(); ++it) {
+		CfgParser cfg;
+		cfg.setVar("$THEME_DIR", *it);
+		if (cfg.parse(*it + "/theme")) {
+			getTextures(cfg.getEntryRoot(), textures);
+		}
+	}
+
+	benchLookup(textures);
+
+	// large theme, unique textures each used by a couple of decors
+	std::vector<std::string> large;
+	for (int i = 0; i < 3000; i++) {
+		std::ostringstream tex;
+		tex << "Solid #" << std::hex << (i % 1000) * 4099;
+		large.push_back(tex.str());
+	}
+	benchLookup(large);
+
+	benchLoad(dirs);
+}
+
+void
+BenchTheme::getThemeDirs(std::vector<std::string> &dirs)
+{
+	const char *themes_dir = "../data/themes";
+	DIR *dh = opendir(themes_dir);
+	if (dh == nullptr) {
+		std::cerr << "  no themes in " << themes_dir << std::endl;
+		return;
+	}
+
+	struct dirent *de;
+	while ((de = readdir(dh)) != nullptr) {
+		std::string dir = std::string(themes_dir) + "/" + de->d_name;
+		if (de->d_name[0] != '.' && Util::isFile(dir + "/theme")) {
+			dirs.push_back(dir);
+		}
+	}
+	closedir(dh);
+}
+
+void
+BenchTheme::getTextures(CfgParser::Entry *section,
+			std::vector<std::string> &textures)
+{
+	CfgParser::Entry::entry_cit it = section->begin();
+	for (; it != section->end(); ++it) {
+		if ((*it)->getSection()) {
+			getTextures((*it)->getSection(), textures);
+		} else if (isTexture((*it)->getValue())) {
+			textures.push_back((*it)->getValue());
+		}
+	}
+}
+
+bool
+BenchTheme::isTexture(const std::string &value)
+{
+	const char *types[] = { "SOLID", "SOLIDRAISED", "LINESHORZ",
+				"LINESVERT", "IMAGE", "IMAGEMAPPED",
+				"EMPTY", nullptr };
+	std::string type = value.substr(0, value.find_first_of(" \t"));
+	for (int i = 0; types[i]; i++) {
+		if (strcasecmp(type.c_str(), types[i]) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Compare the linear, case insensitive, texture scan with the hashed
+ * lookup on normalized keys.
+ */
+void
+BenchTheme::benchLookup(const std::vector<std::string> &textures)
+{
+	if (textures.empty()) {
+		return;
+	}
+
+	// a texture is requested once per use in the theme, simulate
+	// the entries being created the first time they are seen.
+	std::ostringstream name;
+	name << " (" << textures.size() << " textures)";
+	size_t iterations = 200;
+
+	BENCH("scan" + name.str(), iterations, lookupScan(textures));
+	BENCH("hash" + name.str(), iterations, lookupHash(textures));
+}
+
+void
+BenchTheme::lookupScan(const std::vector<std::string> &textures)
+{
+	std::vector<std::string> entries;
+	std::vector<std::string>::const_iterator it = textures.begin();
+	for (; it != textures.end(); ++it) {
+		std::vector<std::string>::iterator e_it = entries.begin();
+		for (; e_it != entries.end(); ++e_it) {
+			if (strcasecmp(e_it->c_str(), it->c_str()) == 0) {
+				break;
+			}
+		}
+		if (e_it == entries.end()) {
+			entries.push_back(*it);
+		}
+	}
+	bench_sink += entries.size();
+}
+
+void
+BenchTheme::lookupHash(const std::vector<std::string> &textures)
+{
+	HashMap<std::string, int> entries;
+	std::vector<std::string>::const_iterator it = textures.begin();
+	for (; it != textures.end(); ++it) {
+		entries[TextureHandler::normalizeKey(*it)]++;
+	}
+	bench_sink += entries.size();
+}
+
+/**
+ * Time loading of each theme, requires a display.
+ */
+void
+BenchTheme::benchLoad(const std::vector<std::string> &dirs)
+{
+	Display *dpy = XOpenDisplay(nullptr);
+	if (dpy == nullptr) {
+		std::cout << "  * load skipped, no display" << std::endl;
+		return;
+	}
+	X11::init(dpy);
+
+	FontHandler fh;
+	TextureHandler th;
+	std::vector<std::string>::const_iterator it = dirs.begin();
+	for (; it != dirs.end(); ++it) {
+		BENCH("load " + *it, 20, loadTheme(fh, th, *it));
+	}
+
+	X11::destruct();
+}
+
+void
+BenchTheme::loadTheme(FontHandler &fh, TextureHandler &th,
+		      const std::string &dir)
+{
+	Theme theme(&fh, pekwm::imageHandler(), &th, dir, "");
+}
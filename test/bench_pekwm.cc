@@ -0,0 +1,39 @@
+//
+// bench_pekwm.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "Compat.hh"
+#include "bench.hh"
+#include "ImageHandler.hh"
+
+#include "bench_PImage.hh"
+#include "bench_Theme.hh"
+
+static ImageHandler *_image_handler = nullptr;
+
+namespace pekwm
+{
+	ImageHandler* imageHandler()
+	{
+		return _image_handler;
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	// PImage
+	BenchPImage benchPImage;
+
+	// Theme
+	BenchTheme benchTheme;
+
+	_image_handler = new ImageHandler();
+	int ret = BenchSuite::main(argc, argv);
+	delete _image_handler;
+	return ret;
+}
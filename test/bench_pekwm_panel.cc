@@ -0,0 +1,137 @@
+//
+// bench_pekwm_panel.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "Compat.hh"
+#include "bench.hh"
+
+#define UNITTEST
+#include "pekwm_panel.cc"
+
+/**
+ * Drive _NET_CLIENT_LIST churn through the panel client list, a tenth
+ * of the windows are replaced and one window moves on every update.
+ */
+class BenchClientList : public BenchSuite {
+public:
+	BenchClientList(void)
+		: BenchSuite("ClientList")
+	{
+	}
+	virtual ~BenchClientList(void) { }
+
+protected:
+	virtual void run(void);
+
+private:
+	static void buildLists(size_t num, size_t updates);
+	static size_t updateDiff(size_t i);
+	static size_t updateLinear(size_t i);
+
+	static std::vector<std::vector<Window> > _lists;
+	static ClientList _client_list;
+	static std::vector<ClientInfo*> _linear;
+};
+
+std::vector<std::vector<Window> > BenchClientList::_lists;
+ClientList BenchClientList::_client_list;
+std::vector<ClientInfo*> BenchClientList::_linear;
+
+void
+BenchClientList::run(void)
+{
+	const size_t updates = 1000;
+	buildLists(500, updates);
+
+	BENCH("ClientList::update (500 windows)", updates,
+	      bench_sink += updateDiff(__bench_i));
+	BENCH("popClientInfo (500 windows)", updates,
+	      bench_sink += updateLinear(__bench_i));
+
+	std::vector<ClientInfo*>::iterator it = _linear.begin();
+	for (; it != _linear.end(); ++it) {
+		delete *it;
+	}
+	_linear.clear();
+}
+
+void
+BenchClientList::buildLists(size_t num, size_t updates)
+{
+	std::vector<Window> windows;
+	Window next = 0x200000;
+	for (size_t i = 0; i < num; i++) {
+		windows.push_back(next++);
+	}
+
+	for (size_t i = 0; i < updates; i++) {
+		for (size_t j = 0; j < num / 10; j++) {
+			windows.erase(windows.begin() + ((i * 31 + j * 7) % num));
+			windows.push_back(next++);
+		}
+		Window moved = windows[(i * 13) % num];
+		windows.erase(windows.begin() + ((i * 13) % num));
+		windows.push_back(moved);
+		_lists.push_back(windows);
+	}
+}
+
+size_t
+BenchClientList::updateDiff(size_t i)
+{
+	std::vector<ClientInfo*> added;
+	_client_list.update(&_lists[i][0], _lists[i].size(), added);
+	return added.size();
+}
+
+/**
+ * Update as done before ClientList, searching the previous list for
+ * each window.
+ */
+size_t
+BenchClientList::updateLinear(size_t i)
+{
+	const std::vector<Window> &windows = _lists[i];
+	std::vector<ClientInfo*> old_clients = _linear;
+	_linear.clear();
+
+	size_t added = 0;
+	for (size_t j = 0; j < windows.size(); j++) {
+		ClientInfo *client_info = nullptr;
+		std::vector<ClientInfo*>::iterator it = old_clients.begin();
+		for (; it != old_clients.end(); ++it) {
+			if ((*it)->getWindow() == windows[j]) {
+				client_info = *it;
+				old_clients.erase(it);
+				break;
+			}
+		}
+		if (client_info == nullptr) {
+			client_info = new ClientInfo(windows[j]);
+			added++;
+		}
+		_linear.push_back(client_info);
+	}
+
+	std::vector<ClientInfo*>::iterator it = old_clients.begin();
+	for (; it != old_clients.end(); ++it) {
+		delete *it;
+	}
+	return added;
+}
+
+int
+main(int argc, char *argv[])
+{
+	// ClientList
+	BenchClientList benchClientList;
+
+	pekwm::initNoDisplay();
+	int ret = BenchSuite::main(argc, argv);
+	pekwm::cleanupNoDisplay();
+	return ret;
+}
@@ -0,0 +1,29 @@
+//
+// bench_util.cc for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "Compat.hh"
+#include "bench.hh"
+
+#include "bench_CfgParser.hh"
+#include "bench_HashMap.hh"
+#include "bench_RegexIndex.hh"
+
+int
+main(int argc, char *argv[])
+{
+	// CfgParser
+	BenchCfgParser benchCfgParser;
+
+	// HashMap
+	BenchHashMap benchHashMap;
+
+	// RegexIndex
+	BenchRegexIndex benchRegexIndex;
+
+	return BenchSuite::main(argc, argv);
+}
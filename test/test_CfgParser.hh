@@ -19,6 +19,7 @@ public:
 
 	void testEmptyVal(void);
 	void testIncludeWithoutNewline(void);
+	void testTokens(void);
 };
 
 TestCfgParser::TestCfgParser(void)
@@ -61,10 +62,43 @@ TestCfgParser::testIncludeWithoutNewline(void)
 	ASSERT_EQUAL("var in include", "value", var);
 }
 
+void
+TestCfgParser::testTokens(void)
+{
+	const char *cfg =
+		"# comment \"=\n"
+		"Section { /* multi\n * line */ Key = \"a\\\"b\\\nc\\\\\" }\n"
+		"Other/Name = \"x\" // comment\n"
+		"Last = \"\n"
+		"y\"";
+	CfgParserSourceString *source =
+		new CfgParserSourceString(":memory:", cfg);
+
+	clear();
+	ASSERT_EQUAL("parse ok", true, parse(source));
+	CfgParser::Entry *section = getEntryRoot()->findSection("SECTION");
+	ASSERT_EQUAL("section", true, section != nullptr);
+	CfgParser::Entry *entry = section->findEntry("KEY");
+	ASSERT_EQUAL("entry", true, entry != nullptr);
+	ASSERT_EQUAL("escape", "a\"bc\\", entry->getValue());
+	ASSERT_EQUAL("line", 3, entry->getLine());
+
+	entry = getEntryRoot()->findEntry("OTHER/NAME");
+	ASSERT_EQUAL("/ in name", true, entry != nullptr);
+	ASSERT_EQUAL("/ in name", "x", entry->getValue());
+	ASSERT_EQUAL("line", 5, entry->getLine());
+
+	entry = getEntryRoot()->findEntry("LAST");
+	ASSERT_EQUAL("newline in value", true, entry != nullptr);
+	ASSERT_EQUAL("newline in value", "\ny", entry->getValue());
+	ASSERT_EQUAL("line", 6, entry->getLine());
+}
+
 bool
 TestCfgParser::run_test(TestSpec spec, bool status)
 {
 	TEST_FN(spec, "empty val", testEmptyVal());
 	TEST_FN(spec, "INCLUDE without newline", testIncludeWithoutNewline());
+	TEST_FN(spec, "tokens", testTokens());
 	return status;
 }
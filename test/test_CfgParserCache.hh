@@ -0,0 +1,255 @@
+//
+// test_CfgParserCache.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+#include "CfgParserCache.hh"
+#include "Util.hh"
+
+#include <fstream>
+
+extern "C" {
+#include <stdlib.h>
+#include <unistd.h>
+}
+
+class TestCfgParserCache : public TestSuite {
+public:
+	TestCfgParserCache(void)
+		: TestSuite("CfgParserCache")
+	{
+	}
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+	static void testLoad(void);
+	static void testStale(void);
+	static void testCorruptNodes(void);
+	static void testNotCached(void);
+
+private:
+	static std::string dump(CfgParser::Entry *entry);
+	static void write(const std::string &path, const std::string &data);
+
+	static std::string _dir;
+};
+
+std::string TestCfgParserCache::_dir;
+
+bool
+TestCfgParserCache::run_test(TestSpec spec, bool status)
+{
+	char dir[] = "/tmp/test_cfgparsercache.XXXXXX";
+	if (mkdtemp(dir) == nullptr) {
+		std::cerr << "failed to create " << dir << std::endl;
+		return false;
+	}
+	_dir = dir;
+	CfgParserCache::setDir(_dir + "/cache");
+
+	write(_dir + "/main", "$VAR = \"var\"\n"
+	      "$_PEKWM_TEST_SET = \"set\"\n"
+	      "INCLUDE = \"include\"\n"
+	      "Define = \"Tmpl\" { Key = \"tmpl\" }\n"
+	      "Section = \"$VAR\" {\n"
+	      "\t@Tmpl\n"
+	      "\tEnv = \"$_PEKWM_TEST_GET\"\n"
+	      "\tSub { Deep = \"$INC\" }\n"
+	      "}\n");
+	write(_dir + "/include", "$INC = \"inc\"\n");
+	setenv("PEKWM_TEST_GET", "get", 1);
+
+	TEST_FN(spec, "load", testLoad());
+	TEST_FN(spec, "stale", testStale());
+	TEST_FN(spec, "corrupt nodes", testCorruptNodes());
+	TEST_FN(spec, "not cached", testNotCached());
+
+	CfgParserCache::setDir("");
+	unsetenv("PEKWM_TEST_GET");
+	unsetenv("PEKWM_TEST_SET");
+	std::string cmd = "rm -rf " + _dir;
+	if (system(cmd.c_str())) {
+		std::cerr << "failed to remove " << _dir << std::endl;
+	}
+	return status;
+}
+
+void
+TestCfgParserCache::testLoad(void)
+{
+	std::string main = _dir + "/main";
+	CfgParser cfg;
+	ASSERT_EQUAL("parse", false, CfgParserCache::load(cfg, main, false));
+	ASSERT_EQUAL("parse", true, cfg.parse(main));
+	ASSERT_EQUAL("saved", true,
+		     Util::isFile(CfgParserCache::getPath(main, false)));
+
+	unsetenv("PEKWM_TEST_SET");
+	CfgParser cached;
+	ASSERT_EQUAL("load", true, CfgParserCache::load(cached, main, false));
+	ASSERT_EQUAL("tree", dump(cfg.getEntryRoot()),
+		     dump(cached.getEntryRoot()));
+	ASSERT_EQUAL("var", std::string("var"), cached.getVar("$VAR"));
+	ASSERT_EQUAL("var", std::string("inc"), cached.getVar("$INC"));
+	ASSERT_EQUAL("env set", std::string("set"),
+		     Util::getEnv("PEKWM_TEST_SET"));
+	ASSERT_EQUAL("files", 2u, cached.getCfgFiles().files.size());
+	ASSERT_EQUAL("files", _dir + "/include",
+		     cached.getCfgFiles().files[1]);
+
+	// overwrite is part of the key
+	CfgParser overwrite;
+	ASSERT_TRUE("overwrite",
+		    CfgParserCache::getPath(main, false)
+		    != CfgParserCache::getPath(main, true));
+	ASSERT_EQUAL("overwrite", false,
+		     CfgParserCache::load(overwrite, main, true));
+}
+
+void
+TestCfgParserCache::testStale(void)
+{
+	std::string main = _dir + "/main";
+	CfgParser cfg;
+	cfg.parse(main);
+
+	// content of include changed
+	write(_dir + "/include", "$INC = \"changed\"\n");
+	CfgParser changed;
+	ASSERT_EQUAL("include", false,
+		     CfgParserCache::load(changed, main, false));
+	ASSERT_EQUAL("include", true, changed.parse(main));
+	CfgParser reparsed;
+	ASSERT_EQUAL("include", true,
+		     CfgParserCache::load(reparsed, main, false));
+	ASSERT_EQUAL("include", std::string("changed"),
+		     reparsed.getVar("$INC"));
+
+	// environment read while parsing changed
+	setenv("PEKWM_TEST_GET", "other", 1);
+	CfgParser env;
+	ASSERT_EQUAL("env", false, CfgParserCache::load(env, main, false));
+	setenv("PEKWM_TEST_GET", "get", 1);
+
+	// variables set before parsing differ
+	CfgParser var;
+	var.setVar("$THEME_DIR", "/tmp");
+	ASSERT_EQUAL("var", false, CfgParserCache::load(var, main, false));
+
+	// include relative to the working directory now exists
+	write(_dir + "/relative", "$REL = \"dir\"\n");
+	write(_dir + "/rel", "INCLUDE = \"relative\"\n");
+	CfgParser rel;
+	rel.parse(_dir + "/rel");
+	ASSERT_EQUAL("missing", std::string("dir"), rel.getVar("$REL"));
+	char cwd[1024];
+	ASSERT_TRUE("getcwd", getcwd(cwd, sizeof(cwd)) != nullptr);
+	ASSERT_EQUAL("chdir", 0, chdir(_dir.c_str()));
+	CfgParser rel_cwd;
+	bool loaded = CfgParserCache::load(rel_cwd, _dir + "/rel", false);
+	ASSERT_EQUAL("chdir", 0, chdir(cwd));
+	ASSERT_EQUAL("missing", false, loaded);
+
+	// corrupt cache file
+	write(CfgParserCache::getPath(main, false), "pCFG");
+	CfgParser corrupt;
+	ASSERT_EQUAL("corrupt", false,
+		     CfgParserCache::load(corrupt, main, false));
+	ASSERT_TRUE("corrupt",
+		    corrupt.getEntryRoot()->begin()
+		    == corrupt.getEntryRoot()->end());
+}
+
+void
+TestCfgParserCache::testCorruptNodes(void)
+{
+	// repeated sections are merged only when overwriting
+	std::string path = _dir + "/overwrite";
+	write(path, "Section { A = \"1\" }\nSection { B = \"2\" }\n");
+	CfgParser cfg;
+	cfg.setVar("$PRESET", "preset");
+	ASSERT_EQUAL("parse", true,
+		     cfg.parse(path, CfgParserSource::SOURCE_FILE, true));
+	std::string expected = dump(cfg.getEntryRoot());
+
+	// valid header with the root claiming more entries than there are
+	// nodes
+	std::string cache_path = CfgParserCache::getPath(path, true);
+	std::fstream fs(cache_path.c_str(),
+			std::ios::in | std::ios::out | std::ios::binary);
+	uint32_t header[10];
+	fs.read(reinterpret_cast<char*>(header), sizeof(header));
+	ASSERT_TRUE("read", fs.good());
+	size_t root = sizeof(header) + header[4] * 16 + header[5] * 12
+		+ (header[6] + header[7]) * 8;
+	uint32_t num_entries = 1000;
+	fs.seekp(root + 16);
+	fs.write(reinterpret_cast<char*>(&num_entries), sizeof(num_entries));
+	fs.close();
+
+	CfgParser corrupt;
+	corrupt.setVar("$PRESET", "preset");
+	ASSERT_EQUAL("nodes", false,
+		     CfgParserCache::load(corrupt, path, true));
+	ASSERT_EQUAL("nodes", std::string("preset"),
+		     corrupt.getVar("$PRESET"));
+
+	// parse falling back on the source keeps overwrite
+	CfgParser reparsed;
+	reparsed.setVar("$PRESET", "preset");
+	ASSERT_EQUAL("nodes", true,
+		     reparsed.parse(path, CfgParserSource::SOURCE_FILE, true));
+	ASSERT_EQUAL("nodes", expected, dump(reparsed.getEntryRoot()));
+	ASSERT_EQUAL("nodes", std::string("preset"),
+		     reparsed.getVar("$PRESET"));
+}
+
+void
+TestCfgParserCache::testNotCached(void)
+{
+	std::string path = _dir + "/command";
+	write(path, "COMMAND = \"echo 'Cmd = \\\"value\\\"'\"\n");
+	CfgParser cfg;
+	ASSERT_EQUAL("command", true, cfg.parse(path));
+	ASSERT_EQUAL("command", true, cfg.isDynamicContent());
+	CfgParser::Entry *entry = cfg.getEntryRoot()->findEntry("CMD");
+	ASSERT_TRUE("command", entry != nullptr);
+	ASSERT_EQUAL("command", std::string("value"), entry->getValue());
+	ASSERT_EQUAL("command", false,
+		     Util::isFile(CfgParserCache::getPath(path, false)));
+
+	// parse into existing content is not cached
+	path = _dir + "/include";
+	CfgParser existing;
+	existing.getEntryRoot()->addEntry("", 0, "Key", "value");
+	ASSERT_EQUAL("existing", true, existing.parse(path));
+	ASSERT_EQUAL("existing", false,
+		     Util::isFile(CfgParserCache::getPath(path, false)));
+}
+
+std::string
+TestCfgParserCache::dump(CfgParser::Entry *entry)
+{
+	std::string str = entry->getName() + "=" + entry->getValue() + "@"
+		+ entry->getSourceName() + ":"
+		+ std::to_string(entry->getLine());
+	if (entry->getSection()) {
+		str += "{" + dump(entry->getSection()) + "}";
+	}
+	CfgParser::Entry::entry_cit it = entry->begin();
+	for (; it != entry->end(); ++it) {
+		str += "[" + dump(*it) + "]";
+	}
+	return str;
+}
+
+void
+TestCfgParserCache::write(const std::string &path, const std::string &data)
+{
+	std::ofstream ofs(path.c_str());
+	ofs << data;
+}
@@ -0,0 +1,134 @@
+//
+// test_ChildRegistry.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+#include "ChildRegistry.hh"
+
+extern "C" {
+#include <sys/wait.h>
+#include <unistd.h>
+}
+
+class TestChildRegistry : public TestSuite {
+public:
+	TestChildRegistry(void)
+		: TestSuite("ChildRegistry")
+	{
+	}
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+	static void testOpenPipe(void);
+	static void testSpawnShell(void);
+	static void testSpawn(void);
+	static void testReap(void);
+
+private:
+	static void childDone(pid_t pid, int status, void *opaque);
+};
+
+bool
+TestChildRegistry::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "openPipe", testOpenPipe());
+	TEST_FN(spec, "spawnShell", testSpawnShell());
+	TEST_FN(spec, "spawn", testSpawn());
+	TEST_FN(spec, "reap", testReap());
+	return status;
+}
+
+void
+TestChildRegistry::testOpenPipe(void)
+{
+	int fd[2];
+	ASSERT_EQUAL("pipe", true, ChildRegistry::openPipe(fd));
+
+	// the read end is not inherited, redirecting from it fails
+	std::string read_fd = std::to_string(fd[0]);
+	pid_t pid = ChildRegistry::spawnShell("if true 2>/dev/null <&" + read_fd
+					      + "; then echo open;"
+					      + " else echo closed; fi",
+					      fd[1], false, nullptr, nullptr);
+	close(fd[1]);
+	ASSERT_TRUE("spawn", pid != -1);
+
+	char buf[16] = {0};
+	ssize_t nread = read(fd[0], buf, sizeof(buf) - 1);
+	close(fd[0]);
+	ChildRegistry::wait(pid);
+	ASSERT_TRUE("read end", nread > 0);
+	ASSERT_EQUAL("read end", std::string("closed\n"), std::string(buf));
+}
+
+void
+TestChildRegistry::testSpawnShell(void)
+{
+	int fd[2];
+	ASSERT_EQUAL("pipe", true, ChildRegistry::openPipe(fd));
+
+	pid_t pid = ChildRegistry::spawnShell("echo hello; exit 3", fd[1], false,
+					      nullptr, nullptr);
+	close(fd[1]);
+	ASSERT_TRUE("spawn", pid != -1);
+	ASSERT_EQUAL("no callback", false, ChildRegistry::contains(pid));
+
+	char buf[16] = {0};
+	ssize_t nread = read(fd[0], buf, sizeof(buf) - 1);
+	close(fd[0]);
+	ASSERT_EQUAL("stdout", 6, nread);
+	ASSERT_EQUAL("stdout", std::string("hello\n"), std::string(buf));
+
+	int status = ChildRegistry::wait(pid);
+	ASSERT_EQUAL("exit", true, WIFEXITED(status));
+	ASSERT_EQUAL("exit", 3, WEXITSTATUS(status));
+}
+
+void
+TestChildRegistry::testSpawn(void)
+{
+	std::vector<std::string> args;
+	args.push_back("sh");
+	args.push_back("-c");
+	args.push_back("exit 2");
+	pid_t pid = ChildRegistry::spawn(args, -1, true, nullptr, nullptr);
+	ASSERT_TRUE("spawn", pid != -1);
+	ASSERT_EQUAL("exit", 2, WEXITSTATUS(ChildRegistry::wait(pid)));
+
+	// missing commands either fail to spawn or exit with 127
+	args.clear();
+	args.push_back("/nonexistent/pekwm-test-command");
+	pid = ChildRegistry::spawn(args, -1, true, nullptr, nullptr);
+	if (pid != -1) {
+		ASSERT_EQUAL("missing", 127,
+			     WEXITSTATUS(ChildRegistry::wait(pid)));
+	}
+}
+
+void
+TestChildRegistry::testReap(void)
+{
+	int status = -1;
+	pid_t pid = ChildRegistry::spawnShell("exit 4", -1, false,
+					      childDone, &status);
+	ASSERT_TRUE("spawn", pid != -1);
+	ASSERT_EQUAL("registered", true, ChildRegistry::contains(pid));
+
+	for (int i = 0; i < 500 && status == -1; i++) {
+		usleep(10000);
+		ChildRegistry::reap();
+	}
+	ASSERT_EQUAL("reaped", 4, WEXITSTATUS(status));
+	ASSERT_EQUAL("reaped", false, ChildRegistry::contains(pid));
+	ASSERT_EQUAL("reaped", 0u, ChildRegistry::size());
+}
+
+void
+TestChildRegistry::childDone(pid_t, int status, void *opaque)
+{
+	*reinterpret_cast<int*>(opaque) = status;
+}
@@ -20,6 +20,7 @@ public:
 	virtual bool run_test(TestSpec spec, bool status);
 
 	static void testApplyGeometry(void);
+	static void testDiffTitleRender(void);
 	static void assertApplyGeometry(std::string msg,
 					Geometry gm,
 					const Geometry &apply_gm, int mask,
@@ -41,6 +42,7 @@ bool
 TestFrame::run_test(TestSpec spec, bool status)
 {
 	TEST_FN(spec, "applyGeometry", testApplyGeometry());
+	TEST_FN(spec, "diffTitleRender", testDiffTitleRender());
 	return status;
 }
 
@@ -92,3 +94,43 @@ TestFrame::assertApplyGeometry(std::string msg,
 	ASSERT_EQUAL(msg + " width", e_gm.width, gm.width);
 	ASSERT_EQUAL(msg + " height", e_gm.height, gm.height);
 }
+
+void
+TestFrame::testDiffTitleRender(void)
+{
+	std::vector<PDecor::TitleRender> rendered;
+	rendered.push_back(PDecor::TitleRender("one", 0, 50,
+					       FOCUSED_STATE_FOCUSED_SELECTED,
+					       false));
+	rendered.push_back(PDecor::TitleRender("two", 52, 50,
+					       FOCUSED_STATE_FOCUSED, false));
+
+	std::vector<uint> dirty;
+	std::vector<PDecor::TitleRender> tabs(rendered);
+	ASSERT_EQUAL("unchanged", false,
+		     diffTitleRender(rendered, tabs, dirty));
+	ASSERT_EQUAL("unchanged", 0u, dirty.size());
+
+	tabs[1].text = "two updated";
+	ASSERT_EQUAL("text", false, diffTitleRender(rendered, tabs, dirty));
+	ASSERT_EQUAL("text", 1u, dirty.size());
+	ASSERT_EQUAL("text", 1u, dirty[0]);
+
+	dirty.clear();
+	tabs = rendered;
+	tabs[0].state = FOCUSED_STATE_FOCUSED;
+	tabs[1].state = FOCUSED_STATE_FOCUSED_SELECTED;
+	ASSERT_EQUAL("state", false, diffTitleRender(rendered, tabs, dirty));
+	ASSERT_EQUAL("state", 2u, dirty.size());
+
+	dirty.clear();
+	tabs = rendered;
+	tabs[0].width = 60;
+	tabs[1].x = 62;
+	ASSERT_EQUAL("layout", true, diffTitleRender(rendered, tabs, dirty));
+
+	tabs = rendered;
+	tabs.pop_back();
+	ASSERT_EQUAL("tab removed", true,
+		     diffTitleRender(rendered, tabs, dirty));
+}
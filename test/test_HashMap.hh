@@ -0,0 +1,112 @@
+//
+// test_HashMap.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+#include "HashMap.hh"
+
+class TestHashMap : public TestSuite {
+public:
+	TestHashMap(void)
+		: TestSuite("HashMap")
+	{
+	}
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+	static void testInsertFind(void);
+	static void testErase(void);
+	static void testIterate(void);
+	static void testString(void);
+};
+
+bool
+TestHashMap::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "insert/find", testInsertFind());
+	TEST_FN(spec, "erase", testErase());
+	TEST_FN(spec, "iterate", testIterate());
+	TEST_FN(spec, "string", testString());
+	return status;
+}
+
+void
+TestHashMap::testInsertFind(void)
+{
+	HashMap<ulong, int> map;
+	ASSERT_TRUE("empty", map.find(1) == nullptr);
+
+	for (ulong i = 0; i < 1000; i++) {
+		map[0x1000000 + i] = static_cast<int>(i);
+	}
+	ASSERT_EQUAL("size", 1000u, map.size());
+	for (ulong i = 0; i < 1000; i++) {
+		int *val = map.find(0x1000000 + i);
+		ASSERT_TRUE("found", val != nullptr);
+		ASSERT_EQUAL("value", static_cast<int>(i), *val);
+	}
+	ASSERT_TRUE("missing", map.find(0x2000000) == nullptr);
+
+	map.insert(0x1000000, 42);
+	ASSERT_EQUAL("replace size", 1000u, map.size());
+	ASSERT_EQUAL("replace", 42, *map.find(0x1000000));
+}
+
+void
+TestHashMap::testErase(void)
+{
+	HashMap<ulong, int> map;
+	for (ulong i = 0; i < 100; i++) {
+		map[i] = static_cast<int>(i);
+	}
+
+	// erase every other entry, remaining entries must still be
+	// reachable after the backward shift.
+	for (ulong i = 0; i < 100; i += 2) {
+		ASSERT_TRUE("erase", map.erase(i));
+	}
+	ASSERT_TRUE("erase missing", ! map.erase(0));
+	ASSERT_EQUAL("size", 50u, map.size());
+	for (ulong i = 0; i < 100; i++) {
+		ASSERT_EQUAL("contains", i % 2 == 1, map.contains(i));
+	}
+
+	// last hit cache must not return an erased entry
+	ASSERT_TRUE("find", map.find(1) != nullptr);
+	map.erase(1);
+	ASSERT_TRUE("find erased", map.find(1) == nullptr);
+}
+
+void
+TestHashMap::testIterate(void)
+{
+	HashMap<ulong, int> map;
+	for (ulong i = 1; i <= 10; i++) {
+		map[i] = static_cast<int>(i);
+	}
+
+	ulong key_sum = 0;
+	int value_sum = 0;
+	HashMap<ulong, int>::iterator it = map.begin();
+	for (; it != map.end(); ++it) {
+		key_sum += it.key();
+		value_sum += it.value();
+	}
+	ASSERT_EQUAL("keys", 55, key_sum);
+	ASSERT_EQUAL("values", 55, value_sum);
+}
+
+void
+TestHashMap::testString(void)
+{
+	HashMap<std::string, int> map;
+	map["Frame"] = 1;
+	map["Menu"] = 2;
+	ASSERT_EQUAL("Frame", 1, *map.find("Frame"));
+	ASSERT_EQUAL("Menu", 2, *map.find("Menu"));
+	ASSERT_TRUE("frame", map.find("frame") == nullptr);
+}
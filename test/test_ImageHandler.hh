@@ -0,0 +1,99 @@
+//
+// test_ImageHandler.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+#include "ImageHandler.hh"
+
+class TestScaledImageCache : public TestSuite {
+public:
+	TestScaledImageCache(void)
+		: TestSuite("ScaledImageCache")
+	{
+	}
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+	static void testGetAdd(void);
+	static void testEvict(void);
+	static void testRemove(void);
+};
+
+bool
+TestScaledImageCache::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "get/add", testGetAdd());
+	TEST_FN(spec, "evict", testEvict());
+	TEST_FN(spec, "remove", testRemove());
+	return status;
+}
+
+void
+TestScaledImageCache::testGetAdd(void)
+{
+	ScaledImageCache cache(1024);
+	ASSERT_TRUE("miss", cache.get(1, 4, 4) == nullptr);
+
+	uchar *data = new uchar[4 * 4 * 4];
+	ScaledImage *scaled = cache.add(1, 4, 4, data);
+	ASSERT_TRUE("data", scaled->data == data);
+	ASSERT_EQUAL("bytes", 64u, cache.getBytes());
+
+	ASSERT_TRUE("hit", cache.get(1, 4, 4) == scaled);
+	ASSERT_TRUE("other size", cache.get(1, 4, 5) == nullptr);
+	ASSERT_TRUE("other image", cache.get(2, 4, 4) == nullptr);
+	ASSERT_EQUAL("hits", 1u, cache.getHits());
+	ASSERT_EQUAL("misses", 3u, cache.getMisses());
+
+	ASSERT_TRUE("fits", cache.fits(8, 16));
+	ASSERT_TRUE("too large", ! cache.fits(16, 16));
+}
+
+void
+TestScaledImageCache::testEvict(void)
+{
+	// room for two 4x4 images
+	ScaledImageCache cache(128);
+	cache.add(1, 4, 4, new uchar[64]);
+	cache.add(2, 4, 4, new uchar[64]);
+	ASSERT_TRUE("use 1", cache.get(1, 4, 4) != nullptr);
+
+	// least recently used, 2, is evicted
+	cache.add(3, 4, 4, new uchar[64]);
+	ASSERT_EQUAL("size", 2u, cache.size());
+	ASSERT_TRUE("1", cache.get(1, 4, 4) != nullptr);
+	ASSERT_TRUE("2", cache.get(2, 4, 4) == nullptr);
+	ASSERT_TRUE("3", cache.get(3, 4, 4) != nullptr);
+
+	// entries larger than the budget are kept until the next add
+	ScaledImage *large = cache.add(4, 16, 16, new uchar[1024]);
+	ASSERT_EQUAL("size large", 1u, cache.size());
+	ASSERT_TRUE("large", cache.get(4, 16, 16) == large);
+
+	cache.setMaxBytes(0);
+	ASSERT_EQUAL("size max 0", 1u, cache.size());
+}
+
+void
+TestScaledImageCache::testRemove(void)
+{
+	ScaledImageCache cache(1024);
+	cache.add(1, 1, 1, new uchar[4]);
+	cache.add(2, 1, 1, new uchar[4]);
+	cache.add(2, 2, 2, new uchar[16]);
+	cache.add(3, 1, 1, new uchar[4]);
+
+	cache.remove(2);
+	ASSERT_EQUAL("size", 2u, cache.size());
+	ASSERT_EQUAL("bytes", 8u, cache.getBytes());
+	ASSERT_TRUE("1", cache.get(1, 1, 1) != nullptr);
+	ASSERT_TRUE("3", cache.get(3, 1, 1) != nullptr);
+
+	cache.clear();
+	ASSERT_EQUAL("clear", 0u, cache.size());
+	ASSERT_EQUAL("clear bytes", 0u, cache.getBytes());
+}
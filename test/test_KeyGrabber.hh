@@ -0,0 +1,117 @@
+//
+// test_KeyGrabber.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+
+#include "KeyGrabber.hh"
+
+class TestKeyGrabberChain : public TestSuite {
+public:
+	TestKeyGrabberChain(void);
+	~TestKeyGrabberChain(void);
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+private:
+	static void testFindAction(void);
+	static void testFindChain(void);
+
+	static ActionEvent mkActionEvent(uint mod, uint sym);
+	static XKeyEvent mkKeyEvent(uint state, uint keycode);
+};
+
+TestKeyGrabberChain::TestKeyGrabberChain(void)
+	: TestSuite("KeyGrabberChain")
+{
+}
+
+TestKeyGrabberChain::~TestKeyGrabberChain(void)
+{
+}
+
+bool
+TestKeyGrabberChain::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "findAction", testFindAction());
+	TEST_FN(spec, "findChain", testFindChain());
+	return status;
+}
+
+void
+TestKeyGrabberChain::testFindAction(void)
+{
+	KeyGrabber::Chain chain(0, 0);
+	chain.addAction(mkActionEvent(Mod4Mask, 24));
+	chain.addAction(mkActionEvent(Mod4Mask, 24));
+	chain.addAction(mkActionEvent(MOD_ANY, 25));
+	chain.addAction(mkActionEvent(ShiftMask, 25));
+	chain.addAction(mkActionEvent(ShiftMask, 26));
+	chain.addAction(mkActionEvent(ControlMask, 0));
+	const ActionEvent *keys = &chain.getKeys()[0];
+
+	bool matched = false;
+	XKeyEvent ev = mkKeyEvent(Mod4Mask, 24);
+	ASSERT_TRUE("exact", chain.findAction(&ev, matched) == keys);
+	ASSERT_EQUAL("exact", true, matched);
+
+	// wildcard before exact match wins
+	ev = mkKeyEvent(ShiftMask, 25);
+	ASSERT_TRUE("any mod", chain.findAction(&ev, matched) == keys + 2);
+	ev = mkKeyEvent(ShiftMask, 26);
+	ASSERT_TRUE("exact after wildcard",
+		    chain.findAction(&ev, matched) == keys + 4);
+	ev = mkKeyEvent(ControlMask, 30);
+	ASSERT_TRUE("any key", chain.findAction(&ev, matched) == keys + 5);
+
+	matched = false;
+	ev = mkKeyEvent(Mod1Mask, 24);
+	ASSERT_TRUE("no match", chain.findAction(&ev, matched) == nullptr);
+	ASSERT_EQUAL("no match", false, matched);
+
+	chain.unload();
+	ev = mkKeyEvent(Mod4Mask, 24);
+	ASSERT_TRUE("unload", chain.findAction(&ev, matched) == nullptr);
+}
+
+void
+TestKeyGrabberChain::testFindChain(void)
+{
+	KeyGrabber::Chain chain(0, 0);
+	KeyGrabber::Chain *sub_exact = new KeyGrabber::Chain(Mod4Mask, 40);
+	KeyGrabber::Chain *sub_any = new KeyGrabber::Chain(MOD_ANY, 41);
+	chain.addChain(sub_exact);
+	chain.addChain(sub_any);
+
+	bool matched = false;
+	XKeyEvent ev = mkKeyEvent(Mod4Mask, 40);
+	ASSERT_TRUE("exact", chain.findChain(&ev, matched) == sub_exact);
+	ev = mkKeyEvent(Mod1Mask, 41);
+	ASSERT_TRUE("any mod", chain.findChain(&ev, matched) == sub_any);
+	ev = mkKeyEvent(Mod1Mask, 40);
+	ASSERT_TRUE("no match", chain.findChain(&ev, matched) == nullptr);
+}
+
+ActionEvent
+TestKeyGrabberChain::mkActionEvent(uint mod, uint sym)
+{
+	ActionEvent ae;
+	ae.mod = mod;
+	ae.sym = sym;
+	return ae;
+}
+
+XKeyEvent
+TestKeyGrabberChain::mkKeyEvent(uint state, uint keycode)
+{
+	XKeyEvent ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.type = KeyPress;
+	ev.state = state;
+	ev.keycode = keycode;
+	return ev;
+}
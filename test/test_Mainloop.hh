@@ -0,0 +1,140 @@
+//
+// test_Mainloop.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+#include "Mainloop.hh"
+
+extern "C" {
+#include <limits.h>
+#include <unistd.h>
+}
+
+class TestMainloop : public TestSuite {
+public:
+	TestMainloop(void)
+		: TestSuite("Mainloop")
+	{
+	}
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+	static void testDiffTimespecMs(void);
+	static void testTimers(void);
+	static void testFd(void);
+
+private:
+	static void timerFired(int id, void *opaque);
+	static void fdReady(int fd, void *opaque);
+};
+
+bool
+TestMainloop::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "diffTimespecMs", testDiffTimespecMs());
+	TEST_FN(spec, "timers", testTimers());
+	TEST_FN(spec, "fd", testFd());
+	return status;
+}
+
+void
+TestMainloop::testDiffTimespecMs(void)
+{
+	struct timespec a = { 1, 500000000 };
+	struct timespec b = { 1, 0 };
+	ASSERT_EQUAL("diff", 500, Mainloop::diffTimespecMs(a, b));
+	ASSERT_EQUAL("negative", -500, Mainloop::diffTimespecMs(b, a));
+
+	Mainloop::addTimespecMs(a, 600);
+	ASSERT_EQUAL("add sec", 2, a.tv_sec);
+	ASSERT_EQUAL("add nsec", 100000000, a.tv_nsec);
+
+	struct timespec c = { 0, 100 };
+	struct timespec d = { 0, 0 };
+	ASSERT_EQUAL("round up", 1, Mainloop::diffTimespecMs(c, d));
+
+	// 30 days does not fit int milliseconds, clamped
+	struct timespec e = { 30 * 24 * 3600, 0 };
+	ASSERT_EQUAL("clamp", INT_MAX, Mainloop::diffTimespecMs(e, d));
+	ASSERT_EQUAL("clamp", INT_MIN, Mainloop::diffTimespecMs(d, e));
+}
+
+void
+TestMainloop::testTimers(void)
+{
+	Mainloop mainloop;
+	std::vector<int> fired;
+
+	int t1 = mainloop.addTimer(20, false, timerFired, &fired);
+	int t2 = mainloop.addTimer(0, false, timerFired, &fired);
+	int t3 = mainloop.addTimer(10, false, timerFired, &fired);
+	int t4 = mainloop.addTimer(5, false, timerFired, &fired);
+	mainloop.removeTimer(t4);
+	ASSERT_EQUAL("num", 3, mainloop.numTimers());
+
+	while (fired.size() < 3) {
+		mainloop.wait(100);
+	}
+	ASSERT_EQUAL("first", t2, fired[0]);
+	ASSERT_EQUAL("second", t3, fired[1]);
+	ASSERT_EQUAL("third", t1, fired[2]);
+	ASSERT_EQUAL("num", 0, mainloop.numTimers());
+
+	fired.clear();
+	int repeat = mainloop.addTimer(1, true, timerFired, &fired);
+	while (fired.size() < 3) {
+		mainloop.wait(100);
+	}
+	ASSERT_EQUAL("repeat", repeat, fired[2]);
+	ASSERT_EQUAL("repeat num", 1, mainloop.numTimers());
+	mainloop.removeTimer(repeat);
+	ASSERT_EQUAL("repeat removed", 0, mainloop.numTimers());
+
+	// timers further away than int milliseconds do not fire at once
+	fired.clear();
+	uint month_ms = 30u * 24 * 3600 * 1000;
+	int month = mainloop.addTimer(month_ms, true, timerFired, &fired);
+	int dispatched = mainloop.wait(0);
+	ASSERT_EQUAL("month", 0, dispatched);
+	ASSERT_EQUAL("month", 0, fired.size());
+	mainloop.removeTimer(month);
+}
+
+void
+TestMainloop::testFd(void)
+{
+	int fds[2];
+	ASSERT_EQUAL("pipe", 0, pipe(fds));
+
+	Mainloop mainloop;
+	int ready = -1;
+	mainloop.addFd(fds[0], fdReady, &ready);
+	ASSERT_EQUAL("timeout", 0, mainloop.wait(0));
+
+	ASSERT_EQUAL("write", 1, write(fds[1], "x", 1));
+	ASSERT_EQUAL("ready", 1, mainloop.wait(100));
+	ASSERT_EQUAL("ready fd", fds[0], ready);
+
+	mainloop.removeFd(fds[0]);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+void
+TestMainloop::timerFired(int id, void *opaque)
+{
+	reinterpret_cast<std::vector<int>*>(opaque)->push_back(id);
+}
+
+void
+TestMainloop::fdReady(int fd, void *opaque)
+{
+	char buf[1];
+	if (read(fd, buf, sizeof(buf)) == 1) {
+		*reinterpret_cast<int*>(opaque) = fd;
+	}
+}
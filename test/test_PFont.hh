@@ -22,18 +22,22 @@ public:
 	virtual ~MockPFont(void);
 
 	virtual bool load(const std::string&) { return true; }
-	virtual uint getWidth(const std::string& text, uint max_chars = 0);
+	virtual uint measureWidth(const std::string& text, uint max_chars);
 	virtual void setColor(PFont::Color*) { }
 
+	uint getLookups(void) const { return _lookups; }
+
 private:
 	virtual void drawText(Drawable, int, int, const std::string&,
 			      uint, bool) { }
 
 private:
 	std::map<std::string, uint> _width_map;
+	uint _lookups;
 };
 
 MockPFont::MockPFont(WMP *width_map)
+	: _lookups(0)
 {
 	for (int i = 0; width_map[i].str != nullptr; ++i) {
 		_width_map[width_map[i].str] = width_map[i].w;
@@ -45,8 +49,9 @@ MockPFont::~MockPFont(void)
 }
 
 uint
-MockPFont::getWidth(const std::string& text, uint max_chars)
+MockPFont::measureWidth(const std::string& text, uint max_chars)
 {
+	_lookups++;
 	std::string key = text + std::to_string(max_chars);
 	std::map<std::string, uint>::iterator it = _width_map.find(key);
 	if (it == _width_map.end()) {
@@ -70,6 +75,7 @@ private:
 	static void testTrimEndNoSpace(void);
 	static void testTrimEndUTF8(void);
 	static void testTrimMiddle(void);
+	static void testWidthCache(void);
 };
 
 TestPFont::TestPFont(void)
@@ -89,6 +95,7 @@ TestPFont::run_test(TestSpec spec, bool status)
 	TEST_FN(spec, "trimEndNoSpace", testTrimEndNoSpace());
 	TEST_FN(spec, "trimEndUTF8", testTrimEndUTF8());
 	TEST_FN(spec, "trimMiddle", testTrimMiddle());
+	TEST_FN(spec, "widthCache", testWidthCache());
 	return status;
 }
 
@@ -134,6 +141,14 @@ TestPFont::testTrimEndUTF8(void)
 		       {"Räksmörgås — M13", 60},
 		       {"Räksmörgås — M12", 50},
 		       {"Räksmörgås — M10", 40},
+		       {"Räksmörgås — M9", 35},
+		       {"Räksmörgås — M8", 30},
+		       {"Räksmörgås — M6", 25},
+		       {"Räksmörgås — M5", 20},
+		       {"Räksmörgås — M4", 15},
+		       {"Räksmörgås — M3", 10},
+		       {"Räksmörgås — M1", 5},
+		       {"Räksmörgås — M18", 95},
 		       {nullptr, 0}};
 	MockPFont font(fontd);
 	std::string str("Räksmörgås — M");
@@ -158,6 +173,7 @@ TestPFont::testTrimMiddle(void)
 		       {"test0", 40},
 		       {"est0", 30},
 		       {"st0", 20},
+		       {"t0", 10},
 
 		       {"test2", 20},
 
@@ -169,3 +185,25 @@ TestPFont::testTrimMiddle(void)
 	font.trim(str, PFont::FONT_TRIM_MIDDLE, 60);
 	ASSERT_EQUAL("trim middle", "te..st", str);
 }
+
+void
+TestPFont::testWidthCache(void)
+{
+	WMP fontd[] = {{"test0", 100}, {"test2", 50}, {nullptr, 0}};
+	MockPFont font(fontd);
+
+	ASSERT_EQUAL("measure", 100u, font.getWidth("test"));
+	ASSERT_EQUAL("measure", 100u, font.getWidth("test"));
+	ASSERT_EQUAL("cached", 1u, font.getLookups());
+
+	// max_chars covering the whole string shares the full entry
+	ASSERT_EQUAL("full prefix", 100u, font.getWidth("test", 4));
+	ASSERT_EQUAL("cached full prefix", 1u, font.getLookups());
+
+	ASSERT_EQUAL("prefix", 50u, font.getWidth("test", 2));
+	ASSERT_EQUAL("prefix", 50u, font.getWidth("test", 2));
+	ASSERT_EQUAL("cached prefix", 2u, font.getLookups());
+
+	ASSERT_EQUAL("empty", 0u, font.getWidth(""));
+	ASSERT_EQUAL("empty not measured", 2u, font.getLookups());
+}
@@ -0,0 +1,197 @@
+//
+// test_PImage.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+#include "PImage.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+class TestPImage : public TestSuite {
+public:
+	TestPImage(void)
+		: TestSuite("PImage")
+	{
+	}
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+	static void testScaleBilinear(void);
+	static void testScaleBox(void);
+	static void testFillXImage(void);
+	static void testFillMask(void);
+
+private:
+	static void initImage(XImage &ximage, std::vector<char> &data,
+			      int depth, uint width, uint height,
+			      int byte_order, int bit_order);
+};
+
+bool
+TestPImage::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "scaleBilinear", testScaleBilinear());
+	TEST_FN(spec, "scaleBox", testScaleBox());
+	TEST_FN(spec, "fillXImage", testFillXImage());
+	TEST_FN(spec, "fillMask", testFillMask());
+	return status;
+}
+
+void
+TestPImage::testScaleBilinear(void)
+{
+	// identity scale keeps data as is
+	uchar src[] = { 255, 0, 0, 0,  255, 200, 100, 50,
+			128, 10, 20, 30,  0, 255, 255, 255 };
+	std::vector<uchar> dst(sizeof(src));
+	PImage::scaleBilinear(src, 2, 2, &dst[0], 2, 2);
+	for (size_t i = 0; i < sizeof(src); i++) {
+		ASSERT_EQUAL("identity", static_cast<int>(src[i]),
+			     static_cast<int>(dst[i]));
+	}
+
+	// single pixel source must not read outside of the image
+	uchar pixel[] = { 255, 1, 2, 3 };
+	dst.resize(3 * 3 * 4);
+	PImage::scaleBilinear(pixel, 1, 1, &dst[0], 3, 3);
+	for (size_t i = 0; i < dst.size(); i++) {
+		ASSERT_EQUAL("1x1", static_cast<int>(pixel[i % 4]),
+			     static_cast<int>(dst[i]));
+	}
+
+	// upscale of gradient is monotonic and keeps the end points
+	uchar grad[] = { 255, 0, 0, 0,  255, 255, 255, 255 };
+	dst.resize(8 * 4);
+	PImage::scaleBilinear(grad, 2, 1, &dst[0], 8, 1);
+	ASSERT_EQUAL("start", 0, static_cast<int>(dst[1]));
+	ASSERT_EQUAL("end", 255, static_cast<int>(dst[7 * 4 + 1]));
+	for (size_t i = 1; i < 8; i++) {
+		ASSERT_TRUE("monotonic", dst[i * 4 + 1] >= dst[(i - 1) * 4 + 1]);
+		ASSERT_EQUAL("alpha", 255, static_cast<int>(dst[i * 4]));
+	}
+}
+
+void
+TestPImage::testScaleBox(void)
+{
+	// 4x2 to 2x1, each destination pixel averages a 2x2 block
+	uchar src[] = { 255, 0, 0, 0,  255, 100, 0, 0,
+			0, 0, 0, 0,  0, 0, 0, 0,
+			255, 0, 0, 0,  255, 100, 0, 0,
+			0, 0, 0, 0,  0, 0, 0, 200 };
+	uchar dst[8];
+	PImage::scaleBox(src, 4, 2, dst, 2, 1);
+	ASSERT_EQUAL("a0", 255, static_cast<int>(dst[0]));
+	ASSERT_EQUAL("r0", 50, static_cast<int>(dst[1]));
+	ASSERT_EQUAL("a1", 0, static_cast<int>(dst[4]));
+	ASSERT_EQUAL("b1", 50, static_cast<int>(dst[7]));
+
+	// box covering more than 2^32 / 255 pixels, overflowing 32 bit sums
+	size_t swidth = 4200, sheight = 4020;
+	std::vector<uchar> large(swidth * sheight * 4, 255);
+	PImage::scaleBox(&large[0], swidth, sheight, dst, 1, 1);
+	for (size_t i = 0; i < 4; i++) {
+		ASSERT_EQUAL("large", 255, static_cast<int>(dst[i]));
+	}
+}
+
+void
+TestPImage::testFillXImage(void)
+{
+	// 7 pixels wide to cover both full words and the tail of each row
+	uint width = 7, height = 2;
+	std::vector<uchar> argb(width * height * 4);
+	for (size_t i = 0; i < argb.size(); i++) {
+		argb[i] = static_cast<uchar>(i * 13 + 5);
+	}
+
+	int orders[] = { LSBFirst, MSBFirst };
+	for (int o = 0; o < 2; o++) {
+		for (int bgr = 0; bgr < 2; bgr++) {
+			XImage ximage;
+			std::vector<char> data;
+			initImage(ximage, data, 24, width, height,
+				  orders[o], orders[o]);
+			if (bgr) {
+				std::swap(ximage.red_mask, ximage.blue_mask);
+			}
+			PImage::fillXImage(&ximage, &argb[0]);
+
+			for (uint y = 0; y < height; y++) {
+				for (uint x = 0; x < width; x++) {
+					const uchar *p = &argb[(y * width + x) * 4];
+					ulong expected = bgr
+						? (p[3] << 16) | (p[2] << 8) | p[1]
+						: (p[1] << 16) | (p[2] << 8) | p[3];
+					ASSERT_EQUAL("pixel", expected,
+						     XGetPixel(&ximage, x, y));
+				}
+			}
+		}
+	}
+}
+
+void
+TestPImage::testFillMask(void)
+{
+	// 11 pixels wide to cover both full bytes and the tail of each row
+	uint width = 11, height = 2;
+	std::vector<uchar> argb(width * height * 4, 0);
+	for (size_t i = 0; i < width * height; i++) {
+		argb[i * 4] = (i % 3) ? 200 : 100;
+	}
+
+	int orders[] = { LSBFirst, MSBFirst };
+	for (int o = 0; o < 2; o++) {
+		for (ulong solid = 0; solid < 2; solid++) {
+			XImage ximage;
+			std::vector<char> data;
+			initImage(ximage, data, 1, width, height,
+				  orders[o], orders[o]);
+			PImage::fillMask(&ximage, &argb[0], solid, ! solid);
+
+			for (uint y = 0; y < height; y++) {
+				for (uint x = 0; x < width; x++) {
+					bool is_solid = argb[(y * width + x) * 4] > 127;
+					ASSERT_EQUAL("bit", is_solid ? solid : ! solid,
+						     XGetPixel(&ximage, x, y));
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Setup XImage without a display, data is owned by the caller.
+ */
+void
+TestPImage::initImage(XImage &ximage, std::vector<char> &data,
+		      int depth, uint width, uint height,
+		      int byte_order, int bit_order)
+{
+	memset(&ximage, 0, sizeof(ximage));
+	ximage.width = width;
+	ximage.height = height;
+	ximage.format = ZPixmap;
+	ximage.byte_order = byte_order;
+	ximage.bitmap_unit = 32;
+	ximage.bitmap_bit_order = bit_order;
+	ximage.bitmap_pad = 32;
+	ximage.depth = depth;
+	ximage.bits_per_pixel = depth == 1 ? 1 : 32;
+	ximage.bytes_per_line = ((width * ximage.bits_per_pixel + 31) / 32) * 4;
+	if (depth != 1) {
+		ximage.red_mask = 0xff0000;
+		ximage.green_mask = 0xff00;
+		ximage.blue_mask = 0xff;
+	}
+	data.assign(ximage.bytes_per_line * height, 0);
+	ximage.data = &data[0];
+	XInitImage(&ximage);
+}
@@ -0,0 +1,87 @@
+//
+// test_RegexIndex.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+#include "RegexIndex.hh"
+
+class TestRegexIndex : public TestSuite {
+public:
+	TestRegexIndex(void)
+		: TestSuite("RegexIndex")
+	{
+	}
+
+	virtual bool run_test(TestSpec spec, bool status);
+	static void testFind(void);
+	static void testFindMemoized(void);
+};
+
+bool
+TestRegexIndex::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "find", testFind());
+	TEST_FN(spec, "findMemoized", testFindMemoized());
+	return status;
+}
+
+void
+TestRegexIndex::testFind(void)
+{
+	RegexString xterm_name("^xterm"), xterm_class("^XTerm$");
+	RegexString any_name(".*"), term_class("Term");
+	RegexString empty_name(""), any_class(".*");
+	RegexString gimp_name("^gimp"), dock_class("^Gimp.*dock");
+	RegexString re_name("^(xterm|urxvt)$"), re_class("^.*$");
+
+	RegexIndex index;
+	index.add(&xterm_name, &xterm_class); // 0, first prefix
+	index.add(&any_name, &term_class); // 1, unindexed
+	index.add(&empty_name, &any_class); // 2, never matches
+	index.add(&gimp_name, &dock_class); // 3, first prefix
+	index.add(&re_name, &re_class); // 4, unindexed regex
+	ASSERT_EQUAL("size", 5u, index.size());
+
+	std::vector<uint> rules = index.find("xterm", "XTerm");
+	ASSERT_EQUAL("xterm", 3u, rules.size());
+	ASSERT_EQUAL("xterm", 0u, rules[0]);
+	ASSERT_EQUAL("xterm", 1u, rules[1]);
+	ASSERT_EQUAL("xterm", 4u, rules[2]);
+
+	rules = index.find("urxvt", "URxvt");
+	ASSERT_EQUAL("urxvt", 1u, rules.size());
+	ASSERT_EQUAL("urxvt", 4u, rules[0]);
+
+	rules = index.find("gimp-2.10", "Gimp-dock");
+	ASSERT_EQUAL("gimp", 1u, rules.size());
+	ASSERT_EQUAL("gimp", 3u, rules[0]);
+
+	ASSERT_EQUAL("none", 0u, index.find("x", "y").size());
+
+	index.clear();
+	ASSERT_EQUAL("clear", 0u, index.size());
+	ASSERT_EQUAL("clear", 0u, index.find("xterm", "XTerm").size());
+}
+
+void
+TestRegexIndex::testFindMemoized(void)
+{
+	RegexString xterm_name("^xterm"), xterm_class("^XTerm$");
+	RegexIndex index;
+	index.add(&xterm_name, &xterm_class);
+
+	const std::vector<uint> *rules = &index.find("xterm", "XTerm");
+	ASSERT_EQUAL("memoized", rules, &index.find("xterm", "XTerm"));
+	ASSERT_EQUAL("key", 0u, index.find("xtermX", "Term").size());
+	ASSERT_EQUAL("key", 0u, index.find("xterm", "").size());
+	ASSERT_EQUAL("key", 1u, index.find("xterm", "XTerm").size());
+
+	// adding rules invalidates the memoized matches
+	RegexString any(".*");
+	index.add(&any, &any);
+	ASSERT_EQUAL("add", 2u, index.find("xterm", "XTerm").size());
+}
@@ -20,12 +20,18 @@ public:
 
 	virtual bool run_test(TestSpec spec, bool status);
 	static void testEdS(void);
+	static void testLiteral(void);
+	static void assertLiteral(const std::string &msg,
+				  const std::string &pattern,
+				  RegexString::MatchType type,
+				  const std::string &prefix);
 };
 
 bool
 TestRegexString::run_test(TestSpec spec, bool status)
 {
 	TEST_FN(spec, "ed_s", testEdS());
+	TEST_FN(spec, "literal", testLiteral());
 	return status;
 }
 
@@ -39,3 +45,49 @@ TestRegexString::testEdS(void)
 	ASSERT_EQUAL("ed_s", "T: My", str);
 }
 
+
+void
+TestRegexString::testLiteral(void)
+{
+	assertLiteral("exact", "^xterm$", RegexString::MATCH_EXACT, "xterm");
+	assertLiteral("prefix", "^XTerm", RegexString::MATCH_PREFIX, "XTerm");
+	assertLiteral("contains", "term", RegexString::MATCH_CONTAINS, "");
+	assertLiteral("escaped", "^org\\.gimp$", RegexString::MATCH_EXACT,
+		      "org.gimp");
+	assertLiteral("full", "/^xterm/", RegexString::MATCH_PREFIX, "xterm");
+	assertLiteral("any", ".*", RegexString::MATCH_ANY, "");
+	assertLiteral("regex", "^Gimp.*-dock$", RegexString::MATCH_REGEX,
+		      "Gimp");
+	assertLiteral("optional", "^xterms?$", RegexString::MATCH_REGEX,
+		      "xterm");
+	assertLiteral("alternation", "^xterm|^urxvt", RegexString::MATCH_REGEX,
+		      "");
+	assertLiteral("icase", "/^xterm/i", RegexString::MATCH_REGEX, "");
+	assertLiteral("inverted", "/^xterm/!", RegexString::MATCH_REGEX, "");
+
+	RegexString exact("^xterm$");
+	ASSERT_EQUAL("exact", true, exact == "xterm");
+	ASSERT_EQUAL("exact", false, exact == "xterm2");
+	RegexString prefix("^XTerm");
+	ASSERT_EQUAL("prefix", true, prefix == "XTerm-256color");
+	ASSERT_EQUAL("prefix", false, prefix == "UXTerm");
+	ASSERT_EQUAL("prefix", false, prefix == "XTer");
+	RegexString contains("Term");
+	ASSERT_EQUAL("contains", true, contains == "UXTerm");
+	ASSERT_EQUAL("contains", false, contains == "urxvt");
+	RegexString inverted("/^xterm/!", true);
+	ASSERT_EQUAL("inverted", false, inverted == "xterm");
+	ASSERT_EQUAL("inverted", true, inverted == "urxvt");
+}
+
+void
+TestRegexString::assertLiteral(const std::string &msg,
+			       const std::string &pattern,
+			       RegexString::MatchType type,
+			       const std::string &prefix)
+{
+	RegexString regex(pattern);
+	ASSERT_EQUAL(msg, true, regex.is_match_ok());
+	ASSERT_EQUAL(msg, type, regex.getMatchType());
+	ASSERT_EQUAL(msg, prefix, regex.getLiteralPrefix());
+}
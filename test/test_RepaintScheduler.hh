@@ -0,0 +1,148 @@
+//
+// test_RepaintScheduler.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+
+#include "PDecor.hh"
+#include "RepaintScheduler.hh"
+
+class MockRepaintDecor : public PDecor {
+public:
+	MockRepaintDecor(void)
+		: PDecor(DEFAULT_DECOR_NAME, None, false),
+		  repaints(0)
+	{
+	}
+	virtual ~MockRepaintDecor(void) { }
+
+	virtual void repaint(const RepaintScheduler::Damage &damage_)
+	{
+		repaints++;
+		damage = damage_;
+	}
+
+	uint repaints;
+	RepaintScheduler::Damage damage;
+};
+
+class TestRepaintScheduler : public TestSuite {
+public:
+	TestRepaintScheduler(void);
+	~TestRepaintScheduler(void);
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+private:
+	static void testFlushOnce(void);
+	static void testAreaUnion(void);
+	static void testClip(void);
+	static void testRemove(void);
+};
+
+TestRepaintScheduler::TestRepaintScheduler(void)
+	: TestSuite("RepaintScheduler")
+{
+}
+
+TestRepaintScheduler::~TestRepaintScheduler(void)
+{
+}
+
+bool
+TestRepaintScheduler::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "flushOnce", testFlushOnce());
+	TEST_FN(spec, "areaUnion", testAreaUnion());
+	TEST_FN(spec, "clip", testClip());
+	TEST_FN(spec, "remove", testRemove());
+	return status;
+}
+
+void
+TestRepaintScheduler::testFlushOnce(void)
+{
+	RepaintScheduler rs;
+	MockRepaintDecor decor1, decor2;
+
+	rs.damage(&decor1, RepaintScheduler::PART_TITLE);
+	rs.damage(&decor2, RepaintScheduler::PART_BORDER);
+	rs.damage(&decor1, RepaintScheduler::PART_BORDER);
+	rs.damage(&decor1, RepaintScheduler::PART_TITLE);
+	ASSERT_EQUAL("pending", 2u, rs.size());
+
+	ASSERT_EQUAL("flush", 2u, rs.flush());
+	ASSERT_EQUAL("decor1", 1u, decor1.repaints);
+	ASSERT_EQUAL("decor1", static_cast<uint>(RepaintScheduler::PART_TITLE
+						 | RepaintScheduler::PART_BORDER),
+		     decor1.damage.parts);
+	ASSERT_EQUAL("decor2", 1u, decor2.repaints);
+	ASSERT_EQUAL("decor2", static_cast<uint>(RepaintScheduler::PART_BORDER),
+		     decor2.damage.parts);
+
+	ASSERT_EQUAL("empty", 0u, rs.size());
+	ASSERT_EQUAL("empty flush", 0u, rs.flush());
+	ASSERT_EQUAL("empty flush", 1u, decor1.repaints);
+}
+
+void
+TestRepaintScheduler::testAreaUnion(void)
+{
+	RepaintScheduler rs;
+	MockRepaintDecor decor;
+
+	rs.damage(&decor, RepaintScheduler::PART_CONTENT,
+		  Geometry(10, 10, 10, 10));
+	rs.damage(&decor, RepaintScheduler::PART_CONTENT,
+		  Geometry(30, 5, 10, 10));
+	const RepaintScheduler::Damage *damage = rs.getDamage(&decor);
+	ASSERT_TRUE("damage", damage != nullptr);
+	ASSERT_EQUAL("union", false, damage->full);
+	ASSERT_EQUAL("union", Geometry(10, 5, 30, 15), damage->area);
+
+	rs.damage(&decor, RepaintScheduler::PART_CONTENT);
+	ASSERT_EQUAL("full", true, rs.getDamage(&decor)->full);
+	rs.damage(&decor, RepaintScheduler::PART_CONTENT,
+		  Geometry(0, 0, 10, 10));
+	ASSERT_EQUAL("stays full", true, rs.getDamage(&decor)->full);
+}
+
+void
+TestRepaintScheduler::testClip(void)
+{
+	RepaintScheduler::Damage damage;
+	damage.add(RepaintScheduler::PART_CONTENT, Geometry(10, 10, 20, 20));
+
+	Geometry gm(0, 15, 15, 5);
+	ASSERT_EQUAL("intersects", true, damage.clip(gm));
+	ASSERT_EQUAL("clipped", Geometry(10, 15, 5, 5), gm);
+
+	ASSERT_EQUAL("outside", false,
+		     damage.intersects(Geometry(30, 10, 10, 10)));
+
+	RepaintScheduler::Damage title;
+	title.add(RepaintScheduler::PART_TITLE, Geometry(10, 10, 20, 20));
+	ASSERT_EQUAL("no content", false,
+		     title.intersects(Geometry(10, 10, 20, 20)));
+}
+
+void
+TestRepaintScheduler::testRemove(void)
+{
+	RepaintScheduler rs;
+	MockRepaintDecor decor1, decor2;
+
+	rs.damage(&decor1, RepaintScheduler::PART_TITLE);
+	rs.damage(&decor2, RepaintScheduler::PART_TITLE);
+	rs.remove(&decor1);
+	ASSERT_EQUAL("removed", 1u, rs.size());
+	ASSERT_TRUE("removed", rs.getDamage(&decor1) == nullptr);
+
+	ASSERT_EQUAL("flush", 1u, rs.flush());
+	ASSERT_EQUAL("decor1", 0u, decor1.repaints);
+	ASSERT_EQUAL("decor2", 1u, decor2.repaints);
+}
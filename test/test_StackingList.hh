@@ -0,0 +1,211 @@
+//
+// test_StackingList.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+
+#include "StackingList.hh"
+
+class TestStackingList : public TestSuite {
+public:
+	TestStackingList(void);
+	~TestStackingList(void);
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+private:
+	static void testLayers(void);
+	static void testInsertAbove(void);
+	static void testRemove(void);
+	static void testIsBelow(void);
+
+	static std::string order(const StackingList &list, PWinObj **wos,
+				 size_t num);
+	static std::string reverseOrder(const StackingList &list, PWinObj **wos,
+					size_t num);
+	static std::string woName(PWinObj *wo, PWinObj **wos, size_t num);
+};
+
+TestStackingList::TestStackingList(void)
+	: TestSuite("StackingList")
+{
+}
+
+TestStackingList::~TestStackingList(void)
+{
+}
+
+bool
+TestStackingList::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "layers", testLayers());
+	TEST_FN(spec, "insertAbove", testInsertAbove());
+	TEST_FN(spec, "remove", testRemove());
+	TEST_FN(spec, "isBelow", testIsBelow());
+	return status;
+}
+
+void
+TestStackingList::testLayers(void)
+{
+	PWinObj wo0(false), wo1(false), wo2(false), wo3(false), wo4(false);
+	PWinObj *wos[] = {&wo0, &wo1, &wo2, &wo3, &wo4};
+
+	StackingList list;
+	list.insertTop(&wo0, LAYER_NORMAL);
+	list.insertTop(&wo1, LAYER_ONTOP);
+	list.insertTop(&wo2, LAYER_BELOW);
+	list.insertTop(&wo3, LAYER_NORMAL);
+	list.insertBottom(&wo4, LAYER_NORMAL);
+	ASSERT_EQUAL("insert", 5u, list.size());
+	ASSERT_EQUAL("insert", std::string("2 4 0 3 1"), order(list, wos, 5));
+	ASSERT_EQUAL("insert", std::string("1 3 0 4 2"),
+		     reverseOrder(list, wos, 5));
+
+	// raise within layer
+	list.insertTop(&wo4, LAYER_NORMAL);
+	ASSERT_EQUAL("raise", std::string("2 0 3 4 1"), order(list, wos, 5));
+	// lower within layer
+	list.insertBottom(&wo3, LAYER_NORMAL);
+	ASSERT_EQUAL("lower", std::string("2 3 0 4 1"), order(list, wos, 5));
+	// raising the top does not move it
+	list.insertTop(&wo4, LAYER_NORMAL);
+	ASSERT_EQUAL("raise top", std::string("2 3 0 4 1"),
+		     order(list, wos, 5));
+	// change layer
+	list.insertBottom(&wo2, LAYER_MENU);
+	ASSERT_EQUAL("layer", std::string("3 0 4 1 2"), order(list, wos, 5));
+	ASSERT_EQUAL("size", 5u, list.size());
+
+	for (size_t i = 0; i < 5; i++) {
+		list.remove(wos[i]);
+	}
+	ASSERT_EQUAL("empty", true, list.empty());
+	ASSERT_TRUE("empty", list.begin() == list.end());
+}
+
+void
+TestStackingList::testInsertAbove(void)
+{
+	PWinObj wo0(false), wo1(false), wo2(false), wo3(false);
+	PWinObj *wos[] = {&wo0, &wo1, &wo2, &wo3};
+
+	StackingList list;
+	list.insertTop(&wo0, LAYER_NORMAL);
+	list.insertTop(&wo1, LAYER_NORMAL);
+	list.insertTop(&wo2, LAYER_ONTOP);
+	list.insertAbove(&wo3, &wo0);
+	ASSERT_EQUAL("middle", std::string("0 3 1 2"), order(list, wos, 4));
+
+	// above the top of a layer, stays in the layer of below
+	list.insertAbove(&wo3, &wo1);
+	ASSERT_EQUAL("top", std::string("0 1 3 2"), order(list, wos, 4));
+	ASSERT_EQUAL("top", LAYER_NORMAL, wo3.getStackingPos().layer);
+	list.insertBottom(&wo0, LAYER_ONTOP);
+	ASSERT_EQUAL("layer top", std::string("1 3 0 2"), order(list, wos, 4));
+
+	for (size_t i = 0; i < 4; i++) {
+		list.remove(wos[i]);
+	}
+}
+
+void
+TestStackingList::testRemove(void)
+{
+	PWinObj wo0(false), wo1(false), wo2(false), wo3(false);
+	PWinObj *wos[] = {&wo0, &wo1, &wo2, &wo3};
+
+	StackingList list;
+	list.insertTop(&wo0, LAYER_BELOW);
+	list.insertTop(&wo1, LAYER_NORMAL);
+	list.insertTop(&wo2, LAYER_NORMAL);
+	list.insertTop(&wo3, LAYER_ONTOP);
+
+	// removing the only object of a layer empties it
+	list.remove(&wo0);
+	ASSERT_EQUAL("bottom", false, StackingList::contains(&wo0));
+	ASSERT_EQUAL("bottom", std::string("1 2 3"), order(list, wos, 4));
+	list.insertTop(&wo0, LAYER_BELOW);
+	ASSERT_EQUAL("bottom", std::string("0 1 2 3"), order(list, wos, 4));
+
+	// removing the top of a layer
+	list.remove(&wo2);
+	list.insertTop(&wo2, LAYER_ONTOP);
+	ASSERT_EQUAL("top", std::string("0 1 3 2"), order(list, wos, 4));
+	list.remove(&wo3);
+	list.remove(&wo2);
+	list.insertTop(&wo3, LAYER_NORMAL);
+	ASSERT_EQUAL("top", std::string("0 1 3"), order(list, wos, 4));
+	ASSERT_TRUE("top", list.getTop() == &wo3);
+	ASSERT_TRUE("top", StackingList::getAbove(&wo3) == nullptr);
+
+	// removing twice is a no-op
+	list.remove(&wo2);
+	ASSERT_EQUAL("size", 3u, list.size());
+
+	for (size_t i = 0; i < 4; i++) {
+		list.remove(wos[i]);
+	}
+	ASSERT_EQUAL("empty", 0u, list.size());
+}
+
+void
+TestStackingList::testIsBelow(void)
+{
+	PWinObj wo0(false), wo1(false), wo2(false), wo3(false);
+	PWinObj *wos[] = {&wo0, &wo1, &wo2, &wo3};
+
+	StackingList list;
+	list.insertTop(&wo0, LAYER_NORMAL);
+	list.insertTop(&wo1, LAYER_NORMAL);
+	list.insertTop(&wo2, LAYER_NORMAL);
+	list.insertTop(&wo3, LAYER_BELOW);
+
+	ASSERT_EQUAL("same layer", true, StackingList::isBelow(&wo0, &wo2));
+	ASSERT_EQUAL("same layer", false, StackingList::isBelow(&wo2, &wo0));
+	ASSERT_EQUAL("same layer", false, StackingList::isBelow(&wo1, &wo1));
+	ASSERT_EQUAL("layer", true, StackingList::isBelow(&wo3, &wo0));
+	ASSERT_EQUAL("layer", false, StackingList::isBelow(&wo2, &wo3));
+
+	for (size_t i = 0; i < 4; i++) {
+		list.remove(wos[i]);
+	}
+}
+
+std::string
+TestStackingList::order(const StackingList &list, PWinObj **wos, size_t num)
+{
+	std::string str;
+	StackingList::const_iterator it = list.begin();
+	for (; it != list.end(); ++it) {
+		str += (str.empty() ? "" : " ") + woName(*it, wos, num);
+	}
+	return str;
+}
+
+std::string
+TestStackingList::reverseOrder(const StackingList &list, PWinObj **wos,
+			       size_t num)
+{
+	std::string str;
+	StackingList::const_reverse_iterator it = list.rbegin();
+	for (; it != list.rend(); ++it) {
+		str += (str.empty() ? "" : " ") + woName(*it, wos, num);
+	}
+	return str;
+}
+
+std::string
+TestStackingList::woName(PWinObj *wo, PWinObj **wos, size_t num)
+{
+	for (size_t i = 0; i < num; i++) {
+		if (wos[i] == wo) {
+			return std::string(1, '0' + i);
+		}
+	}
+	return "?";
+}
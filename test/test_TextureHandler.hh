@@ -0,0 +1,67 @@
+//
+// test_TextureHandler.hh for pekwm
+// Copyright (C) 2021 the pekwm development team
+//
+// This program is licensed under the GNU GPL.
+// See the LICENSE file for more information.
+//
+
+#include "test.hh"
+#include "TextureHandler.hh"
+
+class TestTextureHandler : public TestSuite {
+public:
+	TestTextureHandler(void)
+		: TestSuite("TextureHandler")
+	{
+	}
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+	static void testNormalizeKey(void);
+	static void testGetTexture(void);
+};
+
+bool
+TestTextureHandler::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "normalizeKey", testNormalizeKey());
+	TEST_FN(spec, "getTexture", testGetTexture());
+	return status;
+}
+
+void
+TestTextureHandler::testNormalizeKey(void)
+{
+	ASSERT_EQUAL("plain", "SOLID #FFFFFF",
+		     TextureHandler::normalizeKey("Solid #ffffff"));
+	ASSERT_EQUAL("whitespace", "SOLID #FFFFFF 10X10",
+		     TextureHandler::normalizeKey(" Solid \t #ffffff  10x10 "));
+	ASSERT_EQUAL("empty", "", TextureHandler::normalizeKey(" \t"));
+}
+
+void
+TestTextureHandler::testGetTexture(void)
+{
+	TextureHandler th;
+
+	PTexture *tex = th.getTexture("Empty");
+	ASSERT_TRUE("parse", tex != nullptr);
+	ASSERT_TRUE("same", th.getTexture("EMPTY") == tex);
+	ASSERT_TRUE("whitespace", th.getTexture("  empty\t") == tex);
+	ASSERT_EQUAL("size", 1u, th.size());
+
+	ASSERT_TRUE("reference", th.referenceTexture(tex) == tex);
+
+	// four references, texture is kept until the last is returned
+	for (int i = 0; i < 3; i++) {
+		th.returnTexture(tex);
+		ASSERT_EQUAL("returned", 1u, th.size());
+	}
+	th.returnTexture(tex);
+	ASSERT_EQUAL("freed", 0u, th.size());
+
+	PTexture *new_tex = th.getTexture("Empty");
+	ASSERT_EQUAL("new", 1u, th.size());
+	th.returnTexture(new_tex);
+}
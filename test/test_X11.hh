@@ -25,6 +25,8 @@ public:
 	static void testParseGeometryVal(void);
 	static void assertParseGeometryVal(std::string msg, std::string str,
 					   int e_ret, int e_val);
+	static void testCoalesceEvents(void);
+	static void testCopyPropertyValue(void);
 };
 
 TestX11::TestX11(void)
@@ -42,6 +44,8 @@ TestX11::run_test(TestSpec spec, bool status)
 {
 	TEST_FN(spec, "parseGeometry", testParseGeometry());
 	TEST_FN(spec, "parseGeometryVal", testParseGeometryVal());
+	TEST_FN(spec, "coalesceEvents", testCoalesceEvents());
+	TEST_FN(spec, "copyPropertyValue", testCopyPropertyValue());
 	return status;
 }
 
@@ -102,3 +106,99 @@ TestX11::assertParseGeometryVal(std::string msg, std::string str,
 	ASSERT_EQUAL(msg + " ret", e_ret, ret);
 	ASSERT_EQUAL(msg + " val", e_val, val);
 }
+
+static XEvent
+mkEvent(int type, Window win)
+{
+	XEvent ev = {0};
+	ev.type = type;
+	ev.xany.window = win;
+	return ev;
+}
+
+void
+TestX11::testCoalesceEvents(void)
+{
+	std::vector<XEvent> events;
+	EventQueueStats stats;
+
+	// motion, earlier motion on the same window is dropped while the
+	// last motion before the button press and the last motion per
+	// window after it are kept
+	events.push_back(mkEvent(MotionNotify, 1));
+	events.push_back(mkEvent(MotionNotify, 1));
+	events.push_back(mkEvent(ButtonPress, 1));
+	events.push_back(mkEvent(MotionNotify, 1));
+	events.push_back(mkEvent(MotionNotify, 2));
+	events.push_back(mkEvent(MotionNotify, 1));
+	events[5].xmotion.x = 42;
+	coalesceEvents(events, 0, stats);
+	ASSERT_EQUAL("motion", 2, stats.motion);
+	ASSERT_EQUAL("motion 0", 0, events[0].type);
+	ASSERT_EQUAL("motion 1", MotionNotify, events[1].type);
+	ASSERT_EQUAL("motion 3", 0, events[3].type);
+	ASSERT_EQUAL("motion 4", MotionNotify, events[4].type);
+	ASSERT_EQUAL("motion 5", 42, events[5].xmotion.x);
+
+	// configure requests are merged into the last request
+	events.clear();
+	events.push_back(mkEvent(ConfigureRequest, 1));
+	events[0].xconfigurerequest.value_mask = CWX | CWY;
+	events[0].xconfigurerequest.x = 10;
+	events[0].xconfigurerequest.y = 20;
+	events.push_back(mkEvent(ConfigureRequest, 1));
+	events[1].xconfigurerequest.value_mask = CWY | CWWidth;
+	events[1].xconfigurerequest.y = 30;
+	events[1].xconfigurerequest.width = 40;
+	coalesceEvents(events, 0, stats);
+	ASSERT_EQUAL("configure", 1, stats.configure);
+	ASSERT_EQUAL("configure 0", 0, events[0].type);
+	XConfigureRequestEvent &cr = events[1].xconfigurerequest;
+	ASSERT_EQUAL("configure mask", CWX | CWY | CWWidth, cr.value_mask);
+	ASSERT_EQUAL("configure x", 10, cr.x);
+	ASSERT_EQUAL("configure y", 30, cr.y);
+	ASSERT_EQUAL("configure width", 40, cr.width);
+
+	// one property per window and atom, destroy is a barrier
+	events.clear();
+	events.push_back(mkEvent(PropertyNotify, 1));
+	events[0].xproperty.atom = XA_WM_NAME;
+	events.push_back(mkEvent(PropertyNotify, 1));
+	events[1].xproperty.atom = XA_WM_NAME;
+	events.push_back(mkEvent(PropertyNotify, 1));
+	events[2].xproperty.atom = XA_WM_HINTS;
+	events.push_back(mkEvent(DestroyNotify, 1));
+	events[3].xdestroywindow.window = 1;
+	events.push_back(mkEvent(PropertyNotify, 1));
+	events[4].xproperty.atom = XA_WM_HINTS;
+	coalesceEvents(events, 0, stats);
+	ASSERT_EQUAL("property", 1, stats.property);
+	ASSERT_EQUAL("property 0", 0, events[0].type);
+	ASSERT_EQUAL("property 2", PropertyNotify, events[2].type);
+	ASSERT_EQUAL("property 4", PropertyNotify, events[4].type);
+}
+
+void
+TestX11::testCopyPropertyValue(void)
+{
+	const char str[] = {'a', 'b', 'c'};
+	uchar *data = copyPropertyValue(8, str, 3);
+	ASSERT_EQUAL("8", std::string("abc"),
+		     std::string(reinterpret_cast<char*>(data)));
+	X11::free(data);
+
+	const int16_t shorts[] = {1, -2};
+	data = copyPropertyValue(16, shorts, 2);
+	ASSERT_EQUAL("16", 1, reinterpret_cast<short*>(data)[0]);
+	ASSERT_EQUAL("16", -2, reinterpret_cast<short*>(data)[1]);
+	X11::free(data);
+
+	// 32 bit items are longs, sign extended as with Xlib
+	const uint32_t longs[] = {42, 0xffffffff};
+	data = copyPropertyValue(32, longs, 2);
+	ASSERT_EQUAL("32", 42L, reinterpret_cast<long*>(data)[0]);
+	ASSERT_EQUAL("32", -1L, reinterpret_cast<long*>(data)[1]);
+	X11::free(data);
+
+	ASSERT_TRUE("format", copyPropertyValue(24, longs, 2) == nullptr);
+}
@@ -13,10 +13,16 @@
 #include "test_Action.hh"
 #include "test_Config.hh"
 #include "test_Frame.hh"
+#include "test_ImageHandler.hh"
 #include "test_InputDialog.hh"
+#include "test_KeyGrabber.hh"
 #include "test_ManagerWindows.hh"
 #include "test_Observable.hh"
 #include "test_PFont.hh"
+#include "test_PImage.hh"
+#include "test_RepaintScheduler.hh"
+#include "test_StackingList.hh"
+#include "test_TextureHandler.hh"
 #include "test_Theme.hh"
 #include "test_WindowManager.hh"
 #include "test_X11.hh"
@@ -40,9 +46,15 @@ main_tests(int argc, char *argv[])
 	// Frame
 	TestFrame testFrame;
 
+	// ImageHandler
+	TestScaledImageCache testScaledImageCache;
+
 	// InputDialog
 	TestInputBuffer testInputBuffer;
 
+	// KeyGrabber
+	TestKeyGrabberChain testKeyGrabberChain;
+
 	// ManagerWindows
 	TestRootWO testRootWO(&hint_wo, &cfg);
 
@@ -52,6 +64,18 @@ main_tests(int argc, char *argv[])
 	// PFont
 	TestPFont testPFont;
 
+	// PImage
+	TestPImage testPImage;
+
+	// RepaintScheduler
+	TestRepaintScheduler testRepaintScheduler;
+
+	// StackingList
+	TestStackingList testStackingList;
+
+	// TextureHandler
+	TestTextureHandler testTextureHandler;
+
 	// Theme
 	TestTheme testTheme;
 
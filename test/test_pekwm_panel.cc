@@ -8,9 +8,602 @@
 
 #include "test.hh"
 
-#include "pekwm.hh"
-#include "Debug.hh"
-#include "X11.hh"
+#define UNITTEST
+#include "pekwm_panel.cc"
+
+#include <map>
+
+extern "C" {
+#include <poll.h>
+}
+
+class TestClientList : public TestSuite {
+public:
+	TestClientList(void);
+	virtual ~TestClientList(void);
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+private:
+	static void testUpdate(void);
+	static void testUnchanged(void);
+
+	static std::string windows(const ClientList &list);
+};
+
+TestClientList::TestClientList(void)
+	: TestSuite("ClientList")
+{
+}
+
+TestClientList::~TestClientList(void)
+{
+}
+
+bool
+TestClientList::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "update", testUpdate());
+	TEST_FN(spec, "unchanged", testUnchanged());
+	return status;
+}
+
+void
+TestClientList::testUpdate(void)
+{
+	ClientList list;
+	std::vector<ClientInfo*> added;
+
+	Window windows1[] = {3, 1, 2};
+	ASSERT_EQUAL("initial", true, list.update(windows1, 3, added));
+	ASSERT_EQUAL("initial", 3u, added.size());
+	ASSERT_EQUAL("initial", std::string("3 1 2"), windows(list));
+	ClientInfo *client1 = list.find(1);
+	ASSERT_TRUE("find", client1 != nullptr);
+	ASSERT_EQUAL("find", 1u, client1->getWindow());
+
+	// 3 removed, 4 and 0 added and 1 moved to the top
+	Window windows2[] = {0, 2, 4, 1};
+	ASSERT_EQUAL("churn", true, list.update(windows2, 4, added));
+	ASSERT_EQUAL("churn", 2u, added.size());
+	ASSERT_EQUAL("churn", std::string("0 2 4 1"), windows(list));
+	ASSERT_TRUE("churn", list.find(3) == nullptr);
+	ASSERT_TRUE("churn", list.find(1) == client1);
+
+	ASSERT_EQUAL("empty", true, list.update(nullptr, 0, added));
+	ASSERT_EQUAL("empty", 0u, added.size());
+	ASSERT_EQUAL("empty", 0u, list.size());
+	ASSERT_TRUE("empty", list.find(1) == nullptr);
+}
+
+void
+TestClientList::testUnchanged(void)
+{
+	ClientList list;
+	std::vector<ClientInfo*> added;
+
+	Window windows[] = {5, 6, 7};
+	list.update(windows, 3, added);
+	ClientInfo *client = list.find(6);
+	ASSERT_EQUAL("unchanged", false, list.update(windows, 3, added));
+	ASSERT_EQUAL("unchanged", 0u, added.size());
+	ASSERT_TRUE("unchanged", list.find(6) == client);
+}
+
+std::string
+TestClientList::windows(const ClientList &list)
+{
+	std::ostringstream oss;
+	ClientList::const_iterator it = list.begin();
+	for (; it != list.end(); ++it) {
+		oss << (it == list.begin() ? "" : " ") << (*it)->getWindow();
+	}
+	return oss.str();
+}
+
+class TestCommandProcess : public TestSuite {
+public:
+	TestCommandProcess(void);
+	virtual ~TestCommandProcess(void);
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+private:
+	static void testGetNextRunS(void);
+};
+
+TestCommandProcess::TestCommandProcess(void)
+	: TestSuite("CommandProcess")
+{
+}
+
+TestCommandProcess::~TestCommandProcess(void)
+{
+}
+
+bool
+TestCommandProcess::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "getNextRunS", testGetNextRunS());
+	return status;
+}
+
+void
+TestCommandProcess::testGetNextRunS(void)
+{
+	ExternalCommandData::CommandProcess interval("true", 15, false);
+	ASSERT_EQUAL("interval", 15u, interval.getNextRunS());
+	ASSERT_EQUAL("interval", 15u, interval.getNextRunS());
+
+	ExternalCommandData::CommandProcess persistent("true", UINT_MAX, true);
+	uint expected[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 300, 300};
+	for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+		ASSERT_EQUAL("backoff", expected[i], persistent.getNextRunS());
+	}
+
+	// interval limits the backoff of persistent commands
+	ExternalCommandData::CommandProcess limited("true", 10, true);
+	uint expected_limited[] = {1, 2, 4, 8, 10, 10};
+	for (size_t i = 0; i < sizeof(expected_limited) / sizeof(uint); i++) {
+		ASSERT_EQUAL("limit", expected_limited[i], limited.getNextRunS());
+	}
+}
+
+/**
+ * Write data to a temporary file and load it as panel configuration.
+ */
+static bool
+loadPanelConfig(const std::string &data, PanelConfig &cfg)
+{
+	char path[] = "/tmp/test_pekwm_panel.XXXXXX";
+	int cfg_fd = mkstemp(path);
+	if (cfg_fd == -1) {
+		return false;
+	}
+	bool written = write(cfg_fd, data.c_str(), data.size())
+		== static_cast<ssize_t>(data.size());
+	close(cfg_fd);
+
+	bool loaded = written && cfg.load(path);
+	unlink(path);
+	return loaded;
+}
+
+class TestExternalCommandData : public TestSuite {
+public:
+	TestExternalCommandData(void);
+	virtual ~TestExternalCommandData(void);
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+private:
+	static void testInput(void);
+	static void testInputPersistent(void);
+	static void testSchedule(void);
+
+	/** State shared with the ExternalCommandData callbacks. */
+	struct RunState {
+		ExternalCommandData *data;
+		int fd;
+		/** Value of the last field when the command was done. */
+		std::string last_done;
+	};
+
+	static bool runCommand(const std::string &command_cfg,
+			       std::map<std::string, std::string> &fields,
+			       size_t &timers);
+	static void addFd(int fd, void *opaque);
+	static void removeFd(int fd, void *opaque);
+	static void commandDone(void *opaque);
+};
+
+TestExternalCommandData::TestExternalCommandData(void)
+	: TestSuite("ExternalCommandData")
+{
+}
+
+TestExternalCommandData::~TestExternalCommandData(void)
+{
+}
+
+bool
+TestExternalCommandData::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "input", testInput());
+	TEST_FN(spec, "input persistent", testInputPersistent());
+	TEST_FN(spec, "schedule", testSchedule());
+	return status;
+}
+
+/** Shell loop writing about 100 KiB of output before the last line. */
+static const char *EXTERNAL_COMMAND_LARGE_OUTPUT =
+	"i=0; while [ $i -lt 2000 ]; do "
+	"echo field line-$i ........................................; "
+	"i=$((i+1)); done; echo last done";
+
+void
+TestExternalCommandData::testInput(void)
+{
+	std::map<std::string, std::string> fields;
+	size_t timers;
+	ASSERT_EQUAL("run", true,
+		     runCommand(std::string("Command = \"")
+				+ EXTERNAL_COMMAND_LARGE_OUTPUT
+				+ "\" { Interval = \"60\" }",
+				fields, timers));
+	ASSERT_EQUAL("after 64 KiB", std::string("done"), fields["last"]);
+	ASSERT_EQUAL("after 64 KiB",
+		     std::string("line-1999 ........................................"),
+		     fields["field"]);
+}
+
+void
+TestExternalCommandData::testInputPersistent(void)
+{
+	std::map<std::string, std::string> fields;
+	size_t timers;
+	ASSERT_EQUAL("run", true,
+		     runCommand(std::string("Command = \"")
+				+ EXTERNAL_COMMAND_LARGE_OUTPUT
+				+ "\" { Interval = \"60\""
+				" Persistent = \"True\" }",
+				fields, timers));
+	ASSERT_EQUAL("after 64 KiB", std::string("done"), fields["last"]);
+	ASSERT_EQUAL("after 64 KiB",
+		     std::string("line-1999 ........................................"),
+		     fields["field"]);
+}
+
+void
+TestExternalCommandData::testSchedule(void)
+{
+	// commands without an interval run once
+	std::map<std::string, std::string> fields;
+	size_t timers;
+	ASSERT_EQUAL("run", true,
+		     runCommand("Command = \"echo last done\"", fields, timers));
+	ASSERT_EQUAL("once", std::string("done"), fields["last"]);
+	ASSERT_EQUAL("once", 0, timers);
+
+	ASSERT_EQUAL("run", true,
+		     runCommand("Command = \"echo last done\""
+				" { Interval = \"60\" }",
+				fields, timers));
+	ASSERT_EQUAL("interval", 1, timers);
+
+	// output without a trailing newline is parsed before the
+	// command is reported done
+	ASSERT_EQUAL("run", true,
+		     runCommand("Command = \"printf 'last unterminated'\"",
+				fields, timers));
+	ASSERT_EQUAL("unterminated", std::string("unterminated"),
+		     fields["last"]);
+	ASSERT_EQUAL("unterminated", std::string("unterminated"),
+		     fields["last_done"]);
+}
+
+/**
+ * Start the command in command_cfg, part of a Commands section, and
+ * read all of its output through ExternalCommandData::input.
+ *
+ * @param timers Set to the number of timers left once the command has
+ *               exited, 1 if it is scheduled to run again.
+ */
+bool
+TestExternalCommandData::runCommand(const std::string &command_cfg,
+				    std::map<std::string, std::string> &fields,
+				    size_t &timers)
+{
+	PanelConfig cfg;
+	if (! loadPanelConfig("Commands {\n" + command_cfg + "\n}\n", cfg)) {
+		return false;
+	}
+
+	Mainloop mainloop;
+	ExternalCommandData data(cfg);
+	RunState state = {&data, -1, ""};
+	data.start(&mainloop, addFd, removeFd, commandDone, &state);
+	for (int i = 0; i < 10 && state.fd == -1; i++) {
+		mainloop.wait(100);
+	}
+	if (state.fd == -1) {
+		return false;
+	}
+	int fd = state.fd;
+
+	// input returns false both at end of output and when no data is
+	// available, poll to tell them apart.
+	struct pollfd pfd = {fd, POLLIN, 0};
+	while (poll(&pfd, 1, 5000) > 0) {
+		if (! data.input(fd) && (pfd.revents & POLLHUP)) {
+			break;
+		}
+	}
+
+	for (int i = 0; i < 500 && ChildRegistry::size() > 0; i++) {
+		usleep(10000);
+		ChildRegistry::reap();
+	}
+
+	fields["field"] = data.get("field");
+	fields["last"] = data.get("last");
+	fields["last_done"] = state.last_done;
+	timers = mainloop.numTimers();
+	return true;
+}
+
+void
+TestExternalCommandData::addFd(int fd, void *opaque)
+{
+	reinterpret_cast<RunState*>(opaque)->fd = fd;
+}
+
+void
+TestExternalCommandData::removeFd(int, void *)
+{
+}
+
+void
+TestExternalCommandData::commandDone(void *opaque)
+{
+	RunState *state = reinterpret_cast<RunState*>(opaque);
+	state->last_done = state->data->get("last");
+}
+
+class TestLineBuffer : public TestSuite {
+public:
+	TestLineBuffer(void);
+	virtual ~TestLineBuffer(void);
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+private:
+	static void testGetLine(void);
+	static void testLongLine(void);
+
+	static ssize_t writeRead(LineBuffer &buf, const std::string &data);
+};
+
+TestLineBuffer::TestLineBuffer(void)
+	: TestSuite("LineBuffer")
+{
+}
+
+TestLineBuffer::~TestLineBuffer(void)
+{
+}
+
+bool
+TestLineBuffer::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "getLine", testGetLine());
+	TEST_FN(spec, "longLine", testLongLine());
+	return status;
+}
+
+void
+TestLineBuffer::testGetLine(void)
+{
+	LineBuffer buf(8);
+	std::string line;
+
+	ASSERT_EQUAL("partial", 5, writeRead(buf, "ab\ncd"));
+	ASSERT_EQUAL("partial", true, buf.getLine(line));
+	ASSERT_EQUAL("partial", std::string("ab"), line);
+	ASSERT_EQUAL("partial", false, buf.getLine(line));
+
+	// line wrapping around the end of the buffer
+	ASSERT_EQUAL("wrap", 5, writeRead(buf, "efg\nh"));
+	ASSERT_EQUAL("wrap", true, buf.getLine(line));
+	ASSERT_EQUAL("wrap", std::string("cdefg"), line);
+	ASSERT_EQUAL("wrap", false, buf.getLine(line));
+
+	ASSERT_EQUAL("rest", true, buf.getRest(line));
+	ASSERT_EQUAL("rest", std::string("h"), line);
+	ASSERT_EQUAL("rest", 0u, buf.size());
+	ASSERT_EQUAL("rest", false, buf.getRest(line));
+}
+
+void
+TestLineBuffer::testLongLine(void)
+{
+	LineBuffer buf(8);
+	std::string line;
+
+	ASSERT_EQUAL("full", 8, writeRead(buf, "0123456789\nxy\n"));
+	ASSERT_EQUAL("full", false, buf.getLine(line));
+
+	// rest of the long line is dropped
+	ASSERT_EQUAL("drop", 6, writeRead(buf, ""));
+	ASSERT_EQUAL("drop", true, buf.getLine(line));
+	ASSERT_EQUAL("drop", std::string("xy"), line);
+	ASSERT_EQUAL("drop", false, buf.getLine(line));
+}
+
+/**
+ * Write data to a pipe and read it into buf, data left in the pipe is
+ * read by the next call.
+ */
+ssize_t
+TestLineBuffer::writeRead(LineBuffer &buf, const std::string &data)
+{
+	static int fd[2] = {-1, -1};
+	if (fd[0] == -1 && pipe(fd) == -1) {
+		return -1;
+	}
+	if (! data.empty() && write(fd[1], data.c_str(), data.size()) == -1) {
+		return -1;
+	}
+	return buf.read(fd[0]);
+}
+
+class TestPanelConfig : public TestSuite {
+public:
+	TestPanelConfig(void);
+	virtual ~TestPanelConfig(void);
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+private:
+	static void testRefreshInterval(void);
+};
+
+TestPanelConfig::TestPanelConfig(void)
+	: TestSuite("PanelConfig")
+{
+}
+
+TestPanelConfig::~TestPanelConfig(void)
+{
+}
+
+bool
+TestPanelConfig::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "refreshInterval", testRefreshInterval());
+	return status;
+}
+
+void
+TestPanelConfig::testRefreshInterval(void)
+{
+	// no widget with an interval, no refresh timer
+	PanelConfig cfg;
+	std::string data =
+		"Commands { Command = \"true\" { Interval = \"5\" } }\n"
+		"Widgets { ExternalData = \"%last\" { Size = \"*\" } }\n";
+	ASSERT_EQUAL("load", true, loadPanelConfig(data, cfg));
+	ASSERT_EQUAL("no interval", UINT_MAX, cfg.getRefreshIntervalS());
+
+	data = "Widgets {\n"
+		"DateTime = \"%H\" { Interval = \"60\" }\n"
+		"DateTime = \"%M\" { Interval = \"10\" }\n"
+		"}\n";
+	ASSERT_EQUAL("load", true, loadPanelConfig(data, cfg));
+	ASSERT_EQUAL("interval", 10u, cfg.getRefreshIntervalS());
+}
+
+class TestPanelWidget : public TestSuite {
+public:
+	TestPanelWidget(void);
+	virtual ~TestPanelWidget(void);
+
+	virtual bool run_test(TestSpec spec, bool status);
+
+private:
+	static void testUpdateContent(void);
+	static void testRenderCached(void);
+
+	static void setPixmap(PanelWidget &widget, Pixmap pixmap);
+};
+
+/**
+ * Widget formatting its content when dirty, like TextWidget, without
+ * rendering anything.
+ */
+class FormatCountWidget : public PanelWidget {
+public:
+	FormatCountWidget(const PanelTheme &theme, const SizeReq &size_req)
+		: PanelWidget(theme, size_req),
+		  formats(0)
+	{
+	}
+
+	void setDirty(void) { _dirty = true; }
+
+	virtual size_t updateContent(void)
+	{
+		if (_dirty) {
+			formats++;
+		}
+		return 42;
+	}
+
+	virtual void render(Render&) { }
+
+	uint formats;
+};
+
+TestPanelWidget::TestPanelWidget(void)
+	: TestSuite("PanelWidget")
+{
+}
+
+TestPanelWidget::~TestPanelWidget(void)
+{
+}
+
+bool
+TestPanelWidget::run_test(TestSpec spec, bool status)
+{
+	TEST_FN(spec, "updateContent", testUpdateContent());
+	TEST_FN(spec, "renderCached", testRenderCached());
+	return status;
+}
+
+void
+TestPanelWidget::testUpdateContent(void)
+{
+	PanelTheme theme;
+	SizeReq size_req(WIDGET_UNIT_PIXELS, 100);
+
+	// same formatted output, same hash
+	DateTimeWidget constant(theme, size_req, "constant");
+	size_t hash = constant.updateContent();
+	ASSERT_EQUAL("unchanged", hash, constant.updateContent());
+	DateTimeWidget other(theme, size_req, "other");
+	ASSERT_TRUE("changed", hash != other.updateContent());
+
+	// widgets without a content hash change when dirty
+	PanelWidget widget(theme, size_req);
+	ASSERT_EQUAL("dirty", true, widget.isDirty());
+	hash = widget.updateContent();
+	ASSERT_EQUAL("dirty", hash, widget.updateContent());
+
+	// widgets are dirty until rendered, no width or failing to create
+	// the pixmap (no display) does not render
+	ASSERT_EQUAL("no width", false, widget.renderCached(None, false));
+	ASSERT_EQUAL("no width", true, widget.isDirty());
+	widget.setWidth(100);
+	ASSERT_EQUAL("no pixmap", false, widget.renderCached(None, false));
+	ASSERT_EQUAL("no pixmap", true, widget.isDirty());
+	ASSERT_EQUAL("no pixmap", hash, widget.updateContent());
+}
+
+void
+TestPanelWidget::testRenderCached(void)
+{
+	PanelTheme theme;
+	SizeReq size_req(WIDGET_UNIT_PIXELS, 100);
+
+	FormatCountWidget widget(theme, size_req);
+	widget.setWidth(100);
+	setPixmap(widget, 1);
+	ASSERT_EQUAL("render", true, widget.renderCached(None, false));
+	ASSERT_EQUAL("render", 1u, widget.formats);
+	ASSERT_EQUAL("render", false, widget.isDirty());
+
+	// dirty with unchanged content formats once, then stays clean
+	widget.setDirty();
+	ASSERT_EQUAL("unchanged", false, widget.renderCached(None, false));
+	ASSERT_EQUAL("unchanged", 2u, widget.formats);
+	ASSERT_EQUAL("unchanged", false, widget.isDirty());
+	ASSERT_EQUAL("refresh", false, widget.renderCached(None, false));
+	ASSERT_EQUAL("refresh", 2u, widget.formats);
+
+	setPixmap(widget, None);
+}
+
+/**
+ * Set pixmap of widget, used to render without a display.
+ */
+void
+TestPanelWidget::setPixmap(PanelWidget &widget, Pixmap pixmap)
+{
+	widget._pixmap = pixmap;
+	widget._pixmap_width = widget._width;
+	widget._pixmap_height = widget._theme.getHeight();
+}
 
 static int
 main_tests(int argc, char *argv[])
@@ -19,6 +612,19 @@ main_tests(int argc, char *argv[])
 	Debug::setLogFile("/dev/null");
 	X11::addHead(Head(0, 0, 800, 600));
 
+	// ClientList
+	TestClientList testClientList;
+	// CommandProcess
+	TestCommandProcess testCommandProcess;
+	// ExternalCommandData
+	TestExternalCommandData testExternalCommandData;
+	// LineBuffer
+	TestLineBuffer testLineBuffer;
+	// PanelConfig
+	TestPanelConfig testPanelConfig;
+	// PanelWidget
+	TestPanelWidget testPanelWidget;
+
 	return TestSuite::main(argc, argv);
 }
 
@@ -11,7 +11,12 @@
 #include "Debug.hh"
 
 #include "test_CfgParser.hh"
+#include "test_CfgParserCache.hh"
 #include "test_Charset.hh"
+#include "test_ChildRegistry.hh"
+#include "test_HashMap.hh"
+#include "test_Mainloop.hh"
+#include "test_RegexIndex.hh"
 #include "test_RegexString.hh"
 #include "test_Util.hh"
 
@@ -22,10 +27,23 @@ main(int argc, char *argv[])
 
 	// CfgParser
 	TestCfgParser testCfgParser;
+	TestCfgParserCache testCfgParserCache;
 
 	// Charset
 	TestCharset testCharset;
 
+	// ChildRegistry
+	TestChildRegistry testChildRegistry;
+
+	// HashMap
+	TestHashMap testHashMap;
+
+	// Mainloop
+	TestMainloop testMainloop;
+
+	// RegexIndex
+	TestRegexIndex testRegexIndex;
+
 	// // RegexString
 	TestRegexString testRegexString;
 